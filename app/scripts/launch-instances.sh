@@ -0,0 +1,194 @@
+#!/bin/bash
+##############################################################################
+#                                                                            #
+# Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        #
+# All Rights Reserved.                                                       #
+#                                                                            #
+##############################################################################
+
+#
+# author: Nicola Piga <nicolapiga@gmail.com>
+#
+
+#
+# Start several isolated instances of the kinematic simulation
+# on the same name server. The ports of the instance k are prefixed
+# with the namespace /vtl<k> and its processes are pinned to a
+# disjoint set of cores.
+#
+# The localizer is not part of this repository, hence it is started
+# only if a command is given with -l. The variable PREFIX holds the
+# namespace of the instance when the command is evaluated. The localizer
+# is expected to open $PREFIX/upf-localizer:i and $PREFIX/upf-localizer/contacts:i
+# and to publish the estimates to $PREFIX/transformServer.
+#
+
+usage()
+{
+    echo "Usage: $0 [-n <instances>] [-c <cores per instance>] [-f <first core>]"
+    echo "          [-s] [-e] [-l <localizer command>] [-o <log directory>]"
+    echo ""
+    echo "  -n  number of instances (default 2)"
+    echo "  -c  number of cores assigned to each instance (default 2)"
+    echo "  -f  first core to be used (default 0)"
+    echo "  -s  drive each instance with its own stepped clock"
+    echo "  -e  run experiment_runner on each instance and exit when all are done"
+    echo "  -l  command starting the localizer of an instance,"
+    echo "      \$PREFIX expands to the namespace of the instance"
+    echo "  -o  directory of the logs and of the results (default instances)"
+}
+
+instances=2
+cores_per_instance=2
+first_core=0
+stepped=0
+experiment=0
+localizer=""
+log_dir="instances"
+
+while getopts "n:c:f:sel:o:h" option; do
+    case $option in
+	n) instances=$OPTARG ;;
+	c) cores_per_instance=$OPTARG ;;
+	f) first_core=$OPTARG ;;
+	s) stepped=1 ;;
+	e) experiment=1 ;;
+	l) localizer=$OPTARG ;;
+	o) log_dir=$OPTARG ;;
+	*) usage; exit 1 ;;
+    esac
+done
+
+if ! yarp detect > /dev/null 2>&1; then
+    echo "$0: cannot find YARP!"
+    exit 1
+fi
+
+cores=$(nproc)
+if [ $((first_core + instances * cores_per_instance)) -gt "$cores" ]; then
+    echo "$0: $instances instances of $cores_per_instance cores do not fit in $cores cores"
+    exit 1
+fi
+
+mkdir -p "$log_dir"
+
+pids=()
+stop_all()
+{
+    # the modules are stopped before the clocks
+    for (( i=${#pids[@]}-1; i>=0; i-- )); do
+	kill -INT "${pids[i]}" 2> /dev/null
+	wait "${pids[i]}" 2> /dev/null
+    done
+}
+trap stop_all EXIT
+trap "exit 1" INT TERM
+
+# wait for a port giving up after a timeout
+# usage: wait_port <port>
+wait_port()
+{
+    if ! timeout 60 yarp wait "$1" > /dev/null; then
+	echo "$0: port $1 not available, see the logs in $log_dir"
+	exit 1
+    fi
+}
+
+# start a process of an instance pinned to its cores
+# usage: start <instance> <log name> <command> [<arguments>]
+start()
+{
+    local k=$1
+    local name=$2
+    shift 2
+    taskset -c "${instance_cores[k]}" "$@" > "$log_dir/vtl$k-$name.log" 2>&1 &
+    pids+=($!)
+}
+
+instance_cores=()
+for (( k=1; k<=instances; k++ )); do
+    first=$((first_core + (k - 1) * cores_per_instance))
+    instance_cores[$k]="$first-$((first + cores_per_instance - 1))"
+done
+
+context="--context simVisualTactileLocalization"
+
+for (( k=1; k<=instances; k++ )); do
+    prefix="/vtl$k"
+    echo "$0: starting instance $prefix on cores ${instance_cores[k]}"
+
+    # clock
+    clock_env=()
+    clock_args=()
+    if [ $stepped -eq 1 ]; then
+	start $k clock_master clock_master $context --prefix $prefix
+	wait_port $prefix/clock-master/ack:i
+	clock_env=(env YARP_CLOCK=$prefix/clock)
+	clock_args=(--clockMaster $prefix/clock-master/ack:i)
+    fi
+
+    # transforms and localizer
+    start $k transformServer yarpdev --device transformServer --name ${prefix#/}/transformServer \
+	  --ROS::enable_ros_publisher false --ROS::enable_ros_subscriber false
+    wait_port $prefix/transformServer/transforms:o
+    if [ -n "$localizer" ]; then
+	start $k localizer env PREFIX=$prefix bash -c "$localizer"
+    fi
+
+    # robot and controllers
+    start $k kinematic_sim "${clock_env[@]}" kinematic_sim $context --prefix $prefix "${clock_args[@]}"
+    wait_port $prefix/icubSim/right_arm/state:o
+    wait_port $prefix/icubSim/left_arm/state:o
+
+    for hand in right left; do
+	start $k hand_ctrl_module_$hand "${clock_env[@]}" hand_ctrl_module $context \
+	      --handName $hand --prefix $prefix "${clock_args[@]}"
+	wait_port $prefix/hand-control/$hand/rpc:i
+    done
+
+    start $k visual-tactile-localization-sim "${clock_env[@]}" visual-tactile-localization-sim $context \
+	  --cartesianController kinematic --prefix $prefix "${clock_args[@]}"
+    wait_port $prefix/service
+
+    # connections, the same of the application VisualTactileLocalizationKinematicSim
+    for hand in right left; do
+	yarp connect $prefix/${hand}_hand/skinManager/skin_events:o $prefix/hand-control/$hand/contacts:i
+	yarp connect $prefix/vis_tac_localization/hand-control/$hand/rpc:o $prefix/hand-control/$hand/rpc:i
+	if [ -n "$localizer" ]; then
+	    yarp connect $prefix/${hand}_hand/skinManager/skin_events:o $prefix/upf-localizer/contacts:i
+	fi
+    done
+    if [ -n "$localizer" ]; then
+	yarp connect $prefix/vis_tac_localization/filter:o $prefix/upf-localizer:i
+    fi
+done
+
+if [ $experiment -eq 0 ]; then
+    echo "$0: $instances instances running, press Ctrl+C to stop them"
+    wait
+    exit 0
+fi
+
+# run the experiments concurrently
+runners=()
+for (( k=1; k<=instances; k++ )); do
+    prefix="/vtl$k"
+    clock_env=()
+    if [ $stepped -eq 1 ]; then
+	clock_env=(env YARP_CLOCK=$prefix/clock)
+    fi
+    taskset -c "${instance_cores[k]}" "${clock_env[@]}" experiment_runner $context --backend local \
+	    --prefix $prefix --results "$log_dir/results-vtl$k.csv" > "$log_dir/vtl$k-experiment_runner.log" 2>&1 &
+    runners+=($!)
+done
+
+status=0
+for (( k=1; k<=instances; k++ )); do
+    if ! wait "${runners[k-1]}"; then
+	echo "$0: the experiment of instance /vtl$k failed, see $log_dir/vtl$k-experiment_runner.log"
+	status=1
+    fi
+done
+echo "$0: results written to $log_dir/results-vtl<k>.csv"
+
+exit $status
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Measure the time required by PoseDistanceKernel to evaluate
+ * the sum of squared distances for several numbers of hypotheses,
+ * measurements and threads.
+ *
+ * Usage:
+ * pose_distance_benchmark [<file.sdfgrid>]
+ *
+ * The analytic distance field of the box is used
+ * unless a grid is provided.
+ */
+
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "headers/DistanceField.h"
+#include "headers/PoseDistanceKernel.h"
+
+// number of evaluations averaged for each configuration
+#define BENCHMARK_REPETITIONS 20
+
+int main(int argc, char **argv)
+{
+    std::unique_ptr<DistanceField> field;
+    if (argc > 1)
+    {
+	GridDistanceField *grid = new GridDistanceField();
+	field.reset(grid);
+	if (!grid->load(argv[1]))
+	    return 1;
+	std::printf("distance field: %s\n", argv[1]);
+    }
+    else
+    {
+	field.reset(new BoxDistanceField(0.24, 0.17, 0.037));
+	std::printf("distance field: box 0.24 x 0.17 x 0.037\n");
+    }
+
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> position(-0.05, 0.05);
+    std::uniform_real_distribution<float> angle(-M_PI, M_PI);
+    std::uniform_real_distribution<float> measurement(-0.15, 0.15);
+
+    const std::size_t n_hypotheses[] = {100, 1000, 5000};
+    const std::size_t n_measurements[] = {10, 1000, 10000};
+
+    // powers of two up to the number of cores
+    std::vector<std::size_t> n_threads;
+    std::size_t hw_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::size_t threads = 1; threads < hw_threads; threads *= 2)
+	n_threads.push_back(threads);
+    n_threads.push_back(hw_threads);
+
+    std::printf("%12s %12s %8s %14s %18s\n",
+		"hypotheses", "measurements", "threads", "time [ms]", "distances / s");
+
+    for (std::size_t m : n_measurements)
+    {
+	SoAPointCloud points;
+	points.resize(m);
+	for (std::size_t i = 0; i < m; i++)
+	{
+	    points.xData()[i] = measurement(generator);
+	    points.yData()[i] = measurement(generator);
+	    points.zData()[i] = measurement(generator);
+	}
+
+	for (std::size_t n : n_hypotheses)
+	{
+	    // random poses, rotations about the z axis
+	    std::vector<PoseHypothesis> poses(n);
+	    for (PoseHypothesis &pose : poses)
+	    {
+		float yaw = angle(generator);
+		float c = std::cos(yaw);
+		float s = std::sin(yaw);
+		float rot[9] = {c, -s, 0, s, c, 0, 0, 0, 1};
+		for (std::size_t k = 0; k < 9; k++)
+		    pose.rot[k] = rot[k];
+		for (std::size_t k = 0; k < 3; k++)
+		    pose.pos[k] = position(generator);
+	    }
+
+	    for (std::size_t threads : n_threads)
+	    {
+		PoseDistanceKernel kernel(*field, threads);
+		std::vector<float> sums;
+
+		// warm up
+		kernel.sumOfSquares(poses, points, sums);
+
+		auto begin = std::chrono::steady_clock::now();
+		for (std::size_t r = 0; r < BENCHMARK_REPETITIONS; r++)
+		    kernel.sumOfSquares(poses, points, sums);
+		auto end = std::chrono::steady_clock::now();
+
+		double elapsed = std::chrono::duration<double>(end - begin).count() / BENCHMARK_REPETITIONS;
+		std::printf("%12zu %12zu %8zu %14.3f %18.3e\n",
+			    n, m, threads, elapsed * 1000.0, n * m / elapsed);
+	    }
+	}
+    }
+
+    return 0;
+}
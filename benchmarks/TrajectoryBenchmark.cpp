@@ -0,0 +1,263 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Measure the time and the number of heap allocations required
+ * to evaluate the quintic trajectory used while pushing
+ * - with yarp::sig::Vector expressions and pow(), as TrajectoryGenerator
+ *   did before PolynomialTrajectory was introduced;
+ * - with TrajectoryGenerator;
+ * - with PolynomialTrajectory and coefficients evaluated at compile time;
+ * - with the samples of the jerk limited JerkLimitedTrajectory
+ *   (a different profile, not compared with the reference);
+ * and the time required to sample the whole trajectory at 1 kHz
+ * calling TrajectoryGenerator once per sample or once for all the samples.
+ *
+ * Usage:
+ * trajectory_benchmark
+ */
+
+// yarp
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Math.h>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "headers/TrajectoryGenerator.h"
+#include "headers/PolynomialTrajectory.h"
+#include "headers/JerkLimitedTrajectory.h"
+
+// number of evaluations for each implementation
+#define BENCHMARK_EVALUATIONS 1000000
+
+// duration of the trajectory in seconds
+#define BENCHMARK_DURATION 4.0
+
+// rate of the samples of the whole trajectory in Hz
+#define BENCHMARK_SAMPLING_RATE 1000
+
+// number of repetitions of the sampling of the whole trajectory
+#define BENCHMARK_REPETITIONS 1000
+
+using namespace yarp::math;
+
+// number of calls to the global operator new
+static std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+	throw std::bad_alloc();
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+/*
+ * Reference implementation allocating temporaries.
+ */
+class VectorQuintic
+{
+private:
+    yarp::sig::Vector a0;
+    yarp::sig::Vector a3;
+    yarp::sig::Vector a4;
+    yarp::sig::Vector a5;
+    double duration;
+
+public:
+    VectorQuintic(const yarp::sig::Vector &pos_i, const yarp::sig::Vector &pos_f,
+		  const double &duration) :
+	duration(duration)
+    {
+	a0 = pos_i;
+	a5 = a4 = a3 = a0 - pos_f;
+	a3 *= (-10.0 / pow(duration, 3));
+	a4 *= (15.0 / pow(duration, 4));
+	a5 *= (-6.0 / pow(duration, 5));
+    }
+
+    void getTrajectory(const double &time, yarp::sig::Vector &position, yarp::sig::Vector &velocity)
+    {
+	double t = time > duration ? duration : time;
+	position = a0 + a3 * pow(t, 3.0) + a4 * pow(t, 4.0) + a5 * pow(t, 5.0);
+	velocity = 3.0 * a3 * pow(t, 2.0) + 4.0 * a4 * pow(t, 3.0) + 5.0 * a5 * pow(t, 4.0);
+    }
+};
+
+/*
+ * Time and allocations of an implementation.
+ * @param name the name of the implementation
+ * @param evaluate a callable evaluating the trajectory at a given time
+ */
+template <typename Evaluate>
+void measure(const char *name, Evaluate evaluate)
+{
+    const double dt = 1.2 * BENCHMARK_DURATION / BENCHMARK_EVALUATIONS;
+
+    // warm up
+    evaluate(0.0);
+
+    std::size_t allocations_begin = allocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < BENCHMARK_EVALUATIONS; i++)
+	evaluate(i * dt);
+    auto end = std::chrono::steady_clock::now();
+    std::size_t calls_allocations = allocations.load() - allocations_begin;
+
+    double elapsed = std::chrono::duration<double>(end - begin).count();
+    std::printf("%-24s %14.1f %18.3f\n", name,
+		elapsed / BENCHMARK_EVALUATIONS * 1e9,
+		static_cast<double>(calls_allocations) / BENCHMARK_EVALUATIONS);
+}
+
+int main()
+{
+    yarp::sig::Vector pos_i(3);
+    yarp::sig::Vector pos_f(3);
+    pos_i[0] = -0.35; pos_i[1] = 0.05; pos_i[2] = 0.10;
+    pos_f[0] = -0.25; pos_f[1] = 0.05; pos_f[2] = 0.10;
+
+    VectorQuintic reference(pos_i, pos_f, BENCHMARK_DURATION);
+
+    TrajectoryGenerator generator;
+    generator.setInitialPosition(pos_i);
+    generator.setFinalPosition(pos_f);
+    generator.setDuration(BENCHMARK_DURATION);
+    generator.init();
+
+    constexpr RestToRestQuintic profile(BENCHMARK_DURATION);
+    PolynomialTrajectory<3, 5> trajectory;
+    trajectory.setRestToRest(pos_i.data(), pos_f.data(), profile);
+
+    JerkLimitedTrajectory jerk_limited;
+    jerk_limited.setLimits(0.08, 0.1, 0.5);
+    jerk_limited.plan(std::vector<yarp::sig::Vector>{pos_i, pos_f});
+
+    // check that the implementations agree
+    yarp::sig::Vector ref_pos(3), ref_vel(3), pos(3), vel(3);
+    double max_error = 0.0;
+    for (std::size_t i = 0; i <= 1000; i++)
+    {
+	double t = i * BENCHMARK_DURATION / 1000;
+	reference.getTrajectory(t, ref_pos, ref_vel);
+	generator.getTrajectory(t, pos, vel);
+	for (std::size_t j = 0; j < 3; j++)
+	    max_error = std::max(max_error, std::max(std::abs(pos[j] - ref_pos[j]),
+						     std::abs(vel[j] - ref_vel[j])));
+    }
+    std::printf("maximum difference w.r.t. the reference: %.3e\n\n", max_error);
+
+    // results are accumulated in order
+    // not to let the compiler discard the evaluations
+    double sink = 0.0;
+
+    std::printf("%-24s %14s %18s\n", "implementation", "time [ns]", "allocations / call");
+
+    measure("yarp::sig::Vector", [&](const double &t)
+	    {
+		reference.getTrajectory(t, pos, vel);
+		sink += vel[0];
+	    });
+
+    measure("TrajectoryGenerator", [&](const double &t)
+	    {
+		generator.getTrajectory(t, pos, vel);
+		sink += vel[0];
+	    });
+
+    double p[3];
+    double v[3];
+    measure("PolynomialTrajectory", [&](const double &t)
+	    {
+		trajectory.evaluate(t, p, v);
+		sink += v[0];
+	    });
+
+    measure("JerkLimitedTrajectory", [&](const double &t)
+	    {
+		jerk_limited.getTrajectory(t, pos, vel);
+		sink += vel[0];
+	    });
+
+    // sample the whole trajectory
+    const std::size_t count = static_cast<std::size_t>(BENCHMARK_DURATION * BENCHMARK_SAMPLING_RATE) + 1;
+    std::vector<double> times(count);
+    for (std::size_t k = 0; k < count; k++)
+	times[k] = static_cast<double>(k) / BENCHMARK_SAMPLING_RATE;
+    std::vector<double> positions(3 * count);
+    std::vector<double> velocities(3 * count);
+
+    // check that the batch evaluation agrees
+    generator.getTrajectory(times.data(), count, positions.data(), velocities.data());
+    max_error = 0.0;
+    for (std::size_t k = 0; k < count; k++)
+    {
+	generator.getTrajectory(times[k], pos, vel);
+	for (std::size_t j = 0; j < 3; j++)
+	    max_error = std::max(max_error, std::max(std::abs(positions[j * count + k] - pos[j]),
+						     std::abs(velocities[j * count + k] - vel[j])));
+    }
+    std::printf("\nmaximum difference of the batch evaluation: %.3e\n\n", max_error);
+
+    std::printf("%-24s %14s %18s\n", "sampling of the push", "time [us]", "allocations / call");
+
+    std::size_t allocations_begin = allocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < BENCHMARK_REPETITIONS; r++)
+    {
+	for (std::size_t k = 0; k < count; k++)
+	{
+	    generator.getTrajectory(times[k], pos, vel);
+	    positions[k] = pos[0];
+	    velocities[k] = vel[0];
+	}
+	sink += velocities[count / 2];
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %14.2f %18.3f\n", "one call per sample",
+		std::chrono::duration<double>(end - begin).count() / BENCHMARK_REPETITIONS * 1e6,
+		static_cast<double>(allocations.load() - allocations_begin) / BENCHMARK_REPETITIONS);
+
+    allocations_begin = allocations.load();
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < BENCHMARK_REPETITIONS; r++)
+    {
+	generator.getTrajectory(times.data(), count, positions.data(), velocities.data());
+	sink += velocities[count / 2];
+    }
+    end = std::chrono::steady_clock::now();
+    std::printf("%-24s %14.2f %18.3f\n", "batch",
+		std::chrono::duration<double>(end - begin).count() / BENCHMARK_REPETITIONS * 1e6,
+		static_cast<double>(allocations.load() - allocations_begin) / BENCHMARK_REPETITIONS);
+
+    std::printf("\n(checksum %g)\n", sink);
+
+    return 0;
+}
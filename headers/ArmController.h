@@ -22,7 +22,9 @@
 #include <iCub/iKin/iKinFwd.h>
 
 // std
+#include <map>
 #include <string>
+#include <vector>
 
 class ArmController
 {
@@ -59,15 +61,102 @@ protected:
 
     // whether the finger tip is attached to the chain or not
     bool is_tip_attached;
+
+    // finger chains built once and the last tip evaluated
+    // for each finger, keyed on the quantized joints of the finger
+    struct FingerTip
+    {
+	iCub::iKin::iCubFinger chain;
+	std::vector<int> key;
+	yarp::sig::Vector tip_x;
+	bool is_valid;
+    };
+    std::map<std::string, FingerTip> finger_tips;
+
+    // quantization of the joints of the fingers in degrees
+    double tip_quantization;
+
+    // name and key of the attached tip
+    std::string attached_finger;
+    std::vector<int> attached_key;
+
+    // the same when the context was stored
+    // since restoring the context restores the tip
+    bool stored_is_tip_attached;
+    std::string stored_finger;
+    std::vector<int> stored_key;
+
+    // status of the homing started by startGoHome()
+    // and context to be restored when it ends
+    bool is_homing;
+    int home_context;
+    bool home_is_tip_attached;
+    std::string home_finger;
+    std::vector<int> home_key;
+
+    /*
+     * Open the cartesian controller and store the home pose,
+     * waiting for the controller to be ready.
+     * @return true/false on success/failure
+     */
+    bool openCartesian(const bool &use_sim_controller,
+		       const std::string &clock_master,
+		       const std::string &prefix);
+
+    /*
+     * Open the drivers of the encoders of the arm and of the torso,
+     * waiting for the control boards to be ready.
+     * @return true/false on success/failure
+     */
+    bool openEncoders(const std::string &prefix);
+
+    /*
+     * Restore the context stored by startGoHome()
+     * and the status of the tip.
+     * @return true/false on success/failure
+     */
+    bool finishGoHome();
+
+    /*
+     * Instantiate the chains of the fingers of the arm.
+     */
+    void initFingerTips();
+
+    /*
+     * Read the encoders of the arm, attach and remove the tip
+     * of the cartesian controller. These are the only calls to
+     * the drivers required to attach a tip, hence they are
+     * virtual so that the tests can replace the drivers.
+     * @return true/false on success/failure
+     */
+    virtual bool readArmEncoders(yarp::sig::Vector &encs);
+    virtual bool attachTip(const yarp::sig::Vector &x, const yarp::sig::Vector &o);
+    virtual bool removeTip();
+
+    // storage reused to evaluate the tip
+    yarp::sig::Vector arm_encs;
+    yarp::sig::Vector finger_joints;
+    std::vector<int> finger_key;
+    yarp::sig::Vector tip_attitude;
     
 public:
+    virtual ~ArmController() { }
+
     
     /*
      * Configure the arm.
      * @param which_arm which arm to be used, right or left
+     * @param use_sim_controller whether to use the kinematic controller
+     * simcartesiancontroller instead of the iKinCartesianSolver
+     * @param clock_master the acknowledgment port of the clock master
+     * driving the kinematic controller, empty if not stepped
+     * @param prefix the namespace prepended to the names of the ports
      * @return true/false on success/fail
      */
-    bool configure(const std::string& which_arm);
+    bool configure(const std::string& which_arm,
+		   const bool& use_sim_controller = false,
+		   const std::string& clock_master = "",
+		   const std::string& prefix = "");
 
     /*
      * Stop the controller, restore the startup context,
@@ -115,6 +204,9 @@ public:
     /*
      * This function attach a tip to the end effector
      * so that the controlled point becomes one of finger of the hand.
+     * The tip is evaluated again only if the joints of the finger changed
+     * more than the quantization step and it is sent to the cartesian
+     * controller only if it differs from the one already attached.
      * @param finger_name the name of the finger
      * @return true/false on success/failure
      */
@@ -135,10 +227,34 @@ public:
 
     /*
      * This function restore the initial pose of the arm.
+     * It blocks until the motion is done.
      * @return true/false on success/failure
      */
     bool goHome();
 
+    /*
+     * Start restoring the initial pose of the arm without waiting.
+     * The completion has to be checked using checkGoHomeDone(),
+     * which restores the context of the cartesian controller.
+     * @return true/false on success/failure
+     */
+    bool startGoHome();
+
+    /*
+     * Check if the homing started by startGoHome() is done
+     * and in case restore the previous context.
+     * @param is_done whether the homing is done or not, true if no homing is running
+     * @return true/false on success/failure
+     */
+    bool checkGoHomeDone(bool &is_done);
+
+    /*
+     * Stop the homing started by startGoHome(), if any,
+     * and restore the previous context.
+     * @return true/false on success/failure
+     */
+    bool stopGoHome();
+
     /*
      * Call the method goToPoseSync of the underlying cartesian controller
      * using the given position and the hand attitude stored in this->
@@ -162,13 +278,17 @@ public:
 class RightArmController : public ArmController
 {
 public:
-    bool configure();
+    bool configure(const bool &use_sim_controller = false,
+		   const std::string &clock_master = "",
+		   const std::string &prefix = "");
 };
 
 class LeftArmController : public ArmController
 {
 public:
-    bool configure();
+    bool configure(const bool &use_sim_controller = false,
+		   const std::string &clock_master = "",
+		   const std::string &prefix = "");
 };
 
 #endif
@@ -0,0 +1,165 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef CLOCK_MASTER_MODULE_H
+#define CLOCK_MASTER_MODULE_H
+
+// yarp
+#include <yarp/os/RFModule.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/os/Semaphore.h>
+
+// std
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+class ClockMasterModule;
+
+/*
+ * Port receiving the acknowledgments of the participants.
+ */
+class ClockAckPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+    ClockMasterModule *master;
+
+public:
+    void setMaster(ClockMasterModule *master);
+    void onRead(yarp::os::Bottle &ack) override;
+};
+
+/*
+ * Stepped clock published on /clock.
+ *
+ * Each participant, i.e. an instance of ClockParticipant, acknowledges
+ * the end of its cycle together with the time at which it has to run
+ * again. The clock is advanced to the earliest of these times as soon as
+ * all the participants are waiting, hence the simulation runs as fast
+ * as the participants allow. Until all the expected participants have
+ * joined the clock runs in real time.
+ */
+class ClockMasterModule : public yarp::os::RFModule
+{
+private:
+    struct Participant
+    {
+	// time at which the participant runs again in nanoseconds
+	int64_t wake_time;
+
+	// whether the participant missed the acknowledgment timeout
+	bool is_late;
+    };
+
+    // ports
+    ClockAckPort port_ack;
+    yarp::os::BufferedPort<yarp::os::Bottle> port_clock;
+    yarp::os::BufferedPort<yarp::os::Bottle> port_stats;
+
+    // participants
+    std::map<std::string, Participant> participants;
+    std::set<std::string> expected;
+    std::set<std::string> joined;
+
+    // mutex required to share the participants between
+    // the RFModule thread and the port callback
+    yarp::os::Mutex mutex;
+
+    // signaled on each acknowledgment
+    yarp::os::Semaphore semaphore;
+
+    // current time in nanoseconds
+    int64_t now;
+
+    // step used in real time mode and maximum step
+    // in stepped mode in nanoseconds
+    int64_t step;
+    int64_t max_step;
+
+    // maximum speed-up, zero if not limited
+    double max_speed_up;
+
+    // time after which a participant that did not acknowledge
+    // its cycle is ignored, in seconds of real time
+    double ack_timeout;
+
+    // real time of the last tick
+    double tick_wall_time;
+
+    // speed-up measurement
+    double report_period;
+    int64_t start_time;
+    double start_wall_time;
+    int64_t report_time;
+    double report_wall_time;
+    int64_t ticks;
+
+    /*
+     * Publish the current time.
+     */
+    void publishTime();
+
+    /*
+     * Publish and print the achieved speed-up.
+     * @param wall_now the current real time
+     */
+    void reportSpeedUp(const double &wall_now);
+
+    /*
+     * Evaluate the next time of the clock.
+     * Assumes that the mutex is held.
+     * @param wall_now the current real time
+     * @return the next time in nanoseconds, negative if the clock cannot be advanced
+     */
+    int64_t nextTime(const double &wall_now);
+
+public:
+    ClockMasterModule();
+
+    /*
+     * Store the acknowledgment of a participant.
+     * @param name the name of the participant
+     * @param wake_time the time at which the participant runs again,
+     *        negative if the participant leaves
+     */
+    void acknowledge(const std::string &name, const double &wake_time);
+
+    /*
+     * Configure the module.
+     * @param rf a previously instantiated @see ResourceFinder
+     */
+    bool configure(yarp::os::ResourceFinder &rf) override;
+
+    /*
+     * Return the module period.
+     */
+    double getPeriod() override;
+
+    /*
+     * Define the behavior of this module.
+     */
+    bool updateModule() override;
+
+    /*
+     * Define the interrupt behavior.
+     */
+    bool interruptModule() override;
+
+    /*
+     * Define the cleanup behavior.
+     */
+    bool close() override;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef CLOCK_PARTICIPANT_H
+#define CLOCK_PARTICIPANT_H
+
+// yarp
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+
+// std
+#include <string>
+
+/*
+ * Participant of the stepped clock published by clock_master.
+ *
+ * At the end of each cycle the participant notifies the master
+ * the time at which it has to run again. The master advances the
+ * clock only when all the participants are waiting, hence the cycles
+ * take no simulated time and the clock runs as fast as the slowest
+ * participant allows.
+ *
+ * If the participant is not configured with the port of the master
+ * all the methods have no effect.
+ */
+class ClockParticipant
+{
+private:
+    // port connected to the master
+    yarp::os::BufferedPort<yarp::os::Bottle> port;
+
+    // name of the participant
+    std::string name;
+
+    bool is_enabled;
+
+public:
+    ClockParticipant();
+
+    /*
+     * Configure the participant.
+     * @param name the name of the participant
+     * @param master_port the acknowledgment port of the master,
+     *        an empty string disables the participant
+     * @param prefix the namespace prepended to the name of the port
+     * @return true/false on success/failure
+     */
+    bool configure(const std::string &name, const std::string &master_port,
+		   const std::string &prefix = "");
+
+    /*
+     * Return true if the participant is connected to a master.
+     */
+    bool isEnabled() const;
+
+    /*
+     * Notify the master that the current cycle is finished.
+     * @param wake_time the time at which the next cycle starts
+     */
+    void cycleDone(const double &wake_time);
+
+    /*
+     * Leave the clock and close the port.
+     */
+    void close();
+};
+
+#endif
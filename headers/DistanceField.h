@@ -0,0 +1,161 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "headers/MeshModel.h"
+
+/*
+ * Signed distance from the surface of an object,
+ * negative inside the object, expressed in the object frame.
+ */
+class DistanceField
+{
+public:
+    virtual ~DistanceField() { }
+
+    /*
+     * Return the signed distance of a point.
+     * @param p the point
+     */
+    virtual float distance(const float p[3]) const = 0;
+
+    /*
+     * Evaluate the signed distance of several points
+     * stored as columns, e.g. those of a SoAPointCloud.
+     * @param x the x coordinates of the points
+     * @param y the y coordinates of the points
+     * @param z the z coordinates of the points
+     * @param n the number of points
+     * @param d the distances
+     */
+    virtual void distance(const float *x, const float *y, const float *z,
+			  const std::size_t &n, float *d) const;
+};
+
+/*
+ * Analytic distance field of a box centered in the origin
+ * of its frame and aligned with its axes.
+ */
+class BoxDistanceField : public DistanceField
+{
+private:
+    float half_size[3];
+
+public:
+    /*
+     * Constructor
+     * @param width the size of the box along the x axis
+     * @param depth the size of the box along the y axis
+     * @param height the size of the box along the z axis
+     */
+    BoxDistanceField(const double &width,
+		     const double &depth,
+		     const double &height);
+
+    float distance(const float p[3]) const override;
+
+    void distance(const float *x, const float *y, const float *z,
+		  const std::size_t &n, float *d) const override;
+};
+
+/*
+ * Header of a .sdfgrid file.
+ * The values follow the header with x varying fastest.
+ */
+#define SDF_GRID_MAGIC 0x444c5456 // 'VTLD'
+#define SDF_GRID_VERSION 1
+
+// each side of the grid has at least two samples
+// and the grid at most 2^28 samples, i.e. 1 GiB
+#define SDF_GRID_MIN_SIZE 2
+#define SDF_GRID_MAX_CELLS (std::size_t(1) << 28)
+
+struct SdfGridHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size[3];
+    float origin[3];
+    float spacing;
+    uint32_t reserved;
+};
+
+/*
+ * Distance field sampled on a dense regular grid
+ * and evaluated using trilinear interpolation.
+ *
+ * Outside the grid the distance is approximated adding
+ * the distance from the grid to the value at its border.
+ */
+class GridDistanceField : public DistanceField
+{
+private:
+    std::size_t size[3];
+    float origin[3];
+    float spacing;
+    std::vector<float> values;
+
+    /*
+     * Return the value stored in a cell.
+     */
+    inline float value(const std::size_t &i,
+		       const std::size_t &j,
+		       const std::size_t &k) const
+    {
+	return values[(k * size[1] + j) * size[0] + i];
+    }
+
+public:
+    /*
+     * Constructor
+     */
+    GridDistanceField();
+
+    /*
+     * Sample the distance field of a mesh.
+     * The sign is evaluated by majority vote of the parity
+     * of the intersections of three rays with the mesh, hence
+     * the mesh is expected to be closed.
+     * @param mesh the mesh
+     * @param spacing the size of the cells
+     * @param padding the space between the mesh and the border of the grid
+     * @return true/false on success/failure
+     */
+    bool generate(const MeshModel &mesh,
+		  const double &spacing,
+		  const double &padding);
+
+    /*
+     * Load a grid from a .sdfgrid file.
+     * @param file_name the path of the file
+     * @return true/false on success/failure
+     */
+    bool load(const std::string &file_name);
+
+    /*
+     * Save the grid to a .sdfgrid file.
+     * @param file_name the path of the file
+     * @return true/false on success/failure
+     */
+    bool save(const std::string &file_name) const;
+
+    float distance(const float p[3]) const override;
+};
+
+#endif
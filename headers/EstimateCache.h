@@ -0,0 +1,162 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef ESTIMATE_CACHE_H
+#define ESTIMATE_CACHE_H
+
+// yarp
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/sig/Matrix.h>
+
+// std
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Timestamped pose stored in the cache.
+ */
+struct TimedPose
+{
+    double timestamp;
+    double pos[3];
+    // quaternion (w, x, y, z)
+    double quat[4];
+};
+
+/*
+ * Fixed capacity ring buffer of timestamped estimates.
+ * Estimates are expected to be pushed in chronological order,
+ * older or duplicated estimates are discarded.
+ *
+ * The cache can be shared between the thread pushing the estimates
+ * and the threads reading them.
+ */
+class EstimateCache
+{
+private:
+    // storage
+    std::vector<TimedPose> buffer;
+    std::size_t head;
+    std::size_t count;
+
+    // mutex required to share the cache between threads
+    mutable yarp::os::Mutex mutex;
+
+    /*
+     * Return the i-th oldest pose.
+     */
+    const TimedPose& get(const std::size_t &i) const;
+
+    /*
+     * Convert a pose to an homogeneous transformation.
+     */
+    static void toMatrix(const TimedPose &pose, yarp::sig::Matrix &matrix);
+
+public:
+    /*
+     * Constructor
+     * @param capacity the number of estimates retained
+     */
+    EstimateCache(const std::size_t &capacity = 256);
+
+    /*
+     * Push a new estimate.
+     * @param timestamp the time of the estimate
+     * @param pose the estimate as an homogeneous transformation
+     * @return true if the estimate was stored
+     */
+    bool push(const double &timestamp, const yarp::sig::Matrix &pose);
+
+    /*
+     * Push a new estimate.
+     * @param pose the estimate
+     * @return true if the estimate was stored
+     */
+    bool push(const TimedPose &pose);
+
+    /*
+     * Remove all the estimates.
+     */
+    void clear();
+
+    /*
+     * Return the number of estimates stored.
+     */
+    std::size_t size() const;
+
+    /*
+     * Get the latest estimate.
+     * @param pose the estimate as an homogeneous transformation
+     * @param timestamp optional output for the time of the estimate
+     * @return false if no estimate is available
+     */
+    bool latest(yarp::sig::Matrix &pose, double *timestamp = nullptr) const;
+
+    /*
+     * Get the estimate at a given time interpolating the stored
+     * estimates, SLERP is used for the rotation and linear interpolation
+     * for the position. Times after the latest estimate return the latest
+     * estimate, no extrapolation is performed.
+     * @param time the time
+     * @param pose the estimate as an homogeneous transformation
+     * @return false if no estimate is available or the time
+     *         is older than the oldest estimate stored
+     */
+    bool at(const double &time, yarp::sig::Matrix &pose) const;
+
+    /*
+     * Return the age of the latest estimate w.r.t. the given time,
+     * a negative value if no estimate is available.
+     * @param now the current time
+     */
+    double ageOfLatest(const double &now) const;
+};
+
+/*
+ * Port receiving the transforms streamed by the FrameTransformServer
+ * on /transformServer/transforms:o and pushing those matching the
+ * requested frames into the EstimateCache of the corresponding object.
+ * Targets are added before the callback is enabled.
+ */
+class EstimateSubscriber : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+    // caches indexed by target frame
+    std::map<std::string, EstimateCache*> caches;
+    std::string source_frame;
+
+public:
+    /*
+     * Constructor
+     */
+    EstimateSubscriber();
+
+    /*
+     * Configure the subscriber.
+     * @param source_frame the source frame, e.g. /iCub/frame
+     */
+    void configure(const std::string &source_frame);
+
+    /*
+     * Add a target frame.
+     * @param cache the cache where estimates are pushed
+     * @param target_frame the target frame, e.g. /box_alt/estimate/frame
+     */
+    void addTarget(EstimateCache *cache, const std::string &target_frame);
+
+    void onRead(yarp::os::Bottle &transforms) override;
+};
+
+#endif
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+// yarp
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/dev/CartesianControl.h>
+
+// std
+#include <deque>
+#include <string>
+
+enum class EventType { Wake,
+		       ArmMotionDone,
+		       FingersApproachDone,
+		       FingersRestoreDone };
+
+struct Event
+{
+    EventType type;
+    // the arm or hand that produced the event
+    std::string source;
+    double timestamp;
+};
+
+/*
+ * Thread safe queue of events.
+ * The consumer blocks until an event is posted or a timeout expires.
+ */
+class EventQueue
+{
+private:
+    std::deque<Event> events;
+
+    // mutex protecting the queue
+    yarp::os::Mutex mutex;
+
+    // counts the events in the queue
+    yarp::os::Semaphore semaphore;
+
+public:
+    /*
+     * Constructor
+     */
+    EventQueue();
+
+    /*
+     * Post an event and wake the consumer.
+     * @param event the event
+     */
+    void post(const Event &event);
+
+    /*
+     * Post an event of type Wake.
+     */
+    void wake();
+
+    /*
+     * Wait for the next event.
+     * @param event the event
+     * @param timeout the timeout in seconds, a negative value to wait forever
+     * @return false if the timeout expired
+     */
+    bool wait(Event &event, const double &timeout);
+
+    /*
+     * Take the next event, if any, without blocking.
+     * @param event the event
+     * @return false if the queue is empty
+     */
+    bool poll(Event &event);
+};
+
+/*
+ * Cartesian event posting an ArmMotionDone event
+ * when the motion of an arm is done.
+ */
+class ArmMotionDoneEvent : public yarp::dev::CartesianEvent
+{
+private:
+    EventQueue &queue;
+    std::string which_arm;
+
+public:
+    /*
+     * Constructor
+     * @param queue the queue where events are posted
+     * @param which_arm the name of the arm
+     */
+    ArmMotionDoneEvent(EventQueue &queue, const std::string &which_arm);
+
+    void cartesianEventCallback() override;
+};
+
+/*
+ * Port receiving the status published by a hand control module
+ * and posting FingersApproachDone and FingersRestoreDone events.
+ */
+class HandStatusPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+    EventQueue *queue;
+    std::string which_hand;
+
+public:
+    /*
+     * Constructor
+     */
+    HandStatusPort();
+
+    /*
+     * Configure the port.
+     * @param queue the queue where events are posted
+     * @param which_hand the name of the hand
+     */
+    void configure(EventQueue *queue, const std::string &which_hand);
+
+    void onRead(yarp::os::Bottle &status) override;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef EXPERIMENT_RUNNER_H
+#define EXPERIMENT_RUNNER_H
+
+// yarp
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/RpcClient.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/IFrameTransform.h>
+
+// std
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "headers/ObjectRegistry.h"
+
+/*
+ * Outcome of a trial.
+ */
+struct TrialResult
+{
+    int trial;
+
+    // final state of the pipeline
+    bool is_success;
+    std::string pipeline_state;
+
+    // duration on the module clock and on the system clock
+    double duration;
+    double wall_duration;
+
+    // ratio between the two durations,
+    // greater than one when running on a stepped clock
+    double speed_up;
+
+    // error of the final estimate w.r.t. the ground truth,
+    // negative if not available
+    double position_error;
+    double angle_error;
+
+    // number of contact lists received,
+    // fraction of lists containing contacts and
+    // mean number of contacts in those lists
+    int contact_samples;
+    double contact_ratio;
+    double mean_contacts;
+};
+
+/*
+ * Port counting the contacts published by a skin manager.
+ */
+class ContactsCounterPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+    std::atomic<int> samples;
+    std::atomic<int> samples_in_contact;
+    std::atomic<int> contacts;
+
+public:
+    /*
+     * Constructor
+     */
+    ContactsCounterPort();
+
+    /*
+     * Reset the counters.
+     */
+    void reset();
+
+    /*
+     * Get the counters.
+     * @param samples the number of contact lists received
+     * @param samples_in_contact the number of non empty lists
+     * @param contacts the total number of contacts
+     */
+    void getCounters(int &samples, int &samples_in_contact, int &contacts) const;
+
+    void onRead(yarp::os::Bottle &contacts_list) override;
+};
+
+/*
+ * Interface to the simulated world.
+ */
+class ExperimentBackend
+{
+public:
+    virtual ~ExperimentBackend() { }
+
+    /*
+     * Configure the backend.
+     * @param group the group of the backend within the configuration
+     * @param object the description of the object within the scene
+     * @param prefix the namespace prepended to the names of the ports
+     * @return true/false on success/failure
+     */
+    virtual bool configure(const yarp::os::Bottle &group, const ObjectDescription &object,
+			   const std::string &prefix) = 0;
+
+    /*
+     * Reset the object to its initial pose.
+     * @return true/false on success/failure
+     */
+    virtual bool resetObject() = 0;
+
+    /*
+     * Get the ground truth pose of the object.
+     * @param pose the pose as an homogeneous transformation
+     * @return true/false on success/failure
+     */
+    virtual bool getGroundTruth(yarp::sig::Matrix &pose) = 0;
+
+    virtual void close() = 0;
+};
+
+/*
+ * Backend using the plugins GazeboYarpModelReset,
+ * to reset the object, and GazeboYarpModelPosePublisher,
+ * to get the ground truth from the FrameTransformServer.
+ */
+class GazeboBackend : public ExperimentBackend
+{
+private:
+    // port connected to the GazeboYarpModelReset plugin
+    yarp::os::RpcClient port_reset;
+    std::string reset_command;
+
+    // FrameTransformClient to read the ground truth
+    yarp::dev::PolyDriver drv_transform_client;
+    yarp::dev::IFrameTransform* tf_client;
+
+    // name of the frames
+    std::string ground_truth_frame;
+    std::string root_frame;
+
+public:
+    bool configure(const yarp::os::Bottle &group, const ObjectDescription &object,
+		   const std::string &prefix) override;
+    bool resetObject() override;
+    bool getGroundTruth(yarp::sig::Matrix &pose) override;
+    void close() override;
+};
+
+/*
+ * Backend not requiring Gazebo.
+ * Without physics the object is not moved by the robot,
+ * hence it is always at the initial pose given in the configuration.
+ */
+class LocalBackend : public ExperimentBackend
+{
+private:
+    yarp::sig::Matrix initial_pose;
+
+public:
+    bool configure(const yarp::os::Bottle &group, const ObjectDescription &object,
+		   const std::string &prefix) override;
+    bool resetObject() override;
+    bool getGroundTruth(yarp::sig::Matrix &pose) override;
+    void close() override;
+};
+
+/*
+ * Run several trials of a pipeline of the module
+ * visual-tactile-localization-sim, resetting the object
+ * between trials, and write the results in a csv file.
+ */
+class ExperimentRunner
+{
+private:
+    // backend
+    std::unique_ptr<ExperimentBackend> backend;
+
+    // rpc port of the module
+    yarp::os::RpcClient port_service;
+
+    // contacts ports
+    std::vector<std::unique_ptr<ContactsCounterPort>> ports_contacts;
+
+    // object and steps of the trials
+    std::string object;
+    yarp::os::Bottle steps;
+    yarp::os::Bottle restore_steps;
+
+    // number of trials
+    int trials;
+
+    // timing
+    double trial_timeout;
+    double reset_delay;
+    double poll_period;
+
+    // results
+    std::ofstream results;
+
+    /*
+     * Run a pipeline of the module and wait for its completion.
+     * @param steps the steps of the pipeline
+     * @param timeout the timeout in seconds
+     * @param state the final state of the pipeline
+     * @return true if the pipeline is done
+     */
+    bool runPipeline(const yarp::os::Bottle &steps,
+		     const double &timeout,
+		     std::string &state);
+
+    /*
+     * Get the latest estimate of the object from the module.
+     * @param pose the estimate as an homogeneous transformation
+     * @return true/false on success/failure
+     */
+    bool getEstimate(yarp::sig::Matrix &pose);
+
+    /*
+     * Run a trial.
+     * @param result the outcome of the trial
+     * @return false if the experiment cannot continue
+     */
+    bool runTrial(TrialResult &result);
+
+    /*
+     * Append the outcome of a trial to the results.
+     * @param result the outcome of the trial
+     */
+    void writeResult(const TrialResult &result);
+
+public:
+    /*
+     * Configure the runner.
+     * @param rf a previously instantiated @see ResourceFinder
+     * @return true/false on success/failure
+     */
+    bool configure(yarp::os::ResourceFinder &rf);
+
+    /*
+     * Run all the trials.
+     * @return true if all the trials were executed
+     */
+    bool run();
+
+    void close();
+};
+
+#endif
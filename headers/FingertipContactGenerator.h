@@ -0,0 +1,102 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef FINGERTIP_CONTACT_GENERATOR_H
+#define FINGERTIP_CONTACT_GENERATOR_H
+
+// yarp
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+// icub-main
+#include <iCub/iKin/iKinFwd.h>
+#include <iCub/skinDynLib/skinContactList.h>
+
+// std
+#include <string>
+#include <vector>
+
+/*
+ * Geometric contact generator between the finger tips
+ * of a hand and a box.
+ *
+ * A contact is generated for each finger tip whose distance
+ * from the surface of the box is below a threshold. The contacts
+ * carry the taxel ids of the corresponding finger tip, i.e.
+ * 0-11 index, 12-23 middle, 24-35 ring, 36-47 little, 48-59 thumb,
+ * as published by the skinManager.
+ */
+class FingertipContactGenerator
+{
+private:
+    // chain of the arm including the torso
+    iCub::iKin::iCubArm arm_chain;
+
+    // chains of the fingers and first taxel of each finger tip
+    std::vector<iCub::iKin::iCubFinger> fingers;
+    std::vector<unsigned int> taxel_bases;
+
+    // which hand
+    std::string hand_name;
+
+    // pose of the center of the box
+    // with respect to the robot root frame
+    yarp::sig::Matrix object_pose;
+    yarp::sig::Matrix object_pose_inv;
+
+    // half sizes of the box along the axes of its frame
+    yarp::sig::Vector half_sizes;
+
+    // distance below which a contact is generated
+    double threshold;
+
+    /*
+     * Evaluate the signed distance of a point from the box.
+     * @param point the point expressed in the frame of the box
+     * @param closest the closest point on the surface
+     * @param normal the outward normal of the surface at the closest point
+     * @return the signed distance, negative within the box
+     */
+    double boxDistance(const yarp::sig::Vector &point,
+		       yarp::sig::Vector &closest,
+		       yarp::sig::Vector &normal) const;
+
+public:
+    /*
+     * Configure the generator.
+     * @param hand_name the name of the hand, right or left
+     * @param dimensions the dimensions of the box (width depth height)
+     * @param threshold the distance below which a contact is generated
+     * @return true/false on success/failure
+     */
+    bool configure(const std::string &hand_name,
+		   const yarp::sig::Vector &dimensions,
+		   const double &threshold);
+
+    /*
+     * Set the pose of the box.
+     * @param pose the pose of the center of the box as an homogeneous
+     * transformation with respect to the robot root frame
+     */
+    void setObjectPose(const yarp::sig::Matrix &pose);
+
+    /*
+     * Generate the contacts.
+     * @param encs_torso the encoders of the torso in degrees
+     * @param encs_arm the encoders of the arm in degrees
+     * @param contacts the list of the contacts
+     */
+    void generate(const yarp::sig::Vector &encs_torso,
+		  const yarp::sig::Vector &encs_arm,
+		  iCub::skinDynLib::skinContactList &contacts);
+};
+
+#endif
@@ -18,6 +18,8 @@
 #include <yarp/os/Mutex.h>
 #include <yarp/os/PortReader.h>
 #include <yarp/os/ConnectionReader.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
 
 // icub-main
 #include <iCub/skinDynLib/skinContactList.h>
@@ -28,6 +30,7 @@
 #include "headers/HandController.h"
 #include "headers/HandControlCommand.h"
 #include "headers/HandControlResponse.h"
+#include "headers/ClockParticipant.h"
 
 class HandControlModule : public yarp::os::RFModule, public yarp::os::PortReader
 {
@@ -45,6 +48,11 @@ private:
     // command port
     std::string port_rpc_name;
 
+    // status port
+    // used to notify the completion of approach and restore
+    yarp::os::BufferedPort<yarp::os::Bottle> port_status;
+    std::string port_status_name;
+
     // current command
     Command current_command;
 
@@ -62,6 +70,9 @@ private:
     // period
     double period;
 
+    // participant of the stepped clock, if any
+    ClockParticipant clock;
+
     // status
     bool is_approach_done;
     bool is_restore_done;
@@ -96,6 +107,22 @@ private:
     */
     void stopControl();
 
+   /*
+    * Publish an event on the status port
+    * @param event the event, i.e. 'approach-done' or 'restore-done'
+    */
+    void publishStatus(const std::string &event);
+
+   /*
+    * Open the contacts, rpc and status ports
+    */
+    bool openPorts();
+
+   /*
+    * Close the contacts, rpc and status ports
+    */
+    void closePorts();
+
 public:
     /*
      * Configure the module.
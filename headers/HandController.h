@@ -56,9 +56,11 @@ public:
     /*
      * Configure the hand controller.
      * @param hand_name is the name of the hand
+     * @param prefix is the namespace prepended to the names of the ports
      * @return true/false con success/failure
      */
-    bool configure(const std::string &hand_name);
+    bool configure(const std::string &hand_name,
+		   const std::string &prefix = "");
 
     /*
      * Close all the finger controllers and
@@ -132,13 +134,13 @@ public:
 class RightHandController : public HandController
 {
 public:
-    bool configure();
+    bool configure(const std::string &prefix = "");
 };
 
 class LeftHandController : public HandController
 {
 public:
-    bool configure();
+    bool configure(const std::string &prefix = "");
 };
 
 #endif
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef JERK_LIMITED_TRAJECTORY_H
+#define JERK_LIMITED_TRAJECTORY_H
+
+// yarp
+#include <yarp/sig/Vector.h>
+
+// std
+#include <vector>
+
+/*
+ * Minimum time trajectory of a 3D point through a sequence of waypoints
+ * with bounded velocity, acceleration and jerk.
+ *
+ * The path is the polyline through the waypoints. Each straight segment is
+ * covered with a rest-to-rest double S velocity profile, the minimum time
+ * profile under the three bounds. The point stops at each corner of the path,
+ * since the velocity cannot change direction instantaneously, while collinear
+ * waypoints are merged.
+ *
+ * The trajectory is sampled once when planned, hence getTrajectory()
+ * interpolates between two samples in constant time and does not allocate.
+ */
+class JerkLimitedTrajectory
+{
+private:
+    struct Segment
+    {
+	// initial point and unit direction
+	double start[3];
+	double direction[3];
+
+	// length of the segment
+	double length;
+
+	// time instant at which the segment starts
+	double start_time;
+
+	// duration of the jerk, acceleration and
+	// constant velocity phases of the double S profile
+	double jerk_time;
+	double acceleration_time;
+	double cruise_time;
+    };
+
+    // bounds on the norm of the velocity, acceleration and jerk
+    double max_velocity;
+    double max_acceleration;
+    double max_jerk;
+
+    // period of the samples
+    double sampling_period;
+
+    // total duration
+    double duration;
+
+    // segments of the path
+    std::vector<Segment> segments;
+
+    // samples stored as position and velocity
+    std::vector<double> samples;
+    std::size_t number_samples;
+
+    /*
+     * Evaluate the phases of the double S profile of a segment.
+     * @param segment the segment whose length is already set
+     */
+    void planSegment(Segment &segment) const;
+
+    /*
+     * Evaluate the curvilinear abscissa and its derivative along a segment.
+     * @param segment the segment
+     * @param time the time elapsed since the beginning of the segment
+     * @param s the abscissa
+     * @param s_dot the derivative of the abscissa
+     */
+    void evaluateSegment(const Segment &segment, const double &time,
+			 double &s, double &s_dot) const;
+
+public:
+    JerkLimitedTrajectory();
+
+    /*
+     * Set the bounds of the trajectory.
+     * @param velocity the maximum velocity in m/s
+     * @param acceleration the maximum acceleration in m/s^2
+     * @param jerk the maximum jerk in m/s^3
+     * @return true/false on success/failure
+     */
+    bool setLimits(const double &velocity, const double &acceleration, const double &jerk);
+
+    /*
+     * Set the period of the samples.
+     * @param period the positive period in seconds
+     * @return true/false on success/failure
+     */
+    bool setSamplingPeriod(const double &period);
+
+    /*
+     * Plan and sample the trajectory.
+     * @param waypoints the 3x1 waypoints, the first one is the initial position
+     * @return true/false on success/failure
+     */
+    bool plan(const std::vector<yarp::sig::Vector> &waypoints);
+
+    /*
+     * Return the duration of the trajectory.
+     */
+    double getDuration() const;
+
+    /*
+     * Get the trajectory position and velocity at specified time.
+     * The vectors are resized only if their size is not 3.
+     * @param time the value of the time, saturated at the duration
+     * @param position the 3x1 position at the specified time
+     * @param velocity the 3x1 velocity at the specified time
+     * @return true/false on success/failure
+     */
+    bool getTrajectory(const double &time,
+		       yarp::sig::Vector &position,
+		       yarp::sig::Vector &velocity) const;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef KINEMATIC_SIM_MODULE_H
+#define KINEMATIC_SIM_MODULE_H
+
+// yarp
+#include <yarp/os/RFModule.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/dev/PolyDriver.h>
+
+// icub-main
+#include <iCub/skinDynLib/skinContactList.h>
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "headers/SimControlBoard.h"
+#include "headers/FingertipContactGenerator.h"
+#include "headers/ClockParticipant.h"
+
+/*
+ * Part of the robot simulated by a SimControlBoard
+ * and exposed on the network by a controlboardwrapper2.
+ */
+struct SimPart
+{
+    std::string name;
+    yarp::dev::PolyDriver drv_board;
+    yarp::dev::PolyDriver drv_wrapper;
+    SimControlBoard *board;
+};
+
+/*
+ * Kinematic simulation of the torso and of the arms of iCub
+ * standing in for Gazebo and yarprobotinterface.
+ *
+ * The control boards are exposed with the same names used by the
+ * simulator, e.g. /icubSim/right_arm, and the contacts between the
+ * finger tips and the box are published on the ports of the skinManager.
+ * The box is not moved by the robot.
+ */
+class KinematicSimModule : public yarp::os::RFModule
+{
+private:
+    // simulated parts
+    std::vector<std::unique_ptr<SimPart>> parts;
+
+    // contacts generators and ports
+    FingertipContactGenerator contacts_right;
+    FingertipContactGenerator contacts_left;
+    yarp::os::BufferedPort<iCub::skinDynLib::skinContactList> port_contacts_right;
+    yarp::os::BufferedPort<iCub::skinDynLib::skinContactList> port_contacts_left;
+
+    // period and time of the last step
+    double period;
+    double last_time;
+
+    // participant of the stepped clock, if any
+    ClockParticipant clock;
+
+    /*
+     * Open a simulated part.
+     * @param robot the prefix of the names of the control boards
+     * @param name the name of the part
+     * @param group the group of the part within the configuration
+     * @return true/false on success/failure
+     */
+    bool openPart(const std::string &robot,
+		  const std::string &name,
+		  yarp::os::Bottle &group);
+
+    /*
+     * Find a simulated part.
+     * @param name the name of the part
+     * @return a pointer to the control board of the part,
+     *         a null pointer if the part does not exist
+     */
+    SimControlBoard* findPart(const std::string &name);
+
+    /*
+     * Generate and publish the contacts of a hand.
+     */
+    void publishContacts(const std::string &arm_name,
+			 FingertipContactGenerator &generator,
+			 yarp::os::BufferedPort<iCub::skinDynLib::skinContactList> &port);
+
+public:
+    /*
+     * Configure the module.
+     * @param rf a previously instantiated @see ResourceFinder
+     */
+    bool configure(yarp::os::ResourceFinder &rf) override;
+
+    /*
+     * Return the module period.
+     */
+    double getPeriod() override;
+
+    /*
+     * Define the behavior of this module.
+     */
+    bool updateModule() override;
+
+    /*
+     * Define the cleanup behavior.
+     */
+    bool close() override;
+};
+
+#endif
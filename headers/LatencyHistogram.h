@@ -0,0 +1,160 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// yarp
+#include <yarp/os/Bottle.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+/*
+ * Histogram of durations with logarithmic buckets, in the style of HDR histograms.
+ *
+ * Durations are stored in microseconds. Each power of two is split
+ * in 32 linear sub buckets, hence the relative error is about 3%
+ * from 1 us up to about 70 minutes. Recording is lock free and
+ * can be done concurrently from any thread.
+ */
+class LatencyHistogram
+{
+private:
+    static const std::size_t sub_bucket_bits = 5;
+    static const std::size_t sub_bucket_count = 1 << sub_bucket_bits;
+    static const std::size_t bucket_count = (32 - sub_bucket_bits + 1) * sub_bucket_count;
+
+    std::atomic<std::uint64_t> counts[bucket_count];
+    std::atomic<std::uint64_t> total_count;
+    std::atomic<std::uint64_t> total_us;
+    std::atomic<std::uint64_t> min_us;
+    std::atomic<std::uint64_t> max_us;
+
+    /*
+     * Return the bucket of a value in microseconds.
+     */
+    static std::size_t bucketIndex(const std::uint64_t &value);
+
+    /*
+     * Return the value, in microseconds, at the center of a bucket.
+     */
+    static double bucketValue(const std::size_t &index);
+
+public:
+    /*
+     * Constructor
+     */
+    LatencyHistogram();
+
+    /*
+     * Record a duration.
+     * @param duration the duration in seconds
+     */
+    void record(const double &duration);
+
+    /*
+     * Discard all the recorded durations.
+     */
+    void reset();
+
+    /*
+     * Return the number of recorded durations.
+     */
+    std::uint64_t count() const;
+
+    /*
+     * Return the mean, the minimum and the maximum duration in seconds.
+     */
+    double mean() const;
+    double min() const;
+    double max() const;
+
+    /*
+     * Return a percentile in seconds.
+     * @param percentile the percentile in [0, 100]
+     */
+    double percentile(const double &percentile) const;
+};
+
+/*
+ * Collection of named latency histograms.
+ *
+ * Histograms are added during the configuration, afterwards
+ * the collection can be accessed concurrently without locks.
+ */
+class LatencyStats
+{
+private:
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+
+public:
+    /*
+     * Add a histogram.
+     * Not thread safe, to be used only during the configuration.
+     * @param name the name of the histogram
+     */
+    void add(const std::string &name);
+
+    /*
+     * Get a histogram.
+     * @param name the name of the histogram
+     * @return a pointer to the histogram, a null pointer if it does not exist
+     */
+    LatencyHistogram* get(const std::string &name) const;
+
+    /*
+     * Record a duration.
+     * @param name the name of the histogram
+     * @param duration the duration in seconds
+     */
+    void record(const std::string &name, const double &duration) const;
+
+    /*
+     * Discard all the recorded durations.
+     */
+    void reset();
+
+    /*
+     * Write the aggregates in a bottle as a list
+     * (name count mean p50 p90 p99 max) for each histogram,
+     * durations are in milliseconds.
+     * @param bottle the bottle
+     */
+    void toBottle(yarp::os::Bottle &bottle) const;
+};
+
+/*
+ * Record the lifetime of the object in a histogram.
+ * The system clock is used in order to measure real durations
+ * also when the module runs on the simulation clock.
+ */
+class ScopedLatency
+{
+private:
+    LatencyHistogram *histogram;
+    double start;
+
+public:
+    /*
+     * Constructor
+     * @param histogram the histogram, nothing is recorded if null
+     */
+    ScopedLatency(LatencyHistogram *histogram);
+
+    ~ScopedLatency();
+};
+
+#endif
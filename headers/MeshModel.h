@@ -0,0 +1,215 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef MESH_MODEL_H
+#define MESH_MODEL_H
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * The first time a mesh is loaded the OFF file is parsed and a binary cache
+ * is written next to it, i.e. <file>.bin. The cache is loaded again
+ * with a single mmap as long as the size and the modification time
+ * of the OFF file do not change.
+ *
+ * cache := header, vertices, faces, normals, areas, nodes
+ *
+ * Faces are sorted so that the faces of each leaf of the
+ * bounding volume hierarchy are contiguous.
+ */
+
+#define MESH_CACHE_MAGIC 0x4d4c5456 // 'VTLM'
+#define MESH_CACHE_VERSION 1
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    // size and modification time of the OFF file
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t n_vertices;
+    uint32_t n_faces;
+    uint32_t n_nodes;
+    uint32_t reserved;
+};
+
+/*
+ * Node of the flattened bounding volume hierarchy.
+ * Nodes are stored in depth first order, hence the left child
+ * of an internal node is the next node.
+ */
+struct MeshBVHNode
+{
+    float min[3];
+    float max[3];
+    // index of the first face for leaves,
+    // index of the right child for internal nodes
+    uint32_t offset;
+    // number of faces, 0 for internal nodes
+    uint32_t count;
+};
+
+class MeshModel
+{
+private:
+    // mapped cache
+    void *mapped;
+    std::size_t mapped_size;
+
+    // storage used when the cache cannot be written
+    std::vector<float> vertices_storage;
+    std::vector<uint32_t> faces_storage;
+    std::vector<float> normals_storage;
+    std::vector<float> areas_storage;
+    std::vector<MeshBVHNode> nodes_storage;
+
+    // data
+    std::size_t n_vertices;
+    std::size_t n_faces;
+    std::size_t n_nodes;
+    const float *vertices;
+    const uint32_t *faces;
+    const float *normals;
+    const float *areas;
+    const MeshBVHNode *nodes;
+
+    /*
+     * Parse an OFF file. Polygons are triangulated as fans.
+     */
+    bool parseOFF(const std::string &file_name,
+		  std::vector<float> &vertices,
+		  std::vector<uint32_t> &faces);
+
+    /*
+     * Evaluate normals and areas and build the hierarchy,
+     * faces are sorted accordingly.
+     */
+    void build(const std::vector<float> &vertices,
+	       std::vector<uint32_t> &faces,
+	       std::vector<float> &normals,
+	       std::vector<float> &areas,
+	       std::vector<MeshBVHNode> &nodes);
+
+    /*
+     * Check that the children and the faces of the nodes are within range
+     * and that the depth does not exceed the stack of the traversals.
+     */
+    static bool isHierarchyValid(const MeshBVHNode *nodes,
+				 const std::size_t &n_nodes,
+				 const std::size_t &n_faces);
+
+    /*
+     * Map the cache if valid for the given OFF file.
+     */
+    bool mapCache(const std::string &cache_name,
+		  const uint64_t &source_size,
+		  const int64_t &source_mtime);
+
+    /*
+     * Write the cache.
+     */
+    bool writeCache(const std::string &cache_name,
+		    const uint64_t &source_size,
+		    const int64_t &source_mtime);
+
+    /*
+     * Point the data to the owned storage.
+     */
+    void useStorage();
+
+    /*
+     * Closest point on a face.
+     */
+    float closestPointOnFace(const std::size_t &face,
+			     const float p[3],
+			     float q[3]) const;
+
+public:
+    /*
+     * Constructor
+     */
+    MeshModel();
+
+    /*
+     * Destructor, unmaps the cache.
+     */
+    ~MeshModel();
+
+    MeshModel(const MeshModel&) = delete;
+    MeshModel& operator=(const MeshModel&) = delete;
+
+    /*
+     * Load a mesh from an OFF file using the binary cache when available.
+     * @param file_name the path of the OFF file
+     * @param use_cache whether the binary cache should be used and written
+     * @return true/false on success/failure
+     */
+    bool load(const std::string &file_name, const bool &use_cache = true);
+
+    /*
+     * Release the mesh.
+     */
+    void clear();
+
+    std::size_t getNumberVertices() const;
+    std::size_t getNumberFaces() const;
+    const float* getVertices() const;
+    const uint32_t* getFaces() const;
+    const float* getNormals() const;
+    const float* getAreas() const;
+
+    /*
+     * Return the bounding box of the mesh.
+     * @return false if the mesh is empty
+     */
+    bool getBoundingBox(float min[3], float max[3]) const;
+
+    /*
+     * Find the point of the mesh closest to a given point.
+     * @param p the query point
+     * @param q the closest point
+     * @param face the index of the face containing the closest point
+     * @return the squared distance between p and q,
+     * a negative value if the mesh is empty
+     */
+    float closestPoint(const float p[3], float q[3], uint32_t &face) const;
+
+    /*
+     * Return the unsigned distance between a point and the mesh.
+     * @param p the query point
+     */
+    float distance(const float p[3]) const;
+
+    /*
+     * Find the first intersection of a ray with the mesh.
+     * @param origin the origin of the ray
+     * @param dir the direction of the ray
+     * @param t the distance of the intersection measured in units of dir
+     * @param face the index of the intersected face
+     * @return true if the ray intersects the mesh
+     */
+    bool rayCast(const float origin[3], const float dir[3],
+		 float &t, uint32_t &face) const;
+
+    /*
+     * Return the number of intersections of a ray with the mesh.
+     * @param origin the origin of the ray
+     * @param dir the direction of the ray
+     */
+    std::size_t countIntersections(const float origin[3], const float dir[3]) const;
+};
+
+#endif
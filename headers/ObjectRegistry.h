@@ -0,0 +1,98 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef OBJECT_REGISTRY_H
+#define OBJECT_REGISTRY_H
+
+// yarp
+#include <yarp/os/ResourceFinder.h>
+
+// std
+#include <string>
+#include <vector>
+
+struct ObjectDescription
+{
+    // identifier of the object used within rpc commands
+    std::string id;
+
+    // mesh of the model, e.g. model://box_alt/box.off
+    std::string mesh;
+
+    // dimensions of the model in meters
+    double width;
+    double depth;
+    double height;
+
+    // frame of the estimate published by the filter,
+    // empty if the object is not localized
+    std::string estimate_frame;
+
+    // frame of the ground truth published by the simulator
+    std::string ground_truth_frame;
+};
+
+/*
+ * Registry of the objects of the scene loaded from the configuration.
+ *
+ * The configuration contains the list of the objects
+ *     objects (box_alt mustard ...)
+ * and a group for each object
+ *     [box_alt]
+ *     mesh              model://box_alt/box.off
+ *     dimensions        (0.24 0.17 0.037)
+ *     estimateFrame     /box_alt/estimate/frame
+ *     groundTruthFrame  /box_alt/frame
+ */
+class ObjectRegistry
+{
+private:
+    std::vector<ObjectDescription> objects;
+
+    // object used when a command does not specify one
+    std::string default_object;
+
+public:
+    /*
+     * Load the objects from the configuration.
+     * @param rf the resource finder
+     * @return true/false on success/failure
+     */
+    bool configure(yarp::os::ResourceFinder &rf);
+
+    /*
+     * Add an object.
+     * @param object the description of the object
+     * @return false if an object with the same id already exists
+     */
+    bool add(const ObjectDescription &object);
+
+    /*
+     * Find an object.
+     * @param id the id of the object
+     * @return a pointer to the description of the object,
+     *         a null pointer if the object does not exist
+     */
+    const ObjectDescription* find(const std::string &id) const;
+
+    /*
+     * Return the description of all the objects.
+     */
+    const std::vector<ObjectDescription>& getObjects() const;
+
+    /*
+     * Return the id of the object used when a command
+     * does not specify one.
+     */
+    const std::string& getDefaultObject() const;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// yarp
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Value.h>
+
+// std
+#include <deque>
+#include <string>
+#include <vector>
+
+enum class PipelineStepType { Phase, Parallel, Wait, WaitConvergence };
+
+enum class PipelineState { Idle, Running, Done, Failed, Stopped };
+
+struct PipelineStep
+{
+    PipelineStepType type;
+
+    // name of the phase, i.e. the corresponding rpc command
+    std::string phase;
+
+    // phases of a Parallel step
+    std::vector<std::string> phases;
+
+    // duration of a Wait step or
+    // timeout of a WaitConvergence step
+    double duration;
+
+    // maximum displacement of the estimate, in meters,
+    // over the window required by a WaitConvergence step
+    double tolerance;
+    double window;
+};
+
+/*
+ * Parser of the steps of a pipeline.
+ *
+ * Each step is either the name of a phase, e.g. 'localize', or a list
+ * - (parallel <phase> <phase> ...)
+ * - (wait <seconds>)
+ * - (wait-convergence <tolerance> <window> <timeout>)
+ * - (repeat <times> <step> <step> ...)
+ */
+class PipelineParser
+{
+private:
+    // maximum number of steps after the expansion of repetitions
+    std::size_t max_steps;
+
+    // last error
+    std::string error;
+
+    /*
+     * Parse a single step and append it to the steps.
+     * @param value the step
+     * @param steps the parsed steps
+     * @return true/false on success/failure
+     */
+    bool parseStep(const yarp::os::Value &value, std::deque<PipelineStep> &steps);
+
+public:
+    /*
+     * Constructor
+     * @param max_steps the maximum number of steps
+     */
+    PipelineParser(const std::size_t &max_steps = 1024);
+
+    /*
+     * Parse the steps of a pipeline.
+     * @param command the command containing the steps
+     * @param first the index of the first step within the command
+     * @param steps the parsed steps
+     * @return true/false on success/failure
+     */
+    bool parse(const yarp::os::Bottle &command,
+	       const std::size_t &first,
+	       std::deque<PipelineStep> &steps);
+
+    /*
+     * Return a description of the last error.
+     */
+    const std::string& getError() const;
+};
+
+#endif
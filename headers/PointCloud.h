@@ -10,6 +10,7 @@
  */
 
 #ifndef POINTCLOUD_H
+#define POINTCLOUD_H
 
 #include <yarp/sig/Vector.h>
 
@@ -39,6 +40,9 @@ struct RGBPointCloudItem
  * serialization. Since this feature is of no interest the method
  * is overriden as follows. Drawback is that 'yarp read' cannot
  * be used.
+ *
+ * PointCloudMessage (see headers/PointCloudMessage.h) provides
+ * a bottle compatible and more compact alternative.
  */
 class PointCloud : public yarp::sig::VectorOf<PointCloudItem>
 {
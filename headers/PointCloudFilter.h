@@ -0,0 +1,115 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POINTCLOUD_FILTER_H
+#define POINTCLOUD_FILTER_H
+
+// yarp
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/dev/IFrameTransform.h>
+
+// std
+#include <string>
+
+#include "headers/PointCloudSoA.h"
+
+enum class CropMode { None, AxisAligned, Oriented };
+
+/*
+ * Filtering stage for incoming point clouds.
+ *
+ * The cloud is cropped to a box centered on a given pose, typically
+ * the last estimate of the pose of the object, and decimated using
+ * a voxel grid, i.e. all the points falling in the same voxel are
+ * replaced by their centroid.
+ */
+class PointCloudFilter
+{
+private:
+    // size of the voxels
+    // zero disables the voxel grid
+    double leaf_size;
+
+    // crop box
+    CropMode crop_mode;
+    yarp::sig::Vector crop_size;
+    yarp::sig::Matrix crop_pose;
+    bool is_crop_pose_available;
+
+public:
+    /*
+     * Constructor
+     */
+    PointCloudFilter();
+
+    /*
+     * Set the size of the voxels of the grid.
+     * @param size the non negative size in meters, zero disables decimation
+     * @return true/false on success/failure
+     */
+    bool setLeafSize(const double &size);
+
+    /*
+     * Set the crop mode.
+     * @param mode the crop mode, i.e. None, AxisAligned or Oriented
+     */
+    void setCropMode(const CropMode &mode);
+
+    /*
+     * Set the size of the crop box.
+     * @param size the 3x1 size along the x, y and z axes of the box
+     * @return true/false on success/failure
+     */
+    bool setCropBoxSize(const yarp::sig::Vector &size);
+
+    /*
+     * Set the pose of the center of the crop box.
+     * In AxisAligned mode only the position is used.
+     * @param pose the 4x4 homogeneous transformation
+     * @return true/false on success/failure
+     */
+    bool setCropBoxPose(const yarp::sig::Matrix &pose);
+
+    /*
+     * Set the pose of the center of the crop box from a frame
+     * available on a FrameTransformServer.
+     * @param tf_client an already opened FrameTransformClient view
+     * @param target the frame of the center of the box, e.g. an estimate
+     * @param source the frame the points are expressed in
+     * @return true/false on success/failure
+     */
+    bool setCropBoxPose(yarp::dev::IFrameTransform *tf_client,
+			const std::string &target,
+			const std::string &source);
+
+    /*
+     * Decimate the cloud in place using a voxel grid.
+     * @param cloud the cloud to be decimated
+     */
+    void voxelize(SoAPointCloud &cloud) const;
+
+    /*
+     * Crop the cloud in place.
+     * Nothing is done if the crop mode is None or the pose
+     * of the crop box is not available.
+     * @param cloud the cloud to be cropped
+     */
+    void crop(SoAPointCloud &cloud) const;
+
+    /*
+     * Crop and decimate the cloud in place.
+     * @param cloud the cloud to be filtered
+     */
+    void filter(SoAPointCloud &cloud) const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POINTCLOUD_FILTER_MODULE_H
+#define POINTCLOUD_FILTER_MODULE_H
+
+// yarp
+#include <yarp/os/RFModule.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/IFrameTransform.h>
+
+// std
+#include <string>
+
+#include "headers/PointCloud.h"
+#include "headers/PointCloudSoA.h"
+#include "headers/PointCloudFilter.h"
+
+/*
+ * Relay module placed between the point cloud producer
+ * and the localizer. Each incoming cloud is cropped around the
+ * last estimate, decimated and sent to the output port.
+ */
+class PointCloudFilterModule : public yarp::os::RFModule
+{
+private:
+    // point cloud ports
+    yarp::os::BufferedPort<PointCloud> port_in;
+    yarp::os::BufferedPort<PointCloud> port_out;
+
+    // FrameTransformClient to read the estimate
+    yarp::dev::PolyDriver drv_transform_client;
+    yarp::dev::IFrameTransform* tf_client;
+
+    // name of the frames
+    std::string estimate_frame;
+    std::string root_frame;
+
+    // filtering stage
+    PointCloudFilter filter;
+
+    // working storage
+    SoAPointCloud cloud;
+
+public:
+    /*
+     * Configure the module.
+     * @param rf a previously instantiated @see ResourceFinder
+     */
+    bool configure(yarp::os::ResourceFinder &rf) override;
+
+    /*
+     * Return the module period.
+     */
+    double getPeriod() override;
+
+    /*
+     * Define the behavior of this module.
+     */
+    bool updateModule() override;
+
+    /*
+     * Unblock the module while waiting for a point cloud.
+     */
+    bool interruptModule() override;
+
+    /*
+     * Define the cleanup behavior.
+     */
+    bool close() override;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POINTCLOUD_MESSAGE_H
+#define POINTCLOUD_MESSAGE_H
+
+// yarp
+#include <yarp/os/Portable.h>
+#include <yarp/os/Vocab.h>
+
+// std
+#include <string>
+#include <vector>
+
+#include "headers/PointCloud.h"
+#include "headers/PointCloudSoA.h"
+
+#define POINTCLOUD_MESSAGE_MAGIC VOCAB4('P','C','L','D')
+#define POINTCLOUD_MESSAGE_VERSION 1
+
+// bounds accepted when reading a message
+// well above the size of the clouds of a depth camera
+#define POINTCLOUD_MESSAGE_MAX_POINTS 16777216
+#define POINTCLOUD_MESSAGE_MAX_FRAME_ID 4096
+
+/*
+ * Layout of a single point within the payload of a PointCloudMessage.
+ */
+struct PackedPoint
+{
+    float x;
+    float y;
+    float z;
+};
+
+/*
+ * Layout of a single colored point within the payload of a PointCloudMessage.
+ */
+struct PackedRGBPoint
+{
+    float x;
+    float y;
+    float z;
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char padding;
+};
+
+/*
+ * Point cloud message with a binary payload.
+ *
+ * The message is serialized as a bottle compatible list
+ * (magic, version, number of points, stride, timestamp, frame id, payload)
+ * where the payload is a blob containing all the points stored
+ * as PackedPoint or PackedRGBPoint, depending on the stride.
+ *
+ * The payload is written and read as a single block so that
+ * no per point copies are required during serialization, while
+ * 'yarp read' can still be used to inspect the messages.
+ */
+class PointCloudMessage : public yarp::os::Portable
+{
+private:
+    // header
+    int version;
+    int n_points;
+    int stride;
+    double timestamp;
+    std::string frame_id;
+
+    // payload
+    std::vector<char, AlignedAllocator<char> > payload;
+
+public:
+    /*
+     * Constructor
+     */
+    PointCloudMessage();
+
+    /*
+     * Resize the payload.
+     * @param n the number of points
+     * @param with_colors whether the points have colors or not
+     */
+    void resize(const int &n, const bool &with_colors = false);
+
+    /*
+     * Remove all the points.
+     */
+    void clear();
+
+    /*
+     * Return the number of points.
+     */
+    int size() const;
+
+    /*
+     * Return the size in bytes of a single point.
+     */
+    int getStride() const;
+
+    /*
+     * Return true if the points have colors.
+     */
+    bool hasColors() const;
+
+    /*
+     * Set/get the timestamp of the cloud.
+     */
+    void setTimestamp(const double &time);
+    double getTimestamp() const;
+
+    /*
+     * Set/get the name of the frame the points are expressed in.
+     */
+    void setFrameId(const std::string &frame);
+    std::string getFrameId() const;
+
+    /*
+     * Access the payload as an array of points.
+     * @return a pointer to the points or a null pointer if the
+     *         stride of the message does not match the requested type
+     */
+    PackedPoint* points();
+    const PackedPoint* points() const;
+    PackedRGBPoint* rgbPoints();
+    const PackedRGBPoint* rgbPoints() const;
+
+    /*
+     * Conversions from and to the other point cloud types.
+     */
+    void fromPointCloud(const PointCloud &cloud);
+    void fromPointCloud(const RGBPointCloud &cloud);
+    void fromPointCloud(const SoAPointCloud &cloud);
+    void fromPointCloud(const SoARGBPointCloud &cloud);
+    bool toPointCloud(PointCloud &cloud) const;
+    bool toPointCloud(RGBPointCloud &cloud) const;
+    bool toPointCloud(SoAPointCloud &cloud) const;
+    bool toPointCloud(SoARGBPointCloud &cloud) const;
+
+    /*
+     * Return true iff a PointCloudMessage was received succesfully
+     */
+    bool read(yarp::os::ConnectionReader& connection) YARP_OVERRIDE;
+
+    /*
+     * Return true iff a PointCloudMessage was sent succesfully
+     */
+    bool write(yarp::os::ConnectionWriter& connection) YARP_OVERRIDE;
+};
+
+#endif
@@ -0,0 +1,240 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POINTCLOUD_SOA_H
+#define POINTCLOUD_SOA_H
+
+// yarp
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+// std
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "headers/PointCloud.h"
+
+/*
+ * Alignment, in bytes, of the columns of the point clouds.
+ * This is the width of an AVX register so that aligned loads
+ * can be used on the whole column.
+ */
+#define SOA_POINTCLOUD_ALIGNMENT 32
+
+/*
+ * Minimal allocator returning memory aligned to SOA_POINTCLOUD_ALIGNMENT.
+ */
+template <class T>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    AlignedAllocator() { }
+
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U> &) { }
+
+    T* allocate(std::size_t n)
+    {
+	void *ptr = nullptr;
+	if (posix_memalign(&ptr, SOA_POINTCLOUD_ALIGNMENT, n * sizeof(T)) != 0)
+	    throw std::bad_alloc();
+	return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T *ptr, std::size_t)
+    {
+	free(ptr);
+    }
+
+    template <class U>
+    struct rebind
+    {
+	typedef AlignedAllocator<U> other;
+    };
+};
+
+template <class T, class U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return true; }
+
+template <class T, class U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return false; }
+
+/*
+ * Point cloud stored as a structure of arrays,
+ * i.e. one aligned float column for each coordinate.
+ *
+ * Compared to PointCloud the memory footprint is halved
+ * and the columns can be processed using SIMD instructions.
+ * AVX2 kernels are used when the code is compiled with -mavx2,
+ * SSE2 kernels otherwise (when available).
+ */
+class SoAPointCloud
+{
+public:
+    typedef std::vector<float, AlignedAllocator<float> > Column;
+
+protected:
+    // coordinates of the points
+    Column x;
+    Column y;
+    Column z;
+
+    // mask of the points kept by crop()
+    // reused in order not to allocate it for each cloud
+    std::vector<unsigned char> crop_mask;
+
+    /*
+     * Keep only the points i such that keep[i] != 0,
+     * preserving their order.
+     * @param keep the mask of points to be kept
+     * @return the number of kept points
+     */
+    virtual std::size_t compact(const std::vector<unsigned char> &keep);
+
+public:
+    virtual ~SoAPointCloud();
+
+    /*
+     * Return the number of points.
+     */
+    std::size_t size() const;
+
+    /*
+     * Resize the columns.
+     * @param n the new number of points
+     */
+    virtual void resize(const std::size_t &n);
+
+    /*
+     * Reserve storage for n points.
+     * @param n the number of points
+     */
+    virtual void reserve(const std::size_t &n);
+
+    /*
+     * Remove all the points.
+     */
+    void clear();
+
+    /*
+     * Access the columns.
+     */
+    float* xData();
+    float* yData();
+    float* zData();
+    const float* xData() const;
+    const float* yData() const;
+    const float* zData() const;
+
+    /*
+     * Fill the cloud with the points of a PointCloud.
+     * @param cloud the input point cloud
+     */
+    void fromPointCloud(const PointCloud &cloud);
+
+    /*
+     * Copy the cloud into a PointCloud.
+     * @param cloud the output point cloud
+     */
+    void toPointCloud(PointCloud &cloud) const;
+
+    /*
+     * Transform all the points in place.
+     * @param transform a 4x4 homogeneous transformation
+     * @return true/false on success/failure
+     */
+    bool transform(const yarp::sig::Matrix &transform);
+
+    /*
+     * Transform all the points in place.
+     * @param rot the 3x3 rotation matrix in row major order
+     * @param pos the 3x1 translation
+     */
+    void transform(const float rot[9], const float pos[3]);
+
+    /*
+     * Remove, in place, all the points outside an axis aligned box.
+     * @param min the 3x1 lower corner of the box
+     * @param max the 3x1 upper corner of the box
+     * @return the number of remaining points
+     */
+    std::size_t crop(const float min[3], const float max[3]);
+
+    /*
+     * Remove, in place, all the points outside an oriented box.
+     * The points are tested in the frame of the box, i.e. rot^T (p - pos),
+     * while the coordinates of the points kept are not changed.
+     * @param rot the 3x3 rotation of the box in row major order
+     * @param pos the 3x1 center of the box
+     * @param min the 3x1 lower corner of the box in its frame
+     * @param max the 3x1 upper corner of the box in its frame
+     * @return the number of remaining points
+     */
+    std::size_t crop(const float rot[9], const float pos[3],
+		     const float min[3], const float max[3]);
+
+    /*
+     * Evaluate the centroid of the cloud.
+     * @param centroid the 3x1 centroid
+     * @return true/false on success/failure, i.e. if the cloud is empty
+     */
+    bool centroid(yarp::sig::Vector &centroid) const;
+};
+
+/*
+ * Point cloud with colors stored as a structure of arrays.
+ */
+class SoARGBPointCloud : public SoAPointCloud
+{
+public:
+    typedef std::vector<unsigned char, AlignedAllocator<unsigned char> > ColorColumn;
+
+protected:
+    // colors of the points
+    ColorColumn r;
+    ColorColumn g;
+    ColorColumn b;
+
+    std::size_t compact(const std::vector<unsigned char> &keep) override;
+
+public:
+    void resize(const std::size_t &n) override;
+
+    void reserve(const std::size_t &n) override;
+
+    /*
+     * Access the color columns.
+     */
+    unsigned char* rData();
+    unsigned char* gData();
+    unsigned char* bData();
+    const unsigned char* rData() const;
+    const unsigned char* gData() const;
+    const unsigned char* bData() const;
+
+    /*
+     * Fill the cloud with the points of a RGBPointCloud.
+     * @param cloud the input point cloud
+     */
+    void fromRGBPointCloud(const RGBPointCloud &cloud);
+
+    /*
+     * Copy the cloud into a RGBPointCloud.
+     * @param cloud the output point cloud
+     */
+    void toRGBPointCloud(RGBPointCloud &cloud) const;
+};
+
+#endif
@@ -0,0 +1,243 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POLYNOMIAL_TRAJECTORY_H
+#define POLYNOMIAL_TRAJECTORY_H
+
+// std
+#include <cstddef>
+
+namespace polynomial
+{
+    /*
+     * Integer power evaluated at compile time if possible.
+     */
+    constexpr double power(const double x, const std::size_t n)
+    {
+	return n == 0 ? 1.0 : x * power(x, n - 1);
+    }
+}
+
+/*
+ * Coefficients of the rest-to-rest quintic
+ *     s(t) = c3 t^3 + c4 t^4 + c5 t^5
+ * going from 0 to 1 in a given duration with zero velocity
+ * and acceleration at both ends.
+ *
+ * The coefficients can be evaluated at compile time for fixed durations, e.g.
+ *     constexpr RestToRestQuintic profile(4.0);
+ */
+struct RestToRestQuintic
+{
+    double duration;
+    double c3;
+    double c4;
+    double c5;
+
+    constexpr RestToRestQuintic(const double duration) :
+	duration(duration),
+	c3(10.0 / polynomial::power(duration, 3)),
+	c4(-15.0 / polynomial::power(duration, 4)),
+	c5(6.0 / polynomial::power(duration, 5)) { }
+};
+
+/*
+ * Trajectory whose Dim components are polynomials of degree Order
+ *     p(t) = a_0 + a_1 t + ... + a_Order t^Order
+ * defined for t in [0, duration]. The time is saturated at the duration.
+ *
+ * The coefficients are stored within the object and position and velocity
+ * are evaluated using the Horner scheme, hence the evaluation
+ * does not allocate and does not call pow().
+ */
+template <std::size_t Dim, std::size_t Order>
+class PolynomialTrajectory
+{
+    static_assert(Dim > 0, "PolynomialTrajectory: the dimension should be positive");
+    static_assert(Order > 0, "PolynomialTrajectory: the order should be positive");
+
+private:
+    // coefficients of each component by increasing power
+    double coefficients[Dim][Order + 1];
+
+    // duration of the trajectory
+    double duration;
+
+public:
+    static constexpr std::size_t dimension = Dim;
+    static constexpr std::size_t order = Order;
+
+    /*
+     * Constructor
+     * The trajectory is constant and equal to zero.
+     */
+    PolynomialTrajectory() :
+	duration(1.0)
+    {
+	for (std::size_t i = 0; i < Dim; i++)
+	    for (std::size_t k = 0; k <= Order; k++)
+		coefficients[i][k] = 0.0;
+    }
+
+    /*
+     * Set the coefficients of one component.
+     * @param component the index of the component
+     * @param values the Order + 1 coefficients by increasing power
+     */
+    void setCoefficients(const std::size_t &component, const double (&values)[Order + 1])
+    {
+	for (std::size_t k = 0; k <= Order; k++)
+	    coefficients[component][k] = values[k];
+    }
+
+    /*
+     * Get a coefficient of one component.
+     * @param component the index of the component
+     * @param power the power of the time multiplied by the coefficient
+     */
+    double getCoefficient(const std::size_t &component, const std::size_t &power) const
+    {
+	return coefficients[component][power];
+    }
+
+    /*
+     * Set the duration of the trajectory.
+     * @param duration the positive duration in seconds
+     * @return true/false on success/failure
+     */
+    bool setDuration(const double &duration)
+    {
+	if (duration <= 0)
+	    return false;
+
+	this->duration = duration;
+
+	return true;
+    }
+
+    double getDuration() const
+    {
+	return duration;
+    }
+
+    /*
+     * Configure a rest-to-rest trajectory between two points.
+     * Requires Order to be at least 5.
+     * @param initial the Dim initial coordinates
+     * @param final the Dim final coordinates
+     * @param profile the coefficients of the quintic, possibly evaluated at compile time
+     */
+    void setRestToRest(const double *initial, const double *final,
+		       const RestToRestQuintic &profile)
+    {
+	static_assert(Order >= 5, "PolynomialTrajectory: rest-to-rest trajectories require Order >= 5");
+
+	duration = profile.duration;
+	for (std::size_t i = 0; i < Dim; i++)
+	{
+	    double displacement = final[i] - initial[i];
+	    for (std::size_t k = 0; k <= Order; k++)
+		coefficients[i][k] = 0.0;
+	    coefficients[i][0] = initial[i];
+	    coefficients[i][3] = profile.c3 * displacement;
+	    coefficients[i][4] = profile.c4 * displacement;
+	    coefficients[i][5] = profile.c5 * displacement;
+	}
+    }
+
+    /*
+     * Evaluate position and velocity at the specified time.
+     * @param time the time, saturated at the duration
+     * @param position the Dim coordinates of the position
+     * @param velocity the Dim coordinates of the velocity
+     * @return false if the time is negative
+     */
+    bool evaluate(const double &time, double *position, double *velocity) const
+    {
+	if (time < 0)
+	    return false;
+
+	double t = time;
+	if (t > duration)
+	    t = duration;
+
+	for (std::size_t i = 0; i < Dim; i++)
+	{
+	    const double *a = coefficients[i];
+
+	    double p = a[Order];
+	    double v = Order * a[Order];
+	    for (std::size_t k = Order - 1; k > 0; k--)
+	    {
+		p = p * t + a[k];
+		v = v * t + k * a[k];
+	    }
+	    position[i] = p * t + a[0];
+	    velocity[i] = v;
+	}
+
+	return true;
+    }
+
+    /*
+     * Evaluate position and velocity at several times.
+     * The outputs are stored by component, i.e. the i-th component
+     * at the k-th time is stored at index i * count + k, so that
+     * the loops over the times can be vectorized.
+     * @param times the count times, saturated at the duration
+     * @param count the number of times
+     * @param positions the Dim * count coordinates of the positions
+     * @param velocities the Dim * count coordinates of the velocities
+     * @return false if any time is negative
+     */
+    bool evaluate(const double *times, const std::size_t &count,
+		  double *positions, double *velocities) const
+    {
+	for (std::size_t k = 0; k < count; k++)
+	{
+	    if (times[k] < 0)
+		return false;
+	}
+
+	for (std::size_t i = 0; i < Dim; i++)
+	{
+	    const double *a = coefficients[i];
+	    double *p = positions + i * count;
+	    double *v = velocities + i * count;
+
+	    // the loop over the powers has a constant number of iterations
+	    // hence it is unrolled and the loop over the times is vectorized
+	    for (std::size_t k = 0; k < count; k++)
+	    {
+		const double t = times[k] < duration ? times[k] : duration;
+		double p_k = a[Order];
+		double v_k = Order * a[Order];
+		for (std::size_t n = Order - 1; n > 0; n--)
+		{
+		    p_k = p_k * t + a[n];
+		    v_k = v_k * t + n * a[n];
+		}
+		p[k] = p_k * t + a[0];
+		v[k] = v_k;
+	    }
+	}
+
+	return true;
+    }
+};
+
+template <std::size_t Dim, std::size_t Order>
+constexpr std::size_t PolynomialTrajectory<Dim, Order>::dimension;
+
+template <std::size_t Dim, std::size_t Order>
+constexpr std::size_t PolynomialTrajectory<Dim, Order>::order;
+
+#endif
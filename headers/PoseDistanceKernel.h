@@ -0,0 +1,173 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef POSE_DISTANCE_KERNEL_H
+#define POSE_DISTANCE_KERNEL_H
+
+// yarp
+#include <yarp/sig/Matrix.h>
+
+// std
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "headers/DistanceField.h"
+#include "headers/PointCloudSoA.h"
+
+/*
+ * Pose of the object w.r.t. the frame of the measurements.
+ */
+struct PoseHypothesis
+{
+    // rotation in row major order
+    float rot[9];
+    float pos[3];
+
+    /*
+     * Set the pose from an homogeneous transformation.
+     * @param pose a 4x4 matrix
+     * @return true/false on success/failure
+     */
+    bool fromMatrix(const yarp::sig::Matrix &pose);
+};
+
+/*
+ * Evaluate the distances between a set of measurements, e.g. points
+ * of a cloud or fingertip contacts, and the surface of an object
+ * for each of several pose hypotheses.
+ *
+ * Measurements are moved in the object frame of each hypothesis and
+ * looked up in the distance field of the object in blocks. Hypotheses
+ * are split between the calling thread and a pool of workers created
+ * with the kernel, small batches are evaluated by the calling thread only.
+ * Evaluations requested concurrently are serialized.
+ */
+class PoseDistanceKernel
+{
+private:
+    const DistanceField &field;
+    std::size_t n_threads;
+
+    // batch being evaluated by the workers
+    struct Job
+    {
+	const PoseHypothesis *poses;
+	std::size_t n_poses;
+	std::size_t n_ranges;
+	const SoAPointCloud *points;
+	float *distances;
+	float *sums;
+    };
+
+    // pool of n_threads - 1 workers
+    std::vector<std::thread> workers;
+    mutable Job job;
+    mutable std::size_t generation;
+    mutable std::size_t pending;
+    bool is_stopping;
+    mutable std::mutex pool_mutex;
+    mutable std::condition_variable start_condition;
+    mutable std::condition_variable done_condition;
+
+    // one evaluation at a time uses the pool
+    mutable std::mutex evaluate_mutex;
+
+    /*
+     * Start and stop the workers.
+     */
+    void startWorkers();
+    void stopWorkers();
+
+    /*
+     * Body of the workers.
+     * @param index the index of the worker, i.e. of the range it evaluates
+     */
+    void workerLoop(const std::size_t index);
+
+    /*
+     * Return the range of hypotheses evaluated by the i-th of n_ranges threads.
+     */
+    static void getRange(const std::size_t &i, const std::size_t &n_poses, const std::size_t &n_ranges,
+			 std::size_t &begin, std::size_t &end);
+
+    /*
+     * Evaluate the hypotheses in the range [begin, end).
+     * Either distances or sums can be null.
+     */
+    void evaluateRange(const PoseHypothesis *poses,
+		       const std::size_t &begin,
+		       const std::size_t &end,
+		       const SoAPointCloud &points,
+		       float *distances,
+		       float *sums) const;
+
+    /*
+     * Split the hypotheses between the threads.
+     */
+    void evaluate(const std::vector<PoseHypothesis> &poses,
+		  const SoAPointCloud &points,
+		  float *distances,
+		  float *sums) const;
+
+public:
+    /*
+     * Constructor
+     * @param field the distance field of the object, it must outlive the kernel
+     * @param n_threads the number of threads, 0 to use one thread per core
+     */
+    PoseDistanceKernel(const DistanceField &field,
+		       const std::size_t &n_threads = 0);
+
+    /*
+     * Destructor, stops the workers.
+     */
+    ~PoseDistanceKernel();
+
+    PoseDistanceKernel(const PoseDistanceKernel&) = delete;
+    PoseDistanceKernel& operator=(const PoseDistanceKernel&) = delete;
+
+    /*
+     * Set the number of threads, restarting the workers.
+     * Not to be called concurrently with an evaluation.
+     * @param n_threads the number of threads, 0 to use one thread per core
+     */
+    void setNumberThreads(const std::size_t &n_threads);
+
+    /*
+     * Return the number of threads.
+     */
+    std::size_t getNumberThreads() const;
+
+    /*
+     * Evaluate the N x M matrix of signed distances.
+     * @param poses the N hypotheses
+     * @param points the M measurements
+     * @param distances the distances in row major order, one row per hypothesis
+     */
+    void distances(const std::vector<PoseHypothesis> &poses,
+		   const SoAPointCloud &points,
+		   std::vector<float> &distances) const;
+
+    /*
+     * Evaluate the sum of the squared distances for each hypothesis.
+     * @param poses the N hypotheses
+     * @param points the M measurements
+     * @param sums the N sums
+     */
+    void sumOfSquares(const std::vector<PoseHypothesis> &poses,
+		      const SoAPointCloud &points,
+		      std::vector<float> &sums) const;
+};
+
+#endif
@@ -14,26 +14,142 @@
 
 // yarp
 #include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
 
+// std
+#include <cstddef>
+
+/*
+ * Velocity of the pushing point required to rotate an object
+ * about the vertical axis through its center at a constant yaw rate.
+ *
+ * The pushing point is stored in the horizontal plane of the object
+ * when the generator is initialized. The center and the yaw of the object
+ * can then be updated on line using the estimates of the filter,
+ * hence the pushing point follows the object, e.g. a corner, instead of
+ * rotating about the center sampled at the beginning. Between two estimates
+ * the yaw is extrapolated using the commanded rate. If the actual position
+ * of the pushing point is provided, a proportional term steers it towards
+ * the point tracked on the object.
+ *
+ * The velocity is evaluated in closed form and does not allocate.
+ */
 class RotationTrajectoryGenerator
 {
 private:
     // center of the object
-    yarp::sig::Vector object_center;
+    double object_center[3];
+
+    // yaw of the object
+    double object_yaw;
+
+    // time of the estimate of the object
+    double estimate_time;
 
     // pushing point
-    yarp::sig::Vector push_point;
+    double push_point[3];
+
+    // displacement from the center to the pushing point
+    // in the horizontal plane when the generator was initialized
+    double push_offset[2];
 
     // yaw rate
     double yaw_rate;
-    
+
+    // gain of the correction of the position of the pushing point
+    double position_gain;
+
+    /*
+     * Extract the yaw from a rotation matrix.
+     */
+    static double yawOf(const yarp::sig::Matrix &pose);
+
+    /*
+     * Extrapolate the yaw of the object from the latest estimate.
+     * @param time the time elapsed since the beginning of the rotation
+     */
+    double extrapolateYaw(const double &time) const;
+
 public:
     RotationTrajectoryGenerator();
     void setYawRate(const double &rate);
-    bool getVelocity(const double &time,
-		     yarp::sig::Vector &velocity);
+
+    /*
+     * Set the gain of the correction of the pushing point.
+     * @param gain the non negative gain in 1/s, zero disables the correction
+     */
+    void setPositionGain(const double &gain);
+
+    /*
+     * Set the initial center of the object.
+     * The yaw of the object is assumed to be zero.
+     * @param point the 3x1 center
+     */
     void setObjectCenter(const yarp::sig::Vector &point);
+
+    /*
+     * Set the initial pose of the object.
+     * @param pose the 4x4 homogeneous transformation
+     */
+    void setObjectPose(const yarp::sig::Matrix &pose);
+
+    /*
+     * Set the initial pushing point.
+     * @param point the 3x1 pushing point
+     */
     void setPushingPoint(const yarp::sig::Vector &point);
+
+    /*
+     * Store the pushing point w.r.t. the object.
+     * To be called after the initial pose and pushing point are set.
+     */
+    void init();
+
+    /*
+     * Update the center and the yaw of the object.
+     * Estimates not newer than the last one are discarded.
+     * @param pose the 4x4 homogeneous transformation
+     * @param time the time of the estimate w.r.t. the beginning of the rotation
+     * @return true if the estimate was used
+     */
+    bool updateEstimate(const yarp::sig::Matrix &pose, const double &time);
+
+    /*
+     * Get the velocity of the pushing point.
+     * The vector is resized only if its size is not 3.
+     * @param time the time elapsed since the beginning of the rotation
+     * @param velocity the 3x1 linear velocity
+     * @return false if the time is negative
+     */
+    bool getVelocity(const double &time,
+		     yarp::sig::Vector &velocity) const;
+
+    /*
+     * Get the velocity of the pushing point including the correction
+     * of the error in the horizontal plane between the point tracked
+     * on the object and the actual pushing point.
+     * @param time the time elapsed since the beginning of the rotation
+     * @param actual_point the 3x1 actual position of the pushing point
+     * @param velocity the 3x1 linear velocity
+     * @return false if the time is negative
+     */
+    bool getVelocity(const double &time,
+		     const yarp::sig::Vector &actual_point,
+		     yarp::sig::Vector &velocity) const;
+
+    /*
+     * Get the position of the pushing point tracked on the object
+     * and its velocity, without correction, at several times.
+     * The outputs are stored by coordinate, i.e. x, y and z of the
+     * k-th sample are at indexes k, count + k and 2 * count + k.
+     * @param times the count times elapsed since the beginning of the rotation
+     * @param count the number of samples
+     * @param positions the 3 * count coordinates of the positions
+     * @param velocities the 3 * count coordinates of the velocities
+     * @return false if any time is negative
+     */
+    bool getTrajectory(const double *times, const std::size_t &count,
+		       double *positions, double *velocities) const;
 };
 
 #endif
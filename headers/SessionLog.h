@@ -0,0 +1,264 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * A session log is an append-only binary file made of chunks.
+ *
+ * file   := file header, chunk, chunk, ...
+ * chunk  := chunk header, record, record, ..., index
+ * record := record header, data padded to 8 bytes
+ * index  := offsets of the records w.r.t. the beginning of the chunk
+ *
+ * Each record belongs to a stream. Streams are declared by records
+ * belonging to the reserved stream SESSION_LOG_META_STREAM containing
+ * the id, the kind and the name of the stream.
+ *
+ * Chunks are written at once, hence a crash can only lose
+ * the last chunk of a session.
+ */
+
+#define SESSION_LOG_FILE_MAGIC 0x534c5456  // 'VTLS'
+#define SESSION_LOG_CHUNK_MAGIC 0x4b4e4843 // 'CHNK'
+#define SESSION_LOG_VERSION 1
+#define SESSION_LOG_META_STREAM 0
+
+enum class StreamKind : uint32_t { PointCloud = 1, Contacts = 2, Estimate = 3 };
+
+struct SessionLogFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t reserved;
+};
+
+struct SessionLogChunkHeader
+{
+    uint32_t magic;
+    uint32_t n_records;
+    // size of the chunk including header and index
+    uint64_t size;
+    // offset of the index w.r.t. the beginning of the chunk
+    uint64_t index_offset;
+    // time span of the records
+    double time_begin;
+    double time_end;
+};
+
+struct SessionLogRecordHeader
+{
+    uint32_t stream;
+    uint32_t size;
+    double timestamp;
+};
+
+/*
+ * A record as returned by SessionLogReader.
+ * The data is not copied and points within the mapped file.
+ */
+struct SessionLogRecord
+{
+    uint32_t stream;
+    double timestamp;
+    const char *data;
+    std::size_t size;
+};
+
+/*
+ * Description of a stream.
+ */
+struct SessionLogStream
+{
+    StreamKind kind;
+    std::string name;
+};
+
+class SessionLogWriter
+{
+private:
+    // output file
+    FILE *file;
+
+    // chunk being filled
+    std::vector<char> chunk;
+    std::vector<uint64_t> index;
+    double time_begin;
+    double time_end;
+
+    // maximum size of the records of a chunk
+    std::size_t max_chunk_size;
+
+    // next available stream id
+    uint32_t next_stream;
+
+    /*
+     * Append a record to the current chunk.
+     */
+    void appendRecord(const uint32_t &stream,
+		      const double &timestamp,
+		      const char *data,
+		      const std::size_t &size);
+
+public:
+    /*
+     * Constructor
+     */
+    SessionLogWriter();
+
+    /*
+     * Destructor, flushes and closes the file.
+     */
+    ~SessionLogWriter();
+
+    /*
+     * Create a new log.
+     * @param file_name the path of the file
+     * @param chunk_size the size in bytes of the chunks
+     * @return true/false on success/failure
+     */
+    bool open(const std::string &file_name,
+	      const std::size_t &chunk_size = 4 * 1024 * 1024);
+
+    /*
+     * Declare a new stream.
+     * @param kind the kind of the data of the stream
+     * @param name the name of the stream, e.g. the name of the source port
+     * @return the id of the stream
+     */
+    uint32_t addStream(const StreamKind &kind, const std::string &name);
+
+    /*
+     * Append a record.
+     * @param stream the id of the stream
+     * @param timestamp the timestamp of the record
+     * @param data pointer to the data of the record
+     * @param size the size of the data in bytes
+     * @return true/false on success/failure
+     */
+    bool write(const uint32_t &stream,
+	       const double &timestamp,
+	       const void *data,
+	       const std::size_t &size);
+
+    /*
+     * Write the current chunk to the file.
+     * @return true/false on success/failure
+     */
+    bool flush();
+
+    /*
+     * Flush and close the file.
+     */
+    void close();
+};
+
+class SessionLogReader
+{
+private:
+    // mapped file
+    int fd;
+    const char *mapped;
+    std::size_t mapped_size;
+
+    // offsets of the chunks
+    std::vector<std::size_t> chunks;
+
+    // declared streams
+    std::map<uint32_t, SessionLogStream> streams;
+
+    // iteration state
+    std::size_t current_chunk;
+    std::size_t current_record;
+
+    /*
+     * Return the header of a chunk.
+     */
+    const SessionLogChunkHeader* chunkHeader(const std::size_t &chunk) const;
+
+    /*
+     * Check that the index and all the records of a chunk
+     * lie within the chunk.
+     * @param chunk_begin the beginning of the chunk, whose size is already checked
+     */
+    static bool isChunkValid(const char *chunk_begin);
+
+    /*
+     * Return a record within a chunk.
+     */
+    void getRecord(const std::size_t &chunk,
+		   const std::size_t &record,
+		   SessionLogRecord &rec) const;
+
+public:
+    /*
+     * Constructor
+     */
+    SessionLogReader();
+
+    /*
+     * Destructor, unmaps the file.
+     */
+    ~SessionLogReader();
+
+    /*
+     * Map an existing log.
+     * @param file_name the path of the file
+     * @return true/false on success/failure
+     */
+    bool open(const std::string &file_name);
+
+    /*
+     * Unmap the file.
+     */
+    void close();
+
+    /*
+     * Return the declared streams.
+     */
+    const std::map<uint32_t, SessionLogStream>& getStreams() const;
+
+    /*
+     * Return the time span of the log.
+     * @return true/false on success/failure, i.e. if the log is empty
+     */
+    bool getTimeSpan(double &begin, double &end) const;
+
+    /*
+     * Restart the iteration from the first record.
+     */
+    void rewind();
+
+    /*
+     * Move the iteration to the first record having
+     * timestamp greater or equal to the given time.
+     * @param time the time
+     */
+    void seek(const double &time);
+
+    /*
+     * Get the next data record. Stream declarations are skipped.
+     * @param rec the record
+     * @return true if a record is available, false at the end of the log
+     */
+    bool next(SessionLogRecord &rec);
+};
+
+#endif
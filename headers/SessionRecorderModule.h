@@ -0,0 +1,125 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef SESSION_RECORDER_MODULE_H
+#define SESSION_RECORDER_MODULE_H
+
+// yarp
+#include <yarp/os/RFModule.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/IFrameTransform.h>
+
+// std
+#include <string>
+#include <vector>
+
+#include "headers/PointCloud.h"
+#include "headers/SessionLog.h"
+
+class SessionRecorderModule;
+
+/*
+ * Port recording the incoming point clouds.
+ */
+class PointCloudRecorderPort : public yarp::os::BufferedPort<PointCloud>
+{
+private:
+    SessionRecorderModule *recorder;
+    uint32_t stream;
+
+public:
+    void setRecorder(SessionRecorderModule *recorder, const uint32_t &stream);
+    void onRead(PointCloud &cloud) override;
+};
+
+/*
+ * Port recording the incoming contacts.
+ * Since iCub::skinDynLib::skinContactList is bottle compatible
+ * the contacts are recorded as binary bottles.
+ */
+class ContactsRecorderPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+    SessionRecorderModule *recorder;
+    uint32_t stream;
+
+public:
+    void setRecorder(SessionRecorderModule *recorder, const uint32_t &stream);
+    void onRead(yarp::os::Bottle &contacts) override;
+};
+
+class SessionRecorderModule : public yarp::os::RFModule
+{
+private:
+    // log
+    SessionLogWriter log;
+
+    // mutex required to share the log between
+    // the RFModule thread and the ports callbacks
+    yarp::os::Mutex mutex;
+
+    // point cloud port
+    PointCloudRecorderPort port_cloud;
+
+    // contacts ports
+    std::vector<ContactsRecorderPort*> ports_contacts;
+
+    // FrameTransformClient to read the estimate
+    yarp::dev::PolyDriver drv_transform_client;
+    yarp::dev::IFrameTransform* tf_client;
+
+    // name of the frames
+    std::string estimate_frame;
+    std::string root_frame;
+
+    // last recorded estimate
+    yarp::sig::Matrix last_estimate;
+    uint32_t estimate_stream;
+
+    // period
+    double period;
+
+public:
+    /*
+     * Append a record to the log.
+     * @param stream the id of the stream
+     * @param data pointer to the data of the record
+     * @param size the size of the data in bytes
+     */
+    void record(const uint32_t &stream, const void *data, const std::size_t &size);
+
+    /*
+     * Configure the module.
+     * @param rf a previously instantiated @see ResourceFinder
+     */
+    bool configure(yarp::os::ResourceFinder &rf) override;
+
+    /*
+     * Return the module period.
+     */
+    double getPeriod() override;
+
+    /*
+     * Define the behavior of this module.
+     */
+    bool updateModule() override;
+
+    /*
+     * Define the cleanup behavior.
+     */
+    bool close() override;
+};
+
+#endif
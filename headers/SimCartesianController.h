@@ -0,0 +1,338 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef SIM_CARTESIAN_CONTROLLER_H
+#define SIM_CARTESIAN_CONTROLLER_H
+
+// yarp
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/dev/DeviceDriver.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/ControlBoardInterfaces.h>
+#include <yarp/dev/CartesianControl.h>
+
+// icub-main
+#include <iCub/iKin/iKinFwd.h>
+
+// std
+#include <map>
+#include <string>
+#include <vector>
+
+#include "headers/ClockParticipant.h"
+
+/*
+ * Context of the controller
+ * as saved by storeContext().
+ */
+struct SimCartesianContext
+{
+    // enabled degrees of freedom
+    yarp::sig::Vector dof;
+
+    // limits of the joints in degrees
+    yarp::sig::Vector min_limits;
+    yarp::sig::Vector max_limits;
+
+    // rest posture
+    yarp::sig::Vector rest_pos;
+    yarp::sig::Vector rest_weights;
+
+    double traj_time;
+    double in_target_tol;
+    bool tracking_mode;
+    bool reference_mode;
+    std::string pose_priority;
+
+    // tip attached to the end effector
+    yarp::sig::Matrix tip_frame;
+};
+
+/*
+ * Kinematic Cartesian controller for the arms of iCub.
+ *
+ * The device is named simcartesiancontroller and implements the
+ * ICartesianControl interface directly over the control boards
+ * of the arm and of the torso. It does not require the solver
+ * iKinCartesianSolver. At each period the velocities of the joints are
+ * evaluated using the damped least squares inverse of the jacobian of
+ * the iCubArm chain and sent using IVelocityControl2.
+ *
+ * The device accepts the parameters
+ *     robot           prefix of the control boards, e.g. /icubSim
+ *     part            right_arm or left_arm
+ *     local           prefix of the local ports
+ *     period          control period in seconds
+ *     maxVelocity     maximum velocity of the joints in degrees per second
+ *     damping         damping factor of the least squares inverse
+ *     orientationTol  tolerance on the attitude in radians
+ *     clockMaster     acknowledgment port of the clock master, optional
+ *     clockName       name of the participant of the stepped clock
+ *     clockPrefix     namespace prepended to the name of the port of the participant
+ */
+class SimCartesianController : public yarp::dev::DeviceDriver,
+                               public yarp::dev::ICartesianControl,
+                               public yarp::os::PeriodicThread
+{
+private:
+    enum class ControlMode { Idle, Reaching, Streaming };
+
+    // drivers of the arm and of the torso
+    yarp::dev::PolyDriver drv_arm;
+    yarp::dev::PolyDriver drv_torso;
+
+    // views
+    yarp::dev::IEncoders *ienc_arm;
+    yarp::dev::IEncoders *ienc_torso;
+    yarp::dev::IVelocityControl2 *ivel_arm;
+    yarp::dev::IVelocityControl2 *ivel_torso;
+    yarp::dev::IControlMode2 *imod_arm;
+    yarp::dev::IControlMode2 *imod_torso;
+
+    // chain of the arm including the torso
+    // the links of the torso are in reversed order
+    // with respect to the joints of the control board
+    iCub::iKin::iCubArm chain;
+    std::string arm_type;
+
+    // physical limits of the chain in degrees
+    yarp::sig::Vector phys_min_limits;
+    yarp::sig::Vector phys_max_limits;
+
+    // current context and stored contexts
+    SimCartesianContext context;
+    std::map<int, SimCartesianContext> contexts;
+    int next_context_id;
+
+    // state of the controller
+    ControlMode mode;
+    yarp::sig::Vector q;
+    yarp::sig::Vector qdot;
+    yarp::sig::Vector x;
+    yarp::sig::Vector o;
+    yarp::os::Stamp stamp;
+    bool is_pose_available;
+
+    // target of the current motion
+    yarp::sig::Vector xd;
+    yarp::sig::Vector od;
+    bool is_position_only;
+    double motion_traj_time;
+    double motion_start;
+    bool is_motion_done;
+    bool is_torso_commanded;
+    bool are_joints_moving;
+
+    // task velocities in streaming mode
+    yarp::sig::Vector xdot_ref;
+    yarp::sig::Vector wdot_ref;
+
+    // parameters
+    double max_velocity;
+    double damping;
+    double orientation_tol;
+
+    // registered events
+    std::vector<yarp::dev::CartesianEvent*> events;
+
+    // participant of the stepped clock, if any
+    ClockParticipant clock;
+
+    // mutex required to share the state
+    // between the control thread and the callers
+    yarp::os::Mutex mutex;
+
+    /*
+     * Read the joints of the chain from the encoders.
+     * @param joints the joints in degrees
+     * @return true/false on success/failure
+     */
+    bool readJoints(yarp::sig::Vector &joints);
+
+    /*
+     * Send the velocities to the control boards.
+     * @param velocities the velocities of the chain in degrees per second
+     * @param use_torso whether the torso has to be commanded
+     * @return true/false on success/failure
+     */
+    bool sendVelocities(const yarp::sig::Vector &velocities,
+			const bool &use_torso);
+
+    /*
+     * Put the joints of the chain in velocity mode.
+     * @param use_torso whether the torso has to be commanded
+     * @return true/false on success/failure
+     */
+    bool setVelocityMode(const bool &use_torso);
+
+    /*
+     * Evaluate the pose of the end effector.
+     * Assumes that the mutex is held.
+     * @param joints the joints in degrees
+     * @param pos the position
+     * @param att the attitude in axis-angle representation
+     */
+    void forwardKinematics(const yarp::sig::Vector &joints,
+			   yarp::sig::Vector &pos,
+			   yarp::sig::Vector &att);
+
+    /*
+     * Evaluate the error between the end effector and a target.
+     * Assumes that the mutex is held.
+     * @param joints the joints in degrees
+     * @param pos the target position
+     * @param att the target attitude in axis-angle representation
+     * @param position_only whether the attitude has to be ignored
+     * @return the position error followed by the attitude error
+     */
+    yarp::sig::Vector poseError(const yarp::sig::Vector &joints,
+				const yarp::sig::Vector &pos,
+				const yarp::sig::Vector &att,
+				const bool &position_only);
+
+    /*
+     * Evaluate the velocities of the joints achieving a task velocity
+     * using the damped least squares inverse of the jacobian.
+     * Joints that are outside their limits are moved back within.
+     * Assumes that the mutex is held.
+     * @param joints the joints in degrees
+     * @param task_vel the linear velocity followed by the angular one
+     * @param position_only whether the angular velocity has to be ignored
+     * @param gain the gain used to recover the limits and the rest posture
+     * @return the velocities of the joints in degrees per second
+     */
+    yarp::sig::Vector solveVelocities(const yarp::sig::Vector &joints,
+				      const yarp::sig::Vector &task_vel,
+				      const bool &position_only,
+				      const double &gain);
+
+    /*
+     * Find a configuration of the joints achieving a pose
+     * by integrating the damped least squares inverse offline.
+     * Assumes that the mutex is held.
+     * @param q0 the initial configuration in degrees
+     * @param pos the target position
+     * @param att the target attitude in axis-angle representation
+     * @param position_only whether the attitude has to be ignored
+     * @param qhat the configuration found in degrees
+     */
+    void solvePose(const yarp::sig::Vector &q0,
+		   const yarp::sig::Vector &pos,
+		   const yarp::sig::Vector &att,
+		   const bool &position_only,
+		   yarp::sig::Vector &qhat);
+
+    /*
+     * Start a reaching motion.
+     */
+    bool startMotion(const yarp::sig::Vector &pos,
+		     const yarp::sig::Vector &att,
+		     const bool &position_only,
+		     const double &t);
+
+    /*
+     * Collect the registered events of a given type.
+     * Assumes that the mutex is held.
+     */
+    void collectEvents(const std::string &type,
+		       std::vector<yarp::dev::CartesianEvent*> &fired);
+
+    /*
+     * Invoke the callbacks of the events.
+     * The mutex should not be held.
+     */
+    void fireEvents(const std::string &type,
+		    const std::vector<yarp::dev::CartesianEvent*> &fired);
+
+public:
+    SimCartesianController();
+
+    // DeviceDriver
+    bool open(yarp::os::Searchable &config) override;
+    bool close() override;
+
+    // PeriodicThread
+    void run() override;
+
+    // ICartesianControl
+    bool setTrackingMode(const bool f) override;
+    bool getTrackingMode(bool *f) override;
+    bool setReferenceMode(const bool f) override;
+    bool getReferenceMode(bool *f) override;
+    bool setPosePriority(const std::string &p) override;
+    bool getPosePriority(std::string &p) override;
+    bool getPose(yarp::sig::Vector &x, yarp::sig::Vector &o,
+		 yarp::os::Stamp *stamp = nullptr) override;
+    bool getPose(const int axis, yarp::sig::Vector &x, yarp::sig::Vector &o,
+		 yarp::os::Stamp *stamp = nullptr) override;
+    bool goToPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+		  const double t = 0.0) override;
+    bool goToPosition(const yarp::sig::Vector &xd, const double t = 0.0) override;
+    bool goToPoseSync(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+		      const double t = 0.0) override;
+    bool goToPositionSync(const yarp::sig::Vector &xd, const double t = 0.0) override;
+    bool getDesired(yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+		    yarp::sig::Vector &qdhat) override;
+    bool askForPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+		    yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+		    yarp::sig::Vector &qdhat) override;
+    bool askForPose(const yarp::sig::Vector &q0,
+		    const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+		    yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+		    yarp::sig::Vector &qdhat) override;
+    bool askForPosition(const yarp::sig::Vector &xd,
+			yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+			yarp::sig::Vector &qdhat) override;
+    bool askForPosition(const yarp::sig::Vector &q0,
+			const yarp::sig::Vector &xd,
+			yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+			yarp::sig::Vector &qdhat) override;
+    bool getDOF(yarp::sig::Vector &curDof) override;
+    bool setDOF(const yarp::sig::Vector &newDof, yarp::sig::Vector &curDof) override;
+    bool getRestPos(yarp::sig::Vector &curRestPos) override;
+    bool setRestPos(const yarp::sig::Vector &newRestPos,
+		    yarp::sig::Vector &curRestPos) override;
+    bool getRestWeights(yarp::sig::Vector &curRestWeights) override;
+    bool setRestWeights(const yarp::sig::Vector &newRestWeights,
+			yarp::sig::Vector &curRestWeights) override;
+    bool getLimits(const int axis, double *min, double *max) override;
+    bool setLimits(const int axis, const double min, const double max) override;
+    bool getTrajTime(double *t) override;
+    bool setTrajTime(const double t) override;
+    bool getInTargetTol(double *tol) override;
+    bool setInTargetTol(const double tol) override;
+    bool getJointsVelocities(yarp::sig::Vector &qdot) override;
+    bool getTaskVelocities(yarp::sig::Vector &xdot, yarp::sig::Vector &odot) override;
+    bool setTaskVelocities(const yarp::sig::Vector &xdot,
+			   const yarp::sig::Vector &odot) override;
+    bool attachTipFrame(const yarp::sig::Vector &x, const yarp::sig::Vector &o) override;
+    bool getTipFrame(yarp::sig::Vector &x, yarp::sig::Vector &o) override;
+    bool removeTipFrame() override;
+    bool checkMotionDone(bool *f) override;
+    bool waitMotionDone(const double period = 0.1, const double timeout = 0.0) override;
+    bool stopControl() override;
+    bool storeContext(int *id) override;
+    bool restoreContext(const int id) override;
+    bool deleteContext(const int id) override;
+    bool getInfo(yarp::os::Bottle &info) override;
+    bool registerEvent(yarp::dev::CartesianEvent &event) override;
+    bool unregisterEvent(yarp::dev::CartesianEvent &event) override;
+    bool tweakSet(const yarp::os::Bottle &options) override;
+    bool tweakGet(yarp::os::Bottle &options) override;
+};
+
+#endif
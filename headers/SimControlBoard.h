@@ -0,0 +1,196 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef SIM_CONTROL_BOARD_H
+#define SIM_CONTROL_BOARD_H
+
+// yarp
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/dev/DeviceDriver.h>
+#include <yarp/dev/ControlBoardInterfaces.h>
+
+// std
+#include <vector>
+
+/*
+ * Kinematic control board, i.e. a control board
+ * whose joints follow exactly the commanded references.
+ *
+ * The device is named simcontrolboard and accepts the parameters
+ *     joints     number of joints
+ *     home       (q_0 ... q_n) initial position in degrees
+ *     minLimits  (q_0 ... q_n) lower limits in degrees
+ *     maxLimits  (q_0 ... q_n) upper limits in degrees
+ *     maxVelocity maximum velocity in degrees per second
+ *
+ * The state of the joints is integrated by the owner of the device
+ * using the method step().
+ */
+class SimControlBoard : public yarp::dev::DeviceDriver,
+                        public yarp::dev::IEncodersTimed,
+                        public yarp::dev::IPositionControl2,
+                        public yarp::dev::IVelocityControl2,
+                        public yarp::dev::IControlMode2
+{
+private:
+    // number of joints
+    int joints;
+
+    // state of the joints in degrees and degrees per second
+    std::vector<double> positions;
+    std::vector<double> velocities;
+
+    // time of the last integration step
+    double stamp;
+
+    // references of the position control
+    std::vector<double> targets;
+    std::vector<double> ref_speeds;
+    std::vector<bool> is_motion_done;
+
+    // references of the velocity control
+    std::vector<double> ref_velocities;
+
+    // reference accelerations
+    // the motion is kinematic, i.e. the velocities change instantly,
+    // hence they are only stored
+    std::vector<double> ref_accelerations;
+
+    // control modes
+    std::vector<int> modes;
+
+    // limits
+    std::vector<double> min_limits;
+    std::vector<double> max_limits;
+    double max_velocity;
+
+    // mutex required to share the state
+    // between the wrapper and the owner of the device
+    yarp::os::Mutex mutex;
+
+    /*
+     * Load a vector of doubles from the configuration.
+     * @param config the configuration
+     * @param key the key of the vector
+     * @param default_value the value used if the key is missing
+     * @param vector the vector
+     * @return true/false on success/failure
+     */
+    bool loadVector(yarp::os::Searchable &config,
+		    const std::string &key,
+		    const double &default_value,
+		    std::vector<double> &vector);
+
+    /*
+     * Check the index of a joint.
+     */
+    bool isJoint(const int &j) const;
+
+    /*
+     * Clamp a position within the limits of a joint.
+     */
+    double clamp(const int &j, const double &position) const;
+
+    /*
+     * Set a position target of a joint.
+     * Assumes that the mutex is held.
+     */
+    bool setTarget(const int &j, const double &target);
+
+    /*
+     * Set a velocity reference of a joint.
+     * Assumes that the mutex is held.
+     */
+    bool setVelocity(const int &j, const double &velocity);
+
+    /*
+     * Set the control mode of a joint.
+     * Assumes that the mutex is held.
+     */
+    bool setMode(const int &j, const int &mode);
+
+public:
+    SimControlBoard();
+
+    /*
+     * Integrate the state of the joints.
+     * @param dt the integration step in seconds
+     * @param time the time at the end of the step
+     */
+    void step(const double &dt, const double &time);
+
+    // DeviceDriver
+    bool open(yarp::os::Searchable &config) override;
+    bool close() override;
+
+    // IEncodersTimed
+    bool getAxes(int *ax) override;
+    bool resetEncoder(int j) override;
+    bool resetEncoders() override;
+    bool setEncoder(int j, double val) override;
+    bool setEncoders(const double *vals) override;
+    bool getEncoder(int j, double *v) override;
+    bool getEncoders(double *encs) override;
+    bool getEncoderSpeed(int j, double *sp) override;
+    bool getEncoderSpeeds(double *spds) override;
+    bool getEncoderAcceleration(int j, double *spds) override;
+    bool getEncoderAccelerations(double *accs) override;
+    bool getEncodersTimed(double *encs, double *time) override;
+    bool getEncoderTimed(int j, double *encs, double *time) override;
+
+    // IPositionControl2
+    bool positionMove(int j, double ref) override;
+    bool positionMove(const double *refs) override;
+    bool positionMove(const int n_joint, const int *joints, const double *refs) override;
+    bool relativeMove(int j, double delta) override;
+    bool relativeMove(const double *deltas) override;
+    bool relativeMove(const int n_joint, const int *joints, const double *deltas) override;
+    bool checkMotionDone(int j, bool *flag) override;
+    bool checkMotionDone(bool *flag) override;
+    bool checkMotionDone(const int n_joint, const int *joints, bool *flag) override;
+    bool setRefSpeed(int j, double sp) override;
+    bool setRefSpeeds(const double *spds) override;
+    bool setRefSpeeds(const int n_joint, const int *joints, const double *spds) override;
+    bool setRefAcceleration(int j, double acc) override;
+    bool setRefAccelerations(const double *accs) override;
+    bool setRefAccelerations(const int n_joint, const int *joints, const double *accs) override;
+    bool getRefSpeed(int j, double *ref) override;
+    bool getRefSpeeds(double *spds) override;
+    bool getRefSpeeds(const int n_joint, const int *joints, double *spds) override;
+    bool getRefAcceleration(int j, double *acc) override;
+    bool getRefAccelerations(double *accs) override;
+    bool getRefAccelerations(const int n_joint, const int *joints, double *accs) override;
+    bool stop(int j) override;
+    bool stop() override;
+    bool stop(const int n_joint, const int *joints) override;
+    bool getTargetPosition(const int joint, double *ref) override;
+    bool getTargetPositions(double *refs) override;
+    bool getTargetPositions(const int n_joint, const int *joints, double *refs) override;
+
+    // IVelocityControl2
+    bool velocityMove(int j, double sp) override;
+    bool velocityMove(const double *sp) override;
+    bool velocityMove(const int n_joint, const int *joints, const double *spds) override;
+    bool getRefVelocity(const int joint, double *vel) override;
+    bool getRefVelocities(double *vels) override;
+    bool getRefVelocities(const int n_joint, const int *joints, double *vels) override;
+
+    // IControlMode2
+    bool getControlMode(int j, int *mode) override;
+    bool getControlModes(int *modes) override;
+    bool getControlModes(const int n_joint, const int *joints, int *modes) override;
+    bool setControlMode(const int j, const int mode) override;
+    bool setControlModes(const int n_joint, const int *joints, int *modes) override;
+    bool setControlModes(int *modes) override;
+};
+
+#endif
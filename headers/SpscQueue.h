@@ -0,0 +1,102 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*
+ * Bounded lock-free queue with a single producer and a single consumer.
+ *
+ * push() has to be called always by the same thread,
+ * pop() has to be called always by the same (other) thread.
+ */
+template <typename T>
+class SpscQueue
+{
+private:
+    // one slot is always left empty
+    // in order to distinguish a full queue from an empty one
+    std::vector<T> slots;
+
+    // next slot to be read, written by the consumer only
+    std::atomic<std::size_t> head;
+
+    // next slot to be written, written by the producer only
+    std::atomic<std::size_t> tail;
+
+    std::size_t next(const std::size_t &index) const
+    {
+	return (index + 1) % slots.size();
+    }
+
+public:
+    /*
+     * Constructor
+     * @param capacity the maximum number of items in the queue
+     */
+    SpscQueue(const std::size_t &capacity) :
+	slots(capacity + 1),
+	head(0),
+	tail(0) { }
+
+    /*
+     * Push an item.
+     * To be called by the producer only.
+     * @param item the item
+     * @return false if the queue is full
+     */
+    bool push(T item)
+    {
+	std::size_t current = tail.load(std::memory_order_relaxed);
+	if (next(current) == head.load(std::memory_order_acquire))
+	    return false;
+
+	slots[current] = std::move(item);
+	tail.store(next(current), std::memory_order_release);
+
+	return true;
+    }
+
+    /*
+     * Pop an item.
+     * To be called by the consumer only.
+     * @param item the item
+     * @return false if the queue is empty
+     */
+    bool pop(T &item)
+    {
+	std::size_t current = head.load(std::memory_order_relaxed);
+	if (current == tail.load(std::memory_order_acquire))
+	    return false;
+
+	item = std::move(slots[current]);
+	head.store(next(current), std::memory_order_release);
+
+	return true;
+    }
+
+    /*
+     * Check if the queue is empty.
+     * The result might be outdated as soon as it is returned.
+     */
+    bool empty() const
+    {
+	return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+// yarp
+#include <yarp/os/Mutex.h>
+
+// std
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Call a readiness probe until it succeeds or the timeout expires.
+ * The delay between two attempts starts from initial_delay and is
+ * doubled after each failure up to max_delay, so that resources
+ * available early are detected quickly without flooding those
+ * that take long to start. The system clock is used.
+ * @param probe the probe, returning true when ready
+ * @param timeout the timeout in seconds
+ * @param initial_delay the delay after the first failure in seconds
+ * @param max_delay the maximum delay in seconds
+ * @return true if the probe succeeded before the timeout
+ */
+bool waitWithBackoff(const std::function<bool()> &probe, const double &timeout,
+		     const double &initial_delay = 0.02, const double &max_delay = 1.0);
+
+/*
+ * Start and end times of the steps of the startup of a module
+ * measured on the system clock. Steps can be recorded
+ * concurrently from several threads.
+ */
+class StartupTimeline
+{
+private:
+    struct Step
+    {
+	std::string name;
+	double start;
+	double end;
+	bool is_done;
+	bool is_ok;
+    };
+
+    // name of the module used in the report
+    std::string owner;
+
+    // time at which the timeline was created
+    double origin;
+
+    std::vector<Step> steps;
+
+    // mutex required to record steps from several threads
+    mutable yarp::os::Mutex mutex;
+
+public:
+    /*
+     * Constructor
+     * @param owner the name of the module
+     */
+    StartupTimeline(const std::string &owner);
+
+    /*
+     * Record the beginning of a step.
+     * @param name the name of the step
+     * @return the index of the step
+     */
+    std::size_t begin(const std::string &name);
+
+    /*
+     * Record the end of a step.
+     * @param step the index returned by begin()
+     * @param is_ok whether the step succeeded
+     */
+    void end(const std::size_t &step, const bool &is_ok);
+
+    /*
+     * Print the start, the end and the duration of each step
+     * w.r.t. the creation of the timeline.
+     */
+    void report() const;
+};
+
+#endif
@@ -15,21 +15,25 @@
 // yarp
 #include <yarp/sig/Vector.h>
 
+#include "headers/PolynomialTrajectory.h"
+
+/*
+ * Rest-to-rest quintic trajectory of a 3D point.
+ * The evaluation does not allocate provided that
+ * the output vectors already have size 3.
+ */
 class TrajectoryGenerator
 {
 private:
 
     // initial position
-    yarp::sig::Vector pos_i;
+    double pos_i[3];
 
     // final position
-    yarp::sig::Vector pos_f;
+    double pos_f[3];
 
-    // polynomoinal trajectory constants
-    yarp::sig::Vector a0;
-    yarp::sig::Vector a3;
-    yarp::sig::Vector a4;
-    yarp::sig::Vector a5;
+    // polynomial trajectory
+    PolynomialTrajectory<3, 5> trajectory;
 
     // trajectory duration
     double traj_duration;
@@ -76,6 +80,19 @@ public:
     bool getTrajectory(const double &time,
 		       yarp::sig::Vector &position,
 		       yarp::sig::Vector &velocity);
+
+    /**
+     * Get the trajectory positions and velocities at several times.
+     * The outputs are stored by coordinate, i.e. x, y and z of the
+     * k-th sample are at indexes k, count + k and 2 * count + k.
+     * @param times the count values of the time
+     * @param count the number of samples
+     * @param positions the 3 * count coordinates of the positions
+     * @param velocities the 3 * count coordinates of the velocities
+     * @return true/false on success/failure
+     */
+    bool getTrajectory(const double *times, const std::size_t &count,
+		       double *positions, double *velocities) const;
 };
 
 #endif
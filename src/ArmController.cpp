@@ -10,52 +10,59 @@
  */
 
 #include "headers/ArmController.h"
+#include "headers/StartupTimeline.h"
 
 #include <cmath>
+#include <thread>
 
 using namespace yarp::math;
 
-bool RightArmController::configure()
+bool RightArmController::configure(const bool &use_sim_controller,
+				   const std::string &clock_master,
+				   const std::string &prefix)
 {
-    return ArmController::configure("right");
+    return ArmController::configure("right", use_sim_controller, clock_master, prefix);
 }
 
-bool LeftArmController::configure()
+bool LeftArmController::configure(const bool &use_sim_controller,
+				  const std::string &clock_master,
+				  const std::string &prefix)
 {
-    return ArmController::configure("left");
+    return ArmController::configure("left", use_sim_controller, clock_master, prefix);
 }
 
-bool ArmController::configure(const std::string &which_arm)
+bool ArmController::openCartesian(const bool &use_sim_controller,
+				  const std::string &clock_master,
+				  const std::string &prefix)
 {
     yarp::os::Property prop;
     bool ok;
 
-    // set default value for flag
-    is_tip_attached = false;
-
-    // store which arm
-    this->which_arm = which_arm;
-
     // prepare properties for the CartesianController
-    prop.put("device", "cartesiancontrollerclient");
-    prop.put("remote", "/icubSim/cartesianController/" + which_arm + "_arm");
-    prop.put("local", "/" + which_arm + "_arm_controller/cartesian_client");
+    if (use_sim_controller)
+    {
+	// kinematic controller running within this process
+	// over the control boards of the arm and of the torso
+	prop.put("device", "simcartesiancontroller");
+	prop.put("robot", prefix + "/icubSim");
+	prop.put("part", which_arm + "_arm");
+	prop.put("local", prefix + "/" + which_arm + "_arm_controller/sim_cartesian");
+	prop.put("clockMaster", clock_master);
+	prop.put("clockName", "vis_tac_localization/cartesian/" + which_arm);
+	prop.put("clockPrefix", prefix);
+    }
+    else
+    {
+	prop.put("device", "cartesiancontrollerclient");
+	prop.put("remote", prefix + "/icubSim/cartesianController/" + which_arm + "_arm");
+	prop.put("local", prefix + "/" + which_arm + "_arm_controller/cartesian_client");
+    }
 
     // let's give the controller some time to warm up
     // here use real time and not simulation time
-    ok = false;
-    double t0 = yarp::os::SystemClock::nowSystem();
-    while (yarp::os::SystemClock::nowSystem() - t0 < 10.0)
-    {
-	// this might fail if controller
-	// is not connected to solver yet
-	if (drv_cart.open(prop))
-	{
-	    ok = true;
-	    break;
-	}
-	yarp::os::SystemClock::delaySystem(1.0);
-    }
+    // this might fail if controller
+    // is not connected to solver yet
+    ok = waitWithBackoff([&]() { return drv_cart.open(prop); }, 10.0);
     if (!ok)
     {
 	yError() << "ArmController: Unable to open the Cartesian Controller driver"
@@ -85,19 +92,34 @@ bool ArmController::configure(const std::string &which_arm)
 
     // store home pose
     // wait until the pose is available
-    while(!icart->getPose(home_pos, home_att))
-	yarp::os::Time::yield();
+    ok = waitWithBackoff([&]() { return icart->getPose(home_pos, home_att); }, 10.0, 0.005, 0.1);
+    if (!ok)
+    {
+	yError() << "ArmController: the pose of the"
+		 << which_arm
+		 << "arm is not available";
+	return false;
+    }
 
     // configure default hand attitude
     setHandAttitude(0, 0, 0);
 
+    return true;
+}
+
+bool ArmController::openEncoders(const std::string &prefix)
+{
+    yarp::os::Property prop;
+    bool ok;
+
     // prepare properties for the Encoders
     // these are required to retrieve forward kinematics of the hand
     // without relying on the cartesian controller
+    // the control boards might not be ready yet
     prop.put("device", "remote_controlboard");
-    prop.put("remote", "/icubSim/" + which_arm + "_arm");
-    prop.put("local", "/" + which_arm + "_arm_controller/encoder/arm");
-    ok = drv_enc_arm.open(prop);
+    prop.put("remote", prefix + "/icubSim/" + which_arm + "_arm");
+    prop.put("local", prefix + "/" + which_arm + "_arm_controller/encoder/arm");
+    ok = waitWithBackoff([&]() { return drv_enc_arm.open(prop); }, 10.0);
     if (!ok)
     {
 	yError() << "ArmController: unable to open the Remote Control Board driver"
@@ -107,9 +129,9 @@ bool ArmController::configure(const std::string &which_arm)
 	return false;
     }
 
-    prop.put("remote", "/icubSim/torso");
-    prop.put("local", "/" + which_arm + "_arm_controller/encoder/torso");
-    ok = drv_enc_torso.open(prop);
+    prop.put("remote", prefix + "/icubSim/torso");
+    prop.put("local", prefix + "/" + which_arm + "_arm_controller/encoder/torso");
+    ok = waitWithBackoff([&]() { return drv_enc_torso.open(prop); }, 10.0);
     if (!ok)
     {
 	yError() << "ArmController: unable to open the Remote Control Board driver"
@@ -117,6 +139,33 @@ bool ArmController::configure(const std::string &which_arm)
 	return false;
     }
 
+    return true;
+}
+
+bool ArmController::configure(const std::string &which_arm,
+			      const bool &use_sim_controller,
+			      const std::string &clock_master,
+			      const std::string &prefix)
+{
+    bool ok;
+
+    // set default value for flag
+    is_tip_attached = false;
+    stored_is_tip_attached = false;
+    is_homing = false;
+
+    // store which arm
+    this->which_arm = which_arm;
+
+    // the drivers of the encoders do not depend on the
+    // cartesian controller hence they are opened concurrently
+    bool is_encoders_ok = false;
+    std::thread encoders_thread([&]() { is_encoders_ok = openEncoders(prefix); });
+    bool is_cartesian_ok = openCartesian(use_sim_controller, clock_master, prefix);
+    encoders_thread.join();
+    if (!is_cartesian_ok || !is_encoders_ok)
+	return false;
+
     // try to retrieve the views
     ok = drv_enc_arm.view(ienc_arm);
     if (!ok || ienc_arm == 0)
@@ -146,9 +195,59 @@ bool ArmController::configure(const std::string &which_arm)
     arm_chain.releaseLink(1);
     arm_chain.releaseLink(2);
 
+    // allocate the storage of the encoders
+    int n_encs;
+    ok = ienc_arm->getAxes(&n_encs);
+    if (!ok)
+    {
+	yError() << "ArmController: unable to get the number of axes"
+		 << "of the"
+		 << which_arm
+		 << "arm";
+	return false;
+    }
+    arm_encs.resize(n_encs, 0.0);
+
+    // instantiate the finger chains
+    initFingerTips();
+
     return true;
 }
 
+void ArmController::initFingerTips()
+{
+    for (const char *finger_name : {"thumb", "index", "middle", "ring", "little"})
+    {
+	FingerTip &finger = finger_tips[finger_name];
+	finger.chain = iCub::iKin::iCubFinger(which_arm + "_" + std::string(finger_name));
+	finger.is_valid = false;
+    }
+
+    // the joints of the fingers are quantized
+    // in order to reuse the tip evaluated previously
+    tip_quantization = 0.5;
+
+    // only the positional part of the tip is used
+    yarp::sig::Matrix identity(3, 3);
+    identity.eye();
+    tip_attitude = yarp::math::dcm2axis(identity);
+}
+
+bool ArmController::readArmEncoders(yarp::sig::Vector &encs)
+{
+    return ienc_arm->getEncoders(encs.data());
+}
+
+bool ArmController::attachTip(const yarp::sig::Vector &x, const yarp::sig::Vector &o)
+{
+    return icart->attachTipFrame(x, o);
+}
+
+bool ArmController::removeTip()
+{
+    return icart->removeTipFrame();
+}
+
 void ArmController::close()
 {
     // stop the cartesian controller
@@ -274,47 +373,64 @@ bool ArmController::useFingerFrame(const std::string& finger_name)
 {
     bool ok;
 
-    if (is_tip_attached)
+    std::map<std::string, FingerTip>::iterator it = finger_tips.find(finger_name);
+    if (it == finger_tips.end())
     {
-	// since a tip is already attached
-	// first it is required to detach it
-	ok = removeFingerFrame();
-	if (!ok)
-	    return false;
+	yError() << "ArmController::useFingerFrame"
+		 << "Error: unknown finger" << finger_name;
+	return false;
     }
-    
-    // update tip status
-    is_tip_attached = true;
+    FingerTip &finger = it->second;
 
     // get current value of encoders
-    int n_encs;
-    ok = ienc_arm->getAxes(&n_encs);
+    ok = readArmEncoders(arm_encs);
     if(!ok)
 	return false;
 
-    yarp::sig::Vector encs(n_encs);
-    ok = ienc_arm->getEncoders(encs.data());
-    if(!ok)
+    // get the joints of the finger
+    ok = finger.chain.getChainJoints(arm_encs, finger_joints);
+    if (!ok)
 	return false;
 
+    // quantize the joints
+    finger_key.resize(finger_joints.size());
+    for (size_t i = 0; i < finger_joints.size(); i++)
+	finger_key[i] = static_cast<int>(std::round(finger_joints[i] / tip_quantization));
+
     // get the transformation between the standard
     // effector and the desired finger
-    yarp::sig::Vector joints;
-    iCub::iKin::iCubFinger finger(which_arm + "_" + finger_name);
-    ok = finger.getChainJoints(encs,joints);
-    if (!ok)
-	return false;
-    yarp::sig::Matrix tip_frame = finger.getH((M_PI/180.0)*joints);
+    // if the joints changed
+    if (!finger.is_valid || finger.key != finger_key)
+    {
+	yarp::sig::Matrix tip_frame = finger.chain.getH((M_PI/180.0)*finger_joints);
+	finger.tip_x = tip_frame.getCol(3);
+	finger.key = finger_key;
+	finger.is_valid = true;
+    }
+
+    // the tip is already attached
+    if (is_tip_attached && attached_finger == finger_name && attached_key == finger.key)
+	return true;
+
+    if (is_tip_attached)
+    {
+	// since a tip is already attached
+	// first it is required to detach it
+	ok = removeFingerFrame();
+	if (!ok)
+	    return false;
+    }
 
     // attach the tip taking into account only the positional part
-    yarp::sig::Vector tip_x = tip_frame.getCol(3);
-    yarp::sig::Matrix identity(3, 3);
-    identity.eye();
-    yarp::sig::Vector tip_a = yarp::math::dcm2axis(identity);
-    ok = icart->attachTipFrame(tip_x, tip_a);
+    ok = attachTip(finger.tip_x, tip_attitude);
     if(!ok)
 	return false;
 
+    // update tip status
+    is_tip_attached = true;
+    attached_finger = finger_name;
+    attached_key = finger.key;
+
     return true;
 }
 
@@ -322,9 +438,9 @@ bool ArmController::removeFingerFrame()
 {
     bool ok;
 
-    is_tip_attached = false;
-
-    ok = icart->removeTipFrame();
+    // the status of the tip is changed only once the controller
+    // removed it, otherwise the tip is still attached
+    ok = removeTip();
     if (!ok)
     {
 	yError() << "ArmController::removeFingerFrame"
@@ -333,6 +449,10 @@ bool ArmController::removeFingerFrame()
 	return false;
     }
 
+    is_tip_attached = false;
+    attached_finger.clear();
+    attached_key.clear();
+
     return true;
 }
 
@@ -374,6 +494,23 @@ bool ArmController::goHome()
 {
     bool ok;
 
+    ok = startGoHome();
+    if (!ok)
+	return false;
+
+    icart->waitMotionDone(0.03, 5.0);
+
+    return finishGoHome();
+}
+
+bool ArmController::startGoHome()
+{
+    bool ok;
+
+    // a homing is already running
+    if (is_homing)
+	return true;
+
     // since this function may be called for both
     // right and left arms it should be taken into account
     // the fact that different IK solutions for the torso
@@ -382,18 +519,23 @@ bool ArmController::goHome()
     // 0, 0, 0
 
     // store the context
-    int current_context;
-    ok = icart->storeContext(&current_context);
+    ok = icart->storeContext(&home_context);
     if (!ok)
 	return false;
+    is_homing = true;
 
     // remove finger tip in case it is attached
-    bool tip_status = is_tip_attached;
+    home_is_tip_attached = is_tip_attached;
+    home_finger = attached_finger;
+    home_key = attached_key;
     if (is_tip_attached)
     {
 	ok = removeFingerFrame();
 	if (!ok)
+	{
+	    finishGoHome();
 	    return false;
+	}
     }
 
     // force the IK to use 0, 0, 0
@@ -403,35 +545,74 @@ bool ArmController::goHome()
     ok &= icart->setLimits(2,0.0,0.0);
     if (!ok)
     {
-	yError() << "ArmController::goHome"
+	yError() << "ArmController::startGoHome"
 		 << "Error: unable to force torso solution to 0 for the"
 		 << which_arm << "arm";
+	finishGoHome();
 	return false;
     }
 
     // restore home position
+    // the synchronous version waits for the solver only
+    // so that checkMotionDone() refers to the new motion
     ok = icart->goToPoseSync(home_pos, home_att);
     if (!ok)
     {
-	yError() << "ArmController::goHome"
+	yError() << "ArmController::startGoHome"
 		 << "Error: unable to command home position for the"
 		 << which_arm << "arm";
+	finishGoHome();
 	return false;
     }
-    icart->waitMotionDone(0.03, 5.0);
+
+    return true;
+}
+
+bool ArmController::checkGoHomeDone(bool &is_done)
+{
+    is_done = true;
+    if (!is_homing)
+	return true;
+
+    bool ok = icart->checkMotionDone(&is_done);
+    if (!ok)
+	return false;
+
+    if (is_done)
+	return finishGoHome();
+
+    return true;
+}
+
+bool ArmController::stopGoHome()
+{
+    if (!is_homing)
+	return true;
+
+    bool ok = icart->stopControl();
+    ok &= finishGoHome();
+
+    return ok;
+}
+
+bool ArmController::finishGoHome()
+{
+    is_homing = false;
 
     // restore the context
-    ok = icart->restoreContext(current_context);
+    bool ok = icart->restoreContext(home_context);
     if (!ok)
     {
-	yError() << "ArmController::goHome"
+	yError() << "ArmController::finishGoHome"
 		 << "Error: unable to restore the previous context for the"
 		 << which_arm << "arm";
 	return false;
     }
     // the restoreContext also restore the finger tip if it was attached
     // hence it is required to restore the original state
-    is_tip_attached = tip_status;
+    is_tip_attached = home_is_tip_attached;
+    attached_finger = home_finger;
+    attached_key = home_key;
 
     return true;
 }
@@ -444,9 +625,18 @@ void ArmController::goToPos(const yarp::sig::Vector &pos)
 void ArmController::storeContext()
 {
     icart->storeContext(&curr_cart_context);
+
+    // the context includes the tip
+    stored_is_tip_attached = is_tip_attached;
+    stored_finger = attached_finger;
+    stored_key = attached_key;
 }
 
 void ArmController::restoreContext()
 {
     icart->restoreContext(curr_cart_context);
+
+    is_tip_attached = stored_is_tip_attached;
+    attached_finger = stored_finger;
+    attached_key = stored_key;
 }
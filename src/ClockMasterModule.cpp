@@ -0,0 +1,324 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/SystemClock.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "headers/ClockMasterModule.h"
+
+namespace
+{
+    const double ns_per_second = 1e9;
+
+    // times are rounded up to the nanosecond
+    // so that the published time is never earlier than
+    // the time waited by a participant
+    int64_t toNanoseconds(const double &seconds)
+    {
+	return static_cast<int64_t>(std::ceil(seconds * ns_per_second));
+    }
+
+    double toSeconds(const int64_t &nanoseconds)
+    {
+	return nanoseconds / ns_per_second;
+    }
+}
+
+void ClockAckPort::setMaster(ClockMasterModule *master)
+{
+    this->master = master;
+}
+
+void ClockAckPort::onRead(yarp::os::Bottle &ack)
+{
+    if (ack.size() != 2)
+    {
+	yWarning() << "ClockAckPort: malformed acknowledgment" << ack.toString();
+	return;
+    }
+
+    master->acknowledge(ack.get(0).asString(), ack.get(1).asDouble());
+}
+
+ClockMasterModule::ClockMasterModule() :
+    semaphore(0),
+    now(0),
+    step(0),
+    max_step(0),
+    max_speed_up(0.0),
+    ack_timeout(0.0),
+    tick_wall_time(0.0),
+    report_period(0.0),
+    start_time(0),
+    start_wall_time(0.0),
+    report_time(0),
+    report_wall_time(0.0),
+    ticks(0)
+{
+}
+
+void ClockMasterModule::acknowledge(const std::string &name, const double &wake_time)
+{
+    mutex.lock();
+
+    if (wake_time < 0.0)
+    {
+	participants.erase(name);
+	yInfo() << "ClockMasterModule: participant" << name << "left";
+    }
+    else
+    {
+	if (joined.find(name) == joined.end())
+	{
+	    joined.insert(name);
+	    yInfo() << "ClockMasterModule: participant" << name << "joined";
+	}
+
+	Participant &participant = participants[name];
+	participant.wake_time = toNanoseconds(wake_time);
+	participant.is_late = false;
+    }
+
+    mutex.unlock();
+
+    semaphore.post();
+}
+
+int64_t ClockMasterModule::nextTime(const double &wall_now)
+{
+    bool is_stepping = std::all_of(expected.begin(), expected.end(),
+				   [this](const std::string &name)
+				   { return joined.find(name) != joined.end(); });
+
+    // until all the participants have joined
+    // or if all of them left the clock runs in real time
+    if (!is_stepping || participants.empty())
+    {
+	if (wall_now - tick_wall_time >= toSeconds(step))
+	    return now + step;
+	return -1;
+    }
+
+    // the clock is advanced when all the participants
+    // are waiting for a future time
+    int64_t next = std::numeric_limits<int64_t>::max();
+    for (auto &item : participants)
+    {
+	Participant &participant = item.second;
+	if (participant.wake_time <= now)
+	{
+	    if (wall_now - tick_wall_time < ack_timeout)
+		return -1;
+
+	    // the participant is ignored for one step
+	    // in order not to stall the clock
+	    if (!participant.is_late)
+		yWarning() << "ClockMasterModule: participant" << item.first
+			   << "did not acknowledge within" << ack_timeout << "seconds";
+	    participant.is_late = true;
+	    participant.wake_time = now + step;
+	}
+	next = std::min(next, participant.wake_time);
+    }
+
+    if (max_step > 0)
+	next = std::min(next, now + max_step);
+
+    // limit the speed-up if required
+    if (max_speed_up > 0.0)
+    {
+	double min_wall_time = toSeconds(next - start_time) / max_speed_up;
+	if (wall_now - start_wall_time < min_wall_time)
+	    return -1;
+    }
+
+    return next;
+}
+
+void ClockMasterModule::publishTime()
+{
+    yarp::os::Bottle &clock = port_clock.prepare();
+    clock.clear();
+    clock.addInt(static_cast<int>(now / static_cast<int64_t>(ns_per_second)));
+    clock.addInt(static_cast<int>(now % static_cast<int64_t>(ns_per_second)));
+    port_clock.writeStrict();
+}
+
+void ClockMasterModule::reportSpeedUp(const double &wall_now)
+{
+    double sim_elapsed = toSeconds(now - report_time);
+    double wall_elapsed = wall_now - report_wall_time;
+    double speed_up = (wall_elapsed > 0.0) ? sim_elapsed / wall_elapsed : 0.0;
+
+    double total_speed_up = 0.0;
+    if (wall_now - start_wall_time > 0.0)
+	total_speed_up = toSeconds(now - start_time) / (wall_now - start_wall_time);
+
+    yInfo() << "ClockMasterModule: time" << toSeconds(now)
+	    << "speed-up" << speed_up
+	    << "(overall" << total_speed_up << ")";
+
+    yarp::os::Bottle &stats = port_stats.prepare();
+    stats.clear();
+    stats.addDouble(toSeconds(now));
+    stats.addDouble(wall_now - start_wall_time);
+    stats.addDouble(speed_up);
+    stats.addDouble(total_speed_up);
+    stats.addInt(static_cast<int>(ticks));
+    port_stats.write();
+
+    report_time = now;
+    report_wall_time = wall_now;
+}
+
+bool ClockMasterModule::configure(yarp::os::ResourceFinder &rf)
+{
+    std::string clock_port_name = rf.check("clockPort", yarp::os::Value("/clock")).asString();
+    std::string ack_port_name = rf.check("ackPort", yarp::os::Value("/clock-master/ack:i")).asString();
+    std::string stats_port_name = rf.check("statsPort", yarp::os::Value("/clock-master/stats:o")).asString();
+
+    // namespace prepended to the names of all the ports
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+    clock_port_name = prefix + clock_port_name;
+    ack_port_name = prefix + ack_port_name;
+    stats_port_name = prefix + stats_port_name;
+
+    step = toNanoseconds(rf.check("step", yarp::os::Value(0.01)).asDouble());
+    max_step = toNanoseconds(rf.check("maxStep", yarp::os::Value(0.01)).asDouble());
+    max_speed_up = rf.check("maxSpeedUp", yarp::os::Value(0.0)).asDouble();
+    ack_timeout = rf.check("ackTimeout", yarp::os::Value(5.0)).asDouble();
+    report_period = rf.check("reportPeriod", yarp::os::Value(5.0)).asDouble();
+    now = toNanoseconds(rf.check("startTime", yarp::os::Value(0.0)).asDouble());
+    if (step <= 0)
+    {
+	yError() << "ClockMasterModule: the parameter 'step' should be positive";
+	return false;
+    }
+
+    yarp::os::Bottle *participants_list = rf.find("participants").asList();
+    if (participants_list != nullptr)
+    {
+	for (size_t i = 0; i < participants_list->size(); i++)
+	    expected.insert(participants_list->get(i).asString());
+    }
+    yInfo() << "ClockMasterModule: waiting for" << expected.size() << "participants";
+
+    if (!port_clock.open(clock_port_name) ||
+	!port_stats.open(stats_port_name))
+    {
+	yError() << "ClockMasterModule: unable to open the output ports";
+	return false;
+    }
+
+    port_ack.setMaster(this);
+    port_ack.useCallback();
+    port_ack.setStrict();
+    if (!port_ack.open(ack_port_name))
+    {
+	yError() << "ClockMasterModule: unable to open the acknowledgment port";
+	return false;
+    }
+
+    start_time = report_time = now;
+    start_wall_time = report_wall_time = tick_wall_time = yarp::os::SystemClock::nowSystem();
+    publishTime();
+
+    return true;
+}
+
+double ClockMasterModule::getPeriod()
+{
+    // the module is driven by the acknowledgments
+    return 0.0;
+}
+
+bool ClockMasterModule::updateModule()
+{
+    // wake up on acknowledgments or periodically
+    // to check the timeouts and to run in real time
+    semaphore.waitWithTimeout(toSeconds(step) / 2.0);
+
+    if (isStopping())
+	return false;
+
+    double wall_now = yarp::os::SystemClock::nowSystem();
+
+    mutex.lock();
+    int64_t next = nextTime(wall_now);
+    bool is_tick = next > now;
+    if (is_tick)
+    {
+	now = next;
+	tick_wall_time = wall_now;
+	ticks++;
+    }
+    mutex.unlock();
+
+    if (is_tick)
+	publishTime();
+
+    if (wall_now - report_wall_time >= report_period)
+	reportSpeedUp(wall_now);
+
+    return true;
+}
+
+bool ClockMasterModule::interruptModule()
+{
+    semaphore.post();
+
+    return true;
+}
+
+bool ClockMasterModule::close()
+{
+    reportSpeedUp(yarp::os::SystemClock::nowSystem());
+
+    port_ack.close();
+    port_clock.close();
+    port_stats.close();
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "ClockMasterModule: cannot find YARP!";
+	return 1;
+    }
+
+    // the master publishes the clock
+    // hence it always runs on the system clock
+    yarp::os::Time::useSystemClock();
+
+    // instantiate the resource finder
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("clock_master_config.ini");
+    rf.configure(argc,argv);
+
+    // instantiate the module
+    ClockMasterModule master;
+
+    // run the module
+    return master.runModule(rf);
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/LogStream.h>
+
+#include "headers/ClockParticipant.h"
+
+ClockParticipant::ClockParticipant() :
+    is_enabled(false)
+{
+}
+
+bool ClockParticipant::configure(const std::string &name, const std::string &master_port,
+				 const std::string &prefix)
+{
+    this->name = name;
+
+    if (master_port.empty())
+	return true;
+
+    if (!port.open(prefix + "/" + name + "/clock/ack:o"))
+    {
+	yError() << "ClockParticipant: unable to open the port of participant" << name;
+	return false;
+    }
+
+    if (!yarp::os::Network::connect(port.getName(), master_port))
+    {
+	yError() << "ClockParticipant: unable to connect to the clock master" << master_port;
+	port.close();
+	return false;
+    }
+
+    is_enabled = true;
+    yInfo() << "ClockParticipant:" << name << "is driven by" << master_port;
+
+    return true;
+}
+
+bool ClockParticipant::isEnabled() const
+{
+    return is_enabled;
+}
+
+void ClockParticipant::cycleDone(const double &wake_time)
+{
+    if (!is_enabled)
+	return;
+
+    // acknowledgments cannot be dropped
+    // otherwise the clock would stall
+    yarp::os::Bottle &ack = port.prepare();
+    ack.clear();
+    ack.addString(name);
+    ack.addDouble(wake_time);
+    port.writeStrict();
+}
+
+void ClockParticipant::close()
+{
+    if (!is_enabled)
+	return;
+
+    // a negative time notifies the master
+    // that the participant is leaving
+    cycleDone(-1.0);
+    port.waitForWrite();
+
+    port.close();
+    is_enabled = false;
+}
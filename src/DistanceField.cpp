@@ -0,0 +1,364 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "headers/DistanceField.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    /*
+     * Check the size of a grid, evaluating the number of samples.
+     * @param size the number of samples along each axis
+     * @param n_cells the number of samples of the grid
+     * @return true if the size is within the bounds
+     */
+    bool checkGridSize(const std::size_t size[3], std::size_t &n_cells)
+    {
+	n_cells = 1;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    // the product is checked at each step, hence it cannot overflow
+	    if (size[k] < SDF_GRID_MIN_SIZE || size[k] > SDF_GRID_MAX_CELLS / n_cells)
+		return false;
+	    n_cells *= size[k];
+	}
+
+	return true;
+    }
+}
+
+void DistanceField::distance(const float *x, const float *y, const float *z,
+			     const std::size_t &n, float *d) const
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+	float p[3] = {x[i], y[i], z[i]};
+	d[i] = distance(p);
+    }
+}
+
+BoxDistanceField::BoxDistanceField(const double &width,
+				   const double &depth,
+				   const double &height)
+{
+    half_size[0] = width / 2.0;
+    half_size[1] = depth / 2.0;
+    half_size[2] = height / 2.0;
+}
+
+float BoxDistanceField::distance(const float p[3]) const
+{
+    // distance outside the box and
+    // distance from the nearest face inside the box
+    float outside = 0;
+    float inside = -std::numeric_limits<float>::max();
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	float q = std::fabs(p[k]) - half_size[k];
+	outside += std::max(q, 0.0f) * std::max(q, 0.0f);
+	inside = std::max(inside, q);
+    }
+
+    return std::sqrt(outside) + std::min(inside, 0.0f);
+}
+
+void BoxDistanceField::distance(const float *x, const float *y, const float *z,
+				const std::size_t &n, float *d) const
+{
+    const float hx = half_size[0];
+    const float hy = half_size[1];
+    const float hz = half_size[2];
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 vhx = _mm256_set1_ps(hx);
+    __m256 vhy = _mm256_set1_ps(hy);
+    __m256 vhz = _mm256_set1_ps(hz);
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 qx = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_loadu_ps(x + i)), vhx);
+	__m256 qy = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_loadu_ps(y + i)), vhy);
+	__m256 qz = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_loadu_ps(z + i)), vhz);
+	__m256 ox = _mm256_max_ps(qx, zero);
+	__m256 oy = _mm256_max_ps(qy, zero);
+	__m256 oz = _mm256_max_ps(qz, zero);
+	__m256 outside = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox),
+								    _mm256_mul_ps(oy, oy)),
+						      _mm256_mul_ps(oz, oz)));
+	__m256 inside = _mm256_min_ps(_mm256_max_ps(qx, _mm256_max_ps(qy, qz)), zero);
+	_mm256_storeu_ps(d + i, _mm256_add_ps(outside, inside));
+    }
+#elif defined(__SSE2__)
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 vhx = _mm_set1_ps(hx);
+    __m128 vhy = _mm_set1_ps(hy);
+    __m128 vhz = _mm_set1_ps(hz);
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 qx = _mm_sub_ps(_mm_andnot_ps(sign, _mm_loadu_ps(x + i)), vhx);
+	__m128 qy = _mm_sub_ps(_mm_andnot_ps(sign, _mm_loadu_ps(y + i)), vhy);
+	__m128 qz = _mm_sub_ps(_mm_andnot_ps(sign, _mm_loadu_ps(z + i)), vhz);
+	__m128 ox = _mm_max_ps(qx, zero);
+	__m128 oy = _mm_max_ps(qy, zero);
+	__m128 oz = _mm_max_ps(qz, zero);
+	__m128 outside = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox),
+							   _mm_mul_ps(oy, oy)),
+						_mm_mul_ps(oz, oz)));
+	__m128 inside = _mm_min_ps(_mm_max_ps(qx, _mm_max_ps(qy, qz)), zero);
+	_mm_storeu_ps(d + i, _mm_add_ps(outside, inside));
+    }
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	float qx = std::fabs(x[i]) - hx;
+	float qy = std::fabs(y[i]) - hy;
+	float qz = std::fabs(z[i]) - hz;
+	float ox = std::max(qx, 0.0f);
+	float oy = std::max(qy, 0.0f);
+	float oz = std::max(qz, 0.0f);
+	float inside = std::min(std::max(qx, std::max(qy, qz)), 0.0f);
+	d[i] = std::sqrt(ox * ox + oy * oy + oz * oz) + inside;
+    }
+}
+
+GridDistanceField::GridDistanceField() : spacing(0)
+{
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	size[k] = 0;
+	origin[k] = 0;
+    }
+}
+
+bool GridDistanceField::generate(const MeshModel &mesh,
+				 const double &spacing,
+				 const double &padding)
+{
+    float min[3];
+    float max[3];
+    if (spacing <= 0.0 || padding < 0.0 || !mesh.getBoundingBox(min, max))
+	return false;
+
+    // the size is evaluated in double precision
+    // in order to reject huge grids before the conversion
+    std::size_t grid_size[3];
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	double samples = std::ceil((max[k] - min[k] + 2 * padding) / spacing) + 1;
+	if (!(samples <= SDF_GRID_MAX_CELLS))
+	    samples = SDF_GRID_MAX_CELLS + 1.0;
+	grid_size[k] = std::max(static_cast<std::size_t>(samples), std::size_t(SDF_GRID_MIN_SIZE));
+    }
+    std::size_t n_cells;
+    if (!checkGridSize(grid_size, n_cells))
+    {
+	yError() << "GridDistanceField::generate"
+		 << "Error: the grid has more than"
+		 << SDF_GRID_MAX_CELLS
+		 << "samples, try with a larger spacing";
+	return false;
+    }
+
+    this->spacing = spacing;
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	origin[k] = min[k] - padding;
+	size[k] = grid_size[k];
+    }
+    values.resize(n_cells);
+
+    // directions used to evaluate the sign
+    // chosen so that they are not aligned with the faces
+    const float dirs[3][3] = {{0.5773f, 0.5774f, 0.5773f},
+			      {-0.6f, 0.48f, -0.64f},
+			      {0.28f, -0.96f, 0.0f}};
+
+    for (std::size_t k = 0; k < size[2]; k++)
+    {
+	for (std::size_t j = 0; j < size[1]; j++)
+	{
+	    for (std::size_t i = 0; i < size[0]; i++)
+	    {
+		float p[3] = {origin[0] + i * this->spacing,
+			      origin[1] + j * this->spacing,
+			      origin[2] + k * this->spacing};
+
+		float d = mesh.distance(p);
+
+		std::size_t votes = 0;
+		for (std::size_t r = 0; r < 3; r++)
+		    votes += mesh.countIntersections(p, dirs[r]) % 2;
+
+		values[(k * size[1] + j) * size[0] + i] = votes >= 2 ? -d : d;
+	    }
+	}
+    }
+
+    return true;
+}
+
+bool GridDistanceField::load(const std::string &file_name)
+{
+    FILE *file = std::fopen(file_name.c_str(), "rb");
+    if (file == nullptr)
+    {
+	yError() << "GridDistanceField::load"
+		 << "Error: unable to open the file"
+		 << file_name;
+	return false;
+    }
+
+    SdfGridHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+    ok = ok && header.magic == SDF_GRID_MAGIC && header.version == SDF_GRID_VERSION;
+    ok = ok && header.spacing > 0.0f && std::isfinite(header.spacing);
+
+    // the size of the file has to match the size of the grid
+    std::size_t grid_size[3];
+    std::size_t n_cells = 0;
+    if (ok)
+    {
+	for (std::size_t k = 0; k < 3; k++)
+	    grid_size[k] = header.size[k];
+	ok = checkGridSize(grid_size, n_cells);
+    }
+    if (ok)
+    {
+	ok = std::fseek(file, 0, SEEK_END) == 0;
+	long file_size = std::ftell(file);
+	ok = ok && file_size >= 0 &&
+	     static_cast<std::size_t>(file_size) == sizeof(header) + n_cells * sizeof(float);
+	ok = ok && std::fseek(file, sizeof(header), SEEK_SET) == 0;
+    }
+
+    // the grid is changed only once the whole file is read
+    std::vector<float> grid_values;
+    if (ok)
+    {
+	grid_values.resize(n_cells);
+	ok = std::fread(grid_values.data(), sizeof(float), n_cells, file) == n_cells;
+    }
+    std::fclose(file);
+
+    if (!ok)
+    {
+	yError() << "GridDistanceField::load"
+		 << "Error: the file"
+		 << file_name
+		 << "is not a valid distance field";
+	return false;
+    }
+
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	size[k] = grid_size[k];
+	origin[k] = header.origin[k];
+    }
+    spacing = header.spacing;
+    values.swap(grid_values);
+
+    return true;
+}
+
+bool GridDistanceField::save(const std::string &file_name) const
+{
+    SdfGridHeader header;
+    header.magic = SDF_GRID_MAGIC;
+    header.version = SDF_GRID_VERSION;
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	header.size[k] = size[k];
+	header.origin[k] = origin[k];
+    }
+    header.spacing = spacing;
+    header.reserved = 0;
+
+    FILE *file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr)
+    {
+	yError() << "GridDistanceField::save"
+		 << "Error: unable to create the file"
+		 << file_name;
+	return false;
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok &= std::fwrite(values.data(), sizeof(float), values.size(), file) == values.size();
+    ok &= std::fclose(file) == 0;
+
+    if (!ok)
+    {
+	yError() << "GridDistanceField::save"
+		 << "Error: unable to write the file"
+		 << file_name;
+	return false;
+    }
+
+    return true;
+}
+
+float GridDistanceField::distance(const float p[3]) const
+{
+    if (values.empty())
+	return std::numeric_limits<float>::max();
+
+    // clamp the point to the grid
+    std::size_t index[3];
+    float frac[3];
+    float outside = 0;
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	float g = (p[k] - origin[k]) / spacing;
+	float g_max = static_cast<float>(size[k] - 1);
+	float g_clamped = std::min(std::max(g, 0.0f), g_max);
+	outside += (g - g_clamped) * (g - g_clamped);
+
+	index[k] = std::min(static_cast<std::size_t>(g_clamped), size[k] > 1 ? size[k] - 2 : 0);
+	frac[k] = size[k] > 1 ? g_clamped - index[k] : 0.0f;
+    }
+
+    std::size_t i = index[0];
+    std::size_t j = index[1];
+    std::size_t k = index[2];
+    std::size_t i1 = std::min(i + 1, size[0] - 1);
+    std::size_t j1 = std::min(j + 1, size[1] - 1);
+    std::size_t k1 = std::min(k + 1, size[2] - 1);
+
+    // trilinear interpolation
+    float c00 = value(i, j, k) + (value(i1, j, k) - value(i, j, k)) * frac[0];
+    float c10 = value(i, j1, k) + (value(i1, j1, k) - value(i, j1, k)) * frac[0];
+    float c01 = value(i, j, k1) + (value(i1, j, k1) - value(i, j, k1)) * frac[0];
+    float c11 = value(i, j1, k1) + (value(i1, j1, k1) - value(i, j1, k1)) * frac[0];
+    float c0 = c00 + (c10 - c00) * frac[1];
+    float c1 = c01 + (c11 - c01) * frac[1];
+    float d = c0 + (c1 - c0) * frac[2];
+
+    return d + std::sqrt(outside) * spacing;
+}
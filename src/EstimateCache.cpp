@@ -0,0 +1,314 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// std
+#include <algorithm>
+#include <cmath>
+
+#include "headers/EstimateCache.h"
+
+namespace {
+
+/*
+ * Convert a rotation matrix to a unit quaternion (w, x, y, z).
+ */
+void rotationToQuaternion(const yarp::sig::Matrix &m, double q[4])
+{
+    double trace = m(0, 0) + m(1, 1) + m(2, 2);
+    if (trace > 0.0)
+    {
+	double s = 2.0 * std::sqrt(trace + 1.0);
+	q[0] = 0.25 * s;
+	q[1] = (m(2, 1) - m(1, 2)) / s;
+	q[2] = (m(0, 2) - m(2, 0)) / s;
+	q[3] = (m(1, 0) - m(0, 1)) / s;
+    }
+    else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2))
+    {
+	double s = 2.0 * std::sqrt(1.0 + m(0, 0) - m(1, 1) - m(2, 2));
+	q[0] = (m(2, 1) - m(1, 2)) / s;
+	q[1] = 0.25 * s;
+	q[2] = (m(0, 1) + m(1, 0)) / s;
+	q[3] = (m(0, 2) + m(2, 0)) / s;
+    }
+    else if (m(1, 1) > m(2, 2))
+    {
+	double s = 2.0 * std::sqrt(1.0 + m(1, 1) - m(0, 0) - m(2, 2));
+	q[0] = (m(0, 2) - m(2, 0)) / s;
+	q[1] = (m(0, 1) + m(1, 0)) / s;
+	q[2] = 0.25 * s;
+	q[3] = (m(1, 2) + m(2, 1)) / s;
+    }
+    else
+    {
+	double s = 2.0 * std::sqrt(1.0 + m(2, 2) - m(0, 0) - m(1, 1));
+	q[0] = (m(1, 0) - m(0, 1)) / s;
+	q[1] = (m(0, 2) + m(2, 0)) / s;
+	q[2] = (m(1, 2) + m(2, 1)) / s;
+	q[3] = 0.25 * s;
+    }
+}
+
+/*
+ * Normalize a quaternion.
+ */
+void normalize(double q[4])
+{
+    double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (std::size_t i = 0; i < 4; i++)
+	q[i] /= norm;
+}
+
+/*
+ * Spherical linear interpolation between two unit quaternions.
+ */
+void slerp(const double q0[4], const double q1[4], const double &t, double q[4])
+{
+    double cos_theta = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+
+    // take the shortest path
+    double sign = 1.0;
+    if (cos_theta < 0.0)
+    {
+	cos_theta = -cos_theta;
+	sign = -1.0;
+    }
+
+    double w0;
+    double w1;
+    if (cos_theta > 0.9995)
+    {
+	// quaternions are close, linear interpolation is accurate enough
+	w0 = 1.0 - t;
+	w1 = t;
+    }
+    else
+    {
+	double theta = std::acos(cos_theta);
+	double sin_theta = std::sin(theta);
+	w0 = std::sin((1.0 - t) * theta) / sin_theta;
+	w1 = std::sin(t * theta) / sin_theta;
+    }
+
+    for (std::size_t i = 0; i < 4; i++)
+	q[i] = w0 * q0[i] + sign * w1 * q1[i];
+    normalize(q);
+}
+
+}
+
+EstimateCache::EstimateCache(const std::size_t &capacity) :
+    buffer(std::max(capacity, static_cast<std::size_t>(1))),
+    head(0),
+    count(0) { }
+
+const TimedPose& EstimateCache::get(const std::size_t &i) const
+{
+    return buffer[(head + buffer.size() - count + i) % buffer.size()];
+}
+
+void EstimateCache::toMatrix(const TimedPose &pose, yarp::sig::Matrix &matrix)
+{
+    const double &w = pose.quat[0];
+    const double &x = pose.quat[1];
+    const double &y = pose.quat[2];
+    const double &z = pose.quat[3];
+
+    matrix.resize(4, 4);
+    matrix(0, 0) = 1.0 - 2.0 * (y * y + z * z);
+    matrix(0, 1) = 2.0 * (x * y - z * w);
+    matrix(0, 2) = 2.0 * (x * z + y * w);
+    matrix(1, 0) = 2.0 * (x * y + z * w);
+    matrix(1, 1) = 1.0 - 2.0 * (x * x + z * z);
+    matrix(1, 2) = 2.0 * (y * z - x * w);
+    matrix(2, 0) = 2.0 * (x * z - y * w);
+    matrix(2, 1) = 2.0 * (y * z + x * w);
+    matrix(2, 2) = 1.0 - 2.0 * (x * x + y * y);
+    for (std::size_t i = 0; i < 3; i++)
+    {
+	matrix(i, 3) = pose.pos[i];
+	matrix(3, i) = 0.0;
+    }
+    matrix(3, 3) = 1.0;
+}
+
+bool EstimateCache::push(const double &timestamp, const yarp::sig::Matrix &pose)
+{
+    if (pose.rows() != 4 || pose.cols() != 4)
+	return false;
+
+    TimedPose timed_pose;
+    timed_pose.timestamp = timestamp;
+    for (std::size_t i = 0; i < 3; i++)
+	timed_pose.pos[i] = pose(i, 3);
+    rotationToQuaternion(pose, timed_pose.quat);
+    normalize(timed_pose.quat);
+
+    return push(timed_pose);
+}
+
+bool EstimateCache::push(const TimedPose &pose)
+{
+    mutex.lock();
+
+    // discard older or duplicated estimates
+    bool ok = (count == 0) || (pose.timestamp > get(count - 1).timestamp);
+    if (ok)
+    {
+	buffer[head] = pose;
+	head = (head + 1) % buffer.size();
+	count = std::min(count + 1, buffer.size());
+    }
+
+    mutex.unlock();
+
+    return ok;
+}
+
+void EstimateCache::clear()
+{
+    mutex.lock();
+
+    head = 0;
+    count = 0;
+
+    mutex.unlock();
+}
+
+std::size_t EstimateCache::size() const
+{
+    mutex.lock();
+
+    std::size_t size = count;
+
+    mutex.unlock();
+
+    return size;
+}
+
+bool EstimateCache::latest(yarp::sig::Matrix &pose, double *timestamp) const
+{
+    mutex.lock();
+
+    bool ok = count > 0;
+    if (ok)
+    {
+	const TimedPose &last = get(count - 1);
+	toMatrix(last, pose);
+	if (timestamp != nullptr)
+	    *timestamp = last.timestamp;
+    }
+
+    mutex.unlock();
+
+    return ok;
+}
+
+bool EstimateCache::at(const double &time, yarp::sig::Matrix &pose) const
+{
+    mutex.lock();
+
+    if (count == 0 || time < get(0).timestamp)
+    {
+	mutex.unlock();
+	return false;
+    }
+
+    if (time >= get(count - 1).timestamp)
+    {
+	toMatrix(get(count - 1), pose);
+	mutex.unlock();
+	return true;
+    }
+
+    // find the first estimate newer than time
+    std::size_t low = 0;
+    std::size_t high = count - 1;
+    while (low < high)
+    {
+	std::size_t middle = (low + high) / 2;
+	if (get(middle).timestamp <= time)
+	    low = middle + 1;
+	else
+	    high = middle;
+    }
+
+    const TimedPose &p0 = get(low - 1);
+    const TimedPose &p1 = get(low);
+    double t = (time - p0.timestamp) / (p1.timestamp - p0.timestamp);
+
+    TimedPose interpolated;
+    interpolated.timestamp = time;
+    for (std::size_t i = 0; i < 3; i++)
+	interpolated.pos[i] = p0.pos[i] + t * (p1.pos[i] - p0.pos[i]);
+    slerp(p0.quat, p1.quat, t, interpolated.quat);
+
+    mutex.unlock();
+
+    toMatrix(interpolated, pose);
+
+    return true;
+}
+
+double EstimateCache::ageOfLatest(const double &now) const
+{
+    mutex.lock();
+
+    double age = count > 0 ? now - get(count - 1).timestamp : -1.0;
+
+    mutex.unlock();
+
+    return age;
+}
+
+EstimateSubscriber::EstimateSubscriber() { }
+
+void EstimateSubscriber::configure(const std::string &source_frame)
+{
+    this->source_frame = source_frame;
+}
+
+void EstimateSubscriber::addTarget(EstimateCache *cache, const std::string &target_frame)
+{
+    caches[target_frame] = cache;
+}
+
+void EstimateSubscriber::onRead(yarp::os::Bottle &transforms)
+{
+    if (caches.empty())
+	return;
+
+    // each transform is a list
+    // (source target timestamp tx ty tz qw qx qy qz)
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+	yarp::os::Bottle *transform = transforms.get(i).asList();
+	if (transform == nullptr || transform->size() < 10)
+	    continue;
+
+	if (transform->get(0).asString() != source_frame)
+	    continue;
+
+	auto item = caches.find(transform->get(1).asString());
+	if (item == caches.end())
+	    continue;
+
+	TimedPose pose;
+	pose.timestamp = transform->get(2).asDouble();
+	for (size_t j = 0; j < 3; j++)
+	    pose.pos[j] = transform->get(3 + j).asDouble();
+	for (size_t j = 0; j < 4; j++)
+	    pose.quat[j] = transform->get(6 + j).asDouble();
+	normalize(pose.quat);
+
+	item->second->push(pose);
+    }
+}
@@ -0,0 +1,108 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Time.h>
+
+#include "headers/EventQueue.h"
+
+EventQueue::EventQueue() : semaphore(0) { }
+
+void EventQueue::post(const Event &event)
+{
+    mutex.lock();
+    events.push_back(event);
+    mutex.unlock();
+
+    semaphore.post();
+}
+
+void EventQueue::wake()
+{
+    Event event;
+    event.type = EventType::Wake;
+    event.timestamp = yarp::os::Time::now();
+
+    post(event);
+}
+
+bool EventQueue::wait(Event &event, const double &timeout)
+{
+    if (timeout < 0.0)
+	semaphore.wait();
+    else if (!semaphore.waitWithTimeout(timeout))
+	return false;
+
+    mutex.lock();
+    event = events.front();
+    events.pop_front();
+    mutex.unlock();
+
+    return true;
+}
+
+bool EventQueue::poll(Event &event)
+{
+    if (!semaphore.check())
+	return false;
+
+    mutex.lock();
+    event = events.front();
+    events.pop_front();
+    mutex.unlock();
+
+    return true;
+}
+
+ArmMotionDoneEvent::ArmMotionDoneEvent(EventQueue &queue, const std::string &which_arm) :
+    queue(queue),
+    which_arm(which_arm)
+{
+    cartesianEventParameters.type = "motion-done";
+}
+
+void ArmMotionDoneEvent::cartesianEventCallback()
+{
+    Event event;
+    event.type = EventType::ArmMotionDone;
+    event.source = which_arm;
+    event.timestamp = cartesianEventVariables.time;
+
+    queue.post(event);
+}
+
+HandStatusPort::HandStatusPort() : queue(nullptr) { }
+
+void HandStatusPort::configure(EventQueue *queue, const std::string &which_hand)
+{
+    this->queue = queue;
+    this->which_hand = which_hand;
+}
+
+void HandStatusPort::onRead(yarp::os::Bottle &status)
+{
+    if (queue == nullptr || status.size() < 2)
+	return;
+
+    // the status is (event timestamp)
+    Event event;
+    std::string type = status.get(0).asString();
+    if (type == "approach-done")
+	event.type = EventType::FingersApproachDone;
+    else if (type == "restore-done")
+	event.type = EventType::FingersRestoreDone;
+    else
+	return;
+    event.source = which_hand;
+    event.timestamp = status.get(1).asDouble();
+
+    queue->post(event);
+}
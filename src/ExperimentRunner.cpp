@@ -0,0 +1,544 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Run several trials of a pipeline of the module
+ * visual-tactile-localization-sim without human intervention.
+ *
+ * Usage:
+ * experiment_runner [--backend gazebo|local] [--trials <n>] [--object <id>] [--results <file>]
+ *                   [--prefix <namespace>]
+ *
+ * The remaining parameters are in experiment_runner_config.ini.
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/SystemClock.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Math.h>
+
+// std
+#include <sstream>
+
+#include "headers/ExperimentRunner.h"
+
+using namespace yarp::math;
+
+ContactsCounterPort::ContactsCounterPort()
+{
+    reset();
+}
+
+void ContactsCounterPort::reset()
+{
+    samples = 0;
+    samples_in_contact = 0;
+    contacts = 0;
+}
+
+void ContactsCounterPort::getCounters(int &samples, int &samples_in_contact, int &contacts) const
+{
+    samples = this->samples;
+    samples_in_contact = this->samples_in_contact;
+    contacts = this->contacts;
+}
+
+void ContactsCounterPort::onRead(yarp::os::Bottle &contacts_list)
+{
+    // iCub::skinDynLib::skinContactList is
+    // a list containing one item for each contact
+    samples++;
+    if (contacts_list.size() > 0)
+    {
+	samples_in_contact++;
+	contacts += contacts_list.size();
+    }
+}
+
+bool GazeboBackend::configure(const yarp::os::Bottle &group, const ObjectDescription &object,
+			      const std::string &prefix)
+{
+    // get the parameters of the plugin GazeboYarpModelReset
+    std::string reset_port = group.check("resetPort",
+					 yarp::os::Value("/" + object.id + "/model-reset/rpc:i")).asString();
+    reset_port = prefix + reset_port;
+    reset_command = group.check("resetCommand", yarp::os::Value("reset")).asString();
+
+    // get the name of the frames
+    // the ground truth frame is the one registered for the object
+    ground_truth_frame = object.ground_truth_frame;
+    root_frame = group.check("rootFrame", yarp::os::Value("/iCub/frame")).asString();
+
+    bool ok = port_reset.open(prefix + "/experiment-runner/model-reset/rpc:o");
+    if (!ok)
+    {
+	yError() << "GazeboBackend: unable to open the model reset port";
+	return false;
+    }
+
+    ok = yarp::os::Network::connect(port_reset.getName(), reset_port);
+    if (!ok)
+    {
+	yError() << "GazeboBackend: unable to connect to" << reset_port;
+	return false;
+    }
+
+    // prepare properties for the FrameTransformClient
+    yarp::os::Property propTfClient;
+    propTfClient.put("device", "transformClient");
+    propTfClient.put("local", prefix + "/experiment-runner/transformClient");
+    propTfClient.put("remote", prefix + "/transformServer");
+
+    // try to open the driver
+    ok = drv_transform_client.open(propTfClient);
+    if (!ok)
+    {
+	yError() << "GazeboBackend: unable to open the FrameTransformClient driver.";
+	return false;
+    }
+
+    // try to retrieve the view
+    ok = drv_transform_client.view(tf_client);
+    if (!ok || tf_client == 0)
+    {
+	yError() << "GazeboBackend: unable to retrieve the FrameTransformClient view.";
+	return false;
+    }
+
+    return true;
+}
+
+bool GazeboBackend::resetObject()
+{
+    yarp::os::Bottle cmd;
+    yarp::os::Bottle reply;
+    cmd.addString(reset_command);
+
+    return port_reset.write(cmd, reply);
+}
+
+bool GazeboBackend::getGroundTruth(yarp::sig::Matrix &pose)
+{
+    return tf_client->getTransform(ground_truth_frame, root_frame, pose);
+}
+
+void GazeboBackend::close()
+{
+    port_reset.close();
+    drv_transform_client.close();
+}
+
+bool LocalBackend::configure(const yarp::os::Bottle &group, const ObjectDescription &object,
+			     const std::string &prefix)
+{
+    // the pose is given as position and axis-angle
+    yarp::os::Bottle *pose_bottle = group.find("initialPose").asList();
+    if (pose_bottle == nullptr || pose_bottle->size() != 7)
+    {
+	yError() << "LocalBackend: expected (x y z ax ay az angle)"
+		 << "as parameter 'initialPose' of object" << object.id;
+	return false;
+    }
+
+    yarp::sig::Vector axis_angle(4, 0.0);
+    for (size_t i = 0; i < 4; i++)
+	axis_angle[i] = pose_bottle->get(3 + i).asDouble();
+
+    initial_pose = axis2dcm(axis_angle);
+    for (size_t i = 0; i < 3; i++)
+	initial_pose(i, 3) = pose_bottle->get(i).asDouble();
+
+    return true;
+}
+
+bool LocalBackend::resetObject()
+{
+    // the object never leaves the initial pose
+    return true;
+}
+
+bool LocalBackend::getGroundTruth(yarp::sig::Matrix &pose)
+{
+    pose = initial_pose;
+
+    return true;
+}
+
+void LocalBackend::close() { }
+
+bool ExperimentRunner::runPipeline(const yarp::os::Bottle &steps,
+				   const double &timeout,
+				   std::string &state)
+{
+    yarp::os::Bottle cmd;
+    yarp::os::Bottle reply;
+    cmd.addString("pipeline");
+    cmd.addString(object);
+    for (size_t i = 0; i < steps.size(); i++)
+	cmd.add(steps.get(i));
+
+    // the reply contains the id of the pipeline
+    if (!port_service.write(cmd, reply) || reply.size() < 2 || !reply.get(1).isInt())
+    {
+	yError() << "ExperimentRunner: pipeline refused:" << reply.toString();
+	state = "refused";
+	return false;
+    }
+    int id = reply.get(1).asInt();
+
+    double start = yarp::os::Time::now();
+    while (true)
+    {
+	yarp::os::Bottle status_cmd;
+	yarp::os::Bottle status;
+	status_cmd.addString("pipeline-status");
+	status_cmd.addInt(id);
+	if (!port_service.write(status_cmd, status) || status.size() == 0)
+	{
+	    yError() << "ExperimentRunner: unable to get the status of the pipeline";
+	    state = "lost";
+	    return false;
+	}
+
+	state = status.get(0).asString();
+	if (state != "pending" && state != "running")
+	    break;
+
+	if (yarp::os::Time::now() - start > timeout)
+	{
+	    yarp::os::Bottle stop_cmd;
+	    yarp::os::Bottle stop_reply;
+	    stop_cmd.addString("stop");
+	    port_service.write(stop_cmd, stop_reply);
+
+	    state = "timeout";
+	    return false;
+	}
+
+	yarp::os::Time::delay(poll_period);
+    }
+
+    return state == "done";
+}
+
+bool ExperimentRunner::getEstimate(yarp::sig::Matrix &pose)
+{
+    yarp::os::Bottle cmd;
+    yarp::os::Bottle reply;
+    cmd.addString("estimate");
+    cmd.addString(object);
+
+    // the estimate is given as position and axis-angle
+    if (!port_service.write(cmd, reply) || reply.size() != 7 || !reply.get(0).isDouble())
+	return false;
+
+    yarp::sig::Vector axis_angle(4, 0.0);
+    for (size_t i = 0; i < 4; i++)
+	axis_angle[i] = reply.get(3 + i).asDouble();
+
+    pose = axis2dcm(axis_angle);
+    for (size_t i = 0; i < 3; i++)
+	pose(i, 3) = reply.get(i).asDouble();
+
+    return true;
+}
+
+bool ExperimentRunner::runTrial(TrialResult &result)
+{
+    // restore the robot
+    std::string state;
+    if (restore_steps.size() > 0 && !runPipeline(restore_steps, trial_timeout, state))
+    {
+	yError() << "ExperimentRunner: unable to restore the robot, the pipeline is" << state;
+	return false;
+    }
+
+    // reset the object and wait for it to settle
+    if (!backend->resetObject())
+    {
+	yError() << "ExperimentRunner: unable to reset the object";
+	return false;
+    }
+    yarp::os::Time::delay(reset_delay);
+
+    for (auto &port : ports_contacts)
+	port->reset();
+
+    // run the trial
+    double start = yarp::os::Time::now();
+    double wall_start = yarp::os::SystemClock::nowSystem();
+    result.is_success = runPipeline(steps, trial_timeout, result.pipeline_state);
+    result.duration = yarp::os::Time::now() - start;
+    result.wall_duration = yarp::os::SystemClock::nowSystem() - wall_start;
+    result.speed_up = 0.0;
+    if (result.wall_duration > 0.0)
+	result.speed_up = result.duration / result.wall_duration;
+
+    // contact statistics
+    int samples = 0;
+    int samples_in_contact = 0;
+    int contacts = 0;
+    for (auto &port : ports_contacts)
+    {
+	int port_samples;
+	int port_samples_in_contact;
+	int port_contacts;
+	port->getCounters(port_samples, port_samples_in_contact, port_contacts);
+
+	samples += port_samples;
+	samples_in_contact += port_samples_in_contact;
+	contacts += port_contacts;
+    }
+    result.contact_samples = samples;
+    result.contact_ratio = samples > 0 ? static_cast<double>(samples_in_contact) / samples : 0.0;
+    result.mean_contacts = samples_in_contact > 0 ?
+	static_cast<double>(contacts) / samples_in_contact : 0.0;
+
+    // error of the final estimate
+    yarp::sig::Matrix estimate;
+    yarp::sig::Matrix ground_truth;
+    result.position_error = -1.0;
+    result.angle_error = -1.0;
+    if (getEstimate(estimate) && backend->getGroundTruth(ground_truth))
+    {
+	yarp::sig::Matrix error = SE3inv(ground_truth) * estimate;
+	result.position_error = norm(error.getCol(3).subVector(0, 2));
+	result.angle_error = dcm2axis(error)[3];
+    }
+
+    return true;
+}
+
+void ExperimentRunner::writeResult(const TrialResult &result)
+{
+    results << result.trial << ","
+	    << result.is_success << ","
+	    << result.pipeline_state << ","
+	    << result.duration << ","
+	    << result.wall_duration << ","
+	    << result.speed_up << ","
+	    << result.position_error << ","
+	    << result.angle_error << ","
+	    << result.contact_samples << ","
+	    << result.contact_ratio << ","
+	    << result.mean_contacts << std::endl;
+}
+
+bool ExperimentRunner::configure(yarp::os::ResourceFinder &rf)
+{
+    // get the object and the backend
+    object = rf.check("object", yarp::os::Value("box_alt")).asString();
+    std::string backend_name = rf.check("backend", yarp::os::Value("gazebo")).asString();
+    if (backend_name == "gazebo")
+	backend = std::unique_ptr<ExperimentBackend>(new GazeboBackend());
+    else if (backend_name == "local")
+	backend = std::unique_ptr<ExperimentBackend>(new LocalBackend());
+    else
+    {
+	yError() << "ExperimentRunner: unknown backend" << backend_name;
+	return false;
+    }
+
+    // namespace prepended to the names of all the ports
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+    // the objects of the scene are those of the module
+    yarp::os::ResourceFinder rf_scene;
+    rf_scene.setDefaultContext(rf.getContext());
+    rf_scene.setDefaultConfigFile(rf.check("sceneConfig",
+					   yarp::os::Value("vis_tac_localization_config.ini")).asString());
+    rf_scene.configure(0, nullptr);
+    ObjectRegistry registry;
+    if (!registry.configure(rf_scene))
+    {
+	yError() << "ExperimentRunner: unable to load the objects of the scene";
+	return false;
+    }
+    const ObjectDescription *description = registry.find(object);
+    if (description == nullptr)
+    {
+	yError() << "ExperimentRunner: unknown object" << object;
+	return false;
+    }
+
+    if (!backend->configure(rf.findGroup(backend_name), *description, prefix))
+	return false;
+
+    // get the steps of the trials
+    yarp::os::Bottle *steps_bottle = rf.find("pipeline").asList();
+    if (steps_bottle == nullptr || steps_bottle->size() == 0)
+    {
+	yError() << "ExperimentRunner: cannot find parameter 'pipeline'"
+		 << "in current configuration";
+	return false;
+    }
+    steps = *steps_bottle;
+
+    // the robot is restored before each trial
+    yarp::os::Bottle *restore_bottle = rf.find("restorePipeline").asList();
+    if (restore_bottle != nullptr)
+	restore_steps = *restore_bottle;
+    else
+	restore_steps.addString("home-both");
+
+    // get the parameters of the trials
+    trials = rf.check("trials", yarp::os::Value(10)).asInt();
+    trial_timeout = rf.check("trialTimeout", yarp::os::Value(120.0)).asDouble();
+    reset_delay = rf.check("resetDelay", yarp::os::Value(2.0)).asDouble();
+    poll_period = rf.check("pollPeriod", yarp::os::Value(0.1)).asDouble();
+
+    // connect to the module
+    std::string service = prefix + rf.check("servicePort", yarp::os::Value("/service")).asString();
+    bool ok = port_service.open(prefix + "/experiment-runner/service:o");
+    if (!ok)
+    {
+	yError() << "ExperimentRunner: unable to open the service port";
+	return false;
+    }
+    ok = yarp::os::Network::connect(port_service.getName(), service);
+    if (!ok)
+    {
+	yError() << "ExperimentRunner: unable to connect to" << service;
+	return false;
+    }
+
+    // open the contacts ports
+    std::vector<std::string> contacts_sources;
+    yarp::os::Bottle *sources_bottle = rf.find("contactsSources").asList();
+    if (sources_bottle != nullptr)
+    {
+	for (size_t i = 0; i < sources_bottle->size(); i++)
+	    contacts_sources.push_back(prefix + sources_bottle->get(i).asString());
+    }
+    else
+    {
+	contacts_sources.push_back(prefix + "/right_hand/skinManager/skin_events:o");
+	contacts_sources.push_back(prefix + "/left_hand/skinManager/skin_events:o");
+    }
+
+    for (size_t i = 0; i < contacts_sources.size(); i++)
+    {
+	std::unique_ptr<ContactsCounterPort> port(new ContactsCounterPort());
+
+	std::ostringstream port_name;
+	port_name << prefix << "/experiment-runner/contacts/" << i << ":i";
+	ok = port->open(port_name.str());
+	if (!ok)
+	{
+	    yError() << "ExperimentRunner: unable to open the contacts port"
+		     << port_name.str();
+	    return false;
+	}
+	port->useCallback();
+	yarp::os::Network::connect(contacts_sources[i], port->getName());
+
+	ports_contacts.push_back(std::move(port));
+    }
+
+    // create the results
+    std::string file_name = rf.check("results", yarp::os::Value("results.csv")).asString();
+    results.open(file_name);
+    if (!results.is_open())
+    {
+	yError() << "ExperimentRunner: unable to create" << file_name;
+	return false;
+    }
+    results << "trial,success,state,duration,wall_duration,speed_up,"
+	    << "position_error,angle_error,"
+	    << "contact_samples,contact_ratio,mean_contacts" << std::endl;
+    yInfo() << "ExperimentRunner: writing the results to" << file_name;
+
+    return true;
+}
+
+bool ExperimentRunner::run()
+{
+    int successes = 0;
+    int estimates = 0;
+    double position_error = 0.0;
+    double angle_error = 0.0;
+    double duration = 0.0;
+    double wall_duration = 0.0;
+
+    for (int i = 0; i < trials; i++)
+    {
+	TrialResult result;
+	result.trial = i;
+	if (!runTrial(result))
+	{
+	    yError() << "ExperimentRunner: experiment aborted at trial" << i;
+	    return false;
+	}
+	writeResult(result);
+
+	yInfo() << "ExperimentRunner: trial" << i + 1 << "of" << trials
+		<< result.pipeline_state << "in" << result.duration << "seconds";
+
+	duration += result.duration;
+	wall_duration += result.wall_duration;
+	if (result.is_success)
+	    successes++;
+	if (result.position_error >= 0.0)
+	{
+	    estimates++;
+	    position_error += result.position_error;
+	    angle_error += result.angle_error;
+	}
+    }
+
+    yInfo() << "ExperimentRunner:" << successes << "of" << trials << "trials succeeded";
+    if (estimates > 0)
+	yInfo() << "ExperimentRunner: mean position error" << position_error / estimates
+		<< "m, mean angle error" << angle_error / estimates << "rad";
+    if (wall_duration > 0.0)
+	yInfo() << "ExperimentRunner: speed-up w.r.t. real time" << duration / wall_duration;
+
+    return true;
+}
+
+void ExperimentRunner::close()
+{
+    port_service.close();
+    for (auto &port : ports_contacts)
+	port->close();
+    ports_contacts.clear();
+
+    if (backend)
+	backend->close();
+
+    results.close();
+}
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "ExperimentRunner: cannot find YARP!";
+	return 1;
+    }
+
+    // instantiate the resource finder
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("experiment_runner_config.ini");
+    rf.configure(argc,argv);
+
+    // run the experiment
+    ExperimentRunner runner;
+    bool ok = runner.configure(rf) && runner.run();
+    runner.close();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+#include <yarp/math/Math.h>
+
+// icub-main
+#include <iCub/skinDynLib/common.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+
+#include "headers/FingertipContactGenerator.h"
+
+using namespace yarp::math;
+
+bool FingertipContactGenerator::configure(const std::string &hand_name,
+					  const yarp::sig::Vector &dimensions,
+					  const double &threshold)
+{
+    if (hand_name != "right" && hand_name != "left")
+    {
+	yError() << "FingertipContactGenerator: hand" << hand_name << "not supported";
+	return false;
+    }
+
+    if (dimensions.size() != 3)
+    {
+	yError() << "FingertipContactGenerator: expected (width depth height)"
+		 << "as dimensions of the box";
+	return false;
+    }
+
+    if (threshold <= 0.0)
+    {
+	yError() << "FingertipContactGenerator: the threshold should be positive";
+	return false;
+    }
+
+    this->hand_name = hand_name;
+    this->threshold = threshold;
+    half_sizes = 0.5 * dimensions;
+
+    // instantiate the chain of the arm
+    // as done in ArmController
+    arm_chain = iCub::iKin::iCubArm(hand_name);
+    arm_chain.setAllConstraints(false);
+    arm_chain.releaseLink(0);
+    arm_chain.releaseLink(1);
+    arm_chain.releaseLink(2);
+
+    // taxels ids of the finger tips
+    // as expected by HandControlModule
+    fingers.clear();
+    taxel_bases.clear();
+    const std::vector<std::pair<std::string, unsigned int>> tips =
+	{{"index", 0}, {"middle", 12}, {"ring", 24}, {"little", 36}, {"thumb", 48}};
+    for (const auto &tip : tips)
+    {
+	fingers.push_back(iCub::iKin::iCubFinger(hand_name + "_" + tip.first));
+	taxel_bases.push_back(tip.second);
+    }
+
+    yarp::sig::Matrix identity(4, 4);
+    identity.eye();
+    setObjectPose(identity);
+
+    return true;
+}
+
+void FingertipContactGenerator::setObjectPose(const yarp::sig::Matrix &pose)
+{
+    object_pose = pose;
+    object_pose_inv = SE3inv(pose);
+}
+
+double FingertipContactGenerator::boxDistance(const yarp::sig::Vector &point,
+					      yarp::sig::Vector &closest,
+					      yarp::sig::Vector &normal) const
+{
+    closest.resize(3);
+    normal.resize(3, 0.0);
+
+    bool is_inside = true;
+    for (size_t i = 0; i < 3; i++)
+    {
+	closest[i] = std::min(std::max(point[i], -half_sizes[i]), half_sizes[i]);
+	is_inside &= (closest[i] == point[i]);
+    }
+
+    if (!is_inside)
+    {
+	yarp::sig::Vector diff = point - closest;
+	double distance = norm(diff);
+	normal = (1.0 / distance) * diff;
+
+	return distance;
+    }
+
+    // within the box the closest face
+    // is the one with minimum penetration
+    size_t face = 0;
+    double penetration = half_sizes[0] - std::abs(point[0]);
+    for (size_t i = 1; i < 3; i++)
+    {
+	double face_penetration = half_sizes[i] - std::abs(point[i]);
+	if (face_penetration < penetration)
+	{
+	    penetration = face_penetration;
+	    face = i;
+	}
+    }
+    closest = point;
+    closest[face] = std::copysign(half_sizes[face], point[face]);
+    normal[face] = std::copysign(1.0, point[face]);
+
+    return -penetration;
+}
+
+void FingertipContactGenerator::generate(const yarp::sig::Vector &encs_torso,
+					 const yarp::sig::Vector &encs_arm,
+					 iCub::skinDynLib::skinContactList &contacts)
+{
+    contacts.clear();
+
+    // forward kinematics of the hand
+    // the links of the torso are in reversed order
+    yarp::sig::Vector joints_angles(arm_chain.getDOF());
+    joints_angles[0] = encs_torso[2];
+    joints_angles[1] = encs_torso[1];
+    joints_angles[2] = encs_torso[0];
+    for (size_t i = 0; i < 7; i++)
+	joints_angles[3 + i] = encs_arm[i];
+    arm_chain.setAng((M_PI/180) * joints_angles);
+    yarp::sig::Matrix root_to_hand = arm_chain.getH();
+    yarp::sig::Matrix hand_to_root = SE3inv(root_to_hand);
+
+    // rotation from the frame of the box to the frame of the hand
+    yarp::sig::Matrix hand_to_object = hand_to_root * object_pose;
+    yarp::sig::Matrix R_hand_object = hand_to_object.submatrix(0, 2, 0, 2);
+
+    iCub::skinDynLib::BodyPart body_part;
+    iCub::skinDynLib::SkinPart skin_part;
+    if (hand_name == "right")
+    {
+	body_part = iCub::skinDynLib::RIGHT_ARM;
+	skin_part = iCub::skinDynLib::SKIN_RIGHT_HAND;
+    }
+    else
+    {
+	body_part = iCub::skinDynLib::LEFT_ARM;
+	skin_part = iCub::skinDynLib::SKIN_LEFT_HAND;
+    }
+
+    for (size_t i = 0; i < fingers.size(); i++)
+    {
+	// position of the finger tip in the frame of the hand
+	yarp::sig::Vector finger_joints;
+	if (!fingers[i].getChainJoints(encs_arm, finger_joints))
+	    continue;
+	yarp::sig::Vector tip_hand = fingers[i].getH((M_PI/180.0) * finger_joints).getCol(3);
+
+	// position of the finger tip in the frame of the box
+	yarp::sig::Vector tip_object = (object_pose_inv * (root_to_hand * tip_hand)).subVector(0, 2);
+
+	yarp::sig::Vector closest;
+	yarp::sig::Vector normal;
+	double distance = boxDistance(tip_object, closest, normal);
+	if (distance > threshold)
+	    continue;
+
+	// center of pressure and normal in the frame of the hand
+	yarp::sig::Vector closest_h(4, 1.0);
+	closest_h.setSubvector(0, closest);
+	yarp::sig::Vector cop = (hand_to_object * closest_h).subVector(0, 2);
+	yarp::sig::Vector normal_hand = R_hand_object * normal;
+
+	std::vector<unsigned int> taxels;
+	for (unsigned int k = 0; k < 12; k++)
+	    taxels.push_back(taxel_bases[i] + k);
+
+	// the pressure grows with the penetration
+	double pressure = (threshold - distance) / threshold;
+
+	contacts.push_back(iCub::skinDynLib::skinContact(body_part, skin_part, 6,
+							 cop, cop, taxels,
+							 pressure, normal_hand));
+    }
+}
@@ -11,8 +11,14 @@
 
 // yarp
 #include <yarp/os/ConnectionWriter.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Value.h>
+
+// std
+#include <thread>
 
 #include "headers/HandControlModule.h"
+#include "headers/StartupTimeline.h"
 
 typedef std::map<iCub::skinDynLib::SkinPart, iCub::skinDynLib::skinContactList> skinPartMap;
 
@@ -244,6 +250,8 @@ void HandControlModule::performControl()
 		is_approach_done = true;
 
 		mutex.unlock();
+
+		publishStatus("approach-done");
 	    }
 	}
 
@@ -297,6 +305,9 @@ void HandControlModule::performControl()
 
 	mutex.unlock();
 
+	if (is_done)
+	    publishStatus("restore-done");
+
 	break;
     }
 
@@ -314,6 +325,15 @@ void HandControlModule::stopControl()
     hand.stopFingers(commanded_fingers);
 }
 
+void HandControlModule::publishStatus(const std::string &event)
+{
+    yarp::os::Bottle &status = port_status.prepare();
+    status.clear();
+    status.addString(event);
+    status.addDouble(yarp::os::Time::now());
+    port_status.writeStrict();
+}
+
 bool HandControlModule::configure(yarp::os::ResourceFinder &rf)
 {
     // get the name of the hand to be controlled
@@ -326,6 +346,9 @@ bool HandControlModule::configure(yarp::os::ResourceFinder &rf)
 	return false;
     }
 
+    // get the namespace prepended to the names of all the ports
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
     yarp::os::ResourceFinder inner_rf;
     inner_rf = rf.findNestedResourceFinder(hand_name.c_str());
 
@@ -339,43 +362,70 @@ bool HandControlModule::configure(yarp::os::ResourceFinder &rf)
     port_contacts_name = inner_rf.find("contactsInputPort").asString();
     if (inner_rf.find("contactsInputPort").isNull())
 	port_contacts_name = "/hand-control/" + hand_name + "/contacts:i";
+    port_contacts_name = prefix + port_contacts_name;
     yInfo() << "HandControlModule: contact points input port name is" << port_contacts_name;
 
     // get the name of rpc port
     port_rpc_name = inner_rf.find("rpcPort").asString();
     if (inner_rf.find("rpcPort").isNull())
 	port_rpc_name = "/hand-control/" + hand_name + "/rpc:i";
+    port_rpc_name = prefix + port_rpc_name;
     yInfo() << "HandControlModule: rpc port name is" << port_rpc_name;
+
+    // get the name of the status port
+    port_status_name = inner_rf.find("statusPort").asString();
+    if (inner_rf.find("statusPort").isNull())
+	port_status_name = "/hand-control/" + hand_name + "/status:o";
+    port_status_name = prefix + port_status_name;
+    yInfo() << "HandControlModule: status port name is" << port_status_name;
     
-    // open the contact points port
-    bool ok = port_contacts.open(port_contacts_name);
-    if (!ok)
+    // the hand controller waits for the control board of the arm
+    // while the ports are opened
+    StartupTimeline timeline("HandControlModule");
+    bool is_hand_ok = false;
+    std::thread hand_thread([&]()
+			    {
+				std::size_t step = timeline.begin("hand controller");
+				is_hand_ok = hand.configure(hand_name, prefix);
+				timeline.end(step, is_hand_ok);
+			    });
+
+    std::size_t step = timeline.begin("ports");
+    bool is_ports_ok = openPorts();
+    timeline.end(step, is_ports_ok);
+
+    hand_thread.join();
+    if (!is_ports_ok)
     {
-	yError() << "HandControlModule::configure"
-		 << "Error: unable to open the contacts port";
+	closePorts();
+	hand.close();
 	return false;
     }
 
-    // open the rpc server port
-    ok = rpc_server.open(port_rpc_name);
-    if (!ok)
+    // check the hand controller
+    if (!is_hand_ok)
     {
 	yError() << "HandControlModule::configure"
-		 << "Error: unable to open the rpc port";
+		 << "Error: unable to configure the"
+		 << hand_name
+		 << "hand controller";
+	closePorts();
+	hand.close();
 	return false;
     }
 
-    // configure callback for rpc
-    rpc_server.setReader(*this);
-
-    // configure hand the hand controller
-    ok = hand.configure(hand_name);
+    // join the stepped clock if required
+    std::string clock_master = rf.check("clockMaster", yarp::os::Value("")).asString();
+    step = timeline.begin("clock");
+    bool ok = clock.configure("hand-control/" + hand_name, clock_master, prefix);
+    timeline.end(step, ok);
+    timeline.report();
     if (!ok)
     {
 	yError() << "HandControlModule::configure"
-		 << "Error: unable to configure the"
-		 << hand_name
-		 << "hand controller";
+		 << "Error: unable to join the clock master";
+	closePorts();
+	hand.close();
 	return false;
     }
 
@@ -385,10 +435,53 @@ bool HandControlModule::configure(yarp::os::ResourceFinder &rf)
     // reset flags
     is_approach_done = false;
     is_restore_done = false;
- 	
+
+    // configure callback for rpc
+    // only now that the hand controller and the state are ready
+    rpc_server.setReader(*this);
+
+    return true;
+}
+
+bool HandControlModule::openPorts()
+{
+    // open the contact points port
+    bool ok = port_contacts.open(port_contacts_name);
+    if (!ok)
+    {
+	yError() << "HandControlModule::openPorts"
+		 << "Error: unable to open the contacts port";
+	return false;
+    }
+
+    // open the rpc server port
+    ok = rpc_server.open(port_rpc_name);
+    if (!ok)
+    {
+	yError() << "HandControlModule::openPorts"
+		 << "Error: unable to open the rpc port";
+	return false;
+    }
+
+    // open the status port
+    ok = port_status.open(port_status_name);
+    if (!ok)
+    {
+	yError() << "HandControlModule::openPorts"
+		 << "Error: unable to open the status port";
+	return false;
+    }
+
     return true;
 }
 
+void HandControlModule::closePorts()
+{
+    port_contacts.close();
+    rpc_server.close();
+    port_status.close();
+}
+
 double HandControlModule::getPeriod()
 {
     return period;
@@ -396,8 +489,13 @@ double HandControlModule::getPeriod()
 
 bool HandControlModule::updateModule()
 {
+    double t_start = yarp::os::Time::now();
+
     performControl();
 
+    // the next cycle starts after one period
+    clock.cycleDone(t_start + period);
+
     return true;
 }
 
@@ -407,8 +505,12 @@ bool HandControlModule::close()
     stopControl();
 
     // close ports
-    port_contacts.close();
-    rpc_server.close();
+    closePorts();
+
+    // leave the stepped clock
+    clock.close();
+
+    return true;
 }
 
 bool HandControlModule::read(yarp::os::ConnectionReader& connection)
@@ -14,22 +14,24 @@
 #include <yarp/math/Math.h>
 
 #include "headers/HandController.h"
+#include "headers/StartupTimeline.h"
 
 #include <cmath>
 
 using namespace yarp::math;
 
-bool RightHandController::configure()
+bool RightHandController::configure(const std::string &prefix)
 {
-    return HandController::configure("right");
+    return HandController::configure("right", prefix);
 }
 
-bool LeftHandController::configure()
+bool LeftHandController::configure(const std::string &prefix)
 {
-    return HandController::configure("left");
+    return HandController::configure("left", prefix);
 }
 
-bool HandController::configure(const std::string &hand_name)
+bool HandController::configure(const std::string &hand_name,
+			       const std::string &prefix)
 {
     // store name of the hand
     this->hand_name = hand_name;
@@ -37,9 +39,10 @@ bool HandController::configure(const std::string &hand_name)
     // prepare properties for the Encoders
     yarp::os::Property prop;
     prop.put("device", "remote_controlboard");
-    prop.put("remote", "/icubSim/" + hand_name + "_arm");
-    prop.put("local", "/hand_controller/" + hand_name + "_arm/encoders");
-    bool ok = drv_arm.open(prop);
+    prop.put("remote", prefix + "/icubSim/" + hand_name + "_arm");
+    prop.put("local", prefix + "/hand_controller/" + hand_name + "_arm/encoders");
+    // the control board might not be ready yet
+    bool ok = waitWithBackoff([&]() { return drv_arm.open(prop); }, 10.0);
     if (!ok)
     {
 	yError() << "HandController::configure"
@@ -51,7 +54,7 @@ bool HandController::configure(const std::string &hand_name)
     ok = drv_arm.view(ienc_arm);
     if (!ok || ienc_arm == 0)
     {
-	yError() << "HandController:configure"
+	yError() << "HandController::configure"
 		 << "Error: unable to retrieve the Encoders view";
 	return false;
     }
@@ -59,7 +62,7 @@ bool HandController::configure(const std::string &hand_name)
     ok = drv_arm.view(ipos_arm);
     if (!ok || ipos_arm == 0)
     {
-	yError() << "HandController:configure"
+	yError() << "HandController::configure"
 		 << "Error: unable to retrieve the PositionControl2 view";
 	return false;
     }
@@ -67,7 +70,7 @@ bool HandController::configure(const std::string &hand_name)
     ok = drv_arm.view(ivel_arm);
     if (!ok || ivel_arm == 0)
     {
-	yError() << "HandController:configure"
+	yError() << "HandController::configure"
 		 << "Error: unable to retrieve the VelocityControl2 view";
 	return false;
     }
@@ -75,26 +78,22 @@ bool HandController::configure(const std::string &hand_name)
     ok = drv_arm.view(imod_arm);
     if (!ok || imod_arm == 0)
     {
-	yError() << "HandController:configure"
+	yError() << "HandController::configure"
 		 << "Error: unable to retrieve the ControlMode2 view";
 	return false;
     }
 
     // get the current encoder readings
     // required to set the home position of the fingers joints
-    ok = false;
-    double t0 = yarp::os::SystemClock::nowSystem();    
-    yarp::sig::Vector joints;    
-    while (yarp::os::SystemClock::nowSystem() - t0 < 10.0)
+    // this might fail if the gazebo pluging
+    // exposing encoders is not yet ready
+    yarp::sig::Vector joints;
+    ok = waitWithBackoff([&]() { return getJoints(joints); }, 10.0);
+    if (!ok)
     {
-	// this might fail if the gazebo pluging
-	// exposing encoders is not yet ready
-	if (getJoints(joints))
-	{
-	    ok = true;
-	    break;
-	}
-	yarp::os::SystemClock::delaySystem(1.0);
+	yError() << "HandController::configure"
+		 << "Error: unable to read the encoders";
+	return false;
     }
     
     // handle fingers
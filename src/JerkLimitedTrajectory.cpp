@@ -0,0 +1,290 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// std
+#include <cmath>
+
+#include "headers/JerkLimitedTrajectory.h"
+
+namespace
+{
+    // tolerances used to discard degenerate segments
+    // and to detect collinear waypoints
+    const double min_length = 1e-9;
+    const double collinear_tolerance = 1e-9;
+}
+
+JerkLimitedTrajectory::JerkLimitedTrajectory() :
+    max_velocity(0.1),
+    max_acceleration(0.1),
+    max_jerk(1.0),
+    sampling_period(0.005),
+    duration(0.0),
+    number_samples(0)
+{
+}
+
+bool JerkLimitedTrajectory::setLimits(const double &velocity, const double &acceleration,
+				      const double &jerk)
+{
+    if (velocity <= 0 || acceleration <= 0 || jerk <= 0)
+	return false;
+
+    max_velocity = velocity;
+    max_acceleration = acceleration;
+    max_jerk = jerk;
+
+    return true;
+}
+
+bool JerkLimitedTrajectory::setSamplingPeriod(const double &period)
+{
+    if (period <= 0)
+	return false;
+
+    sampling_period = period;
+
+    return true;
+}
+
+void JerkLimitedTrajectory::planSegment(Segment &segment) const
+{
+    // double S profile with zero initial and final velocity
+    // (L. Biagiotti, C. Melchiorri, Trajectory Planning for Automatic Machines and Robots, 3.4)
+    const double &h = segment.length;
+    const double &v = max_velocity;
+    const double &a = max_acceleration;
+    const double &j = max_jerk;
+
+    // assume that the maximum velocity is reached
+    double jerk_time;
+    double acceleration_time;
+    if (v * j >= a * a)
+    {
+	jerk_time = a / j;
+	acceleration_time = jerk_time + v / a;
+    }
+    else
+    {
+	jerk_time = std::sqrt(v / j);
+	acceleration_time = 2.0 * jerk_time;
+    }
+    double cruise_time = h / v - acceleration_time;
+
+    // otherwise the segment is too short for the maximum velocity
+    if (cruise_time < 0.0)
+    {
+	cruise_time = 0.0;
+	if (h >= 2.0 * a * a * a / (j * j))
+	{
+	    jerk_time = a / j;
+	    acceleration_time = jerk_time / 2.0 + std::sqrt(jerk_time * jerk_time / 4.0 + h / a);
+	}
+	else
+	{
+	    jerk_time = std::cbrt(h / (2.0 * j));
+	    acceleration_time = 2.0 * jerk_time;
+	}
+    }
+
+    segment.jerk_time = jerk_time;
+    segment.acceleration_time = acceleration_time;
+    segment.cruise_time = cruise_time;
+}
+
+void JerkLimitedTrajectory::evaluateSegment(const Segment &segment, const double &time,
+					    double &s, double &s_dot) const
+{
+    const double &j = max_jerk;
+    const double &tj = segment.jerk_time;
+    const double &ta = segment.acceleration_time;
+    const double &tv = segment.cruise_time;
+    double a_lim = j * tj;
+    double v_lim = (ta - tj) * a_lim;
+    double total = 2.0 * ta + tv;
+
+    // the deceleration is symmetric to the acceleration
+    bool is_decelerating = time > ta + tv;
+    double t = is_decelerating ? total - time : time;
+    if (t < 0.0)
+	t = 0.0;
+
+    if (t < tj)
+    {
+	s = j * t * t * t / 6.0;
+	s_dot = j * t * t / 2.0;
+    }
+    else if (t < ta - tj)
+    {
+	s = a_lim / 6.0 * (3.0 * t * t - 3.0 * tj * t + tj * tj);
+	s_dot = a_lim * (t - tj / 2.0);
+    }
+    else if (t < ta)
+    {
+	double r = ta - t;
+	s = v_lim * ta / 2.0 - v_lim * r + j * r * r * r / 6.0;
+	s_dot = v_lim - j * r * r / 2.0;
+    }
+    else
+    {
+	s = v_lim * ta / 2.0 + v_lim * (t - ta);
+	s_dot = v_lim;
+    }
+
+    if (is_decelerating)
+	s = segment.length - s;
+}
+
+bool JerkLimitedTrajectory::plan(const std::vector<yarp::sig::Vector> &waypoints)
+{
+    if (waypoints.empty())
+	return false;
+    for (const yarp::sig::Vector &waypoint : waypoints)
+    {
+	if (waypoint.size() != 3)
+	    return false;
+    }
+
+    // build the segments merging collinear waypoints
+    segments.clear();
+    for (std::size_t i = 1; i < waypoints.size(); i++)
+    {
+	double delta[3];
+	double length = 0.0;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    delta[k] = waypoints[i][k] - waypoints[i - 1][k];
+	    length += delta[k] * delta[k];
+	}
+	length = std::sqrt(length);
+	if (length < min_length)
+	    continue;
+
+	Segment segment;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    segment.start[k] = waypoints[i - 1][k];
+	    segment.direction[k] = delta[k] / length;
+	}
+	segment.length = length;
+
+	if (!segments.empty())
+	{
+	    Segment &last = segments.back();
+	    double cosine = 0.0;
+	    for (std::size_t k = 0; k < 3; k++)
+		cosine += last.direction[k] * segment.direction[k];
+	    if (cosine > 1.0 - collinear_tolerance)
+	    {
+		last.length += length;
+		continue;
+	    }
+	}
+
+	segments.push_back(segment);
+    }
+
+    // evaluate the timing of the segments
+    duration = 0.0;
+    for (Segment &segment : segments)
+    {
+	planSegment(segment);
+	segment.start_time = duration;
+	duration += 2.0 * segment.acceleration_time + segment.cruise_time;
+    }
+
+    // sample the trajectory
+    // the last sample is taken exactly at the end
+    number_samples = static_cast<std::size_t>(std::ceil(duration / sampling_period)) + 1;
+    samples.resize(6 * number_samples);
+
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < number_samples; i++)
+    {
+	double *sample = &samples[6 * i];
+	double t = i * sampling_period;
+	if (t > duration || i == number_samples - 1)
+	    t = duration;
+
+	if (segments.empty())
+	{
+	    for (std::size_t k = 0; k < 3; k++)
+	    {
+		sample[k] = waypoints.back()[k];
+		sample[3 + k] = 0.0;
+	    }
+	    continue;
+	}
+
+	while (index + 1 < segments.size() && t >= segments[index + 1].start_time)
+	    index++;
+	const Segment &segment = segments[index];
+
+	double s;
+	double s_dot;
+	evaluateSegment(segment, t - segment.start_time, s, s_dot);
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    sample[k] = segment.start[k] + s * segment.direction[k];
+	    sample[3 + k] = s_dot * segment.direction[k];
+	}
+    }
+
+    return true;
+}
+
+double JerkLimitedTrajectory::getDuration() const
+{
+    return duration;
+}
+
+bool JerkLimitedTrajectory::getTrajectory(const double &time,
+					  yarp::sig::Vector &position,
+					  yarp::sig::Vector &velocity) const
+{
+    // check for negative times
+    // and for trajectories not planned
+    if (time < 0 || number_samples == 0)
+	return false;
+
+    if (position.size() != 3)
+	position.resize(3);
+    if (velocity.size() != 3)
+	velocity.resize(3);
+
+    // find the samples enclosing the time
+    double t = time > duration ? duration : time;
+    std::size_t i = static_cast<std::size_t>(t / sampling_period);
+    if (i + 1 >= number_samples)
+    {
+	const double *last = &samples[6 * (number_samples - 1)];
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    position[k] = last[k];
+	    velocity[k] = last[3 + k];
+	}
+	return true;
+    }
+
+    // interpolate linearly
+    double t_i = i * sampling_period;
+    double t_next = (i + 2 == number_samples) ? duration : t_i + sampling_period;
+    double ratio = (t_next > t_i) ? (t - t_i) / (t_next - t_i) : 0.0;
+    const double *current = &samples[6 * i];
+    const double *next = &samples[6 * (i + 1)];
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	position[k] = current[k] + ratio * (next[k] - current[k]);
+	velocity[k] = current[3 + k] + ratio * (next[3 + k] - current[3 + k]);
+    }
+
+    return true;
+}
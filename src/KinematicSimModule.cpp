@@ -0,0 +1,275 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <yarp/dev/Drivers.h>
+#include <yarp/dev/Wrapper.h>
+#include <yarp/dev/PolyDriverList.h>
+#include <yarp/math/Math.h>
+
+// std
+#include <sstream>
+
+#include "headers/KinematicSimModule.h"
+
+bool KinematicSimModule::openPart(const std::string &robot,
+				  const std::string &name,
+				  yarp::os::Bottle &group)
+{
+    std::unique_ptr<SimPart> part(new SimPart);
+    part->name = name;
+
+    // open the simulated control board
+    yarp::os::Property prop;
+    prop.fromString(group.toString());
+    prop.put("device", "simcontrolboard");
+    if (!part->drv_board.open(prop))
+    {
+	yError() << "KinematicSimModule: unable to open the control board of part" << name;
+	return false;
+    }
+    if (!part->drv_board.view(part->board) || part->board == nullptr)
+    {
+	yError() << "KinematicSimModule: unable to retrieve the control board of part" << name;
+	return false;
+    }
+
+    int joints;
+    part->board->getAxes(&joints);
+
+    // expose the control board with the same name
+    // used by the simulator
+    std::ostringstream networks;
+    networks << "(networks (" << name << ")) "
+	     << "(" << name << " 0 " << joints - 1 << " 0 " << joints - 1 << ")";
+    yarp::os::Property prop_wrapper;
+    prop_wrapper.fromString(networks.str());
+    prop_wrapper.put("device", "controlboardwrapper2");
+    prop_wrapper.put("name", robot + "/" + name);
+    prop_wrapper.put("joints", joints);
+    if (!part->drv_wrapper.open(prop_wrapper))
+    {
+	yError() << "KinematicSimModule: unable to open the wrapper of part" << name;
+	return false;
+    }
+
+    yarp::dev::IMultipleWrapper *wrapper;
+    if (!part->drv_wrapper.view(wrapper) || wrapper == nullptr)
+    {
+	yError() << "KinematicSimModule: unable to retrieve the wrapper of part" << name;
+	return false;
+    }
+
+    yarp::dev::PolyDriverList list;
+    list.push(&(part->drv_board), name.c_str());
+    if (!wrapper->attachAll(list))
+    {
+	yError() << "KinematicSimModule: unable to attach the wrapper of part" << name;
+	return false;
+    }
+
+    parts.push_back(std::move(part));
+
+    return true;
+}
+
+SimControlBoard* KinematicSimModule::findPart(const std::string &name)
+{
+    for (auto &part : parts)
+    {
+	if (part->name == name)
+	    return part->board;
+    }
+
+    return nullptr;
+}
+
+void KinematicSimModule::publishContacts(const std::string &arm_name,
+					 FingertipContactGenerator &generator,
+					 yarp::os::BufferedPort<iCub::skinDynLib::skinContactList> &port)
+{
+    SimControlBoard *torso = findPart("torso");
+    SimControlBoard *arm = findPart(arm_name);
+    if (torso == nullptr || arm == nullptr)
+	return;
+
+    yarp::sig::Vector encs_torso(3);
+    yarp::sig::Vector encs_arm(16);
+    torso->getEncoders(encs_torso.data());
+    arm->getEncoders(encs_arm.data());
+
+    // as the skinManager the list is published
+    // even if there are no contacts
+    iCub::skinDynLib::skinContactList &contacts = port.prepare();
+    generator.generate(encs_torso, encs_arm, contacts);
+    port.write();
+}
+
+bool KinematicSimModule::configure(yarp::os::ResourceFinder &rf)
+{
+    // namespace prepended to the names of all the ports
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+    std::string robot = prefix + rf.check("robot", yarp::os::Value("/icubSim")).asString();
+    period = rf.check("period", yarp::os::Value(0.01)).asDouble();
+
+    // parts
+    yarp::os::Bottle *parts_names = rf.find("parts").asList();
+    if (parts_names == nullptr)
+    {
+	yError() << "KinematicSimModule: cannot find parameter 'parts'"
+		 << "in current configuration";
+	return false;
+    }
+    for (size_t i = 0; i < parts_names->size(); i++)
+    {
+	std::string name = parts_names->get(i).asString();
+	yarp::os::Bottle &group = rf.findGroup(name);
+	if (group.isNull())
+	{
+	    yError() << "KinematicSimModule: cannot find group" << name
+		     << "in current configuration";
+	    return false;
+	}
+
+	if (!openPart(robot, name, group))
+	    return false;
+    }
+
+    // the contacts require both the torso and the arm
+    if (findPart("torso") == nullptr ||
+	findPart("right_arm") == nullptr ||
+	findPart("left_arm") == nullptr)
+    {
+	yError() << "KinematicSimModule: the parts torso, right_arm and left_arm are required";
+	return false;
+    }
+
+    // contacts
+    yarp::os::ResourceFinder rf_contacts = rf.findNestedResourceFinder("contacts");
+
+    yarp::os::Bottle *dimensions_list = rf_contacts.find("objectDimensions").asList();
+    yarp::os::Bottle *pose_list = rf_contacts.find("objectPose").asList();
+    if (dimensions_list == nullptr || dimensions_list->size() != 3 ||
+	pose_list == nullptr || pose_list->size() != 7)
+    {
+	yError() << "KinematicSimModule: expected (width depth height) as 'objectDimensions'"
+		 << "and (x y z ax ay az angle) as 'objectPose' in group contacts";
+	return false;
+    }
+
+    yarp::sig::Vector dimensions(3);
+    for (size_t i = 0; i < 3; i++)
+	dimensions[i] = dimensions_list->get(i).asDouble();
+
+    yarp::sig::Vector axis_angle(4);
+    for (size_t i = 0; i < 4; i++)
+	axis_angle[i] = pose_list->get(3 + i).asDouble();
+    yarp::sig::Matrix pose = yarp::math::axis2dcm(axis_angle);
+    for (size_t i = 0; i < 3; i++)
+	pose(i, 3) = pose_list->get(i).asDouble();
+
+    double threshold = rf_contacts.check("threshold", yarp::os::Value(0.01)).asDouble();
+    if (!contacts_right.configure("right", dimensions, threshold) ||
+	!contacts_left.configure("left", dimensions, threshold))
+	return false;
+    contacts_right.setObjectPose(pose);
+    contacts_left.setObjectPose(pose);
+
+    std::string port_right_name = rf_contacts.check("rightPort",
+						    yarp::os::Value("/right_hand/skinManager/skin_events:o")).asString();
+    std::string port_left_name = rf_contacts.check("leftPort",
+						   yarp::os::Value("/left_hand/skinManager/skin_events:o")).asString();
+    if (!port_contacts_right.open(prefix + port_right_name) ||
+	!port_contacts_left.open(prefix + port_left_name))
+    {
+	yError() << "KinematicSimModule: unable to open the contacts ports";
+	return false;
+    }
+
+    // join the stepped clock if required
+    std::string clock_master = rf.check("clockMaster", yarp::os::Value("")).asString();
+    if (!clock.configure("kinematic_sim", clock_master, prefix))
+	return false;
+
+    last_time = yarp::os::Time::now();
+
+    return true;
+}
+
+double KinematicSimModule::getPeriod()
+{
+    return period;
+}
+
+bool KinematicSimModule::updateModule()
+{
+    double now = yarp::os::Time::now();
+    double dt = now - last_time;
+    last_time = now;
+
+    for (auto &part : parts)
+	part->board->step(dt, now);
+
+    publishContacts("right_arm", contacts_right, port_contacts_right);
+    publishContacts("left_arm", contacts_left, port_contacts_left);
+
+    clock.cycleDone(now + period);
+
+    return true;
+}
+
+bool KinematicSimModule::close()
+{
+    port_contacts_right.close();
+    port_contacts_left.close();
+
+    clock.close();
+
+    // the wrappers are closed before the control boards
+    for (auto &part : parts)
+	part->drv_wrapper.close();
+    for (auto &part : parts)
+	part->drv_board.close();
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "KinematicSimModule: cannot find YARP!";
+	return 1;
+    }
+
+    // register the simulated control board
+    yarp::dev::Drivers::factory().add(new yarp::dev::DriverCreatorOf<SimControlBoard>("simcontrolboard",
+										       "",
+										       "SimControlBoard"));
+
+    // instantiate the resource finder
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("kinematic_sim_config.ini");
+    rf.configure(argc,argv);
+
+    // instantiate the module
+    KinematicSimModule sim;
+
+    // run the module
+    return sim.runModule(rf);
+}
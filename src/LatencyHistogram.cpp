@@ -0,0 +1,206 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/SystemClock.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "headers/LatencyHistogram.h"
+
+const std::size_t LatencyHistogram::sub_bucket_bits;
+const std::size_t LatencyHistogram::sub_bucket_count;
+const std::size_t LatencyHistogram::bucket_count;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+std::size_t LatencyHistogram::bucketIndex(const std::uint64_t &value)
+{
+    // values that do not need sub buckets are stored as they are
+    if (value < 2 * sub_bucket_count)
+	return static_cast<std::size_t>(value);
+
+    // find the most significant bit
+    std::size_t msb = 0;
+    for (std::uint64_t v = value; v > 1; v >>= 1)
+	msb++;
+
+    // keep the most significant sub_bucket_bits + 1 bits
+    std::size_t exponent = msb - sub_bucket_bits;
+    std::size_t mantissa = static_cast<std::size_t>(value >> exponent);
+
+    std::size_t index = (exponent + 1) * sub_bucket_count + (mantissa - sub_bucket_count);
+
+    return std::min(index, bucket_count - 1);
+}
+
+double LatencyHistogram::bucketValue(const std::size_t &index)
+{
+    if (index < 2 * sub_bucket_count)
+	return static_cast<double>(index);
+
+    std::size_t exponent = index / sub_bucket_count - 1;
+    std::size_t mantissa = index % sub_bucket_count + sub_bucket_count;
+
+    double lower = std::ldexp(static_cast<double>(mantissa), exponent);
+    double upper = std::ldexp(static_cast<double>(mantissa + 1), exponent);
+
+    return 0.5 * (lower + upper);
+}
+
+void LatencyHistogram::record(const double &duration)
+{
+    std::uint64_t value = 0;
+    if (duration > 0.0)
+	value = static_cast<std::uint64_t>(std::llround(duration * 1e6));
+
+    counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_us.fetch_add(value, std::memory_order_relaxed);
+
+    // update extrema
+    std::uint64_t current = min_us.load(std::memory_order_relaxed);
+    while (value < current &&
+	   !min_us.compare_exchange_weak(current, value, std::memory_order_relaxed));
+
+    current = max_us.load(std::memory_order_relaxed);
+    while (value > current &&
+	   !max_us.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::size_t i = 0; i < bucket_count; i++)
+	counts[i].store(0, std::memory_order_relaxed);
+    total_count.store(0, std::memory_order_relaxed);
+    total_us.store(0, std::memory_order_relaxed);
+    min_us.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    max_us.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::count() const
+{
+    return total_count.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    std::uint64_t n = count();
+    if (n == 0)
+	return 0.0;
+
+    return static_cast<double>(total_us.load(std::memory_order_relaxed)) / n * 1e-6;
+}
+
+double LatencyHistogram::min() const
+{
+    if (count() == 0)
+	return 0.0;
+
+    return static_cast<double>(min_us.load(std::memory_order_relaxed)) * 1e-6;
+}
+
+double LatencyHistogram::max() const
+{
+    return static_cast<double>(max_us.load(std::memory_order_relaxed)) * 1e-6;
+}
+
+double LatencyHistogram::percentile(const double &percentile) const
+{
+    // take a snapshot of the counts
+    // since they might change concurrently
+    std::uint64_t snapshot[bucket_count];
+    std::uint64_t n = 0;
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+	snapshot[i] = counts[i].load(std::memory_order_relaxed);
+	n += snapshot[i];
+    }
+
+    if (n == 0)
+	return 0.0;
+
+    // rank of the required value
+    double p = std::min(std::max(percentile, 0.0), 100.0);
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * n));
+    rank = std::max(rank, static_cast<std::uint64_t>(1));
+
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+	cumulative += snapshot[i];
+	if (cumulative >= rank)
+	    return std::min(bucketValue(i), static_cast<double>(max_us.load())) * 1e-6;
+    }
+
+    return max();
+}
+
+void LatencyStats::add(const std::string &name)
+{
+    if (histograms.find(name) == histograms.end())
+	histograms[name] = std::unique_ptr<LatencyHistogram>(new LatencyHistogram());
+}
+
+LatencyHistogram* LatencyStats::get(const std::string &name) const
+{
+    auto item = histograms.find(name);
+    if (item == histograms.end())
+	return nullptr;
+
+    return item->second.get();
+}
+
+void LatencyStats::record(const std::string &name, const double &duration) const
+{
+    LatencyHistogram *histogram = get(name);
+    if (histogram != nullptr)
+	histogram->record(duration);
+}
+
+void LatencyStats::reset()
+{
+    for (auto &item : histograms)
+	item.second->reset();
+}
+
+void LatencyStats::toBottle(yarp::os::Bottle &bottle) const
+{
+    for (const auto &item : histograms)
+    {
+	const LatencyHistogram &histogram = *item.second;
+
+	yarp::os::Bottle &entry = bottle.addList();
+	entry.addString(item.first);
+	entry.addInt(static_cast<int>(histogram.count()));
+	entry.addDouble(histogram.mean() * 1000.0);
+	entry.addDouble(histogram.percentile(50) * 1000.0);
+	entry.addDouble(histogram.percentile(90) * 1000.0);
+	entry.addDouble(histogram.percentile(99) * 1000.0);
+	entry.addDouble(histogram.max() * 1000.0);
+    }
+}
+
+ScopedLatency::ScopedLatency(LatencyHistogram *histogram) :
+    histogram(histogram),
+    start(yarp::os::SystemClock::nowSystem()) { }
+
+ScopedLatency::~ScopedLatency()
+{
+    if (histogram != nullptr)
+	histogram->record(yarp::os::SystemClock::nowSystem() - start);
+}
@@ -0,0 +1,944 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "headers/MeshModel.h"
+
+// maximum number of faces in a leaf
+#define MESH_BVH_LEAF_SIZE 4
+
+// maximum depth of the traversal stack
+#define MESH_BVH_STACK_SIZE 64
+
+// maximum depth of the hierarchy, the root having depth 0
+// a traversal never holds more than depth + 1 nodes in its stack
+#define MESH_BVH_MAX_DEPTH (MESH_BVH_STACK_SIZE - 1)
+
+namespace {
+
+inline void sub(const float a[3], const float b[3], float r[3])
+{
+    r[0] = a[0] - b[0];
+    r[1] = a[1] - b[1];
+    r[2] = a[2] - b[2];
+}
+
+inline float dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline void cross(const float a[3], const float b[3], float r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/*
+ * Parameter of the point of the segment ab closest to p.
+ */
+inline float segmentParameter(const float a[3], const float b[3], const float p[3])
+{
+    float ab[3];
+    float ap[3];
+    sub(b, a, ab);
+    sub(p, a, ap);
+
+    float length = dot(ab, ab);
+    if (length <= 0.0f)
+	return 0.0f;
+    return std::min(std::max(dot(ap, ab) / length, 0.0f), 1.0f);
+}
+
+/*
+ * Squared distance between a point and a box.
+ */
+inline float boxDistance(const MeshBVHNode &node, const float p[3])
+{
+    float d = 0;
+    for (std::size_t i = 0; i < 3; i++)
+    {
+	float e = std::max(std::max(node.min[i] - p[i], p[i] - node.max[i]), 0.0f);
+	d += e * e;
+    }
+    return d;
+}
+
+/*
+ * Slab test between a ray and a box.
+ */
+inline bool rayBox(const MeshBVHNode &node,
+		   const float origin[3],
+		   const float inv_dir[3],
+		   const float &t_max)
+{
+    float t0 = 0;
+    float t1 = t_max;
+    for (std::size_t i = 0; i < 3; i++)
+    {
+	float t_near = (node.min[i] - origin[i]) * inv_dir[i];
+	float t_far = (node.max[i] - origin[i]) * inv_dir[i];
+	if (t_near > t_far)
+	    std::swap(t_near, t_far);
+	t0 = std::max(t0, t_near);
+	t1 = std::min(t1, t_far);
+	if (t0 > t1)
+	    return false;
+    }
+    return true;
+}
+
+/*
+ * Intersection between a ray and a triangle (Moller-Trumbore).
+ */
+inline bool rayTriangle(const float origin[3], const float dir[3],
+			const float *a, const float *b, const float *c,
+			float &t)
+{
+    float e1[3];
+    float e2[3];
+    float pv[3];
+    sub(b, a, e1);
+    sub(c, a, e2);
+    cross(dir, e2, pv);
+
+    float det = dot(e1, pv);
+    if (std::fabs(det) < 1e-12f)
+	return false;
+    float inv_det = 1.0f / det;
+
+    float tv[3];
+    sub(origin, a, tv);
+    float u = dot(tv, pv) * inv_det;
+    if (u < 0.0f || u > 1.0f)
+	return false;
+
+    float qv[3];
+    cross(tv, e1, qv);
+    float v = dot(dir, qv) * inv_det;
+    if (v < 0.0f || u + v > 1.0f)
+	return false;
+
+    t = dot(e2, qv) * inv_det;
+    return t > 0.0f;
+}
+
+}
+
+MeshModel::MeshModel() : mapped(nullptr),
+			 mapped_size(0)
+{
+    clear();
+}
+
+MeshModel::~MeshModel()
+{
+    clear();
+}
+
+void MeshModel::clear()
+{
+    if (mapped != nullptr)
+	munmap(mapped, mapped_size);
+    mapped = nullptr;
+    mapped_size = 0;
+
+    vertices_storage.clear();
+    faces_storage.clear();
+    normals_storage.clear();
+    areas_storage.clear();
+    nodes_storage.clear();
+
+    n_vertices = 0;
+    n_faces = 0;
+    n_nodes = 0;
+    vertices = nullptr;
+    faces = nullptr;
+    normals = nullptr;
+    areas = nullptr;
+    nodes = nullptr;
+}
+
+bool MeshModel::parseOFF(const std::string &file_name,
+			 std::vector<float> &vertices,
+			 std::vector<uint32_t> &faces)
+{
+    std::ifstream file(file_name.c_str());
+    if (!file.is_open())
+    {
+	yError() << "MeshModel::parseOFF"
+		 << "Error: unable to open the file"
+		 << file_name;
+	return false;
+    }
+
+    // get the next line skipping comments and blank lines
+    std::string line;
+    auto next_line = [&file, &line]() -> bool
+    {
+	while (std::getline(file, line))
+	{
+	    std::size_t comment = line.find('#');
+	    if (comment != std::string::npos)
+		line.erase(comment);
+	    if (line.find_first_not_of(" \t\r") != std::string::npos)
+		return true;
+	}
+	return false;
+    };
+
+    // the header keyword can be followed by the counts on the same line
+    std::size_t nv = 0;
+    std::size_t nf = 0;
+    std::string keyword;
+    if (!next_line())
+    {
+	yError() << "MeshModel::parseOFF"
+		 << "Error: the file"
+		 << file_name
+		 << "is empty";
+	return false;
+    }
+    std::istringstream header(line);
+    header >> keyword;
+    if (keyword != "OFF")
+    {
+	yError() << "MeshModel::parseOFF"
+		 << "Error: the file"
+		 << file_name
+		 << "is not an OFF file";
+	return false;
+    }
+    if (!(header >> nv >> nf))
+    {
+	if (!next_line())
+	    return false;
+	std::istringstream counts(line);
+	if (!(counts >> nv >> nf))
+	{
+	    yError() << "MeshModel::parseOFF"
+		     << "Error: invalid header in file"
+		     << file_name;
+	    return false;
+	}
+    }
+
+    vertices.resize(3 * nv);
+    for (std::size_t i = 0; i < nv; i++)
+    {
+	std::istringstream values;
+	if (next_line())
+	    values.str(line);
+	if (!(values >> vertices[3 * i] >> vertices[3 * i + 1] >> vertices[3 * i + 2]))
+	{
+	    yError() << "MeshModel::parseOFF"
+		     << "Error: invalid vertex" << i
+		     << "in file" << file_name;
+	    return false;
+	}
+    }
+
+    faces.clear();
+    faces.reserve(3 * nf);
+    for (std::size_t i = 0; i < nf; i++)
+    {
+	std::istringstream values;
+	if (next_line())
+	    values.str(line);
+
+	std::size_t n = 0;
+	std::vector<uint32_t> polygon;
+	bool ok = static_cast<bool>(values >> n) && n >= 3;
+	for (std::size_t j = 0; ok && j < n; j++)
+	{
+	    uint32_t index;
+	    ok = static_cast<bool>(values >> index) && index < nv;
+	    polygon.push_back(index);
+	}
+	if (!ok)
+	{
+	    yError() << "MeshModel::parseOFF"
+		     << "Error: invalid face" << i
+		     << "in file" << file_name;
+	    return false;
+	}
+
+	// triangulate as a fan
+	for (std::size_t j = 1; j + 1 < n; j++)
+	{
+	    faces.push_back(polygon[0]);
+	    faces.push_back(polygon[j]);
+	    faces.push_back(polygon[j + 1]);
+	}
+    }
+
+    return true;
+}
+
+void MeshModel::build(const std::vector<float> &vertices,
+		      std::vector<uint32_t> &faces,
+		      std::vector<float> &normals,
+		      std::vector<float> &areas,
+		      std::vector<MeshBVHNode> &nodes)
+{
+    std::size_t nf = faces.size() / 3;
+
+    // centroids of the faces
+    std::vector<float> centroids(3 * nf);
+    for (std::size_t i = 0; i < nf; i++)
+    {
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    centroids[3 * i + k] = (vertices[3 * faces[3 * i] + k] +
+				    vertices[3 * faces[3 * i + 1] + k] +
+				    vertices[3 * faces[3 * i + 2] + k]) / 3.0f;
+	}
+    }
+
+    // build the hierarchy by recursive median split
+    // along the largest axis of the centroids
+    std::vector<uint32_t> order(nf);
+    for (std::size_t i = 0; i < nf; i++)
+	order[i] = i;
+
+    nodes.clear();
+    std::function<void(std::size_t, std::size_t, std::size_t)> split;
+    split = [&](std::size_t begin, std::size_t end, std::size_t depth)
+    {
+	std::size_t index = nodes.size();
+	nodes.push_back(MeshBVHNode());
+
+	// bounds of the faces and of the centroids
+	float c_min[3];
+	float c_max[3];
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    nodes[index].min[k] = c_min[k] = std::numeric_limits<float>::max();
+	    nodes[index].max[k] = c_max[k] = std::numeric_limits<float>::lowest();
+	}
+	for (std::size_t i = begin; i < end; i++)
+	{
+	    for (std::size_t k = 0; k < 3; k++)
+	    {
+		for (std::size_t v = 0; v < 3; v++)
+		{
+		    float value = vertices[3 * faces[3 * order[i] + v] + k];
+		    nodes[index].min[k] = std::min(nodes[index].min[k], value);
+		    nodes[index].max[k] = std::max(nodes[index].max[k], value);
+		}
+		c_min[k] = std::min(c_min[k], centroids[3 * order[i] + k]);
+		c_max[k] = std::max(c_max[k], centroids[3 * order[i] + k]);
+	    }
+	}
+
+	// bound the depth, hence the stack used by the traversals
+	if (end - begin <= MESH_BVH_LEAF_SIZE || depth >= MESH_BVH_MAX_DEPTH)
+	{
+	    nodes[index].offset = begin;
+	    nodes[index].count = end - begin;
+	    return;
+	}
+
+	std::size_t axis = 0;
+	for (std::size_t k = 1; k < 3; k++)
+	{
+	    if (c_max[k] - c_min[k] > c_max[axis] - c_min[axis])
+		axis = k;
+	}
+
+	std::size_t middle = begin + (end - begin) / 2;
+	std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+			 [&centroids, &axis](const uint32_t &a, const uint32_t &b)
+			 {
+			     return centroids[3 * a + axis] < centroids[3 * b + axis];
+			 });
+
+	nodes[index].count = 0;
+	split(begin, middle, depth + 1);
+	nodes[index].offset = nodes.size();
+	split(middle, end, depth + 1);
+    };
+    if (nf > 0)
+	split(0, nf, 0);
+
+    // sort the faces and evaluate normals and areas
+    std::vector<uint32_t> sorted(3 * nf);
+    normals.resize(3 * nf);
+    areas.resize(nf);
+    for (std::size_t i = 0; i < nf; i++)
+    {
+	for (std::size_t v = 0; v < 3; v++)
+	    sorted[3 * i + v] = faces[3 * order[i] + v];
+
+	const float *a = &vertices[3 * sorted[3 * i]];
+	const float *b = &vertices[3 * sorted[3 * i + 1]];
+	const float *c = &vertices[3 * sorted[3 * i + 2]];
+	float e1[3];
+	float e2[3];
+	float n[3];
+	sub(b, a, e1);
+	sub(c, a, e2);
+	cross(e1, e2, n);
+
+	float norm = std::sqrt(dot(n, n));
+	areas[i] = 0.5f * norm;
+	for (std::size_t k = 0; k < 3; k++)
+	    normals[3 * i + k] = norm > 0.0f ? n[k] / norm : 0.0f;
+    }
+    faces.swap(sorted);
+}
+
+bool MeshModel::isHierarchyValid(const MeshBVHNode *nodes,
+				 const std::size_t &n_nodes,
+				 const std::size_t &n_faces)
+{
+    if (n_nodes == 0)
+	return n_faces == 0;
+
+    // children follow their parent, hence the walk terminates
+    std::vector<std::pair<std::size_t, std::size_t>> pending;
+    pending.push_back(std::make_pair(0, 0));
+    while (!pending.empty())
+    {
+	std::size_t index = pending.back().first;
+	std::size_t depth = pending.back().second;
+	pending.pop_back();
+
+	if (depth > MESH_BVH_MAX_DEPTH)
+	    return false;
+
+	const MeshBVHNode &node = nodes[index];
+	if (node.count > 0)
+	{
+	    if (node.offset > n_faces || node.count > n_faces - node.offset)
+		return false;
+	    continue;
+	}
+
+	if (index + 1 >= n_nodes || node.offset <= index + 1 || node.offset >= n_nodes)
+	    return false;
+	pending.push_back(std::make_pair(node.offset, depth + 1));
+	pending.push_back(std::make_pair(index + 1, depth + 1));
+    }
+
+    return true;
+}
+
+bool MeshModel::mapCache(const std::string &cache_name,
+			 const uint64_t &source_size,
+			 const int64_t &source_mtime)
+{
+    int fd = ::open(cache_name.c_str(), O_RDONLY);
+    if (fd < 0)
+	return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(MeshCacheHeader)))
+    {
+	::close(fd);
+	return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    std::size_t size = info.st_size;
+    void *ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED)
+	return false;
+
+    // the size of the cache has to match exactly the counts in the header
+    // the counts are 32 bits wide, hence the expected size cannot overflow
+    const MeshCacheHeader *header = static_cast<const MeshCacheHeader*>(ptr);
+    uint64_t expected = sizeof(MeshCacheHeader) +
+	uint64_t(header->n_vertices) * 3 * sizeof(float) +
+	uint64_t(header->n_faces) * (3 * sizeof(uint32_t) + 4 * sizeof(float)) +
+	uint64_t(header->n_nodes) * sizeof(MeshBVHNode);
+    if (header->magic != MESH_CACHE_MAGIC ||
+	header->version != MESH_CACHE_VERSION ||
+	header->source_size != source_size ||
+	header->source_mtime != source_mtime ||
+	expected != size)
+    {
+	munmap(ptr, size);
+	return false;
+    }
+
+    // the nodes are stored at the end of the cache
+    const MeshBVHNode *cached_nodes = reinterpret_cast<const MeshBVHNode*>
+	(static_cast<const char*>(ptr) + size - header->n_nodes * sizeof(MeshBVHNode));
+    if (!isHierarchyValid(cached_nodes, header->n_nodes, header->n_faces))
+    {
+	munmap(ptr, size);
+	return false;
+    }
+
+    // the faces are used to index the vertices without further checks
+    const uint32_t *cached_faces = reinterpret_cast<const uint32_t*>
+	(static_cast<const char*>(ptr) + sizeof(MeshCacheHeader) + header->n_vertices * 3 * sizeof(float));
+    for (std::size_t i = 0; i < 3 * std::size_t(header->n_faces); i++)
+    {
+	if (cached_faces[i] >= header->n_vertices)
+	{
+	    munmap(ptr, size);
+	    return false;
+	}
+    }
+
+    clear();
+    mapped = ptr;
+    mapped_size = size;
+
+    n_vertices = header->n_vertices;
+    n_faces = header->n_faces;
+    n_nodes = header->n_nodes;
+
+    const char *data = static_cast<const char*>(ptr) + sizeof(MeshCacheHeader);
+    vertices = reinterpret_cast<const float*>(data);
+    data += n_vertices * 3 * sizeof(float);
+    faces = reinterpret_cast<const uint32_t*>(data);
+    data += n_faces * 3 * sizeof(uint32_t);
+    normals = reinterpret_cast<const float*>(data);
+    data += n_faces * 3 * sizeof(float);
+    areas = reinterpret_cast<const float*>(data);
+    data += n_faces * sizeof(float);
+    nodes = reinterpret_cast<const MeshBVHNode*>(data);
+
+    return true;
+}
+
+bool MeshModel::writeCache(const std::string &cache_name,
+			   const uint64_t &source_size,
+			   const int64_t &source_mtime)
+{
+    MeshCacheHeader header;
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.source_size = source_size;
+    header.source_mtime = source_mtime;
+    header.n_vertices = n_vertices;
+    header.n_faces = n_faces;
+    header.n_nodes = n_nodes;
+    header.reserved = 0;
+
+    // write to a temporary file first so that concurrent
+    // readers never see a partial cache
+    std::ostringstream tmp_name;
+    tmp_name << cache_name << ".tmp." << getpid();
+    FILE *file = std::fopen(tmp_name.str().c_str(), "wb");
+    if (file == nullptr)
+	return false;
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok &= std::fwrite(vertices, sizeof(float), 3 * n_vertices, file) == 3 * n_vertices;
+    ok &= std::fwrite(faces, sizeof(uint32_t), 3 * n_faces, file) == 3 * n_faces;
+    ok &= std::fwrite(normals, sizeof(float), 3 * n_faces, file) == 3 * n_faces;
+    ok &= std::fwrite(areas, sizeof(float), n_faces, file) == n_faces;
+    ok &= std::fwrite(nodes, sizeof(MeshBVHNode), n_nodes, file) == n_nodes;
+    ok &= std::fclose(file) == 0;
+
+    ok = ok && std::rename(tmp_name.str().c_str(), cache_name.c_str()) == 0;
+    if (!ok)
+	std::remove(tmp_name.str().c_str());
+
+    return ok;
+}
+
+void MeshModel::useStorage()
+{
+    n_vertices = vertices_storage.size() / 3;
+    n_faces = faces_storage.size() / 3;
+    n_nodes = nodes_storage.size();
+    vertices = vertices_storage.data();
+    faces = faces_storage.data();
+    normals = normals_storage.data();
+    areas = areas_storage.data();
+    nodes = nodes_storage.data();
+}
+
+bool MeshModel::load(const std::string &file_name, const bool &use_cache)
+{
+    clear();
+
+    struct stat info;
+    if (stat(file_name.c_str(), &info) != 0)
+    {
+	yError() << "MeshModel::load"
+		 << "Error: unable to find the file"
+		 << file_name;
+	return false;
+    }
+    uint64_t source_size = info.st_size;
+    int64_t source_mtime = info.st_mtime;
+
+    std::string cache_name = file_name + ".bin";
+    if (use_cache && mapCache(cache_name, source_size, source_mtime))
+	return true;
+
+    // parse the mesh and build the hierarchy
+    if (!parseOFF(file_name, vertices_storage, faces_storage))
+    {
+	clear();
+	return false;
+    }
+    build(vertices_storage, faces_storage, normals_storage, areas_storage, nodes_storage);
+    useStorage();
+
+    if (use_cache)
+    {
+	// switch to the mapped cache to release the storage
+	if (writeCache(cache_name, source_size, source_mtime) &&
+	    mapCache(cache_name, source_size, source_mtime))
+	    return true;
+
+	yWarning() << "MeshModel::load"
+		   << "Warning: unable to write the cache"
+		   << cache_name;
+    }
+
+    return true;
+}
+
+std::size_t MeshModel::getNumberVertices() const
+{
+    return n_vertices;
+}
+
+std::size_t MeshModel::getNumberFaces() const
+{
+    return n_faces;
+}
+
+const float* MeshModel::getVertices() const
+{
+    return vertices;
+}
+
+const uint32_t* MeshModel::getFaces() const
+{
+    return faces;
+}
+
+const float* MeshModel::getNormals() const
+{
+    return normals;
+}
+
+const float* MeshModel::getAreas() const
+{
+    return areas;
+}
+
+bool MeshModel::getBoundingBox(float min[3], float max[3]) const
+{
+    if (n_nodes == 0)
+	return false;
+
+    // the root node bounds the whole mesh
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	min[k] = nodes[0].min[k];
+	max[k] = nodes[0].max[k];
+    }
+
+    return true;
+}
+
+float MeshModel::closestPointOnFace(const std::size_t &face,
+				    const float p[3],
+				    float q[3]) const
+{
+    // from C. Ericson, Real-Time Collision Detection, 5.1.5
+    const float *a = &vertices[3 * faces[3 * face]];
+    const float *b = &vertices[3 * faces[3 * face + 1]];
+    const float *c = &vertices[3 * faces[3 * face + 2]];
+
+    float ab[3];
+    float ac[3];
+    float ap[3];
+    sub(b, a, ab);
+    sub(c, a, ac);
+    sub(p, a, ap);
+
+    float d1 = dot(ab, ap);
+    float d2 = dot(ac, ap);
+    float v = 0;
+    float w = 0;
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+	// vertex a
+    }
+    else
+    {
+	float bp[3];
+	sub(p, b, bp);
+	float d3 = dot(ab, bp);
+	float d4 = dot(ac, bp);
+	float cp[3];
+	sub(p, c, cp);
+	float d5 = dot(ab, cp);
+	float d6 = dot(ac, cp);
+
+	float vc = d1 * d4 - d3 * d2;
+	float vb = d5 * d2 - d1 * d6;
+	float va = d3 * d6 - d5 * d4;
+
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+	    // vertex b
+	    v = 1.0f;
+	}
+	else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+	    // edge ab
+	    v = d1 / (d1 - d3);
+	}
+	else if (d6 >= 0.0f && d5 <= d6)
+	{
+	    // vertex c
+	    w = 1.0f;
+	}
+	else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+	    // edge ac
+	    w = d2 / (d2 - d6);
+	}
+	else if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+	    // edge bc
+	    w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+	    v = 1.0f - w;
+	}
+	else if (va + vb + vc > 0.0f)
+	{
+	    // interior
+	    float denom = 1.0f / (va + vb + vc);
+	    v = vb * denom;
+	    w = vc * denom;
+	}
+	else
+	{
+	    // degenerate face, nearest of the edges
+	    float t_ab = segmentParameter(a, b, p);
+	    float t_ac = segmentParameter(a, c, p);
+	    float t_bc = segmentParameter(b, c, p);
+	    float candidates[3][2] = {{t_ab, 0.0f}, {0.0f, t_ac}, {1.0f - t_bc, t_bc}};
+	    float best = std::numeric_limits<float>::max();
+	    for (std::size_t i = 0; i < 3; i++)
+	    {
+		float d = 0;
+		for (std::size_t k = 0; k < 3; k++)
+		{
+		    float e = a[k] + ab[k] * candidates[i][0] + ac[k] * candidates[i][1] - p[k];
+		    d += e * e;
+		}
+		if (d < best)
+		{
+		    best = d;
+		    v = candidates[i][0];
+		    w = candidates[i][1];
+		}
+	    }
+	}
+    }
+
+    float d = 0;
+    for (std::size_t k = 0; k < 3; k++)
+    {
+	q[k] = a[k] + ab[k] * v + ac[k] * w;
+	d += (p[k] - q[k]) * (p[k] - q[k]);
+    }
+
+    return d;
+}
+
+float MeshModel::closestPoint(const float p[3], float q[3], uint32_t &face) const
+{
+    if (n_nodes == 0)
+	return -1.0f;
+
+    float best = std::numeric_limits<float>::max();
+
+    // nodes are visited nearest first
+    // and pruned using the distance from their box
+    uint32_t stack[MESH_BVH_STACK_SIZE];
+    float stack_dist[MESH_BVH_STACK_SIZE];
+    std::size_t top = 0;
+    stack[top] = 0;
+    stack_dist[top++] = boxDistance(nodes[0], p);
+
+    while (top > 0)
+    {
+	top--;
+	if (stack_dist[top] >= best)
+	    continue;
+
+	const MeshBVHNode &node = nodes[stack[top]];
+	if (node.count > 0)
+	{
+	    for (std::size_t i = node.offset; i < node.offset + node.count; i++)
+	    {
+		float candidate[3];
+		float d = closestPointOnFace(i, p, candidate);
+		if (d < best)
+		{
+		    best = d;
+		    face = i;
+		    q[0] = candidate[0];
+		    q[1] = candidate[1];
+		    q[2] = candidate[2];
+		}
+	    }
+	    continue;
+	}
+
+	uint32_t left = stack[top] + 1;
+	uint32_t right = node.offset;
+	float d_left = boxDistance(nodes[left], p);
+	float d_right = boxDistance(nodes[right], p);
+	if (d_left < d_right)
+	{
+	    std::swap(left, right);
+	    std::swap(d_left, d_right);
+	}
+
+	// push the farthest child first
+	if (d_left < best)
+	{
+	    stack[top] = left;
+	    stack_dist[top++] = d_left;
+	}
+	if (d_right < best)
+	{
+	    stack[top] = right;
+	    stack_dist[top++] = d_right;
+	}
+    }
+
+    return best;
+}
+
+float MeshModel::distance(const float p[3]) const
+{
+    float q[3];
+    uint32_t face;
+    float d = closestPoint(p, q, face);
+
+    return d < 0.0f ? d : std::sqrt(d);
+}
+
+bool MeshModel::rayCast(const float origin[3], const float dir[3],
+			float &t, uint32_t &face) const
+{
+    if (n_nodes == 0)
+	return false;
+
+    float inv_dir[3] = {1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2]};
+    float best = std::numeric_limits<float>::max();
+    bool found = false;
+
+    uint32_t stack[MESH_BVH_STACK_SIZE];
+    std::size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+	uint32_t index = stack[--top];
+	const MeshBVHNode &node = nodes[index];
+	if (!rayBox(node, origin, inv_dir, best))
+	    continue;
+
+	if (node.count > 0)
+	{
+	    for (std::size_t i = node.offset; i < node.offset + node.count; i++)
+	    {
+		float t_face;
+		if (rayTriangle(origin, dir,
+				&vertices[3 * faces[3 * i]],
+				&vertices[3 * faces[3 * i + 1]],
+				&vertices[3 * faces[3 * i + 2]],
+				t_face) && t_face < best)
+		{
+		    best = t_face;
+		    face = i;
+		    found = true;
+		}
+	    }
+	    continue;
+	}
+
+	stack[top++] = node.offset;
+	stack[top++] = index + 1;
+    }
+
+    if (found)
+	t = best;
+
+    return found;
+}
+
+std::size_t MeshModel::countIntersections(const float origin[3], const float dir[3]) const
+{
+    if (n_nodes == 0)
+	return 0;
+
+    float inv_dir[3] = {1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2]};
+    std::size_t count = 0;
+
+    uint32_t stack[MESH_BVH_STACK_SIZE];
+    std::size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+	uint32_t index = stack[--top];
+	const MeshBVHNode &node = nodes[index];
+	if (!rayBox(node, origin, inv_dir, std::numeric_limits<float>::max()))
+	    continue;
+
+	if (node.count > 0)
+	{
+	    for (std::size_t i = node.offset; i < node.offset + node.count; i++)
+	    {
+		float t_face;
+		if (rayTriangle(origin, dir,
+				&vertices[3 * faces[3 * i]],
+				&vertices[3 * faces[3 * i + 1]],
+				&vertices[3 * faces[3 * i + 2]],
+				t_face))
+		    count++;
+	    }
+	    continue;
+	}
+
+	stack[top++] = node.offset;
+	stack[top++] = index + 1;
+    }
+
+    return count;
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Value.h>
+
+#include "headers/ObjectRegistry.h"
+
+bool ObjectRegistry::configure(yarp::os::ResourceFinder &rf)
+{
+    objects.clear();
+
+    yarp::os::Bottle *ids = rf.find("objects").asList();
+    if (ids == nullptr || ids->size() == 0)
+    {
+	// fall back to the box used in the default scenario
+	yWarning() << "ObjectRegistry: cannot find parameter 'objects'"
+		   << "in current configuration, using box_alt";
+
+	ObjectDescription box;
+	box.id = "box_alt";
+	box.mesh = "model://box_alt/box.off";
+	box.width = 0.24;
+	box.depth = 0.17;
+	box.height = 0.037;
+	box.estimate_frame = "/box_alt/estimate/frame";
+	box.ground_truth_frame = "/box_alt/frame";
+	add(box);
+
+	default_object = box.id;
+
+	return true;
+    }
+
+    for (size_t i = 0; i < ids->size(); i++)
+    {
+	std::string id = ids->get(i).asString();
+
+	yarp::os::Bottle &group = rf.findGroup(id);
+	if (group.isNull())
+	{
+	    yError() << "ObjectRegistry: cannot find group" << id
+		     << "in current configuration";
+	    return false;
+	}
+
+	ObjectDescription object;
+	object.id = id;
+	object.mesh = group.check("mesh", yarp::os::Value("")).asString();
+	object.estimate_frame = group.check("estimateFrame", yarp::os::Value("")).asString();
+	object.ground_truth_frame = group.check("groundTruthFrame",
+					       yarp::os::Value("/" + id + "/frame")).asString();
+
+	yarp::os::Bottle *dimensions = group.find("dimensions").asList();
+	if (dimensions == nullptr || dimensions->size() != 3)
+	{
+	    yError() << "ObjectRegistry: expected (width depth height)"
+		     << "as parameter 'dimensions' of object" << id;
+	    return false;
+	}
+	object.width = dimensions->get(0).asDouble();
+	object.depth = dimensions->get(1).asDouble();
+	object.height = dimensions->get(2).asDouble();
+
+	if (!add(object))
+	{
+	    yError() << "ObjectRegistry: object" << id << "registered twice";
+	    return false;
+	}
+    }
+
+    default_object = rf.check("defaultObject", yarp::os::Value(objects.front().id)).asString();
+    if (find(default_object) == nullptr)
+    {
+	yError() << "ObjectRegistry: the default object" << default_object
+		 << "is not registered";
+	return false;
+    }
+
+    return true;
+}
+
+bool ObjectRegistry::add(const ObjectDescription &object)
+{
+    if (find(object.id) != nullptr)
+	return false;
+
+    objects.push_back(object);
+
+    return true;
+}
+
+const ObjectDescription* ObjectRegistry::find(const std::string &id) const
+{
+    for (const ObjectDescription &object : objects)
+    {
+	if (object.id == id)
+	    return &object;
+    }
+
+    return nullptr;
+}
+
+const std::vector<ObjectDescription>& ObjectRegistry::getObjects() const
+{
+    return objects;
+}
+
+const std::string& ObjectRegistry::getDefaultObject() const
+{
+    return default_object;
+}
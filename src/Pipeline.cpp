@@ -0,0 +1,168 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#include "headers/Pipeline.h"
+
+PipelineParser::PipelineParser(const std::size_t &max_steps) :
+    max_steps(max_steps) { }
+
+bool PipelineParser::parseStep(const yarp::os::Value &value, std::deque<PipelineStep> &steps)
+{
+    if (steps.size() >= max_steps)
+    {
+	error = "too many steps, at most " + std::to_string(max_steps) + " are allowed";
+	return false;
+    }
+
+    if (value.isString())
+    {
+	PipelineStep step;
+	step.type = PipelineStepType::Phase;
+	step.phase = value.asString();
+	step.duration = 0.0;
+	step.tolerance = 0.0;
+	step.window = 0.0;
+
+	steps.push_back(step);
+
+	return true;
+    }
+
+    yarp::os::Bottle *list = value.asList();
+    if (list == nullptr || list->size() == 0 || !list->get(0).isString())
+    {
+	error = "invalid step " + value.toString();
+	return false;
+    }
+
+    std::string type = list->get(0).asString();
+    if (type == "parallel")
+    {
+	// at least two phases
+	if (list->size() < 3)
+	{
+	    error = "expected (parallel <phase> <phase> ...)";
+	    return false;
+	}
+
+	PipelineStep step;
+	step.type = PipelineStepType::Parallel;
+	step.duration = 0.0;
+	step.tolerance = 0.0;
+	step.window = 0.0;
+	for (std::size_t i = 1; i < list->size(); i++)
+	{
+	    if (!list->get(i).isString())
+	    {
+		error = "only phases can be executed in parallel";
+		return false;
+	    }
+	    step.phases.push_back(list->get(i).asString());
+	}
+
+	steps.push_back(step);
+    }
+    else if (type == "wait")
+    {
+	if (list->size() != 2 ||
+	    (!list->get(1).isDouble() && !list->get(1).isInt()) ||
+	    list->get(1).asDouble() < 0.0)
+	{
+	    error = "expected (wait <seconds>) with non negative seconds";
+	    return false;
+	}
+
+	PipelineStep step;
+	step.type = PipelineStepType::Wait;
+	step.duration = list->get(1).asDouble();
+	step.tolerance = 0.0;
+	step.window = 0.0;
+
+	steps.push_back(step);
+    }
+    else if (type == "wait-convergence")
+    {
+	if (list->size() != 4)
+	{
+	    error = "expected (wait-convergence <tolerance> <window> <timeout>)";
+	    return false;
+	}
+
+	PipelineStep step;
+	step.type = PipelineStepType::WaitConvergence;
+	step.tolerance = list->get(1).asDouble();
+	step.window = list->get(2).asDouble();
+	step.duration = list->get(3).asDouble();
+
+	if (step.tolerance <= 0.0 || step.window <= 0.0 || step.duration < step.window)
+	{
+	    error = "tolerance and window must be positive and the timeout not shorter than the window";
+	    return false;
+	}
+
+	steps.push_back(step);
+    }
+    else if (type == "repeat")
+    {
+	if (list->size() < 3 || !list->get(1).isInt() || list->get(1).asInt() < 0)
+	{
+	    error = "expected (repeat <times> <step> <step> ...)";
+	    return false;
+	}
+
+	int times = list->get(1).asInt();
+	for (int i = 0; i < times; i++)
+	{
+	    for (std::size_t j = 2; j < list->size(); j++)
+	    {
+		if (!parseStep(list->get(j), steps))
+		    return false;
+	    }
+	}
+    }
+    else
+    {
+	error = "unknown step " + type;
+	return false;
+    }
+
+    return true;
+}
+
+bool PipelineParser::parse(const yarp::os::Bottle &command,
+			   const std::size_t &first,
+			   std::deque<PipelineStep> &steps)
+{
+    steps.clear();
+    error.clear();
+
+    if (command.size() <= first)
+    {
+	error = "empty pipeline";
+	return false;
+    }
+
+    for (std::size_t i = first; i < command.size(); i++)
+    {
+	if (!parseStep(command.get(i), steps))
+	{
+	    steps.clear();
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+const std::string& PipelineParser::getError() const
+{
+    return error;
+}
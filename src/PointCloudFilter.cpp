@@ -0,0 +1,206 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "headers/PointCloudFilter.h"
+
+// number of bits used for each coordinate of the voxel key
+#define VOXEL_KEY_BITS 21
+#define VOXEL_KEY_OFFSET (1 << (VOXEL_KEY_BITS - 1))
+#define VOXEL_KEY_MASK ((1 << VOXEL_KEY_BITS) - 1)
+
+PointCloudFilter::PointCloudFilter() : leaf_size(0.0),
+				       crop_mode(CropMode::None),
+				       crop_size(3, 0.0),
+				       crop_pose(4, 4),
+				       is_crop_pose_available(false)
+{
+    crop_pose.eye();
+}
+
+bool PointCloudFilter::setLeafSize(const double &size)
+{
+    if (size < 0)
+	return false;
+
+    leaf_size = size;
+
+    return true;
+}
+
+void PointCloudFilter::setCropMode(const CropMode &mode)
+{
+    crop_mode = mode;
+}
+
+bool PointCloudFilter::setCropBoxSize(const yarp::sig::Vector &size)
+{
+    if (size.size() != 3)
+	return false;
+
+    for (size_t i = 0; i < 3; i++)
+    {
+	if (size[i] <= 0)
+	    return false;
+    }
+
+    crop_size = size;
+
+    return true;
+}
+
+bool PointCloudFilter::setCropBoxPose(const yarp::sig::Matrix &pose)
+{
+    if (pose.rows() != 4 || pose.cols() != 4)
+	return false;
+
+    crop_pose = pose;
+    is_crop_pose_available = true;
+
+    return true;
+}
+
+bool PointCloudFilter::setCropBoxPose(yarp::dev::IFrameTransform *tf_client,
+				      const std::string &target,
+				      const std::string &source)
+{
+    if (tf_client == nullptr)
+	return false;
+
+    yarp::sig::Matrix pose;
+    if (!tf_client->getTransform(target, source, pose))
+	return false;
+
+    return setCropBoxPose(pose);
+}
+
+void PointCloudFilter::voxelize(SoAPointCloud &cloud) const
+{
+    if (leaf_size <= 0)
+	return;
+
+    std::size_t n = cloud.size();
+    if (n == 0)
+	return;
+
+    float *x = cloud.xData();
+    float *y = cloud.yData();
+    float *z = cloud.zData();
+
+    // evaluate the key of the voxel of each point
+    double inv_leaf = 1.0 / leaf_size;
+    std::vector<std::pair<uint64_t, uint32_t> > keys(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+	int64_t ix = static_cast<int64_t>(std::floor(x[i] * inv_leaf)) + VOXEL_KEY_OFFSET;
+	int64_t iy = static_cast<int64_t>(std::floor(y[i] * inv_leaf)) + VOXEL_KEY_OFFSET;
+	int64_t iz = static_cast<int64_t>(std::floor(z[i] * inv_leaf)) + VOXEL_KEY_OFFSET;
+
+	uint64_t key = (static_cast<uint64_t>(ix & VOXEL_KEY_MASK) << (2 * VOXEL_KEY_BITS)) |
+	               (static_cast<uint64_t>(iy & VOXEL_KEY_MASK) << VOXEL_KEY_BITS) |
+	               static_cast<uint64_t>(iz & VOXEL_KEY_MASK);
+
+	keys[i] = std::make_pair(key, static_cast<uint32_t>(i));
+    }
+
+    // points in the same voxel become contiguous
+    std::sort(keys.begin(), keys.end());
+
+    // replace the points of each voxel with their centroid
+    std::vector<float> out_x;
+    std::vector<float> out_y;
+    std::vector<float> out_z;
+    out_x.reserve(n);
+    out_y.reserve(n);
+    out_z.reserve(n);
+    std::size_t begin = 0;
+    while (begin < n)
+    {
+	std::size_t end = begin;
+	double sum[3] = {0.0, 0.0, 0.0};
+	while (end < n && keys[end].first == keys[begin].first)
+	{
+	    uint32_t index = keys[end].second;
+	    sum[0] += x[index];
+	    sum[1] += y[index];
+	    sum[2] += z[index];
+	    end++;
+	}
+
+	double count = end - begin;
+	out_x.push_back(sum[0] / count);
+	out_y.push_back(sum[1] / count);
+	out_z.push_back(sum[2] / count);
+
+	begin = end;
+    }
+
+    std::size_t n_voxels = out_x.size();
+    cloud.resize(n_voxels);
+    std::copy(out_x.begin(), out_x.end(), cloud.xData());
+    std::copy(out_y.begin(), out_y.end(), cloud.yData());
+    std::copy(out_z.begin(), out_z.end(), cloud.zData());
+}
+
+void PointCloudFilter::crop(SoAPointCloud &cloud) const
+{
+    if (crop_mode == CropMode::None || !is_crop_pose_available)
+	return;
+
+    float max[3];
+    float min[3];
+    for (int i = 0; i < 3; i++)
+    {
+	max[i] = crop_size[i] / 2.0;
+	min[i] = -max[i];
+    }
+
+    if (crop_mode == CropMode::AxisAligned)
+    {
+	// shift the box on the center
+	for (int i = 0; i < 3; i++)
+	{
+	    min[i] += crop_pose(i, 3);
+	    max[i] += crop_pose(i, 3);
+	}
+
+	cloud.crop(min, max);
+    }
+    else
+    {
+	// the points are tested in the frame of the box
+	// while their coordinates are left unchanged
+	float rot[9];
+	float pos[3];
+	for (int i = 0; i < 3; i++)
+	{
+	    for (int j = 0; j < 3; j++)
+		rot[i * 3 + j] = crop_pose(i, j);
+	    pos[i] = crop_pose(i, 3);
+	}
+
+	cloud.crop(rot, pos, min, max);
+    }
+}
+
+void PointCloudFilter::filter(SoAPointCloud &cloud) const
+{
+    // cropping is cheaper than decimation
+    // hence it is performed first
+    crop(cloud);
+    voxelize(cloud);
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Bottle.h>
+
+#include "headers/PointCloudFilterModule.h"
+
+bool PointCloudFilterModule::configure(yarp::os::ResourceFinder &rf)
+{
+    // get the namespace prepended to the names of all the ports
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+    // get the name of the ports
+    std::string port_in_name = prefix + rf.check("inputPort",
+						 yarp::os::Value("/point-cloud-filter/pc:i")).asString();
+    std::string port_out_name = prefix + rf.check("outputPort",
+						  yarp::os::Value("/point-cloud-filter/pc:o")).asString();
+
+    // get the name of the frames
+    estimate_frame = rf.check("estimateFrame",
+			      yarp::os::Value("/box_alt/estimate/frame")).asString();
+    root_frame = rf.check("rootFrame",
+			  yarp::os::Value("/iCub/frame")).asString();
+
+    // get the size of the voxels
+    double leaf_size = rf.check("leafSize", yarp::os::Value(0.01)).asDouble();
+    if (!filter.setLeafSize(leaf_size))
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: invalid parameter 'leafSize'";
+	return false;
+    }
+    yInfo() << "PointCloudFilterModule: leaf size is" << leaf_size;
+
+    // get the crop mode
+    std::string crop_mode = rf.check("cropMode", yarp::os::Value("oriented")).asString();
+    if (crop_mode == "none")
+	filter.setCropMode(CropMode::None);
+    else if (crop_mode == "aligned")
+	filter.setCropMode(CropMode::AxisAligned);
+    else if (crop_mode == "oriented")
+	filter.setCropMode(CropMode::Oriented);
+    else
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: parameter 'cropMode' should be one of"
+		 << "'none', 'aligned' or 'oriented'";
+	return false;
+    }
+    yInfo() << "PointCloudFilterModule: crop mode is" << crop_mode;
+
+    // get the size of the crop box
+    if (crop_mode != "none")
+    {
+	yarp::os::Bottle *size_bottle = rf.find("cropSize").asList();
+	if (size_bottle == nullptr || size_bottle->size() != 3)
+	{
+	    yError() << "PointCloudFilterModule::configure"
+		     << "Error: parameter 'cropSize' should be a list of three values";
+	    return false;
+	}
+
+	yarp::sig::Vector size(3);
+	for (size_t i = 0; i < 3; i++)
+	    size[i] = size_bottle->get(i).asDouble();
+	if (!filter.setCropBoxSize(size))
+	{
+	    yError() << "PointCloudFilterModule::configure"
+		     << "Error: invalid parameter 'cropSize'";
+	    return false;
+	}
+    }
+
+    // open ports
+    bool ok = port_in.open(port_in_name);
+    if (!ok)
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: unable to open the input port";
+	return false;
+    }
+
+    ok = port_out.open(port_out_name);
+    if (!ok)
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: unable to open the output port";
+	return false;
+    }
+
+    // prepare properties for the FrameTransformClient
+    yarp::os::Property propTfClient;
+    propTfClient.put("device", "transformClient");
+    propTfClient.put("local", prefix + "/point-cloud-filter/transformClient");
+    propTfClient.put("remote", prefix + "/transformServer");
+
+    // try to open the driver
+    ok = drv_transform_client.open(propTfClient);
+    if (!ok)
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: unable to open the FrameTransformClient driver.";
+	return false;
+    }
+
+    // try to retrieve the view
+    ok = drv_transform_client.view(tf_client);
+    if (!ok || tf_client == 0)
+    {
+	yError() << "PointCloudFilterModule::configure"
+		 << "Error: unable to retrieve the FrameTransformClient view.";
+	return false;
+    }
+
+    return true;
+}
+
+double PointCloudFilterModule::getPeriod()
+{
+    // the module is driven by the incoming point clouds
+    return 0.0;
+}
+
+bool PointCloudFilterModule::updateModule()
+{
+    // wait for a new point cloud
+    PointCloud *cloud_in = port_in.read(true);
+    if (cloud_in == YARP_NULLPTR)
+	return !isStopping();
+
+    // update the center of the crop box
+    // if the estimate is not available yet
+    // the last known pose is used
+    filter.setCropBoxPose(tf_client, estimate_frame, root_frame);
+
+    // filter the cloud
+    cloud.fromPointCloud(*cloud_in);
+    filter.filter(cloud);
+
+    // forward the filtered cloud
+    PointCloud &cloud_out = port_out.prepare();
+    cloud.toPointCloud(cloud_out);
+    port_out.write();
+
+    return true;
+}
+
+bool PointCloudFilterModule::interruptModule()
+{
+    port_in.interrupt();
+
+    return true;
+}
+
+bool PointCloudFilterModule::close()
+{
+    // close ports
+    port_in.close();
+    port_out.close();
+
+    // close drivers
+    drv_transform_client.close();
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "PointCloudFilterModule: cannot find YARP!";
+	return 1;
+    }
+
+    // instantiate the resource finder
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("point_cloud_filter_config.ini");
+    rf.configure(argc,argv);
+
+    // instantiate the module
+    PointCloudFilterModule filter_module;
+
+    // run the module
+    return filter_module.runModule(rf);
+}
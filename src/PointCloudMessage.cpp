@@ -0,0 +1,377 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+#include <yarp/os/ConnectionReader.h>
+#include <yarp/os/ConnectionWriter.h>
+
+#include "headers/PointCloudMessage.h"
+
+// number of items in the list
+// magic, version, n_points, stride, timestamp, frame_id and payload
+#define POINTCLOUD_MESSAGE_ITEMS 7
+
+PointCloudMessage::PointCloudMessage() : version(POINTCLOUD_MESSAGE_VERSION),
+					 n_points(0),
+					 stride(sizeof(PackedPoint)),
+					 timestamp(0.0) { }
+
+void PointCloudMessage::resize(const int &n, const bool &with_colors)
+{
+    n_points = n;
+    stride = with_colors ? sizeof(PackedRGBPoint) : sizeof(PackedPoint);
+    payload.resize(n_points * stride);
+}
+
+void PointCloudMessage::clear()
+{
+    resize(0, hasColors());
+}
+
+int PointCloudMessage::size() const
+{
+    return n_points;
+}
+
+int PointCloudMessage::getStride() const
+{
+    return stride;
+}
+
+bool PointCloudMessage::hasColors() const
+{
+    return stride == sizeof(PackedRGBPoint);
+}
+
+void PointCloudMessage::setTimestamp(const double &time)
+{
+    timestamp = time;
+}
+
+double PointCloudMessage::getTimestamp() const
+{
+    return timestamp;
+}
+
+void PointCloudMessage::setFrameId(const std::string &frame)
+{
+    frame_id = frame;
+}
+
+std::string PointCloudMessage::getFrameId() const
+{
+    return frame_id;
+}
+
+PackedPoint* PointCloudMessage::points()
+{
+    if (hasColors())
+	return nullptr;
+    return reinterpret_cast<PackedPoint*>(payload.data());
+}
+
+const PackedPoint* PointCloudMessage::points() const
+{
+    if (hasColors())
+	return nullptr;
+    return reinterpret_cast<const PackedPoint*>(payload.data());
+}
+
+PackedRGBPoint* PointCloudMessage::rgbPoints()
+{
+    if (!hasColors())
+	return nullptr;
+    return reinterpret_cast<PackedRGBPoint*>(payload.data());
+}
+
+const PackedRGBPoint* PointCloudMessage::rgbPoints() const
+{
+    if (!hasColors())
+	return nullptr;
+    return reinterpret_cast<const PackedRGBPoint*>(payload.data());
+}
+
+void PointCloudMessage::fromPointCloud(const PointCloud &cloud)
+{
+    resize(cloud.size(), false);
+
+    PackedPoint *dst = points();
+    for (int i = 0; i < n_points; i++)
+    {
+	dst[i].x = static_cast<float>(cloud[i].x);
+	dst[i].y = static_cast<float>(cloud[i].y);
+	dst[i].z = static_cast<float>(cloud[i].z);
+    }
+}
+
+void PointCloudMessage::fromPointCloud(const RGBPointCloud &cloud)
+{
+    resize(cloud.size(), true);
+
+    PackedRGBPoint *dst = rgbPoints();
+    for (int i = 0; i < n_points; i++)
+    {
+	dst[i].x = static_cast<float>(cloud[i].x);
+	dst[i].y = static_cast<float>(cloud[i].y);
+	dst[i].z = static_cast<float>(cloud[i].z);
+	dst[i].r = cloud[i].r;
+	dst[i].g = cloud[i].g;
+	dst[i].b = cloud[i].b;
+	dst[i].padding = 0;
+    }
+}
+
+void PointCloudMessage::fromPointCloud(const SoAPointCloud &cloud)
+{
+    resize(cloud.size(), false);
+
+    const float *x = cloud.xData();
+    const float *y = cloud.yData();
+    const float *z = cloud.zData();
+    PackedPoint *dst = points();
+    for (int i = 0; i < n_points; i++)
+    {
+	dst[i].x = x[i];
+	dst[i].y = y[i];
+	dst[i].z = z[i];
+    }
+}
+
+void PointCloudMessage::fromPointCloud(const SoARGBPointCloud &cloud)
+{
+    resize(cloud.size(), true);
+
+    const float *x = cloud.xData();
+    const float *y = cloud.yData();
+    const float *z = cloud.zData();
+    const unsigned char *r = cloud.rData();
+    const unsigned char *g = cloud.gData();
+    const unsigned char *b = cloud.bData();
+    PackedRGBPoint *dst = rgbPoints();
+    for (int i = 0; i < n_points; i++)
+    {
+	dst[i].x = x[i];
+	dst[i].y = y[i];
+	dst[i].z = z[i];
+	dst[i].r = r[i];
+	dst[i].g = g[i];
+	dst[i].b = b[i];
+	dst[i].padding = 0;
+    }
+}
+
+bool PointCloudMessage::toPointCloud(PointCloud &cloud) const
+{
+    cloud.resize(n_points);
+
+    for (int i = 0; i < n_points; i++)
+    {
+	// both layouts start with x, y and z
+	const PackedPoint &src = *reinterpret_cast<const PackedPoint*>(payload.data() + i * stride);
+	cloud[i].x = src.x;
+	cloud[i].y = src.y;
+	cloud[i].z = src.z;
+    }
+
+    return true;
+}
+
+bool PointCloudMessage::toPointCloud(RGBPointCloud &cloud) const
+{
+    const PackedRGBPoint *src = rgbPoints();
+    if (src == nullptr)
+	return false;
+
+    cloud.resize(n_points);
+    for (int i = 0; i < n_points; i++)
+    {
+	cloud[i].x = src[i].x;
+	cloud[i].y = src[i].y;
+	cloud[i].z = src[i].z;
+	cloud[i].r = src[i].r;
+	cloud[i].g = src[i].g;
+	cloud[i].b = src[i].b;
+    }
+
+    return true;
+}
+
+bool PointCloudMessage::toPointCloud(SoAPointCloud &cloud) const
+{
+    cloud.resize(n_points);
+
+    float *x = cloud.xData();
+    float *y = cloud.yData();
+    float *z = cloud.zData();
+    for (int i = 0; i < n_points; i++)
+    {
+	// both layouts start with x, y and z
+	const PackedPoint &src = *reinterpret_cast<const PackedPoint*>(payload.data() + i * stride);
+	x[i] = src.x;
+	y[i] = src.y;
+	z[i] = src.z;
+    }
+
+    return true;
+}
+
+bool PointCloudMessage::toPointCloud(SoARGBPointCloud &cloud) const
+{
+    const PackedRGBPoint *src = rgbPoints();
+    if (src == nullptr)
+	return false;
+
+    cloud.resize(n_points);
+
+    float *x = cloud.xData();
+    float *y = cloud.yData();
+    float *z = cloud.zData();
+    unsigned char *r = cloud.rData();
+    unsigned char *g = cloud.gData();
+    unsigned char *b = cloud.bData();
+    for (int i = 0; i < n_points; i++)
+    {
+	x[i] = src[i].x;
+	y[i] = src[i].y;
+	z[i] = src[i].z;
+	r[i] = src[i].r;
+	g[i] = src[i].g;
+	b[i] = src[i].b;
+    }
+
+    return true;
+}
+
+bool PointCloudMessage::read(yarp::os::ConnectionReader& connection)
+{
+    // messages sent in text mode, e.g. using 'yarp write',
+    // are converted to binary
+    connection.convertTextMode();
+
+    // list
+    if (connection.expectInt() != BOTTLE_TAG_LIST)
+	return false;
+    if (connection.expectInt() != POINTCLOUD_MESSAGE_ITEMS)
+	return false;
+
+    // magic
+    if (connection.expectInt() != BOTTLE_TAG_INT)
+	return false;
+    if (connection.expectInt() != POINTCLOUD_MESSAGE_MAGIC)
+	return false;
+
+    // version
+    if (connection.expectInt() != BOTTLE_TAG_INT)
+	return false;
+    int msg_version = connection.expectInt();
+    if (msg_version != POINTCLOUD_MESSAGE_VERSION)
+	return false;
+
+    // number of points
+    if (connection.expectInt() != BOTTLE_TAG_INT)
+	return false;
+    int msg_n_points = connection.expectInt();
+
+    // stride
+    if (connection.expectInt() != BOTTLE_TAG_INT)
+	return false;
+    int msg_stride = connection.expectInt();
+    if (msg_n_points < 0 || msg_n_points > POINTCLOUD_MESSAGE_MAX_POINTS ||
+	(msg_stride != static_cast<int>(sizeof(PackedPoint)) &&
+	 msg_stride != static_cast<int>(sizeof(PackedRGBPoint))))
+	return false;
+
+    // timestamp
+    if (connection.expectInt() != BOTTLE_TAG_DOUBLE)
+	return false;
+    double msg_timestamp = connection.expectDouble();
+
+    // frame id
+    // strings are sent with the trailing null character
+    if (connection.expectInt() != BOTTLE_TAG_STRING)
+	return false;
+    int frame_id_length = connection.expectInt();
+    if (frame_id_length < 1 || frame_id_length > POINTCLOUD_MESSAGE_MAX_FRAME_ID)
+	return false;
+    std::vector<char> frame_id_buffer(frame_id_length);
+    if (!connection.expectBlock(frame_id_buffer.data(), frame_id_length))
+	return false;
+
+    // payload
+    if (connection.expectInt() != BOTTLE_TAG_BLOB)
+	return false;
+    // the size is evaluated in std::size_t, the bound on the
+    // number of points and on the stride prevents overflows
+    int payload_length = connection.expectInt();
+    std::size_t expected_length = static_cast<std::size_t>(msg_n_points) * static_cast<std::size_t>(msg_stride);
+    if (payload_length < 0 || static_cast<std::size_t>(payload_length) != expected_length)
+	return false;
+
+    // the whole payload is read at once
+    std::vector<char, AlignedAllocator<char> > msg_payload(payload_length);
+    if (payload_length > 0 && !connection.expectBlock(msg_payload.data(), payload_length))
+	return false;
+    if (connection.isError())
+	return false;
+
+    // the message is stored only once it has been completely read
+    version = msg_version;
+    n_points = msg_n_points;
+    stride = msg_stride;
+    timestamp = msg_timestamp;
+    frame_id.assign(frame_id_buffer.data(), frame_id_length - 1);
+    payload.swap(msg_payload);
+
+    return true;
+}
+
+bool PointCloudMessage::write(yarp::os::ConnectionWriter& connection)
+{
+    // list
+    connection.appendInt(BOTTLE_TAG_LIST);
+    connection.appendInt(POINTCLOUD_MESSAGE_ITEMS);
+
+    // magic
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(POINTCLOUD_MESSAGE_MAGIC);
+
+    // version
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(version);
+
+    // number of points
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(n_points);
+
+    // stride
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(stride);
+
+    // timestamp
+    connection.appendInt(BOTTLE_TAG_DOUBLE);
+    connection.appendDouble(timestamp);
+
+    // frame id
+    connection.appendInt(BOTTLE_TAG_STRING);
+    connection.appendInt(frame_id.size() + 1);
+    connection.appendBlock(frame_id.c_str(), frame_id.size() + 1);
+
+    // payload
+    // the storage is owned by this message hence it can be
+    // appended without copies
+    connection.appendInt(BOTTLE_TAG_BLOB);
+    connection.appendInt(payload.size());
+    if (payload.size() > 0)
+	connection.appendExternalBlock(payload.data(), payload.size());
+
+    return !connection.isError();
+}
@@ -0,0 +1,592 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#include "headers/PointCloudSoA.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+static inline __m256 multiplyAdd(const __m256 &a, const __m256 &b, const __m256 &c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif
+
+SoAPointCloud::~SoAPointCloud()
+{ }
+
+std::size_t SoAPointCloud::size() const
+{
+    return x.size();
+}
+
+void SoAPointCloud::resize(const std::size_t &n)
+{
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+}
+
+void SoAPointCloud::reserve(const std::size_t &n)
+{
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+}
+
+void SoAPointCloud::clear()
+{
+    resize(0);
+}
+
+float* SoAPointCloud::xData()
+{
+    return x.data();
+}
+
+float* SoAPointCloud::yData()
+{
+    return y.data();
+}
+
+float* SoAPointCloud::zData()
+{
+    return z.data();
+}
+
+const float* SoAPointCloud::xData() const
+{
+    return x.data();
+}
+
+const float* SoAPointCloud::yData() const
+{
+    return y.data();
+}
+
+const float* SoAPointCloud::zData() const
+{
+    return z.data();
+}
+
+void SoAPointCloud::fromPointCloud(const PointCloud &cloud)
+{
+    std::size_t n = cloud.size();
+    resize(n);
+
+    const PointCloudItem *items = cloud.data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+	x[i] = static_cast<float>(items[i].x);
+	y[i] = static_cast<float>(items[i].y);
+	z[i] = static_cast<float>(items[i].z);
+    }
+}
+
+void SoAPointCloud::toPointCloud(PointCloud &cloud) const
+{
+    std::size_t n = size();
+    cloud.resize(n);
+
+    PointCloudItem *items = cloud.data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+	items[i].x = x[i];
+	items[i].y = y[i];
+	items[i].z = z[i];
+    }
+}
+
+bool SoAPointCloud::transform(const yarp::sig::Matrix &transform)
+{
+    if (transform.rows() != 4 || transform.cols() != 4)
+	return false;
+
+    float rot[9];
+    float pos[3];
+    for (int i = 0; i < 3; i++)
+    {
+	for (int j = 0; j < 3; j++)
+	    rot[i * 3 + j] = static_cast<float>(transform(i, j));
+	pos[i] = static_cast<float>(transform(i, 3));
+    }
+
+    this->transform(rot, pos);
+
+    return true;
+}
+
+void SoAPointCloud::transform(const float rot[9], const float pos[3])
+{
+    std::size_t n = size();
+    float *px = x.data();
+    float *py = y.data();
+    float *pz = z.data();
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256 r00 = _mm256_set1_ps(rot[0]);
+    __m256 r01 = _mm256_set1_ps(rot[1]);
+    __m256 r02 = _mm256_set1_ps(rot[2]);
+    __m256 r10 = _mm256_set1_ps(rot[3]);
+    __m256 r11 = _mm256_set1_ps(rot[4]);
+    __m256 r12 = _mm256_set1_ps(rot[5]);
+    __m256 r20 = _mm256_set1_ps(rot[6]);
+    __m256 r21 = _mm256_set1_ps(rot[7]);
+    __m256 r22 = _mm256_set1_ps(rot[8]);
+    __m256 t0 = _mm256_set1_ps(pos[0]);
+    __m256 t1 = _mm256_set1_ps(pos[1]);
+    __m256 t2 = _mm256_set1_ps(pos[2]);
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 vx = _mm256_load_ps(px + i);
+	__m256 vy = _mm256_load_ps(py + i);
+	__m256 vz = _mm256_load_ps(pz + i);
+
+	__m256 nx = multiplyAdd(r02, vz, multiplyAdd(r01, vy, multiplyAdd(r00, vx, t0)));
+	__m256 ny = multiplyAdd(r12, vz, multiplyAdd(r11, vy, multiplyAdd(r10, vx, t1)));
+	__m256 nz = multiplyAdd(r22, vz, multiplyAdd(r21, vy, multiplyAdd(r20, vx, t2)));
+
+	_mm256_store_ps(px + i, nx);
+	_mm256_store_ps(py + i, ny);
+	_mm256_store_ps(pz + i, nz);
+    }
+#elif defined(__SSE2__)
+    __m128 r00 = _mm_set1_ps(rot[0]);
+    __m128 r01 = _mm_set1_ps(rot[1]);
+    __m128 r02 = _mm_set1_ps(rot[2]);
+    __m128 r10 = _mm_set1_ps(rot[3]);
+    __m128 r11 = _mm_set1_ps(rot[4]);
+    __m128 r12 = _mm_set1_ps(rot[5]);
+    __m128 r20 = _mm_set1_ps(rot[6]);
+    __m128 r21 = _mm_set1_ps(rot[7]);
+    __m128 r22 = _mm_set1_ps(rot[8]);
+    __m128 t0 = _mm_set1_ps(pos[0]);
+    __m128 t1 = _mm_set1_ps(pos[1]);
+    __m128 t2 = _mm_set1_ps(pos[2]);
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 vx = _mm_load_ps(px + i);
+	__m128 vy = _mm_load_ps(py + i);
+	__m128 vz = _mm_load_ps(pz + i);
+
+	__m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, vx), _mm_mul_ps(r01, vy)),
+			       _mm_add_ps(_mm_mul_ps(r02, vz), t0));
+	__m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, vx), _mm_mul_ps(r11, vy)),
+			       _mm_add_ps(_mm_mul_ps(r12, vz), t1));
+	__m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, vx), _mm_mul_ps(r21, vy)),
+			       _mm_add_ps(_mm_mul_ps(r22, vz), t2));
+
+	_mm_store_ps(px + i, nx);
+	_mm_store_ps(py + i, ny);
+	_mm_store_ps(pz + i, nz);
+    }
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	float vx = px[i];
+	float vy = py[i];
+	float vz = pz[i];
+
+	px[i] = rot[0] * vx + rot[1] * vy + rot[2] * vz + pos[0];
+	py[i] = rot[3] * vx + rot[4] * vy + rot[5] * vz + pos[1];
+	pz[i] = rot[6] * vx + rot[7] * vy + rot[8] * vz + pos[2];
+    }
+}
+
+std::size_t SoAPointCloud::crop(const float min[3], const float max[3])
+{
+    std::size_t n = size();
+    const float *px = x.data();
+    const float *py = y.data();
+    const float *pz = z.data();
+    crop_mask.resize(n);
+    unsigned char *keep = crop_mask.data();
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256 min_x = _mm256_set1_ps(min[0]);
+    __m256 min_y = _mm256_set1_ps(min[1]);
+    __m256 min_z = _mm256_set1_ps(min[2]);
+    __m256 max_x = _mm256_set1_ps(max[0]);
+    __m256 max_y = _mm256_set1_ps(max[1]);
+    __m256 max_z = _mm256_set1_ps(max[2]);
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 vx = _mm256_load_ps(px + i);
+	__m256 vy = _mm256_load_ps(py + i);
+	__m256 vz = _mm256_load_ps(pz + i);
+
+	__m256 in = _mm256_and_ps(_mm256_cmp_ps(vx, min_x, _CMP_GE_OQ),
+				  _mm256_cmp_ps(vx, max_x, _CMP_LE_OQ));
+	in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(vy, min_y, _CMP_GE_OQ),
+					     _mm256_cmp_ps(vy, max_y, _CMP_LE_OQ)));
+	in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(vz, min_z, _CMP_GE_OQ),
+					     _mm256_cmp_ps(vz, max_z, _CMP_LE_OQ)));
+
+	int mask = _mm256_movemask_ps(in);
+	for (int k = 0; k < 8; k++)
+	    keep[i + k] = (mask >> k) & 1;
+    }
+#elif defined(__SSE2__)
+    __m128 min_x = _mm_set1_ps(min[0]);
+    __m128 min_y = _mm_set1_ps(min[1]);
+    __m128 min_z = _mm_set1_ps(min[2]);
+    __m128 max_x = _mm_set1_ps(max[0]);
+    __m128 max_y = _mm_set1_ps(max[1]);
+    __m128 max_z = _mm_set1_ps(max[2]);
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 vx = _mm_load_ps(px + i);
+	__m128 vy = _mm_load_ps(py + i);
+	__m128 vz = _mm_load_ps(pz + i);
+
+	__m128 in = _mm_and_ps(_mm_cmpge_ps(vx, min_x), _mm_cmple_ps(vx, max_x));
+	in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(vy, min_y), _mm_cmple_ps(vy, max_y)));
+	in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(vz, min_z), _mm_cmple_ps(vz, max_z)));
+
+	int mask = _mm_movemask_ps(in);
+	for (int k = 0; k < 4; k++)
+	    keep[i + k] = (mask >> k) & 1;
+    }
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	keep[i] = (px[i] >= min[0]) && (px[i] <= max[0]) &&
+	          (py[i] >= min[1]) && (py[i] <= max[1]) &&
+	          (pz[i] >= min[2]) && (pz[i] <= max[2]);
+    }
+
+    return compact(crop_mask);
+}
+
+std::size_t SoAPointCloud::crop(const float rot[9], const float pos[3],
+				const float min[3], const float max[3])
+{
+    std::size_t n = size();
+    const float *px = x.data();
+    const float *py = y.data();
+    const float *pz = z.data();
+    crop_mask.resize(n);
+    unsigned char *keep = crop_mask.data();
+    std::size_t i = 0;
+
+    // the columns of rot are the axes of the box
+#if defined(__AVX2__)
+    __m256 r00 = _mm256_set1_ps(rot[0]);
+    __m256 r01 = _mm256_set1_ps(rot[1]);
+    __m256 r02 = _mm256_set1_ps(rot[2]);
+    __m256 r10 = _mm256_set1_ps(rot[3]);
+    __m256 r11 = _mm256_set1_ps(rot[4]);
+    __m256 r12 = _mm256_set1_ps(rot[5]);
+    __m256 r20 = _mm256_set1_ps(rot[6]);
+    __m256 r21 = _mm256_set1_ps(rot[7]);
+    __m256 r22 = _mm256_set1_ps(rot[8]);
+    __m256 c0 = _mm256_set1_ps(pos[0]);
+    __m256 c1 = _mm256_set1_ps(pos[1]);
+    __m256 c2 = _mm256_set1_ps(pos[2]);
+    __m256 min_x = _mm256_set1_ps(min[0]);
+    __m256 min_y = _mm256_set1_ps(min[1]);
+    __m256 min_z = _mm256_set1_ps(min[2]);
+    __m256 max_x = _mm256_set1_ps(max[0]);
+    __m256 max_y = _mm256_set1_ps(max[1]);
+    __m256 max_z = _mm256_set1_ps(max[2]);
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 dx = _mm256_sub_ps(_mm256_load_ps(px + i), c0);
+	__m256 dy = _mm256_sub_ps(_mm256_load_ps(py + i), c1);
+	__m256 dz = _mm256_sub_ps(_mm256_load_ps(pz + i), c2);
+
+	__m256 qx = multiplyAdd(r20, dz, multiplyAdd(r10, dy, _mm256_mul_ps(r00, dx)));
+	__m256 qy = multiplyAdd(r21, dz, multiplyAdd(r11, dy, _mm256_mul_ps(r01, dx)));
+	__m256 qz = multiplyAdd(r22, dz, multiplyAdd(r12, dy, _mm256_mul_ps(r02, dx)));
+
+	__m256 in = _mm256_and_ps(_mm256_cmp_ps(qx, min_x, _CMP_GE_OQ),
+				  _mm256_cmp_ps(qx, max_x, _CMP_LE_OQ));
+	in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(qy, min_y, _CMP_GE_OQ),
+					     _mm256_cmp_ps(qy, max_y, _CMP_LE_OQ)));
+	in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(qz, min_z, _CMP_GE_OQ),
+					     _mm256_cmp_ps(qz, max_z, _CMP_LE_OQ)));
+
+	int mask = _mm256_movemask_ps(in);
+	for (int k = 0; k < 8; k++)
+	    keep[i + k] = (mask >> k) & 1;
+    }
+#elif defined(__SSE2__)
+    __m128 r00 = _mm_set1_ps(rot[0]);
+    __m128 r01 = _mm_set1_ps(rot[1]);
+    __m128 r02 = _mm_set1_ps(rot[2]);
+    __m128 r10 = _mm_set1_ps(rot[3]);
+    __m128 r11 = _mm_set1_ps(rot[4]);
+    __m128 r12 = _mm_set1_ps(rot[5]);
+    __m128 r20 = _mm_set1_ps(rot[6]);
+    __m128 r21 = _mm_set1_ps(rot[7]);
+    __m128 r22 = _mm_set1_ps(rot[8]);
+    __m128 c0 = _mm_set1_ps(pos[0]);
+    __m128 c1 = _mm_set1_ps(pos[1]);
+    __m128 c2 = _mm_set1_ps(pos[2]);
+    __m128 min_x = _mm_set1_ps(min[0]);
+    __m128 min_y = _mm_set1_ps(min[1]);
+    __m128 min_z = _mm_set1_ps(min[2]);
+    __m128 max_x = _mm_set1_ps(max[0]);
+    __m128 max_y = _mm_set1_ps(max[1]);
+    __m128 max_z = _mm_set1_ps(max[2]);
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 dx = _mm_sub_ps(_mm_load_ps(px + i), c0);
+	__m128 dy = _mm_sub_ps(_mm_load_ps(py + i), c1);
+	__m128 dz = _mm_sub_ps(_mm_load_ps(pz + i), c2);
+
+	__m128 qx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, dx), _mm_mul_ps(r10, dy)), _mm_mul_ps(r20, dz));
+	__m128 qy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r01, dx), _mm_mul_ps(r11, dy)), _mm_mul_ps(r21, dz));
+	__m128 qz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r02, dx), _mm_mul_ps(r12, dy)), _mm_mul_ps(r22, dz));
+
+	__m128 in = _mm_and_ps(_mm_cmpge_ps(qx, min_x), _mm_cmple_ps(qx, max_x));
+	in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(qy, min_y), _mm_cmple_ps(qy, max_y)));
+	in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(qz, min_z), _mm_cmple_ps(qz, max_z)));
+
+	int mask = _mm_movemask_ps(in);
+	for (int k = 0; k < 4; k++)
+	    keep[i + k] = (mask >> k) & 1;
+    }
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	float dx = px[i] - pos[0];
+	float dy = py[i] - pos[1];
+	float dz = pz[i] - pos[2];
+	float qx = rot[0] * dx + rot[3] * dy + rot[6] * dz;
+	float qy = rot[1] * dx + rot[4] * dy + rot[7] * dz;
+	float qz = rot[2] * dx + rot[5] * dy + rot[8] * dz;
+
+	keep[i] = (qx >= min[0]) && (qx <= max[0]) &&
+	          (qy >= min[1]) && (qy <= max[1]) &&
+	          (qz >= min[2]) && (qz <= max[2]);
+    }
+
+    return compact(crop_mask);
+}
+
+std::size_t SoAPointCloud::compact(const std::vector<unsigned char> &keep)
+{
+    std::size_t n = size();
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+	if (keep[i])
+	{
+	    x[j] = x[i];
+	    y[j] = y[i];
+	    z[j] = z[i];
+	    j++;
+	}
+    }
+
+    SoAPointCloud::resize(j);
+
+    return j;
+}
+
+bool SoAPointCloud::centroid(yarp::sig::Vector &centroid) const
+{
+    std::size_t n = size();
+    if (n == 0)
+	return false;
+
+    const float *px = x.data();
+    const float *py = y.data();
+    const float *pz = z.data();
+    double sum[3] = {0.0, 0.0, 0.0};
+    std::size_t i = 0;
+
+    // partial sums are accumulated in double precision
+    // to avoid loss of accuracy on large clouds
+#if defined(__AVX2__)
+    __m256d acc_x = _mm256_setzero_pd();
+    __m256d acc_y = _mm256_setzero_pd();
+    __m256d acc_z = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 vx = _mm256_load_ps(px + i);
+	__m256 vy = _mm256_load_ps(py + i);
+	__m256 vz = _mm256_load_ps(pz + i);
+
+	acc_x = _mm256_add_pd(acc_x, _mm256_cvtps_pd(_mm256_castps256_ps128(vx)));
+	acc_x = _mm256_add_pd(acc_x, _mm256_cvtps_pd(_mm256_extractf128_ps(vx, 1)));
+	acc_y = _mm256_add_pd(acc_y, _mm256_cvtps_pd(_mm256_castps256_ps128(vy)));
+	acc_y = _mm256_add_pd(acc_y, _mm256_cvtps_pd(_mm256_extractf128_ps(vy, 1)));
+	acc_z = _mm256_add_pd(acc_z, _mm256_cvtps_pd(_mm256_castps256_ps128(vz)));
+	acc_z = _mm256_add_pd(acc_z, _mm256_cvtps_pd(_mm256_extractf128_ps(vz, 1)));
+    }
+
+    alignas(32) double lanes[3][4];
+    _mm256_store_pd(lanes[0], acc_x);
+    _mm256_store_pd(lanes[1], acc_y);
+    _mm256_store_pd(lanes[2], acc_z);
+    for (int c = 0; c < 3; c++)
+	sum[c] = lanes[c][0] + lanes[c][1] + lanes[c][2] + lanes[c][3];
+#elif defined(__SSE2__)
+    __m128d acc_x = _mm_setzero_pd();
+    __m128d acc_y = _mm_setzero_pd();
+    __m128d acc_z = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 vx = _mm_load_ps(px + i);
+	__m128 vy = _mm_load_ps(py + i);
+	__m128 vz = _mm_load_ps(pz + i);
+
+	acc_x = _mm_add_pd(acc_x, _mm_cvtps_pd(vx));
+	acc_x = _mm_add_pd(acc_x, _mm_cvtps_pd(_mm_movehl_ps(vx, vx)));
+	acc_y = _mm_add_pd(acc_y, _mm_cvtps_pd(vy));
+	acc_y = _mm_add_pd(acc_y, _mm_cvtps_pd(_mm_movehl_ps(vy, vy)));
+	acc_z = _mm_add_pd(acc_z, _mm_cvtps_pd(vz));
+	acc_z = _mm_add_pd(acc_z, _mm_cvtps_pd(_mm_movehl_ps(vz, vz)));
+    }
+
+    alignas(16) double lanes[3][2];
+    _mm_store_pd(lanes[0], acc_x);
+    _mm_store_pd(lanes[1], acc_y);
+    _mm_store_pd(lanes[2], acc_z);
+    for (int c = 0; c < 3; c++)
+	sum[c] = lanes[c][0] + lanes[c][1];
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	sum[0] += px[i];
+	sum[1] += py[i];
+	sum[2] += pz[i];
+    }
+
+    centroid.resize(3);
+    for (int c = 0; c < 3; c++)
+	centroid[c] = sum[c] / n;
+
+    return true;
+}
+
+void SoARGBPointCloud::resize(const std::size_t &n)
+{
+    SoAPointCloud::resize(n);
+    r.resize(n);
+    g.resize(n);
+    b.resize(n);
+}
+
+void SoARGBPointCloud::reserve(const std::size_t &n)
+{
+    SoAPointCloud::reserve(n);
+    r.reserve(n);
+    g.reserve(n);
+    b.reserve(n);
+}
+
+unsigned char* SoARGBPointCloud::rData()
+{
+    return r.data();
+}
+
+unsigned char* SoARGBPointCloud::gData()
+{
+    return g.data();
+}
+
+unsigned char* SoARGBPointCloud::bData()
+{
+    return b.data();
+}
+
+const unsigned char* SoARGBPointCloud::rData() const
+{
+    return r.data();
+}
+
+const unsigned char* SoARGBPointCloud::gData() const
+{
+    return g.data();
+}
+
+const unsigned char* SoARGBPointCloud::bData() const
+{
+    return b.data();
+}
+
+void SoARGBPointCloud::fromRGBPointCloud(const RGBPointCloud &cloud)
+{
+    std::size_t n = cloud.size();
+    resize(n);
+
+    const RGBPointCloudItem *items = cloud.data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+	x[i] = static_cast<float>(items[i].x);
+	y[i] = static_cast<float>(items[i].y);
+	z[i] = static_cast<float>(items[i].z);
+	r[i] = items[i].r;
+	g[i] = items[i].g;
+	b[i] = items[i].b;
+    }
+}
+
+void SoARGBPointCloud::toRGBPointCloud(RGBPointCloud &cloud) const
+{
+    std::size_t n = size();
+    cloud.resize(n);
+
+    RGBPointCloudItem *items = cloud.data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+	items[i].x = x[i];
+	items[i].y = y[i];
+	items[i].z = z[i];
+	items[i].r = r[i];
+	items[i].g = g[i];
+	items[i].b = b[i];
+    }
+}
+
+std::size_t SoARGBPointCloud::compact(const std::vector<unsigned char> &keep)
+{
+    // compact colors first since the base class
+    // shrinks the coordinates columns
+    std::size_t n = size();
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+	if (keep[i])
+	{
+	    r[j] = r[i];
+	    g[j] = g[i];
+	    b[j] = b[i];
+	    j++;
+	}
+    }
+    r.resize(j);
+    g.resize(j);
+    b.resize(j);
+
+    return SoAPointCloud::compact(keep);
+}
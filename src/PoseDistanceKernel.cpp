@@ -0,0 +1,372 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// std
+#include <algorithm>
+#include <functional>
+
+#include "headers/PoseDistanceKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// number of measurements processed at once
+// so that the transformed block stays in cache
+#define POSE_DISTANCE_BLOCK_SIZE 1024
+
+// minimum number of distances, i.e. hypotheses times measurements,
+// evaluated using the workers, smaller batches do not pay the synchronization
+#define POSE_DISTANCE_PARALLEL_MIN_SIZE 32768
+
+#if defined(__AVX2__)
+static inline __m256 multiplyAdd(const __m256 &a, const __m256 &b, const __m256 &c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif
+
+/*
+ * Transform n points from the source columns to the destination columns.
+ */
+static void transformColumns(const float rot[9], const float pos[3],
+			     const float *sx, const float *sy, const float *sz,
+			     float *dx, float *dy, float *dz,
+			     const std::size_t &n)
+{
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256 r00 = _mm256_set1_ps(rot[0]);
+    __m256 r01 = _mm256_set1_ps(rot[1]);
+    __m256 r02 = _mm256_set1_ps(rot[2]);
+    __m256 r10 = _mm256_set1_ps(rot[3]);
+    __m256 r11 = _mm256_set1_ps(rot[4]);
+    __m256 r12 = _mm256_set1_ps(rot[5]);
+    __m256 r20 = _mm256_set1_ps(rot[6]);
+    __m256 r21 = _mm256_set1_ps(rot[7]);
+    __m256 r22 = _mm256_set1_ps(rot[8]);
+    __m256 t0 = _mm256_set1_ps(pos[0]);
+    __m256 t1 = _mm256_set1_ps(pos[1]);
+    __m256 t2 = _mm256_set1_ps(pos[2]);
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 vx = _mm256_load_ps(sx + i);
+	__m256 vy = _mm256_load_ps(sy + i);
+	__m256 vz = _mm256_load_ps(sz + i);
+
+	_mm256_store_ps(dx + i, multiplyAdd(r02, vz, multiplyAdd(r01, vy, multiplyAdd(r00, vx, t0))));
+	_mm256_store_ps(dy + i, multiplyAdd(r12, vz, multiplyAdd(r11, vy, multiplyAdd(r10, vx, t1))));
+	_mm256_store_ps(dz + i, multiplyAdd(r22, vz, multiplyAdd(r21, vy, multiplyAdd(r20, vx, t2))));
+    }
+#elif defined(__SSE2__)
+    __m128 r00 = _mm_set1_ps(rot[0]);
+    __m128 r01 = _mm_set1_ps(rot[1]);
+    __m128 r02 = _mm_set1_ps(rot[2]);
+    __m128 r10 = _mm_set1_ps(rot[3]);
+    __m128 r11 = _mm_set1_ps(rot[4]);
+    __m128 r12 = _mm_set1_ps(rot[5]);
+    __m128 r20 = _mm_set1_ps(rot[6]);
+    __m128 r21 = _mm_set1_ps(rot[7]);
+    __m128 r22 = _mm_set1_ps(rot[8]);
+    __m128 t0 = _mm_set1_ps(pos[0]);
+    __m128 t1 = _mm_set1_ps(pos[1]);
+    __m128 t2 = _mm_set1_ps(pos[2]);
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 vx = _mm_load_ps(sx + i);
+	__m128 vy = _mm_load_ps(sy + i);
+	__m128 vz = _mm_load_ps(sz + i);
+
+	_mm_store_ps(dx + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, vx), _mm_mul_ps(r01, vy)),
+					_mm_add_ps(_mm_mul_ps(r02, vz), t0)));
+	_mm_store_ps(dy + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, vx), _mm_mul_ps(r11, vy)),
+					_mm_add_ps(_mm_mul_ps(r12, vz), t1)));
+	_mm_store_ps(dz + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, vx), _mm_mul_ps(r21, vy)),
+					_mm_add_ps(_mm_mul_ps(r22, vz), t2)));
+    }
+#endif
+
+    // remaining points
+    for (; i < n; i++)
+    {
+	dx[i] = rot[0] * sx[i] + rot[1] * sy[i] + rot[2] * sz[i] + pos[0];
+	dy[i] = rot[3] * sx[i] + rot[4] * sy[i] + rot[5] * sz[i] + pos[1];
+	dz[i] = rot[6] * sx[i] + rot[7] * sy[i] + rot[8] * sz[i] + pos[2];
+    }
+}
+
+/*
+ * Return the sum of the squares of n values.
+ */
+static float sumSquares(const float *d, const std::size_t &n)
+{
+    std::size_t i = 0;
+    float sum = 0;
+
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+	__m256 v = _mm256_loadu_ps(d + i);
+	acc = multiplyAdd(v, v, acc);
+    }
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, acc);
+    for (std::size_t k = 0; k < 8; k++)
+	sum += lanes[k];
+#elif defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 v = _mm_loadu_ps(d + i);
+	acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    for (std::size_t k = 0; k < 4; k++)
+	sum += lanes[k];
+#endif
+
+    // remaining values
+    for (; i < n; i++)
+	sum += d[i] * d[i];
+
+    return sum;
+}
+
+bool PoseHypothesis::fromMatrix(const yarp::sig::Matrix &pose)
+{
+    if (pose.rows() != 4 || pose.cols() != 4)
+	return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+	for (int j = 0; j < 3; j++)
+	    rot[i * 3 + j] = static_cast<float>(pose(i, j));
+	pos[i] = static_cast<float>(pose(i, 3));
+    }
+
+    return true;
+}
+
+PoseDistanceKernel::PoseDistanceKernel(const DistanceField &field,
+				       const std::size_t &n_threads) :
+    field(field),
+    n_threads(1),
+    generation(0),
+    pending(0),
+    is_stopping(false)
+{
+    setNumberThreads(n_threads);
+}
+
+PoseDistanceKernel::~PoseDistanceKernel()
+{
+    stopWorkers();
+}
+
+void PoseDistanceKernel::setNumberThreads(const std::size_t &n_threads)
+{
+    stopWorkers();
+
+    this->n_threads = n_threads;
+    if (this->n_threads == 0)
+	this->n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    startWorkers();
+}
+
+void PoseDistanceKernel::startWorkers()
+{
+    // no workers are running, new workers wait for the next job
+    is_stopping = false;
+    generation = 0;
+    for (std::size_t i = 0; i + 1 < n_threads; i++)
+	workers.push_back(std::thread(&PoseDistanceKernel::workerLoop, this, i));
+}
+
+void PoseDistanceKernel::stopWorkers()
+{
+    {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	is_stopping = true;
+    }
+    start_condition.notify_all();
+
+    for (std::thread &worker : workers)
+	worker.join();
+    workers.clear();
+}
+
+void PoseDistanceKernel::getRange(const std::size_t &i, const std::size_t &n_poses, const std::size_t &n_ranges,
+				  std::size_t &begin, std::size_t &end)
+{
+    std::size_t chunk = n_poses / n_ranges;
+    std::size_t remainder = n_poses % n_ranges;
+    begin = i * chunk + std::min(i, remainder);
+    end = begin + chunk + (i < remainder ? 1 : 0);
+}
+
+void PoseDistanceKernel::workerLoop(const std::size_t index)
+{
+    std::size_t last_generation = 0;
+    while (true)
+    {
+	Job current;
+	{
+	    std::unique_lock<std::mutex> lock(pool_mutex);
+	    start_condition.wait(lock, [&]() { return is_stopping || generation != last_generation; });
+	    if (is_stopping)
+		return;
+	    last_generation = generation;
+	    current = job;
+	}
+
+	// the last range is evaluated by the calling thread
+	if (index + 1 < current.n_ranges)
+	{
+	    std::size_t begin;
+	    std::size_t end;
+	    getRange(index, current.n_poses, current.n_ranges, begin, end);
+	    evaluateRange(current.poses, begin, end, *current.points,
+			  current.distances, current.sums);
+	}
+
+	{
+	    std::lock_guard<std::mutex> lock(pool_mutex);
+	    pending--;
+	    if (pending == 0)
+		done_condition.notify_one();
+	}
+    }
+}
+
+std::size_t PoseDistanceKernel::getNumberThreads() const
+{
+    return n_threads;
+}
+
+void PoseDistanceKernel::evaluateRange(const PoseHypothesis *poses,
+				       const std::size_t &begin,
+				       const std::size_t &end,
+				       const SoAPointCloud &points,
+				       float *distances,
+				       float *sums) const
+{
+    std::size_t m = points.size();
+
+    // aligned scratch columns
+    std::vector<float, AlignedAllocator<float> > x(POSE_DISTANCE_BLOCK_SIZE);
+    std::vector<float, AlignedAllocator<float> > y(POSE_DISTANCE_BLOCK_SIZE);
+    std::vector<float, AlignedAllocator<float> > z(POSE_DISTANCE_BLOCK_SIZE);
+    std::vector<float, AlignedAllocator<float> > d(POSE_DISTANCE_BLOCK_SIZE);
+
+    for (std::size_t h = begin; h < end; h++)
+    {
+	// the inverse of the pose moves
+	// the measurements in the object frame
+	const PoseHypothesis &pose = poses[h];
+	float rot[9];
+	float pos[3];
+	for (std::size_t i = 0; i < 3; i++)
+	{
+	    for (std::size_t j = 0; j < 3; j++)
+		rot[i * 3 + j] = pose.rot[j * 3 + i];
+	}
+	for (std::size_t i = 0; i < 3; i++)
+	    pos[i] = -(rot[i * 3] * pose.pos[0] + rot[i * 3 + 1] * pose.pos[1] + rot[i * 3 + 2] * pose.pos[2]);
+
+	float sum = 0;
+	for (std::size_t offset = 0; offset < m; offset += POSE_DISTANCE_BLOCK_SIZE)
+	{
+	    std::size_t n = std::min(m - offset, static_cast<std::size_t>(POSE_DISTANCE_BLOCK_SIZE));
+
+	    // offset is a multiple of the block size
+	    // hence the source columns are still aligned
+	    transformColumns(rot, pos,
+			     points.xData() + offset, points.yData() + offset, points.zData() + offset,
+			     x.data(), y.data(), z.data(),
+			     n);
+
+	    float *block = distances != nullptr ? distances + h * m + offset : d.data();
+	    field.distance(x.data(), y.data(), z.data(), n, block);
+
+	    if (sums != nullptr)
+		sum += sumSquares(block, n);
+	}
+
+	if (sums != nullptr)
+	    sums[h] = sum;
+    }
+}
+
+void PoseDistanceKernel::evaluate(const std::vector<PoseHypothesis> &poses,
+				  const SoAPointCloud &points,
+				  float *distances,
+				  float *sums) const
+{
+    std::size_t n = poses.size();
+    std::size_t n_ranges = std::min(n_threads, n);
+    if (n_ranges <= 1 || workers.empty() ||
+	n * points.size() < POSE_DISTANCE_PARALLEL_MIN_SIZE)
+    {
+	evaluateRange(poses.data(), 0, n, points, distances, sums);
+	return;
+    }
+
+    std::lock_guard<std::mutex> evaluate_lock(evaluate_mutex);
+
+    // wake up the workers
+    {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	job.poses = poses.data();
+	job.n_poses = n;
+	job.n_ranges = n_ranges;
+	job.points = &points;
+	job.distances = distances;
+	job.sums = sums;
+	pending = workers.size();
+	generation++;
+    }
+    start_condition.notify_all();
+
+    // the calling thread evaluates the last range
+    std::size_t begin;
+    std::size_t end;
+    getRange(n_ranges - 1, n, n_ranges, begin, end);
+    evaluateRange(poses.data(), begin, end, points, distances, sums);
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    done_condition.wait(lock, [&]() { return pending == 0; });
+}
+
+void PoseDistanceKernel::distances(const std::vector<PoseHypothesis> &poses,
+				   const SoAPointCloud &points,
+				   std::vector<float> &distances) const
+{
+    distances.resize(poses.size() * points.size());
+    evaluate(poses, points, distances.data(), nullptr);
+}
+
+void PoseDistanceKernel::sumOfSquares(const std::vector<PoseHypothesis> &poses,
+				      const SoAPointCloud &points,
+				      std::vector<float> &sums) const
+{
+    sums.resize(poses.size());
+    evaluate(poses, points, nullptr, sums.data());
+}
@@ -9,30 +9,64 @@
  * @author: Nicola Piga <nicolapiga@gmail.com>
  */
 
-#include <yarp/math/Math.h>
+// std
+#include <cmath>
 
 #include "headers/RotationTrajectoryGenerator.h"
 
-using namespace yarp::math;
-
 RotationTrajectoryGenerator::RotationTrajectoryGenerator()
 {
-    // clear vectors
-    object_center.resize(3, 0.0);
-    push_point.resize(3, 0.0);
+    // clear points
+    for (size_t i = 0; i < 3; i++)
+    {
+	object_center[i] = 0.0;
+	push_point[i] = 0.0;
+    }
+    push_offset[0] = 0.0;
+    push_offset[1] = 0.0;
+
+    // clear yaw
+    object_yaw = 0.0;
+    estimate_time = 0.0;
 
     // clear angular rate
     yaw_rate = 0;
+
+    // no correction
+    position_gain = 0.0;
+}
+
+double RotationTrajectoryGenerator::yawOf(const yarp::sig::Matrix &pose)
+{
+    return std::atan2(pose(1, 0), pose(0, 0));
+}
+
+double RotationTrajectoryGenerator::extrapolateYaw(const double &time) const
+{
+    if (time <= estimate_time)
+	return object_yaw;
+
+    return object_yaw + yaw_rate * (time - estimate_time);
 }
 
 void RotationTrajectoryGenerator::setObjectCenter(const yarp::sig::Vector &point)
 {
-    object_center = point;
+    for (size_t i = 0; i < 3; i++)
+	object_center[i] = point[i];
+    object_yaw = 0.0;
+}
+
+void RotationTrajectoryGenerator::setObjectPose(const yarp::sig::Matrix &pose)
+{
+    for (size_t i = 0; i < 3; i++)
+	object_center[i] = pose(i, 3);
+    object_yaw = yawOf(pose);
 }
 
 void RotationTrajectoryGenerator::setPushingPoint(const yarp::sig::Vector &point)
 {
-    push_point = point;
+    for (size_t i = 0; i < 3; i++)
+	push_point[i] = point[i];
 }
 
 void RotationTrajectoryGenerator::setYawRate(const double &rate)
@@ -40,36 +74,128 @@ void RotationTrajectoryGenerator::setYawRate(const double &rate)
     yaw_rate = rate;
 }
 
+void RotationTrajectoryGenerator::setPositionGain(const double &gain)
+{
+    position_gain = gain < 0 ? 0.0 : gain;
+}
+
+void RotationTrajectoryGenerator::init()
+{
+    // the estimate used at initialization
+    // corresponds to the beginning of the rotation
+    estimate_time = 0.0;
+
+    // displacement from the center to the pushing point
+    // expressed in the horizontal plane of the object
+    double dx = push_point[0] - object_center[0];
+    double dy = push_point[1] - object_center[1];
+    double c = std::cos(object_yaw);
+    double s = std::sin(object_yaw);
+    push_offset[0] = c * dx + s * dy;
+    push_offset[1] = -s * dx + c * dy;
+}
+
+bool RotationTrajectoryGenerator::updateEstimate(const yarp::sig::Matrix &pose,
+						 const double &time)
+{
+    // estimates taken before the beginning of the rotation
+    // do not carry new information
+    if (time <= estimate_time)
+	return false;
+
+    setObjectPose(pose);
+    estimate_time = time;
+
+    return true;
+}
+
 bool RotationTrajectoryGenerator::getVelocity(const double &time,
-					      yarp::sig::Vector &velocity)
+					      yarp::sig::Vector &velocity) const
 {
     if (time < 0)
 	return false;
-    
-    // evaluate displacement
-    // from object center to pushing point
-    yarp::sig::Vector diff = push_point - object_center;
-
-    // evaluate yaw
-    double yaw = yaw_rate * time;
 
-    // evaluate rotation matrix
-    yarp::sig::Vector axis_angle(4, 0.0);
-    yarp::sig::Matrix rot(3, 3);
-    axis_angle[2] = 1.0;
-    axis_angle[3] = yaw;
-    rot = yarp::math::axis2dcm(axis_angle).submatrix(0, 2, 0, 2);
+    if (velocity.size() != 3)
+	velocity.resize(3);
 
-    // rotate displacement vector
-    yarp::sig::Vector diff_rotated = rot * diff;
+    // extrapolate the yaw of the object
+    // from the latest estimate
+    double yaw = extrapolateYaw(time);
 
-    // eval angular velocity
-    yarp::sig::Vector angular_velocity(3, 0.0);
-    angular_velocity[2] = yaw_rate;
+    // displacement from the center to the pushing point
+    // rotated with the object
+    double c = std::cos(yaw);
+    double s = std::sin(yaw);
+    double rx = c * push_offset[0] - s * push_offset[1];
+    double ry = s * push_offset[0] + c * push_offset[1];
 
     // evaluate linear velocity of pushing point
     // assuming zero velocity of the center of the object
-    velocity = yarp::math::cross(angular_velocity, diff_rotated);
+    // i.e. yaw_rate * z x r
+    velocity[0] = -yaw_rate * ry;
+    velocity[1] = yaw_rate * rx;
+    velocity[2] = 0.0;
+
+    return true;
+}
+
+bool RotationTrajectoryGenerator::getVelocity(const double &time,
+					      const yarp::sig::Vector &actual_point,
+					      yarp::sig::Vector &velocity) const
+{
+    if (!getVelocity(time, velocity))
+	return false;
+
+    if (position_gain == 0.0)
+	return true;
+
+    // point tracked on the object
+    double yaw = extrapolateYaw(time);
+    double c = std::cos(yaw);
+    double s = std::sin(yaw);
+    double x = object_center[0] + c * push_offset[0] - s * push_offset[1];
+    double y = object_center[1] + s * push_offset[0] + c * push_offset[1];
+
+    // correct the error in the horizontal plane
+    velocity[0] += position_gain * (x - actual_point[0]);
+    velocity[1] += position_gain * (y - actual_point[1]);
+
+    return true;
+}
+
+bool RotationTrajectoryGenerator::getTrajectory(const double *times, const std::size_t &count,
+						double *positions, double *velocities) const
+{
+    for (std::size_t k = 0; k < count; k++)
+    {
+	if (times[k] < 0)
+	    return false;
+    }
+
+    double *x = positions;
+    double *y = positions + count;
+    double *z = positions + 2 * count;
+    double *vx = velocities;
+    double *vy = velocities + count;
+    double *vz = velocities + 2 * count;
+
+    for (std::size_t k = 0; k < count; k++)
+    {
+	// see extrapolateYaw()
+	double elapsed = times[k] - estimate_time;
+	double yaw = object_yaw + yaw_rate * (elapsed > 0.0 ? elapsed : 0.0);
+	double c = std::cos(yaw);
+	double s = std::sin(yaw);
+	double rx = c * push_offset[0] - s * push_offset[1];
+	double ry = s * push_offset[0] + c * push_offset[1];
+
+	x[k] = object_center[0] + rx;
+	y[k] = object_center[1] + ry;
+	z[k] = push_point[2];
+	vx[k] = -yaw_rate * ry;
+	vy[k] = yaw_rate * rx;
+	vz[k] = 0.0;
+    }
 
     return true;
 }
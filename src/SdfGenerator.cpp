@@ -0,0 +1,71 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Generate the signed distance field of an OFF mesh.
+ *
+ * Usage:
+ * sdf_generator --mesh <file.off> [--spacing <m>] [--padding <m>] [--output <file.sdfgrid>]
+ *
+ * By default the grid is saved next to the mesh replacing
+ * the extension .off with .sdfgrid.
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+
+// std
+#include <string>
+
+#include "headers/MeshModel.h"
+#include "headers/DistanceField.h"
+
+int main(int argc, char **argv)
+{
+    yarp::os::ResourceFinder rf;
+    rf.configure(argc, argv);
+
+    if (!rf.check("mesh"))
+    {
+	yError() << "SdfGenerator: usage"
+		 << "sdf_generator --mesh <file.off> [--spacing <m>] [--padding <m>] [--output <file.sdfgrid>]";
+	return 1;
+    }
+    std::string mesh_name = rf.find("mesh").asString();
+    double spacing = rf.check("spacing", yarp::os::Value(0.002)).asDouble();
+    double padding = rf.check("padding", yarp::os::Value(0.02)).asDouble();
+
+    std::string output_name = mesh_name;
+    std::size_t extension = output_name.rfind(".off");
+    if (extension != std::string::npos && extension == output_name.size() - 4)
+	output_name.erase(extension);
+    output_name += ".sdfgrid";
+    output_name = rf.check("output", yarp::os::Value(output_name)).asString();
+
+    MeshModel mesh;
+    if (!mesh.load(mesh_name))
+	return 1;
+
+    GridDistanceField field;
+    if (!field.generate(mesh, spacing, padding))
+    {
+	yError() << "SdfGenerator: invalid spacing or padding";
+	return 1;
+    }
+
+    if (!field.save(output_name))
+	return 1;
+
+    yInfo() << "SdfGenerator: saved" << output_name;
+
+    return 0;
+}
@@ -0,0 +1,464 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "headers/SessionLog.h"
+
+// records are aligned to 8 bytes
+static std::size_t paddedSize(const std::size_t &size)
+{
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+SessionLogWriter::SessionLogWriter() : file(nullptr),
+				       time_begin(0.0),
+				       time_end(0.0),
+				       max_chunk_size(0),
+				       next_stream(SESSION_LOG_META_STREAM + 1) { }
+
+SessionLogWriter::~SessionLogWriter()
+{
+    close();
+}
+
+bool SessionLogWriter::open(const std::string &file_name,
+			    const std::size_t &chunk_size)
+{
+    close();
+
+    file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr)
+    {
+	yError() << "SessionLogWriter::open"
+		 << "Error: unable to create the file"
+		 << file_name;
+	return false;
+    }
+
+    SessionLogFileHeader header;
+    header.magic = SESSION_LOG_FILE_MAGIC;
+    header.version = SESSION_LOG_VERSION;
+    header.reserved = 0;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+	yError() << "SessionLogWriter::open"
+		 << "Error: unable to write the header of the file"
+		 << file_name;
+	close();
+	return false;
+    }
+
+    max_chunk_size = chunk_size;
+    next_stream = SESSION_LOG_META_STREAM + 1;
+    chunk.clear();
+    index.clear();
+    chunk.reserve(max_chunk_size + sizeof(SessionLogChunkHeader));
+
+    return true;
+}
+
+uint32_t SessionLogWriter::addStream(const StreamKind &kind, const std::string &name)
+{
+    uint32_t stream = next_stream++;
+
+    // declaration record
+    // stream id, kind and name
+    std::vector<char> data(2 * sizeof(uint32_t) + name.size());
+    uint32_t kind_value = static_cast<uint32_t>(kind);
+    std::memcpy(data.data(), &stream, sizeof(uint32_t));
+    std::memcpy(data.data() + sizeof(uint32_t), &kind_value, sizeof(uint32_t));
+    std::memcpy(data.data() + 2 * sizeof(uint32_t), name.data(), name.size());
+
+    appendRecord(SESSION_LOG_META_STREAM, 0.0, data.data(), data.size());
+
+    return stream;
+}
+
+void SessionLogWriter::appendRecord(const uint32_t &stream,
+				    const double &timestamp,
+				    const char *data,
+				    const std::size_t &size)
+{
+    // the chunk header is written at the beginning
+    // of the chunk when the chunk is flushed
+    if (chunk.empty())
+    {
+	chunk.resize(sizeof(SessionLogChunkHeader));
+	time_begin = std::numeric_limits<double>::max();
+	time_end = std::numeric_limits<double>::lowest();
+    }
+
+    // update the time span with data records only
+    if (stream != SESSION_LOG_META_STREAM)
+    {
+	time_begin = std::min(time_begin, timestamp);
+	time_end = std::max(time_end, timestamp);
+    }
+
+    SessionLogRecordHeader header;
+    header.stream = stream;
+    header.size = size;
+    header.timestamp = timestamp;
+
+    std::size_t offset = chunk.size();
+    index.push_back(offset);
+
+    chunk.resize(offset + sizeof(header) + paddedSize(size), 0);
+    std::memcpy(chunk.data() + offset, &header, sizeof(header));
+    if (size > 0)
+	std::memcpy(chunk.data() + offset + sizeof(header), data, size);
+}
+
+bool SessionLogWriter::write(const uint32_t &stream,
+			     const double &timestamp,
+			     const void *data,
+			     const std::size_t &size)
+{
+    if (file == nullptr)
+	return false;
+
+    if (stream == SESSION_LOG_META_STREAM || stream >= next_stream)
+	return false;
+
+    // the size of a record is stored in 32 bits
+    if (size > std::numeric_limits<uint32_t>::max())
+    {
+	yError() << "SessionLogWriter::write"
+		 << "Error: the record of size"
+		 << size
+		 << "is too large";
+	return false;
+    }
+
+    appendRecord(stream, timestamp, static_cast<const char*>(data), size);
+
+    // write the chunk when full
+    if (chunk.size() >= max_chunk_size)
+	return flush();
+
+    return true;
+}
+
+bool SessionLogWriter::flush()
+{
+    if (file == nullptr)
+	return false;
+
+    if (chunk.empty())
+	return true;
+
+    // fill in the header
+    SessionLogChunkHeader header;
+    header.magic = SESSION_LOG_CHUNK_MAGIC;
+    header.n_records = index.size();
+    header.index_offset = chunk.size();
+    header.size = chunk.size() + index.size() * sizeof(uint64_t);
+    header.time_begin = time_begin;
+    header.time_end = time_end;
+    std::memcpy(chunk.data(), &header, sizeof(header));
+
+    // write chunk and index
+    bool ok = std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+    ok &= std::fwrite(index.data(), sizeof(uint64_t), index.size(), file) == index.size();
+    ok &= std::fflush(file) == 0;
+
+    chunk.clear();
+    index.clear();
+
+    if (!ok)
+    {
+	yError() << "SessionLogWriter::flush"
+		 << "Error: unable to write the chunk";
+	return false;
+    }
+
+    return true;
+}
+
+void SessionLogWriter::close()
+{
+    if (file == nullptr)
+	return;
+
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
+
+SessionLogReader::SessionLogReader() : fd(-1),
+				       mapped(nullptr),
+				       mapped_size(0),
+				       current_chunk(0),
+				       current_record(0) { }
+
+SessionLogReader::~SessionLogReader()
+{
+    close();
+}
+
+bool SessionLogReader::open(const std::string &file_name)
+{
+    close();
+
+    fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+	yError() << "SessionLogReader::open"
+		 << "Error: unable to open the file"
+		 << file_name;
+	return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SessionLogFileHeader)))
+    {
+	yError() << "SessionLogReader::open"
+		 << "Error: the file"
+		 << file_name
+		 << "is not a session log";
+	close();
+	return false;
+    }
+
+    mapped_size = info.st_size;
+    void *ptr = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED)
+    {
+	yError() << "SessionLogReader::open"
+		 << "Error: unable to map the file"
+		 << file_name;
+	mapped = nullptr;
+	close();
+	return false;
+    }
+    mapped = static_cast<const char*>(ptr);
+
+    // the file is mostly read sequentially
+    madvise(ptr, mapped_size, MADV_SEQUENTIAL);
+
+    const SessionLogFileHeader *header = reinterpret_cast<const SessionLogFileHeader*>(mapped);
+    if (header->magic != SESSION_LOG_FILE_MAGIC || header->version != SESSION_LOG_VERSION)
+    {
+	yError() << "SessionLogReader::open"
+		 << "Error: the file"
+		 << file_name
+		 << "is not a session log or has an unsupported version";
+	close();
+	return false;
+    }
+
+    // find the chunks
+    // a truncated chunk at the end of the file is ignored
+    std::size_t offset = sizeof(SessionLogFileHeader);
+    while (offset + sizeof(SessionLogChunkHeader) <= mapped_size)
+    {
+	const SessionLogChunkHeader *chunk = reinterpret_cast<const SessionLogChunkHeader*>(mapped + offset);
+	if (chunk->magic != SESSION_LOG_CHUNK_MAGIC ||
+	    chunk->size < sizeof(SessionLogChunkHeader) ||
+	    chunk->size > mapped_size - offset ||
+	    !isChunkValid(mapped + offset))
+	{
+	    yWarning() << "SessionLogReader::open"
+		       << "Warning: ignoring truncated or corrupted data at the end of the log";
+	    break;
+	}
+	chunks.push_back(offset);
+	offset += chunk->size;
+    }
+
+    // collect the declarations of the streams
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+	for (std::size_t j = 0; j < chunkHeader(i)->n_records; j++)
+	{
+	    SessionLogRecord rec;
+	    getRecord(i, j, rec);
+	    if (rec.stream != SESSION_LOG_META_STREAM || rec.size < 2 * sizeof(uint32_t))
+		continue;
+
+	    uint32_t stream;
+	    uint32_t kind;
+	    std::memcpy(&stream, rec.data, sizeof(uint32_t));
+	    std::memcpy(&kind, rec.data + sizeof(uint32_t), sizeof(uint32_t));
+
+	    SessionLogStream &info = streams[stream];
+	    info.kind = static_cast<StreamKind>(kind);
+	    info.name.assign(rec.data + 2 * sizeof(uint32_t), rec.size - 2 * sizeof(uint32_t));
+	}
+    }
+
+    rewind();
+
+    return true;
+}
+
+void SessionLogReader::close()
+{
+    if (mapped != nullptr)
+	munmap(const_cast<char*>(mapped), mapped_size);
+    mapped = nullptr;
+    mapped_size = 0;
+
+    if (fd >= 0)
+	::close(fd);
+    fd = -1;
+
+    chunks.clear();
+    streams.clear();
+}
+
+const SessionLogChunkHeader* SessionLogReader::chunkHeader(const std::size_t &chunk) const
+{
+    return reinterpret_cast<const SessionLogChunkHeader*>(mapped + chunks[chunk]);
+}
+
+bool SessionLogReader::isChunkValid(const char *chunk_begin)
+{
+    const SessionLogChunkHeader *header = reinterpret_cast<const SessionLogChunkHeader*>(chunk_begin);
+
+    // the index has to fill the end of the chunk
+    // with exactly one aligned entry for each record
+    if (header->index_offset < sizeof(SessionLogChunkHeader) ||
+	header->index_offset > header->size ||
+	header->index_offset % sizeof(uint64_t) != 0 ||
+	(header->size - header->index_offset) % sizeof(uint64_t) != 0 ||
+	header->n_records != (header->size - header->index_offset) / sizeof(uint64_t))
+	return false;
+
+    // as well as each record with its payload
+    const char *index_begin = chunk_begin + header->index_offset;
+    for (std::size_t i = 0; i < header->n_records; i++)
+    {
+	uint64_t record_offset;
+	std::memcpy(&record_offset, index_begin + i * sizeof(uint64_t), sizeof(uint64_t));
+	if (record_offset < sizeof(SessionLogChunkHeader) ||
+	    record_offset % sizeof(uint64_t) != 0 ||
+	    record_offset > header->size ||
+	    header->size - record_offset < sizeof(SessionLogRecordHeader))
+	    return false;
+
+	const SessionLogRecordHeader *record = reinterpret_cast<const SessionLogRecordHeader*>(chunk_begin + record_offset);
+	if (record->size > header->size - record_offset - sizeof(SessionLogRecordHeader))
+	    return false;
+    }
+
+    return true;
+}
+
+void SessionLogReader::getRecord(const std::size_t &chunk,
+				 const std::size_t &record,
+				 SessionLogRecord &rec) const
+{
+    // the bounds of the index and of the records
+    // were checked by isChunkValid() when the log was opened
+    const char *chunk_begin = mapped + chunks[chunk];
+    const SessionLogChunkHeader *header = chunkHeader(chunk);
+    const uint64_t *index = reinterpret_cast<const uint64_t*>(chunk_begin + header->index_offset);
+    const SessionLogRecordHeader *rec_header = reinterpret_cast<const SessionLogRecordHeader*>(chunk_begin + index[record]);
+
+    rec.stream = rec_header->stream;
+    rec.timestamp = rec_header->timestamp;
+    rec.size = rec_header->size;
+    rec.data = chunk_begin + index[record] + sizeof(SessionLogRecordHeader);
+}
+
+const std::map<uint32_t, SessionLogStream>& SessionLogReader::getStreams() const
+{
+    return streams;
+}
+
+bool SessionLogReader::getTimeSpan(double &begin, double &end) const
+{
+    bool found = false;
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+	// chunks containing only declarations
+	// have an empty time span
+	const SessionLogChunkHeader *header = chunkHeader(i);
+	if (header->time_begin > header->time_end)
+	    continue;
+
+	if (!found)
+	{
+	    begin = header->time_begin;
+	    end = header->time_end;
+	    found = true;
+	}
+	else
+	{
+	    begin = std::min(begin, header->time_begin);
+	    end = std::max(end, header->time_end);
+	}
+    }
+
+    return found;
+}
+
+void SessionLogReader::rewind()
+{
+    current_chunk = 0;
+    current_record = 0;
+}
+
+void SessionLogReader::seek(const double &time)
+{
+    rewind();
+
+    // skip whole chunks using their time span
+    while (current_chunk < chunks.size() &&
+	   chunkHeader(current_chunk)->time_end < time)
+	current_chunk++;
+
+    // then use the index of the chunk
+    while (current_chunk < chunks.size() &&
+	   current_record < chunkHeader(current_chunk)->n_records)
+    {
+	SessionLogRecord rec;
+	getRecord(current_chunk, current_record, rec);
+	if (rec.stream != SESSION_LOG_META_STREAM && rec.timestamp >= time)
+	    break;
+	current_record++;
+    }
+}
+
+bool SessionLogReader::next(SessionLogRecord &rec)
+{
+    while (current_chunk < chunks.size())
+    {
+	if (current_record >= chunkHeader(current_chunk)->n_records)
+	{
+	    current_chunk++;
+	    current_record = 0;
+	    continue;
+	}
+
+	getRecord(current_chunk, current_record, rec);
+	current_record++;
+
+	if (rec.stream != SESSION_LOG_META_STREAM)
+	    return true;
+    }
+
+    return false;
+}
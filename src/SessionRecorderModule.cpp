@@ -0,0 +1,241 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
+
+// std
+#include <sstream>
+
+#include "headers/SessionRecorderModule.h"
+
+void PointCloudRecorderPort::setRecorder(SessionRecorderModule *recorder, const uint32_t &stream)
+{
+    this->recorder = recorder;
+    this->stream = stream;
+}
+
+void PointCloudRecorderPort::onRead(PointCloud &cloud)
+{
+    recorder->record(stream, cloud.data(), cloud.size() * sizeof(PointCloudItem));
+}
+
+void ContactsRecorderPort::setRecorder(SessionRecorderModule *recorder, const uint32_t &stream)
+{
+    this->recorder = recorder;
+    this->stream = stream;
+}
+
+void ContactsRecorderPort::onRead(yarp::os::Bottle &contacts)
+{
+    size_t size;
+    const char *data = contacts.toBinary(&size);
+    recorder->record(stream, data, size);
+}
+
+void SessionRecorderModule::record(const uint32_t &stream, const void *data, const std::size_t &size)
+{
+    double now = yarp::os::Time::now();
+
+    mutex.lock();
+
+    log.write(stream, now, data, size);
+
+    mutex.unlock();
+}
+
+bool SessionRecorderModule::configure(yarp::os::ResourceFinder &rf)
+{
+    // get the name of the log
+    std::string file_name = rf.check("file", yarp::os::Value("session.log")).asString();
+    yInfo() << "SessionRecorderModule: recording to" << file_name;
+
+    // get the period used to sample the estimate
+    period = rf.check("period", yarp::os::Value(0.01)).asDouble();
+
+    // get the namespace prepended to the names of all the ports
+    // the streams are recorded with the original names
+    // so that the log can be replayed in any namespace
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+    // get the name of the frames
+    estimate_frame = rf.check("estimateFrame",
+			      yarp::os::Value("/box_alt/estimate/frame")).asString();
+    root_frame = rf.check("rootFrame",
+			  yarp::os::Value("/iCub/frame")).asString();
+
+    // get the sources
+    std::string cloud_source = rf.check("pointCloudSource",
+					yarp::os::Value("/box_alt/fakepointcloud:o")).asString();
+    std::vector<std::string> contacts_sources;
+    yarp::os::Bottle *sources_bottle = rf.find("contactsSources").asList();
+    if (sources_bottle != nullptr)
+    {
+	for (size_t i = 0; i < sources_bottle->size(); i++)
+	    contacts_sources.push_back(sources_bottle->get(i).asString());
+    }
+    else
+    {
+	contacts_sources.push_back("/right_hand/skinManager/skin_events:o");
+	contacts_sources.push_back("/left_hand/skinManager/skin_events:o");
+    }
+
+    // create the log
+    if (!log.open(file_name))
+	return false;
+
+    // declare the streams and open the ports
+    port_cloud.setRecorder(this, log.addStream(StreamKind::PointCloud, cloud_source));
+    bool ok = port_cloud.open(prefix + "/session-recorder/pc:i");
+    if (!ok)
+    {
+	yError() << "SessionRecorderModule::configure"
+		 << "Error: unable to open the point cloud port";
+	return false;
+    }
+    port_cloud.useCallback();
+    port_cloud.setStrict();
+    yarp::os::Network::connect(prefix + cloud_source, port_cloud.getName());
+
+    for (size_t i = 0; i < contacts_sources.size(); i++)
+    {
+	ContactsRecorderPort *port = new ContactsRecorderPort();
+	ports_contacts.push_back(port);
+
+	port->setRecorder(this, log.addStream(StreamKind::Contacts, contacts_sources[i]));
+
+	std::ostringstream port_name;
+	port_name << prefix << "/session-recorder/contacts/" << i << ":i";
+	ok = port->open(port_name.str());
+	if (!ok)
+	{
+	    yError() << "SessionRecorderModule::configure"
+		     << "Error: unable to open the contacts port"
+		     << port_name.str();
+	    return false;
+	}
+	port->useCallback();
+	port->setStrict();
+	yarp::os::Network::connect(prefix + contacts_sources[i], port->getName());
+    }
+
+    // the estimate stream is named after the frames
+    estimate_stream = log.addStream(StreamKind::Estimate, estimate_frame + " " + root_frame);
+
+    // prepare properties for the FrameTransformClient
+    yarp::os::Property propTfClient;
+    propTfClient.put("device", "transformClient");
+    propTfClient.put("local", prefix + "/session-recorder/transformClient");
+    propTfClient.put("remote", prefix + "/transformServer");
+
+    // try to open the driver
+    ok = drv_transform_client.open(propTfClient);
+    if (!ok)
+    {
+	yError() << "SessionRecorderModule::configure"
+		 << "Error: unable to open the FrameTransformClient driver.";
+	return false;
+    }
+
+    // try to retrieve the view
+    ok = drv_transform_client.view(tf_client);
+    if (!ok || tf_client == 0)
+    {
+	yError() << "SessionRecorderModule::configure"
+		 << "Error: unable to retrieve the FrameTransformClient view.";
+	return false;
+    }
+
+    return true;
+}
+
+double SessionRecorderModule::getPeriod()
+{
+    return period;
+}
+
+bool SessionRecorderModule::updateModule()
+{
+    // sample the estimate
+    yarp::sig::Matrix estimate;
+    if (!tf_client->getTransform(estimate_frame, root_frame, estimate))
+	return true;
+
+    // record only new estimates
+    bool is_new = (last_estimate.rows() != 4);
+    for (int i = 0; !is_new && i < 4; i++)
+    {
+	for (int j = 0; !is_new && j < 4; j++)
+	    is_new = estimate(i, j) != last_estimate(i, j);
+    }
+
+    if (is_new)
+    {
+	// the matrix is stored in row major order
+	double data[16];
+	for (int i = 0; i < 4; i++)
+	{
+	    for (int j = 0; j < 4; j++)
+		data[i * 4 + j] = estimate(i, j);
+	}
+	record(estimate_stream, data, sizeof(data));
+
+	last_estimate = estimate;
+    }
+
+    return true;
+}
+
+bool SessionRecorderModule::close()
+{
+    // close ports
+    port_cloud.close();
+    for (ContactsRecorderPort *port : ports_contacts)
+    {
+	port->close();
+	delete port;
+    }
+    ports_contacts.clear();
+
+    // close drivers
+    drv_transform_client.close();
+
+    // flush the last chunk
+    mutex.lock();
+    log.close();
+    mutex.unlock();
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "SessionRecorderModule: cannot find YARP!";
+	return 1;
+    }
+
+    // instantiate the resource finder
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("session_recorder_config.ini");
+    rf.configure(argc,argv);
+
+    // instantiate the module
+    SessionRecorderModule recorder;
+
+    // run the module
+    return recorder.runModule(rf);
+}
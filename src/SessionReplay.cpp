@@ -0,0 +1,210 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Replay a session log recorded by the session recorder.
+ *
+ * Recorded streams are published again on ports having
+ * the original names (optionally prepended with a prefix),
+ * estimates are published again using the FrameTransformServer.
+ *
+ * Usage:
+ * session_replay --file <log> [--speed <factor>] [--from <seconds>] [--prefix <prefix>]
+ *
+ * speed 1.0 replays in real time, N replays N times faster,
+ * 0.0 replays as fast as possible.
+ */
+
+// yarp
+#include <yarp/os/Network.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/SystemClock.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/IFrameTransform.h>
+
+// std
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "headers/PointCloud.h"
+#include "headers/SessionLog.h"
+
+int main(int argc, char **argv)
+{
+    yarp::os::Network yarp;
+    if (!yarp.checkNetwork())
+    {
+	yError() << "SessionReplay: cannot find YARP!";
+	return 1;
+    }
+
+    yarp::os::ResourceFinder rf;
+    rf.configure(argc, argv);
+
+    if (!rf.check("file"))
+    {
+	yError() << "SessionReplay: usage"
+		 << "session_replay --file <log> [--speed <factor>] [--from <seconds>] [--prefix <prefix>]";
+	return 1;
+    }
+    std::string file_name = rf.find("file").asString();
+    double speed = rf.check("speed", yarp::os::Value(1.0)).asDouble();
+    double from = rf.check("from", yarp::os::Value(0.0)).asDouble();
+    std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+    if (speed < 0.0)
+    {
+	yError() << "SessionReplay: speed should be non negative";
+	return 1;
+    }
+
+    // map the log
+    SessionLogReader log;
+    if (!log.open(file_name))
+	return 1;
+
+    double time_begin;
+    double time_end;
+    if (!log.getTimeSpan(time_begin, time_end))
+    {
+	yWarning() << "SessionReplay: the log is empty";
+	return 0;
+    }
+    yInfo() << "SessionReplay: the log spans" << time_end - time_begin << "seconds";
+
+    // open the ports
+    std::map<uint32_t, yarp::os::BufferedPort<PointCloud>*> ports_cloud;
+    std::map<uint32_t, yarp::os::BufferedPort<yarp::os::Bottle>*> ports_contacts;
+    std::map<uint32_t, std::pair<std::string, std::string>> frames;
+    bool ok = true;
+    for (const auto &item : log.getStreams())
+    {
+	const uint32_t &stream = item.first;
+	const SessionLogStream &info = item.second;
+
+	switch (info.kind)
+	{
+	case StreamKind::PointCloud:
+	{
+	    yarp::os::BufferedPort<PointCloud> *port = new yarp::os::BufferedPort<PointCloud>();
+	    ports_cloud[stream] = port;
+	    ok &= port->open(prefix + info.name);
+	    break;
+	}
+	case StreamKind::Contacts:
+	{
+	    yarp::os::BufferedPort<yarp::os::Bottle> *port = new yarp::os::BufferedPort<yarp::os::Bottle>();
+	    ports_contacts[stream] = port;
+	    ok &= port->open(prefix + info.name);
+	    break;
+	}
+	case StreamKind::Estimate:
+	{
+	    // the name of the stream is "<target frame> <source frame>"
+	    std::size_t separator = info.name.find(' ');
+	    frames[stream] = std::make_pair(info.name.substr(0, separator),
+					    info.name.substr(separator + 1));
+	    break;
+	}
+	}
+    }
+
+    // open the FrameTransformClient only if required
+    yarp::dev::PolyDriver drv_transform_client;
+    yarp::dev::IFrameTransform* tf_client = nullptr;
+    if (ok && !frames.empty())
+    {
+	yarp::os::Property propTfClient;
+	propTfClient.put("device", "transformClient");
+	propTfClient.put("local", prefix + "/session-replay/transformClient");
+	propTfClient.put("remote", prefix + "/transformServer");
+
+	ok = drv_transform_client.open(propTfClient);
+	ok = ok && drv_transform_client.view(tf_client) && tf_client != 0;
+	if (!ok)
+	    yError() << "SessionReplay: unable to open the FrameTransformClient driver.";
+    }
+
+    if (ok)
+    {
+	log.seek(time_begin + from);
+
+	SessionLogRecord rec;
+	double replay_begin = yarp::os::SystemClock::nowSystem();
+	double log_begin = time_begin + from;
+	while (log.next(rec))
+	{
+	    // wait until the record is due
+	    if (speed > 0.0)
+	    {
+		double due = replay_begin + (rec.timestamp - log_begin) / speed;
+		double wait = due - yarp::os::SystemClock::nowSystem();
+		if (wait > 0.0)
+		    yarp::os::SystemClock::delaySystem(wait);
+	    }
+
+	    if (ports_cloud.count(rec.stream) > 0)
+	    {
+		yarp::os::BufferedPort<PointCloud> *port = ports_cloud[rec.stream];
+		PointCloud &cloud = port->prepare();
+		cloud.resize(rec.size / sizeof(PointCloudItem));
+		std::memcpy(cloud.data(), rec.data, cloud.size() * sizeof(PointCloudItem));
+		port->writeStrict();
+	    }
+	    else if (ports_contacts.count(rec.stream) > 0)
+	    {
+		yarp::os::BufferedPort<yarp::os::Bottle> *port = ports_contacts[rec.stream];
+		yarp::os::Bottle &contacts = port->prepare();
+		contacts.fromBinary(rec.data, rec.size);
+		port->writeStrict();
+	    }
+	    else if (frames.count(rec.stream) > 0 && rec.size == 16 * sizeof(double))
+	    {
+		// the matrix is stored in row major order
+		yarp::sig::Matrix estimate(4, 4);
+		const double *data = reinterpret_cast<const double*>(rec.data);
+		for (int i = 0; i < 4; i++)
+		{
+		    for (int j = 0; j < 4; j++)
+			estimate(i, j) = data[i * 4 + j];
+		}
+		tf_client->setTransform(frames[rec.stream].first,
+					frames[rec.stream].second,
+					estimate);
+	    }
+	}
+
+	double elapsed = yarp::os::SystemClock::nowSystem() - replay_begin;
+	yInfo() << "SessionReplay: replayed" << time_end - log_begin
+		<< "seconds of log in" << elapsed << "seconds";
+    }
+
+    // close ports and drivers
+    for (auto &item : ports_cloud)
+    {
+	item.second->close();
+	delete item.second;
+    }
+    for (auto &item : ports_contacts)
+    {
+	item.second->close();
+	delete item.second;
+    }
+    drv_transform_client.close();
+
+    return ok ? 0 : 1;
+}
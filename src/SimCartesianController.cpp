@@ -0,0 +1,1123 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Property.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/LockGuard.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/SystemClock.h>
+#include <yarp/math/Math.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+
+#include "headers/SimCartesianController.h"
+
+using namespace yarp::math;
+
+namespace
+{
+    // number of links of the chain
+    // 3 for the torso and 7 for the arm
+    const int chain_size = 10;
+
+    // velocity of the joints below which a motion
+    // that cannot reach the target is considered done
+    const double stall_velocity = 0.5;
+
+    // number of iterations and maximum step in degrees
+    // of the offline solver
+    const int solver_iterations = 200;
+    const double solver_max_step = 5.0;
+}
+
+SimCartesianController::SimCartesianController() :
+    PeriodicThread(0.01),
+    ienc_arm(nullptr),
+    ienc_torso(nullptr),
+    ivel_arm(nullptr),
+    ivel_torso(nullptr),
+    imod_arm(nullptr),
+    imod_torso(nullptr),
+    next_context_id(0),
+    mode(ControlMode::Idle),
+    is_pose_available(false),
+    is_position_only(false),
+    motion_traj_time(0.0),
+    motion_start(0.0),
+    is_motion_done(true),
+    is_torso_commanded(false),
+    are_joints_moving(false),
+    max_velocity(0.0),
+    damping(0.0),
+    orientation_tol(0.0)
+{
+}
+
+bool SimCartesianController::open(yarp::os::Searchable &config)
+{
+    std::string robot = config.check("robot", yarp::os::Value("/icubSim")).asString();
+    std::string part = config.check("part", yarp::os::Value("right_arm")).asString();
+    if (part != "right_arm" && part != "left_arm")
+    {
+	yError() << "SimCartesianController: part" << part << "not supported";
+	return false;
+    }
+    arm_type = part.substr(0, part.find('_'));
+
+    std::string local = config.check("local",
+				     yarp::os::Value("/sim_cartesian_controller/" + part)).asString();
+    double period = config.check("period", yarp::os::Value(0.01)).asDouble();
+    max_velocity = config.check("maxVelocity", yarp::os::Value(60.0)).asDouble();
+    damping = config.check("damping", yarp::os::Value(0.02)).asDouble();
+    orientation_tol = config.check("orientationTol", yarp::os::Value(0.03)).asDouble();
+    std::string clock_master = config.check("clockMaster", yarp::os::Value("")).asString();
+    std::string clock_name = config.check("clockName",
+					  yarp::os::Value("sim_cartesian_controller/" + part)).asString();
+    std::string clock_prefix = config.check("clockPrefix", yarp::os::Value("")).asString();
+
+    // open the control boards
+    yarp::os::Property prop;
+    prop.put("device", "remote_controlboard");
+    prop.put("remote", robot + "/" + part);
+    prop.put("local", local + "/arm");
+    if (!drv_arm.open(prop))
+    {
+	yError() << "SimCartesianController: unable to open the Remote Control Board driver"
+		 << "for the" << arm_type << "arm";
+	return false;
+    }
+
+    prop.put("remote", robot + "/torso");
+    prop.put("local", local + "/torso");
+    if (!drv_torso.open(prop))
+    {
+	yError() << "SimCartesianController: unable to open the Remote Control Board driver"
+		 << "for the torso";
+	return false;
+    }
+
+    bool ok = drv_arm.view(ienc_arm) && drv_arm.view(ivel_arm) && drv_arm.view(imod_arm);
+    ok &= drv_torso.view(ienc_torso) && drv_torso.view(ivel_torso) && drv_torso.view(imod_torso);
+    if (!ok)
+    {
+	yError() << "SimCartesianController: unable to retrieve the views"
+		 << "of the control boards";
+	return false;
+    }
+
+    // instantiate the chain
+    // the limits are enforced by the controller
+    // hence the constraints of the chain are disabled
+    chain = iCub::iKin::iCubArm(arm_type);
+    chain.releaseLink(0);
+    chain.releaseLink(1);
+    chain.releaseLink(2);
+    chain.setAllConstraints(false);
+
+    phys_min_limits.resize(chain_size);
+    phys_max_limits.resize(chain_size);
+    for (int i = 0; i < chain_size; i++)
+    {
+	phys_min_limits[i] = chain(i).getMin() * (180.0 / M_PI);
+	phys_max_limits[i] = chain(i).getMax() * (180.0 / M_PI);
+    }
+
+    // default context
+    // as in the iKinCartesianSolver the torso is disabled
+    context.dof.resize(chain_size, 1.0);
+    context.dof[0] = context.dof[1] = context.dof[2] = 0.0;
+    context.min_limits = phys_min_limits;
+    context.max_limits = phys_max_limits;
+    context.rest_pos.resize(chain_size, 0.0);
+    context.rest_weights.resize(chain_size, 0.0);
+    context.traj_time = 2.0;
+    context.in_target_tol = 0.005;
+    context.tracking_mode = false;
+    context.reference_mode = false;
+    context.pose_priority = "position";
+    context.tip_frame.resize(4, 4);
+    context.tip_frame.eye();
+
+    q.resize(chain_size, 0.0);
+    qdot.resize(chain_size, 0.0);
+    xdot_ref.resize(3, 0.0);
+    wdot_ref.resize(3, 0.0);
+
+    // let's give the remote control boards some time
+    // to receive the state of the joints
+    // here use real time and not simulation time
+    ok = false;
+    double t0 = yarp::os::SystemClock::nowSystem();
+    while (yarp::os::SystemClock::nowSystem() - t0 < 5.0)
+    {
+	if (readJoints(q))
+	{
+	    ok = true;
+	    break;
+	}
+	yarp::os::SystemClock::delaySystem(0.1);
+    }
+    if (!ok)
+    {
+	yError() << "SimCartesianController: unable to read the encoders"
+		 << "of the" << arm_type << "arm";
+	return false;
+    }
+    forwardKinematics(q, x, o);
+    stamp.update();
+    is_pose_available = true;
+
+    // join the stepped clock if required
+    if (!clock.configure(clock_name, clock_master, clock_prefix))
+	return false;
+
+    setPeriod(period);
+
+    return start();
+}
+
+bool SimCartesianController::close()
+{
+    if (isRunning())
+	stop();
+
+    if (are_joints_moving)
+	sendVelocities(yarp::sig::Vector(chain_size, 0.0), is_torso_commanded);
+
+    clock.close();
+
+    drv_arm.close();
+    drv_torso.close();
+
+    return true;
+}
+
+bool SimCartesianController::readJoints(yarp::sig::Vector &joints)
+{
+    yarp::sig::Vector encs_torso(3);
+    yarp::sig::Vector encs_arm(16);
+
+    if (!ienc_torso->getEncoders(encs_torso.data()))
+	return false;
+    if (!ienc_arm->getEncoders(encs_arm.data()))
+	return false;
+
+    joints.resize(chain_size);
+    joints[0] = encs_torso[2];
+    joints[1] = encs_torso[1];
+    joints[2] = encs_torso[0];
+    for (size_t i = 0; i < 7; i++)
+	joints[3 + i] = encs_arm[i];
+
+    return true;
+}
+
+bool SimCartesianController::sendVelocities(const yarp::sig::Vector &velocities,
+					    const bool &use_torso)
+{
+    int arm_joints[] = {0, 1, 2, 3, 4, 5, 6};
+    if (!ivel_arm->velocityMove(7, arm_joints, velocities.data() + 3))
+	return false;
+
+    if (use_torso)
+    {
+	int torso_joints[] = {0, 1, 2};
+	double torso_velocities[] = {velocities[2], velocities[1], velocities[0]};
+	if (!ivel_torso->velocityMove(3, torso_joints, torso_velocities))
+	    return false;
+    }
+
+    return true;
+}
+
+bool SimCartesianController::setVelocityMode(const bool &use_torso)
+{
+    int arm_joints[] = {0, 1, 2, 3, 4, 5, 6};
+    int arm_modes[7];
+    std::fill(arm_modes, arm_modes + 7, VOCAB_CM_VELOCITY);
+    if (!imod_arm->setControlModes(7, arm_joints, arm_modes))
+	return false;
+
+    if (use_torso)
+    {
+	int torso_joints[] = {0, 1, 2};
+	int torso_modes[] = {VOCAB_CM_VELOCITY, VOCAB_CM_VELOCITY, VOCAB_CM_VELOCITY};
+	if (!imod_torso->setControlModes(3, torso_joints, torso_modes))
+	    return false;
+    }
+
+    return true;
+}
+
+void SimCartesianController::forwardKinematics(const yarp::sig::Vector &joints,
+					       yarp::sig::Vector &pos,
+					       yarp::sig::Vector &att)
+{
+    chain.setAng((M_PI / 180.0) * joints);
+    yarp::sig::Matrix H = chain.getH();
+
+    pos = H.getCol(3).subVector(0, 2);
+    att = dcm2axis(H);
+}
+
+yarp::sig::Vector SimCartesianController::poseError(const yarp::sig::Vector &joints,
+						    const yarp::sig::Vector &pos,
+						    const yarp::sig::Vector &att,
+						    const bool &position_only)
+{
+    chain.setAng((M_PI / 180.0) * joints);
+    yarp::sig::Matrix H = chain.getH();
+
+    yarp::sig::Vector error(6, 0.0);
+    error.setSubvector(0, pos - H.getCol(3).subVector(0, 2));
+
+    if (!position_only)
+    {
+	// attitude error expressed as the axis-angle
+	// representation of R_d * R^T
+	yarp::sig::Matrix R = H.submatrix(0, 2, 0, 2);
+	yarp::sig::Matrix R_d = axis2dcm(att).submatrix(0, 2, 0, 2);
+	yarp::sig::Vector error_aa = dcm2axis(R_d * R.transposed());
+	error.setSubvector(3, error_aa[3] * error_aa.subVector(0, 2));
+    }
+
+    return error;
+}
+
+yarp::sig::Vector SimCartesianController::solveVelocities(const yarp::sig::Vector &joints,
+							  const yarp::sig::Vector &task_vel,
+							  const bool &position_only,
+							  const double &gain)
+{
+    yarp::sig::Vector velocities(chain_size, 0.0);
+
+    // joints outside their limits, e.g. after a call to setLimits(),
+    // are moved back within the limits and excluded from the task
+    std::vector<bool> is_active(chain_size, false);
+    for (int i = 0; i < chain_size; i++)
+    {
+	if (context.dof[i] == 0.0)
+	    continue;
+
+	double lower = context.min_limits[i];
+	double upper = context.max_limits[i];
+	if (joints[i] < lower || joints[i] > upper || upper - lower < 1e-3)
+	{
+	    double target = std::min(std::max(joints[i], lower), upper);
+	    velocities[i] = gain * (target - joints[i]);
+	}
+	else
+	    is_active[i] = true;
+    }
+
+    // jacobian of the enabled joints
+    chain.setAng((M_PI / 180.0) * joints);
+    yarp::sig::Matrix J_full = chain.GeoJacobian();
+    int task_size = position_only ? 3 : 6;
+    yarp::sig::Matrix J = J_full.submatrix(0, task_size - 1, 0, chain_size - 1);
+    for (int i = 0; i < chain_size; i++)
+    {
+	if (!is_active[i])
+	    J.setCol(i, yarp::sig::Vector(task_size, 0.0));
+    }
+
+    // damped least squares inverse
+    // J^T (J J^T + lambda^2 I)^-1
+    yarp::sig::Matrix J_t = J.transposed();
+    yarp::sig::Matrix J_pinv = J_t * luinv(J * J_t + (damping * damping) * eye(task_size, task_size));
+
+    yarp::sig::Vector qdot_task = J_pinv * task_vel.subVector(0, task_size - 1);
+
+    // the rest posture is tracked within the null space of the task
+    yarp::sig::Vector rest_error(chain_size, 0.0);
+    for (int i = 0; i < chain_size; i++)
+    {
+	if (is_active[i])
+	    rest_error[i] = context.rest_weights[i] * (context.rest_pos[i] - joints[i]) * (M_PI / 180.0);
+    }
+    yarp::sig::Matrix N = eye(chain_size, chain_size) - J_pinv * J;
+    qdot_task = qdot_task + gain * (N * rest_error);
+
+    for (int i = 0; i < chain_size; i++)
+    {
+	if (!is_active[i])
+	    continue;
+
+	velocities[i] = qdot_task[i] * (180.0 / M_PI);
+
+	// do not push the joints beyond their limits
+	if ((joints[i] <= context.min_limits[i] && velocities[i] < 0.0) ||
+	    (joints[i] >= context.max_limits[i] && velocities[i] > 0.0))
+	    velocities[i] = 0.0;
+    }
+
+    // saturate the velocities preserving the direction of motion
+    double max_abs = 0.0;
+    for (int i = 0; i < chain_size; i++)
+	max_abs = std::max(max_abs, std::abs(velocities[i]));
+    if (max_abs > max_velocity)
+	velocities = (max_velocity / max_abs) * velocities;
+
+    return velocities;
+}
+
+void SimCartesianController::solvePose(const yarp::sig::Vector &q0,
+				       const yarp::sig::Vector &pos,
+				       const yarp::sig::Vector &att,
+				       const bool &position_only,
+				       yarp::sig::Vector &qhat)
+{
+    qhat = (q0.size() == static_cast<size_t>(chain_size)) ? q0 : q;
+
+    // integrate the velocities with unitary gain and time step
+    // limiting the size of each step to preserve the linearization
+    for (int k = 0; k < solver_iterations; k++)
+    {
+	yarp::sig::Vector error = poseError(qhat, pos, att, position_only);
+	if (norm(error.subVector(0, 2)) < context.in_target_tol * 0.1 &&
+	    (position_only || norm(error.subVector(3, 5)) < orientation_tol * 0.1))
+	    break;
+
+	yarp::sig::Vector step = solveVelocities(qhat, error, position_only, 1.0);
+	double max_abs = 0.0;
+	for (int i = 0; i < chain_size; i++)
+	    max_abs = std::max(max_abs, std::abs(step[i]));
+	if (max_abs > solver_max_step)
+	    step = (solver_max_step / max_abs) * step;
+
+	qhat = qhat + step;
+	for (int i = 0; i < chain_size; i++)
+	{
+	    if (context.dof[i] != 0.0)
+		qhat[i] = std::min(std::max(qhat[i], context.min_limits[i]), context.max_limits[i]);
+	}
+    }
+}
+
+bool SimCartesianController::startMotion(const yarp::sig::Vector &pos,
+					 const yarp::sig::Vector &att,
+					 const bool &position_only,
+					 const double &t)
+{
+    if (pos.size() < 3 || (!position_only && att.size() < 4))
+	return false;
+
+    bool use_torso;
+    {
+	yarp::os::LockGuard lg(mutex);
+	use_torso = (context.dof[0] + context.dof[1] + context.dof[2]) > 0.0;
+    }
+
+    if (!setVelocityMode(use_torso))
+    {
+	yError() << "SimCartesianController: unable to set the velocity mode"
+		 << "for the" << arm_type << "arm";
+	return false;
+    }
+
+    std::vector<yarp::dev::CartesianEvent*> fired;
+    {
+	yarp::os::LockGuard lg(mutex);
+
+	xd = pos.subVector(0, 2);
+	if (!position_only)
+	    od = att.subVector(0, 3);
+	is_position_only = position_only;
+	motion_traj_time = (t > 0.0) ? t : context.traj_time;
+	motion_start = yarp::os::Time::now();
+	is_motion_done = false;
+	is_torso_commanded = use_torso;
+	mode = ControlMode::Reaching;
+
+	collectEvents("motion-start", fired);
+    }
+    fireEvents("motion-start", fired);
+
+    return true;
+}
+
+void SimCartesianController::collectEvents(const std::string &type,
+					   std::vector<yarp::dev::CartesianEvent*> &fired)
+{
+    for (yarp::dev::CartesianEvent *event : events)
+    {
+	const std::string &event_type = event->cartesianEventParameters.type;
+	if (event_type == type || event_type == "*")
+	    fired.push_back(event);
+    }
+}
+
+void SimCartesianController::fireEvents(const std::string &type,
+					const std::vector<yarp::dev::CartesianEvent*> &fired)
+{
+    double now = yarp::os::Time::now();
+    for (yarp::dev::CartesianEvent *event : fired)
+    {
+	event->cartesianEventVariables.type = type;
+	event->cartesianEventVariables.time = now;
+	event->cartesianEventVariables.motionOngoingCheckPoint = -1.0;
+	event->cartesianEventCallback();
+    }
+}
+
+void SimCartesianController::run()
+{
+    double now = yarp::os::Time::now();
+
+    yarp::sig::Vector joints;
+    if (!readJoints(joints))
+    {
+	clock.cycleDone(now + getPeriod());
+	return;
+    }
+
+    std::vector<yarp::dev::CartesianEvent*> fired;
+    yarp::sig::Vector velocities(chain_size, 0.0);
+    bool use_torso;
+    bool send;
+
+    {
+	yarp::os::LockGuard lg(mutex);
+
+	q = joints;
+	forwardKinematics(q, x, o);
+	stamp.update(now);
+	is_pose_available = true;
+
+	if (mode == ControlMode::Reaching)
+	{
+	    // proportional law whose time constant
+	    // approximates the trajectory time
+	    double tau = motion_traj_time / 3.0;
+	    yarp::sig::Vector error = poseError(q, xd, od, is_position_only);
+	    velocities = solveVelocities(q, (1.0 / tau) * error, is_position_only, 1.0 / tau);
+
+	    bool in_target = norm(error.subVector(0, 2)) < context.in_target_tol &&
+		(is_position_only || norm(error.subVector(3, 5)) < orientation_tol);
+	    bool stalled = (now - motion_start > motion_traj_time) &&
+		(norm(velocities) < stall_velocity);
+	    if (!is_motion_done && (in_target || stalled))
+	    {
+		is_motion_done = true;
+		collectEvents("motion-done", fired);
+
+		// in tracking mode the controller keeps holding the target
+		if (!context.tracking_mode)
+		{
+		    mode = ControlMode::Idle;
+		    velocities = 0.0;
+		}
+	    }
+	}
+	else if (mode == ControlMode::Streaming)
+	{
+	    yarp::sig::Vector task_vel(6);
+	    task_vel.setSubvector(0, xdot_ref);
+	    task_vel.setSubvector(3, wdot_ref);
+	    velocities = solveVelocities(q, task_vel, false, 1.0);
+	}
+
+	qdot = velocities;
+	use_torso = is_torso_commanded;
+
+	// once the joints are stopped
+	// the velocities are not sent anymore
+	send = (mode != ControlMode::Idle) || are_joints_moving;
+	are_joints_moving = (mode != ControlMode::Idle);
+    }
+
+    if (send)
+	sendVelocities(velocities, use_torso);
+
+    fireEvents("motion-done", fired);
+
+    clock.cycleDone(now + getPeriod());
+}
+
+bool SimCartesianController::setTrackingMode(const bool f)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    context.tracking_mode = f;
+
+    return true;
+}
+
+bool SimCartesianController::getTrackingMode(bool *f)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *f = context.tracking_mode;
+
+    return true;
+}
+
+bool SimCartesianController::setReferenceMode(const bool f)
+{
+    // without a reference generator
+    // the mode is only stored
+    yarp::os::LockGuard lg(mutex);
+
+    context.reference_mode = f;
+
+    return true;
+}
+
+bool SimCartesianController::getReferenceMode(bool *f)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *f = context.reference_mode;
+
+    return true;
+}
+
+bool SimCartesianController::setPosePriority(const std::string &p)
+{
+    if (p != "position" && p != "orientation")
+	return false;
+
+    // position and attitude are solved together
+    // hence the priority is only stored
+    yarp::os::LockGuard lg(mutex);
+
+    context.pose_priority = p;
+
+    return true;
+}
+
+bool SimCartesianController::getPosePriority(std::string &p)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    p = context.pose_priority;
+
+    return true;
+}
+
+bool SimCartesianController::getPose(yarp::sig::Vector &x, yarp::sig::Vector &o,
+				     yarp::os::Stamp *stamp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!is_pose_available)
+	return false;
+
+    x = this->x;
+    o = this->o;
+    if (stamp != nullptr)
+	*stamp = this->stamp;
+
+    return true;
+}
+
+bool SimCartesianController::getPose(const int axis, yarp::sig::Vector &x, yarp::sig::Vector &o,
+				     yarp::os::Stamp *stamp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!is_pose_available || axis < 0 || axis >= chain_size)
+	return false;
+
+    chain.setAng((M_PI / 180.0) * q);
+    yarp::sig::Matrix H = chain.getH(axis, true);
+
+    x = H.getCol(3).subVector(0, 2);
+    o = dcm2axis(H);
+    if (stamp != nullptr)
+	*stamp = this->stamp;
+
+    return true;
+}
+
+bool SimCartesianController::goToPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+				      const double t)
+{
+    return startMotion(xd, od, false, t);
+}
+
+bool SimCartesianController::goToPosition(const yarp::sig::Vector &xd, const double t)
+{
+    return startMotion(xd, yarp::sig::Vector(), true, t);
+}
+
+bool SimCartesianController::goToPoseSync(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+					  const double t)
+{
+    // the controller runs in the same process
+    // hence the command is accepted synchronously in any case
+    return goToPose(xd, od, t);
+}
+
+bool SimCartesianController::goToPositionSync(const yarp::sig::Vector &xd, const double t)
+{
+    return goToPosition(xd, t);
+}
+
+bool SimCartesianController::getDesired(yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+					yarp::sig::Vector &qdhat)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (xd.size() == 0)
+    {
+	// no motion has been requested yet
+	xdhat = x;
+	odhat = o;
+	qdhat = q;
+	return true;
+    }
+
+    solvePose(q, xd, od, is_position_only, qdhat);
+    forwardKinematics(qdhat, xdhat, odhat);
+
+    return true;
+}
+
+bool SimCartesianController::askForPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+					yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+					yarp::sig::Vector &qdhat)
+{
+    return askForPose(yarp::sig::Vector(), xd, od, xdhat, odhat, qdhat);
+}
+
+bool SimCartesianController::askForPose(const yarp::sig::Vector &q0,
+					const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+					yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+					yarp::sig::Vector &qdhat)
+{
+    if (xd.size() < 3 || od.size() < 4)
+	return false;
+
+    yarp::os::LockGuard lg(mutex);
+
+    solvePose(q0, xd.subVector(0, 2), od.subVector(0, 3), false, qdhat);
+    forwardKinematics(qdhat, xdhat, odhat);
+
+    return true;
+}
+
+bool SimCartesianController::askForPosition(const yarp::sig::Vector &xd,
+					    yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+					    yarp::sig::Vector &qdhat)
+{
+    return askForPosition(yarp::sig::Vector(), xd, xdhat, odhat, qdhat);
+}
+
+bool SimCartesianController::askForPosition(const yarp::sig::Vector &q0,
+					    const yarp::sig::Vector &xd,
+					    yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+					    yarp::sig::Vector &qdhat)
+{
+    if (xd.size() < 3)
+	return false;
+
+    yarp::os::LockGuard lg(mutex);
+
+    solvePose(q0, xd.subVector(0, 2), yarp::sig::Vector(), true, qdhat);
+    forwardKinematics(qdhat, xdhat, odhat);
+
+    return true;
+}
+
+bool SimCartesianController::getDOF(yarp::sig::Vector &curDof)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    curDof = context.dof;
+
+    return true;
+}
+
+bool SimCartesianController::setDOF(const yarp::sig::Vector &newDof, yarp::sig::Vector &curDof)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    // as in the iKinCartesianSolver the value 2
+    // leaves the corresponding joint unchanged
+    for (size_t i = 0; i < std::min(newDof.size(), context.dof.size()); i++)
+    {
+	if (newDof[i] != 2.0)
+	    context.dof[i] = (newDof[i] != 0.0) ? 1.0 : 0.0;
+    }
+    curDof = context.dof;
+
+    return true;
+}
+
+bool SimCartesianController::getRestPos(yarp::sig::Vector &curRestPos)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    curRestPos = context.rest_pos;
+
+    return true;
+}
+
+bool SimCartesianController::setRestPos(const yarp::sig::Vector &newRestPos,
+					yarp::sig::Vector &curRestPos)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    for (size_t i = 0; i < std::min(newRestPos.size(), context.rest_pos.size()); i++)
+	context.rest_pos[i] = std::min(std::max(newRestPos[i], phys_min_limits[i]), phys_max_limits[i]);
+    curRestPos = context.rest_pos;
+
+    return true;
+}
+
+bool SimCartesianController::getRestWeights(yarp::sig::Vector &curRestWeights)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    curRestWeights = context.rest_weights;
+
+    return true;
+}
+
+bool SimCartesianController::setRestWeights(const yarp::sig::Vector &newRestWeights,
+					    yarp::sig::Vector &curRestWeights)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    for (size_t i = 0; i < std::min(newRestWeights.size(), context.rest_weights.size()); i++)
+	context.rest_weights[i] = std::max(newRestWeights[i], 0.0);
+    curRestWeights = context.rest_weights;
+
+    return true;
+}
+
+bool SimCartesianController::getLimits(const int axis, double *min, double *max)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (axis < 0 || axis >= chain_size)
+	return false;
+
+    *min = context.min_limits[axis];
+    *max = context.max_limits[axis];
+
+    return true;
+}
+
+bool SimCartesianController::setLimits(const int axis, const double min, const double max)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (axis < 0 || axis >= chain_size || min > max)
+	return false;
+
+    // the limits cannot exceed the physical ones
+    context.min_limits[axis] = std::max(min, phys_min_limits[axis]);
+    context.max_limits[axis] = std::min(max, phys_max_limits[axis]);
+    if (context.min_limits[axis] > context.max_limits[axis])
+	context.min_limits[axis] = context.max_limits[axis];
+
+    return true;
+}
+
+bool SimCartesianController::getTrajTime(double *t)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *t = context.traj_time;
+
+    return true;
+}
+
+bool SimCartesianController::setTrajTime(const double t)
+{
+    if (t <= 0.0)
+	return false;
+
+    yarp::os::LockGuard lg(mutex);
+
+    context.traj_time = t;
+
+    return true;
+}
+
+bool SimCartesianController::getInTargetTol(double *tol)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *tol = context.in_target_tol;
+
+    return true;
+}
+
+bool SimCartesianController::setInTargetTol(const double tol)
+{
+    if (tol <= 0.0)
+	return false;
+
+    yarp::os::LockGuard lg(mutex);
+
+    context.in_target_tol = tol;
+
+    return true;
+}
+
+bool SimCartesianController::getJointsVelocities(yarp::sig::Vector &qdot)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    // velocities of the enabled joints only
+    qdot.clear();
+    for (int i = 0; i < chain_size; i++)
+    {
+	if (context.dof[i] != 0.0)
+	    qdot.push_back(this->qdot[i]);
+    }
+
+    return true;
+}
+
+bool SimCartesianController::getTaskVelocities(yarp::sig::Vector &xdot, yarp::sig::Vector &odot)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    chain.setAng((M_PI / 180.0) * q);
+    yarp::sig::Vector task_vel = chain.GeoJacobian() * ((M_PI / 180.0) * qdot);
+
+    xdot = task_vel.subVector(0, 2);
+
+    yarp::sig::Vector w = task_vel.subVector(3, 5);
+    double w_norm = norm(w);
+    odot.resize(4, 0.0);
+    if (w_norm > 0.0)
+    {
+	odot.setSubvector(0, (1.0 / w_norm) * w);
+	odot[3] = w_norm;
+    }
+
+    return true;
+}
+
+bool SimCartesianController::setTaskVelocities(const yarp::sig::Vector &xdot,
+					       const yarp::sig::Vector &odot)
+{
+    if (xdot.size() < 3 || odot.size() < 4)
+	return false;
+
+    bool use_torso;
+    bool is_streaming;
+    {
+	yarp::os::LockGuard lg(mutex);
+	use_torso = (context.dof[0] + context.dof[1] + context.dof[2]) > 0.0;
+	is_streaming = (mode == ControlMode::Streaming);
+    }
+
+    // the control mode is set once at the beginning of the stream
+    if (!is_streaming && !setVelocityMode(use_torso))
+    {
+	yError() << "SimCartesianController: unable to set the velocity mode"
+		 << "for the" << arm_type << "arm";
+	return false;
+    }
+
+    yarp::os::LockGuard lg(mutex);
+
+    // the angular velocity is given in axis-angle representation
+    xdot_ref = xdot.subVector(0, 2);
+    wdot_ref = odot[3] * odot.subVector(0, 2);
+
+    if (!is_streaming)
+    {
+	is_torso_commanded = use_torso;
+	is_motion_done = false;
+	mode = ControlMode::Streaming;
+    }
+
+    return true;
+}
+
+bool SimCartesianController::attachTipFrame(const yarp::sig::Vector &x, const yarp::sig::Vector &o)
+{
+    if (x.size() < 3 || o.size() < 4)
+	return false;
+
+    yarp::sig::Matrix tip_frame = axis2dcm(o.subVector(0, 3));
+    tip_frame(0, 3) = x[0];
+    tip_frame(1, 3) = x[1];
+    tip_frame(2, 3) = x[2];
+
+    yarp::os::LockGuard lg(mutex);
+
+    if (!chain.setHN(tip_frame))
+	return false;
+    context.tip_frame = tip_frame;
+
+    return true;
+}
+
+bool SimCartesianController::getTipFrame(yarp::sig::Vector &x, yarp::sig::Vector &o)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    x = context.tip_frame.getCol(3).subVector(0, 2);
+    o = dcm2axis(context.tip_frame);
+
+    return true;
+}
+
+bool SimCartesianController::removeTipFrame()
+{
+    yarp::sig::Matrix identity(4, 4);
+    identity.eye();
+
+    yarp::os::LockGuard lg(mutex);
+
+    if (!chain.setHN(identity))
+	return false;
+    context.tip_frame = identity;
+
+    return true;
+}
+
+bool SimCartesianController::checkMotionDone(bool *f)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *f = is_motion_done;
+
+    return true;
+}
+
+bool SimCartesianController::waitMotionDone(const double period, const double timeout)
+{
+    double t0 = yarp::os::Time::now();
+    bool done = false;
+    while (!done)
+    {
+	checkMotionDone(&done);
+	if (done)
+	    break;
+
+	if (timeout > 0.0 && yarp::os::Time::now() - t0 > timeout)
+	    return false;
+
+	yarp::os::Time::delay(period);
+    }
+
+    return true;
+}
+
+bool SimCartesianController::stopControl()
+{
+    bool use_torso;
+    {
+	yarp::os::LockGuard lg(mutex);
+
+	mode = ControlMode::Idle;
+	is_motion_done = true;
+	qdot = 0.0;
+	use_torso = is_torso_commanded;
+	are_joints_moving = false;
+    }
+
+    return sendVelocities(yarp::sig::Vector(chain_size, 0.0), use_torso);
+}
+
+bool SimCartesianController::storeContext(int *id)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *id = next_context_id++;
+    contexts[*id] = context;
+
+    return true;
+}
+
+bool SimCartesianController::restoreContext(const int id)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    auto it = contexts.find(id);
+    if (it == contexts.end())
+	return false;
+
+    context = it->second;
+    chain.setHN(context.tip_frame);
+
+    return true;
+}
+
+bool SimCartesianController::deleteContext(const int id)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    return contexts.erase(id) > 0;
+}
+
+bool SimCartesianController::getInfo(yarp::os::Bottle &info)
+{
+    info.clear();
+
+    yarp::os::Bottle &type = info.addList();
+    type.addString("arm_type");
+    type.addString(arm_type);
+
+    yarp::os::Bottle &controller = info.addList();
+    controller.addString("controller");
+    controller.addString("simcartesiancontroller");
+
+    yarp::os::Bottle &events = info.addList();
+    events.addString("events");
+    yarp::os::Bottle &events_list = events.addList();
+    events_list.addString("motion-start");
+    events_list.addString("motion-done");
+
+    return true;
+}
+
+bool SimCartesianController::registerEvent(yarp::dev::CartesianEvent &event)
+{
+    const std::string &type = event.cartesianEventParameters.type;
+    if (type != "motion-start" && type != "motion-done" && type != "*")
+	return false;
+
+    yarp::os::LockGuard lg(mutex);
+
+    if (std::find(events.begin(), events.end(), &event) == events.end())
+	events.push_back(&event);
+
+    return true;
+}
+
+bool SimCartesianController::unregisterEvent(yarp::dev::CartesianEvent &event)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    auto it = std::find(events.begin(), events.end(), &event);
+    if (it == events.end())
+	return false;
+    events.erase(it);
+
+    return true;
+}
+
+bool SimCartesianController::tweakSet(const yarp::os::Bottle &options)
+{
+    // no tweakable options are available
+    return options.size() == 0;
+}
+
+bool SimCartesianController::tweakGet(yarp::os::Bottle &options)
+{
+    options.clear();
+
+    return true;
+}
@@ -0,0 +1,728 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/LockGuard.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+
+#include "headers/SimControlBoard.h"
+
+SimControlBoard::SimControlBoard() :
+    joints(0),
+    stamp(0.0),
+    max_velocity(0.0)
+{
+}
+
+bool SimControlBoard::loadVector(yarp::os::Searchable &config,
+				 const std::string &key,
+				 const double &default_value,
+				 std::vector<double> &vector)
+{
+    vector.assign(joints, default_value);
+
+    yarp::os::Bottle *list = config.find(key).asList();
+    if (list == nullptr)
+	return true;
+
+    if (list->size() != static_cast<size_t>(joints))
+    {
+	yError() << "SimControlBoard: expected" << joints
+		 << "values for parameter" << key;
+	return false;
+    }
+
+    for (size_t i = 0; i < list->size(); i++)
+	vector[i] = list->get(i).asDouble();
+
+    return true;
+}
+
+bool SimControlBoard::open(yarp::os::Searchable &config)
+{
+    joints = config.check("joints", yarp::os::Value(0)).asInt();
+    if (joints <= 0)
+    {
+	yError() << "SimControlBoard: invalid or missing parameter 'joints'";
+	return false;
+    }
+
+    max_velocity = config.check("maxVelocity", yarp::os::Value(100.0)).asDouble();
+
+    if (!loadVector(config, "home", 0.0, positions) ||
+	!loadVector(config, "minLimits", -180.0, min_limits) ||
+	!loadVector(config, "maxLimits", 180.0, max_limits))
+	return false;
+
+    for (int i = 0; i < joints; i++)
+    {
+	if (min_limits[i] > max_limits[i])
+	{
+	    yError() << "SimControlBoard: the limits of joint" << i
+		     << "are not consistent";
+	    return false;
+	}
+	positions[i] = clamp(i, positions[i]);
+    }
+
+    // initially the joints are at rest in position mode
+    velocities.assign(joints, 0.0);
+    targets = positions;
+    ref_speeds.assign(joints, 10.0);
+    ref_velocities.assign(joints, 0.0);
+    ref_accelerations.assign(joints, 1e6);
+    is_motion_done.assign(joints, true);
+    modes.assign(joints, VOCAB_CM_POSITION);
+
+    stamp = yarp::os::Time::now();
+
+    return true;
+}
+
+bool SimControlBoard::close()
+{
+    return true;
+}
+
+void SimControlBoard::step(const double &dt, const double &time)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    for (int i = 0; i < joints; i++)
+    {
+	double previous = positions[i];
+
+	if (modes[i] == VOCAB_CM_VELOCITY)
+	{
+	    positions[i] = clamp(i, positions[i] + ref_velocities[i] * dt);
+	}
+	else if (modes[i] == VOCAB_CM_POSITION && !is_motion_done[i])
+	{
+	    // move towards the target at the reference speed
+	    double error = targets[i] - positions[i];
+	    double max_step = ref_speeds[i] * dt;
+	    if (std::abs(error) <= max_step)
+	    {
+		positions[i] = targets[i];
+		is_motion_done[i] = true;
+	    }
+	    else
+		positions[i] += std::copysign(max_step, error);
+	}
+
+	velocities[i] = (dt > 0.0) ? (positions[i] - previous) / dt : 0.0;
+    }
+
+    stamp = time;
+}
+
+bool SimControlBoard::isJoint(const int &j) const
+{
+    return (j >= 0) && (j < joints);
+}
+
+double SimControlBoard::clamp(const int &j, const double &position) const
+{
+    return std::min(std::max(position, min_limits[j]), max_limits[j]);
+}
+
+bool SimControlBoard::setTarget(const int &j, const double &target)
+{
+    if (!isJoint(j))
+	return false;
+
+    // as in the real robot the command is ignored
+    // if the joint is not in position mode
+    if (modes[j] != VOCAB_CM_POSITION)
+	return false;
+
+    targets[j] = clamp(j, target);
+    is_motion_done[j] = false;
+
+    return true;
+}
+
+bool SimControlBoard::setVelocity(const int &j, const double &velocity)
+{
+    if (!isJoint(j))
+	return false;
+
+    if (modes[j] != VOCAB_CM_VELOCITY)
+	return false;
+
+    ref_velocities[j] = std::min(std::max(velocity, -max_velocity), max_velocity);
+
+    return true;
+}
+
+bool SimControlBoard::setMode(const int &j, const int &mode)
+{
+    if (!isJoint(j))
+	return false;
+
+    if (mode != VOCAB_CM_POSITION &&
+	mode != VOCAB_CM_VELOCITY &&
+	mode != VOCAB_CM_IDLE)
+    {
+	yError() << "SimControlBoard: control mode"
+		 << yarp::os::Vocab::decode(mode)
+		 << "not supported";
+	return false;
+    }
+
+    if (mode == modes[j])
+	return true;
+
+    // switching mode the joint stops where it is
+    targets[j] = positions[j];
+    is_motion_done[j] = true;
+    ref_velocities[j] = 0.0;
+    modes[j] = mode;
+
+    return true;
+}
+
+// IEncodersTimed
+
+bool SimControlBoard::getAxes(int *ax)
+{
+    *ax = joints;
+
+    return true;
+}
+
+bool SimControlBoard::resetEncoder(int j)
+{
+    return setEncoder(j, 0.0);
+}
+
+bool SimControlBoard::resetEncoders()
+{
+    for (int i = 0; i < joints; i++)
+	resetEncoder(i);
+
+    return true;
+}
+
+bool SimControlBoard::setEncoder(int j, double val)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    positions[j] = clamp(j, val);
+    targets[j] = positions[j];
+    is_motion_done[j] = true;
+
+    return true;
+}
+
+bool SimControlBoard::setEncoders(const double *vals)
+{
+    for (int i = 0; i < joints; i++)
+	setEncoder(i, vals[i]);
+
+    return true;
+}
+
+bool SimControlBoard::getEncoder(int j, double *v)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *v = positions[j];
+
+    return true;
+}
+
+bool SimControlBoard::getEncoders(double *encs)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(positions.begin(), positions.end(), encs);
+
+    return true;
+}
+
+bool SimControlBoard::getEncoderSpeed(int j, double *sp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *sp = velocities[j];
+
+    return true;
+}
+
+bool SimControlBoard::getEncoderSpeeds(double *spds)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(velocities.begin(), velocities.end(), spds);
+
+    return true;
+}
+
+bool SimControlBoard::getEncoderAcceleration(int j, double *spds)
+{
+    if (!isJoint(j))
+	return false;
+
+    *spds = 0.0;
+
+    return true;
+}
+
+bool SimControlBoard::getEncoderAccelerations(double *accs)
+{
+    std::fill(accs, accs + joints, 0.0);
+
+    return true;
+}
+
+bool SimControlBoard::getEncodersTimed(double *encs, double *time)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(positions.begin(), positions.end(), encs);
+    std::fill(time, time + joints, stamp);
+
+    return true;
+}
+
+bool SimControlBoard::getEncoderTimed(int j, double *encs, double *time)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *encs = positions[j];
+    *time = stamp;
+
+    return true;
+}
+
+// IPositionControl2
+
+bool SimControlBoard::positionMove(int j, double ref)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    return setTarget(j, ref);
+}
+
+bool SimControlBoard::positionMove(const double *refs)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < joints; i++)
+	ok &= setTarget(i, refs[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::positionMove(const int n_joint, const int *joints, const double *refs)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= setTarget(joints[i], refs[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::relativeMove(int j, double delta)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    return setTarget(j, targets[j] + delta);
+}
+
+bool SimControlBoard::relativeMove(const double *deltas)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < joints; i++)
+	ok &= setTarget(i, targets[i] + deltas[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::relativeMove(const int n_joint, const int *joints, const double *deltas)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+    {
+	if (!isJoint(joints[i]))
+	    return false;
+	ok &= setTarget(joints[i], targets[joints[i]] + deltas[i]);
+    }
+
+    return ok;
+}
+
+bool SimControlBoard::checkMotionDone(int j, bool *flag)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *flag = is_motion_done[j];
+
+    return true;
+}
+
+bool SimControlBoard::checkMotionDone(bool *flag)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *flag = std::all_of(is_motion_done.begin(), is_motion_done.end(),
+			[](bool done){ return done; });
+
+    return true;
+}
+
+bool SimControlBoard::checkMotionDone(const int n_joint, const int *joints, bool *flag)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    *flag = true;
+    for (int i = 0; i < n_joint; i++)
+    {
+	if (!isJoint(joints[i]))
+	    return false;
+	*flag &= is_motion_done[joints[i]];
+    }
+
+    return true;
+}
+
+bool SimControlBoard::setRefSpeed(int j, double sp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    ref_speeds[j] = std::min(std::abs(sp), max_velocity);
+
+    return true;
+}
+
+bool SimControlBoard::setRefSpeeds(const double *spds)
+{
+    for (int i = 0; i < joints; i++)
+	setRefSpeed(i, spds[i]);
+
+    return true;
+}
+
+bool SimControlBoard::setRefSpeeds(const int n_joint, const int *joints, const double *spds)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= setRefSpeed(joints[i], spds[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::setRefAcceleration(int j, double acc)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    ref_accelerations[j] = acc;
+
+    return true;
+}
+
+bool SimControlBoard::setRefAccelerations(const double *accs)
+{
+    for (int i = 0; i < joints; i++)
+	setRefAcceleration(i, accs[i]);
+
+    return true;
+}
+
+bool SimControlBoard::setRefAccelerations(const int n_joint, const int *joints, const double *accs)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= setRefAcceleration(joints[i], accs[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::getRefSpeed(int j, double *ref)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *ref = ref_speeds[j];
+
+    return true;
+}
+
+bool SimControlBoard::getRefSpeeds(double *spds)
+{
+    for (int i = 0; i < joints; i++)
+	getRefSpeed(i, &spds[i]);
+
+    return true;
+}
+
+bool SimControlBoard::getRefSpeeds(const int n_joint, const int *joints, double *spds)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= getRefSpeed(joints[i], &spds[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::getRefAcceleration(int j, double *acc)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *acc = ref_accelerations[j];
+
+    return true;
+}
+
+bool SimControlBoard::getRefAccelerations(double *accs)
+{
+    for (int i = 0; i < joints; i++)
+	getRefAcceleration(i, &accs[i]);
+
+    return true;
+}
+
+bool SimControlBoard::getRefAccelerations(const int n_joint, const int *joints, double *accs)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= getRefAcceleration(joints[i], &accs[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::stop(int j)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    targets[j] = positions[j];
+    is_motion_done[j] = true;
+    ref_velocities[j] = 0.0;
+
+    return true;
+}
+
+bool SimControlBoard::stop()
+{
+    for (int i = 0; i < joints; i++)
+	stop(i);
+
+    return true;
+}
+
+bool SimControlBoard::stop(const int n_joint, const int *joints)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= stop(joints[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::getTargetPosition(const int joint, double *ref)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(joint))
+	return false;
+
+    *ref = targets[joint];
+
+    return true;
+}
+
+bool SimControlBoard::getTargetPositions(double *refs)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(targets.begin(), targets.end(), refs);
+
+    return true;
+}
+
+bool SimControlBoard::getTargetPositions(const int n_joint, const int *joints, double *refs)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= getTargetPosition(joints[i], &refs[i]);
+
+    return ok;
+}
+
+// IVelocityControl2
+
+bool SimControlBoard::velocityMove(int j, double sp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    return setVelocity(j, sp);
+}
+
+bool SimControlBoard::velocityMove(const double *sp)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < joints; i++)
+	ok &= setVelocity(i, sp[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::velocityMove(const int n_joint, const int *joints, const double *spds)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= setVelocity(joints[i], spds[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::getRefVelocity(const int joint, double *vel)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(joint))
+	return false;
+
+    *vel = ref_velocities[joint];
+
+    return true;
+}
+
+bool SimControlBoard::getRefVelocities(double *vels)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(ref_velocities.begin(), ref_velocities.end(), vels);
+
+    return true;
+}
+
+bool SimControlBoard::getRefVelocities(const int n_joint, const int *joints, double *vels)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= getRefVelocity(joints[i], &vels[i]);
+
+    return ok;
+}
+
+// IControlMode2
+
+bool SimControlBoard::getControlMode(int j, int *mode)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    if (!isJoint(j))
+	return false;
+
+    *mode = modes[j];
+
+    return true;
+}
+
+bool SimControlBoard::getControlModes(int *modes)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    std::copy(this->modes.begin(), this->modes.end(), modes);
+
+    return true;
+}
+
+bool SimControlBoard::getControlModes(const int n_joint, const int *joints, int *modes)
+{
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= getControlMode(joints[i], &modes[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::setControlMode(const int j, const int mode)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    return setMode(j, mode);
+}
+
+bool SimControlBoard::setControlModes(const int n_joint, const int *joints, int *modes)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < n_joint; i++)
+	ok &= setMode(joints[i], modes[i]);
+
+    return ok;
+}
+
+bool SimControlBoard::setControlModes(int *modes)
+{
+    yarp::os::LockGuard lg(mutex);
+
+    bool ok = true;
+    for (int i = 0; i < joints; i++)
+	ok &= setMode(i, modes[i]);
+
+    return ok;
+}
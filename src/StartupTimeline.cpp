@@ -0,0 +1,98 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+// yarp
+#include <yarp/os/LogStream.h>
+#include <yarp/os/SystemClock.h>
+
+// std
+#include <algorithm>
+#include <cstdio>
+
+#include "headers/StartupTimeline.h"
+
+bool waitWithBackoff(const std::function<bool()> &probe, const double &timeout,
+		     const double &initial_delay, const double &max_delay)
+{
+    double t0 = yarp::os::SystemClock::nowSystem();
+    double delay = initial_delay;
+    while (true)
+    {
+	if (probe())
+	    return true;
+
+	double remaining = t0 + timeout - yarp::os::SystemClock::nowSystem();
+	if (remaining <= 0.0)
+	    return false;
+
+	yarp::os::SystemClock::delaySystem(std::min(delay, remaining));
+	delay = std::min(2.0 * delay, max_delay);
+    }
+}
+
+StartupTimeline::StartupTimeline(const std::string &owner) :
+    owner(owner),
+    origin(yarp::os::SystemClock::nowSystem())
+{
+}
+
+std::size_t StartupTimeline::begin(const std::string &name)
+{
+    Step step;
+    step.name = name;
+    step.start = yarp::os::SystemClock::nowSystem() - origin;
+    step.end = step.start;
+    step.is_done = false;
+    step.is_ok = false;
+
+    mutex.lock();
+    steps.push_back(step);
+    std::size_t index = steps.size() - 1;
+    mutex.unlock();
+
+    return index;
+}
+
+void StartupTimeline::end(const std::size_t &step, const bool &is_ok)
+{
+    double now = yarp::os::SystemClock::nowSystem() - origin;
+
+    mutex.lock();
+    if (step < steps.size())
+    {
+	steps[step].end = now;
+	steps[step].is_done = true;
+	steps[step].is_ok = is_ok;
+    }
+    mutex.unlock();
+}
+
+void StartupTimeline::report() const
+{
+    double now = yarp::os::SystemClock::nowSystem() - origin;
+
+    mutex.lock();
+    yInfo() << owner + ": startup timeline";
+    for (const Step &step : steps)
+    {
+	char line[160];
+	const char *result = !step.is_done ? "running" : (step.is_ok ? "ok" : "failed");
+	double end = step.is_done ? step.end : now;
+	std::snprintf(line, sizeof(line), "%-28s %8.3f s -> %8.3f s (%7.3f s) %s",
+		      step.name.c_str(), step.start, end, end - step.start, result);
+	yInfo() << owner + ":" << line;
+    }
+    mutex.unlock();
+
+    char line[64];
+    std::snprintf(line, sizeof(line), "startup took %.3f s", now);
+    yInfo() << owner + ":" << line;
+}
@@ -10,37 +10,30 @@
  */
 
 // yarp
-#include <yarp/math/Math.h>
 #include <yarp/sig/Vector.h>
 
-#include <cmath>
-
 #include "headers/TrajectoryGenerator.h"
 
-using namespace yarp::math;
-
 TrajectoryGenerator::TrajectoryGenerator()
 {
     // clear initial and final position
-    pos_i.resize(3, 0.0);
-    pos_f.resize(3, 0.0);
+    for (int i = 0; i < 3; i++)
+    {
+	pos_i[i] = 0.0;
+	pos_f[i] = 0.0;
+    }
 
     // clear trajectory duration
     traj_duration = 1.0;
-
-    // clear trajectory constants
-    a0.resize(3, 0.0);
-    a3.resize(3, 0.0);
-    a4.resize(3, 0.0);
-    a5.resize(3, 0.0);    
 }
 
 bool TrajectoryGenerator::setInitialPosition(const yarp::sig::Vector &pos)
 {
     if (pos.size() != 3)
 	return false;
-    
-    pos_i = pos;
+
+    for (int i = 0; i < 3; i++)
+	pos_i[i] = pos[i];
 
     return true;
 }
@@ -49,8 +42,9 @@ bool TrajectoryGenerator::setFinalPosition(const yarp::sig::Vector &pos)
 {
     if (pos.size() != 3)
 	return false;
-    
-    pos_f = pos;
+
+    for (int i = 0; i < 3; i++)
+	pos_f[i] = pos[i];
 
     return true;
 }
@@ -67,42 +61,26 @@ bool TrajectoryGenerator::setDuration(const double &duration)
 
 void TrajectoryGenerator::init()
 {
-    // set initial conditions
-    a0 = pos_i;
-
-    // set difference between initial
-    // and final conditions
-    a5 = a4 = a3 = a0 - pos_f;
-
     // eval the polynomial trajectory constants
-    a3 *= (-10.0 / pow(traj_duration, 3));
-    a4 *= (15.0 / pow(traj_duration, 4));
-    a5 *= (-6.0 / pow(traj_duration, 5));
+    trajectory.setRestToRest(pos_i, pos_f, RestToRestQuintic(traj_duration));
 }
 
 bool TrajectoryGenerator::getTrajectory(const double &time,
                                         yarp::sig::Vector &position,
 					yarp::sig::Vector &velocity)
 {
-    // check for negative times
-    if (time < 0)
-	return false;
-    
-    // enforce duration of the trajectory
-    double t = time;
-    if (t > traj_duration)
-	t = traj_duration;
-    
-    // eval current position
-    position = a0
-	     + a3 * pow(t, 3.0)
-	     + a4 * pow(t, 4.0)
-	     + a5 * pow(t, 5.0);
-
-    // eval current velocity
-    velocity = 3.0 * a3 * pow(t, 2.0)
-	     + 4.0 * a4 * pow(t, 3.0)
-	     + 5.0 * a5 * pow(t, 4.0);
+    // the vectors are resized only if required
+    if (position.size() != 3)
+	position.resize(3);
+    if (velocity.size() != 3)
+	velocity.resize(3);
+
+    // the time is saturated at the duration of the trajectory
+    return trajectory.evaluate(time, position.data(), velocity.data());
+}
 
-    return true;
+bool TrajectoryGenerator::getTrajectory(const double *times, const std::size_t &count,
+					double *positions, double *velocities) const
+{
+    return trajectory.evaluate(times, count, positions, velocities);
 }
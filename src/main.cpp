@@ -12,41 +12,57 @@
 // std
 #include <string>
 #include <map>
+#include <deque>
+#include <set>
+#include <vector>
+#include <memory>
 #include <unordered_map>
+#include <thread>
 
 // yarp os
 #include <yarp/os/BufferedPort.h>
+#include <yarp/os/Network.h>
 #include <yarp/os/ResourceFinder.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/Vocab.h>
 #include <yarp/os/LogStream.h>
 #include <yarp/os/RpcClient.h>
+#include <yarp/os/SystemClock.h>
 
 // yarp sig
 #include <yarp/sig/Vector.h>
 #include <yarp/sig/Matrix.h>
 
+// yarp dev
+#include <yarp/dev/Drivers.h>
+
 // yarp math
 #include <yarp/math/Math.h>
 
-// yarp dev
-#include <yarp/dev/IFrameTransform.h>
-#include <yarp/dev/PolyDriver.h>
-
 #include <cmath>
+#include <algorithm>
+#include <atomic>
 
 #include "headers/filterCommand.h"
 #include "headers/ArmController.h"
 #include "headers/ModelHelper.h"
 #include "headers/HandControlCommand.h"
 #include "headers/HandControlResponse.h"
-#include "headers/TrajectoryGenerator.h"
+#include "headers/JerkLimitedTrajectory.h"
 #include "headers/RotationTrajectoryGenerator.h"
+#include "headers/EstimateCache.h"
+#include "headers/EventQueue.h"
+#include "headers/Pipeline.h"
+#include "headers/LatencyHistogram.h"
+#include "headers/SpscQueue.h"
+#include "headers/ClockParticipant.h"
+#include "headers/ObjectRegistry.h"
+#include "headers/SimCartesianController.h"
+#include "headers/StartupTimeline.h"
 
 using namespace yarp::math;
 
 enum class Status { Idle,
-	            Localize,
 	            MoveLeftUpward,
 	            ArmApproach, WaitArmApproachDone,
                     FingersApproach, WaitFingersApproachDone,
@@ -56,6 +72,82 @@ enum class Status { Idle,
 	            FingersRestore, WaitFingersRestoreDone,
 	            Stop };
 
+/*
+ * State of the phases executed by one arm and the corresponding hand.
+ * The executors of the two arms run concurrently within the RFModule thread.
+ */
+struct ArmExecutor
+{
+    // the arm and hand controlled by this executor
+    std::string hand;
+
+    // status
+    Status status;
+    Status previous_status;
+    bool is_approach_done;
+    bool is_timer_started;
+    bool approach_corner;
+
+    // whether the last phase failed
+    bool is_phase_failed;
+
+    // object the current phase acts on
+    std::string object;
+
+    // last time
+    // required to implement timeouts
+    double last_time;
+
+    // time of the last command sent to the hand control module
+    double fingers_command_time;
+
+    // timing instrumentation
+    double last_cycle_start;
+    bool is_streaming;
+    Status timed_status;
+    double status_start_time;
+
+    // snapshot of the status published for the rpc thread
+    std::atomic<Status> published_status;
+};
+
+enum class ModuleCommandType { Phase, Pipeline, Stop };
+
+struct ModuleCommand
+{
+    ModuleCommandType type;
+
+    // the phase, i.e. the corresponding rpc command,
+    // or the arm to be stopped, empty to stop both arms
+    std::string phase;
+
+    // the steps of a pipeline
+    std::deque<PipelineStep> steps;
+
+    // the id of a pipeline
+    int pipeline_id;
+
+    // the object the phase or the pipeline acts on
+    std::string object;
+};
+
+/*
+ * Object of the scene tracked by the module.
+ */
+struct TrackedObject
+{
+    ObjectDescription description;
+
+    // estimates published by the filter
+    // received from the FrameTransformServer
+    EstimateCache cache;
+
+    // last estimate published by the filter
+    yarp::sig::Matrix estimate;
+    bool is_estimate_available;
+    double estimate_time;
+};
+
 class VisTacLocSimModule: public yarp::os::RFModule
 {
 protected:
@@ -67,45 +159,111 @@ protected:
     yarp::os::RpcClient port_hand_right;
     yarp::os::RpcClient port_hand_left;
 
+    // events waking up the module
+    EventQueue events;
+
+    // completion of the motion of the arms
+    ArmMotionDoneEvent right_arm_done{events, "right"};
+    ArmMotionDoneEvent left_arm_done{events, "left"};
+    std::map<std::string, bool> arm_events_enabled;
+
+    // completion of the motion of the fingers
+    HandStatusPort port_hand_status_right;
+    HandStatusPort port_hand_status_left;
+
+    // period used to stream velocities and
+    // to poll the status when events are not available
+    double tick_period;
+
+    // participant of the stepped clock, if any
+    ClockParticipant clock;
+
     // filter port
     yarp::os::BufferedPort<yarp::sig::FilterCommand> port_filter;
 
-    // last estimate published by the filter
-    yarp::sig::Matrix estimate;
-    bool is_estimate_available;
+    // objects of the scene
+    // all the objects are tracked concurrently
+    ObjectRegistry registry;
+    std::map<std::string, std::unique_ptr<TrackedObject>> objects;
+
+    // estimates of all the objects
+    // received from the FrameTransformServer
+    EstimateSubscriber port_estimate;
 
-    // FrameTransformClient to read published poses
-    yarp::dev::PolyDriver drv_transform_client;
-    yarp::dev::IFrameTransform* tf_client;
+    // estimates older than this are not available,
+    // e.g. if the filter stopped publishing
+    double max_estimate_age;
 
     // model helper class
     ModelHelper mod_helper;
 
-    // trajectory generator
-    TrajectoryGenerator traj_gen;
+    // trajectory generators
+    JerkLimitedTrajectory push_traj;
     RotationTrajectoryGenerator rot_traj_gen;
 
+    // waypoints of the pushing phase
+    // expressed as offsets from the initial position of the finger
+    std::vector<yarp::sig::Vector> push_offsets;
+    std::vector<yarp::sig::Vector> push_waypoints;
+
+    // storage of the trajectory sampled while pushing
+    // and of the pose of the finger while rotating
+    // reused in order not to allocate at each tick
+    yarp::sig::Vector traj_pos;
+    yarp::sig::Vector traj_vel;
+    yarp::sig::Vector traj_att;
+
     // default trajectory length
     double trajectory_duration;
 
     // rpc server
     yarp::os::RpcServer rpc_port;
 
-    // mutexes required to share data between
-    // the RFModule thread and the rpc thread
-    yarp::os::Mutex mutex;
-
-    // status
-    Status status;
-    Status previous_status;
-    std::string current_hand;
-    bool is_approach_done;
-    bool is_timer_started;
-    bool approach_corner;
-
-    // last time
-    // required to implement timeouts
-    double last_time;
+    // commands sent from the rpc thread to the RFModule thread
+    SpscQueue<ModuleCommand> commands{16};
+
+    // snapshot of the status of the pipeline published
+    // by the RFModule thread for the rpc thread
+    std::atomic<PipelineState> published_pipeline_state;
+    std::atomic<int> published_pipeline_step;
+    std::atomic<int> published_pipeline_length;
+    std::atomic<int> published_pipeline_id;
+
+    // id of the next pipeline, owned by the rpc thread
+    int next_pipeline_id;
+
+    // executors of the phases of each arm
+    // owned by the RFModule thread
+    ArmExecutor right_executor;
+    ArmExecutor left_executor;
+
+    // steps of the pipeline still to be executed
+    // the pipeline coordinates the executors of both arms
+    std::deque<PipelineStep> pipeline;
+    std::size_t pipeline_length;
+    PipelineState pipeline_state;
+    int pipeline_id;
+
+    // object the pipeline acts on
+    std::string pipeline_object;
+
+    // condition being waited by the pipeline
+    PipelineStep condition;
+    bool is_waiting_condition;
+    bool is_condition_failed;
+    double condition_start_time;
+    double condition_start_system_time;
+
+    // reference used to check the convergence of the estimate
+    yarp::sig::Vector convergence_ref;
+    double convergence_ref_time;
+
+    // timing instrumentation
+    // durations are measured on the system clock
+    LatencyStats stats;
+    yarp::os::BufferedPort<yarp::os::Bottle> port_stats;
+    double stats_period;
+    double last_stats_time;
 
     /*
      * Send command to the filtering algorithm.
@@ -139,41 +297,840 @@ protected:
 		filter_cmd.enableTactileFiltering();
 	}
 
-	// send command to the filter
-	port_filter.writeStrict();
-
-	return true;
+	// send command to the filter
+	port_filter.writeStrict();
+
+	return true;
+    }
+
+    /*
+     * Return the name of a status.
+     * @param curr_status the status
+     */
+    std::string getStatusName(const Status &curr_status)
+    {
+	switch (curr_status)
+	{
+	case Status::Idle: return "Idle";
+	case Status::MoveLeftUpward: return "MoveLeftUpward";
+	case Status::ArmApproach: return "ArmApproach";
+	case Status::WaitArmApproachDone: return "WaitArmApproachDone";
+	case Status::FingersApproach: return "FingersApproach";
+	case Status::WaitFingersApproachDone: return "WaitFingersApproachDone";
+	case Status::PrepareRotation: return "PrepareRotation";
+	case Status::PerformRotation: return "PerformRotation";
+	case Status::PreparePush: return "PreparePush";
+	case Status::PerformPush: return "PerformPush";
+	case Status::ArmRestore: return "ArmRestore";
+	case Status::WaitArmRestoreDone: return "WaitArmRestoreDone";
+	case Status::FingersRestore: return "FingersRestore";
+	case Status::WaitFingersRestoreDone: return "WaitFingersRestoreDone";
+	case Status::Stop: return "Stop";
+	}
+
+	return "";
+    }
+
+    /*
+     * Add the histograms used by the timing instrumentation.
+     */
+    void configureStats()
+    {
+	// duration of the processing of updateModule
+	// and jitter of the period while streaming velocities
+	stats.add("cycle");
+	stats.add("cycle-jitter");
+
+	// duration of each status
+	for (int i = static_cast<int>(Status::Idle); i <= static_cast<int>(Status::Stop); i++)
+	    stats.add("status/" + getStatusName(static_cast<Status>(i)));
+	stats.add("status/WaitCondition");
+
+	// latency of the requests to the hand control modules
+	stats.add("rpc/hand/right");
+	stats.add("rpc/hand/left");
+
+	// latency of the requests to the cartesian controllers
+	stats.add("rpc/cartesian/approach");
+	stats.add("rpc/cartesian/check-motion-done");
+	stats.add("rpc/cartesian/go-home");
+	stats.add("rpc/cartesian/prepare");
+	stats.add("rpc/cartesian/set-velocities");
+	stats.add("rpc/cartesian/stop");
+
+	// age of the estimate when it is used
+	stats.add("estimate/age");
+    }
+
+    /*
+     * Update the timing instrumentation of an executor
+     * at the beginning of a cycle.
+     * @param executor the executor
+     * @param cycle_start the beginning of the cycle
+     * @return true if the executor went back to Idle
+     */
+    bool updateStats(ArmExecutor &executor, const double &cycle_start)
+    {
+	// jitter of the period while streaming velocities
+	if (executor.status == Status::PerformPush ||
+	    executor.status == Status::PerformRotation)
+	{
+	    if (executor.is_streaming)
+		stats.record("cycle-jitter",
+			     std::abs(cycle_start - executor.last_cycle_start - tick_period));
+
+	    executor.is_streaming = true;
+	    executor.last_cycle_start = cycle_start;
+	}
+	else
+	    executor.is_streaming = false;
+
+	// duration of the last status
+	bool is_phase_end = false;
+	if (executor.status != executor.timed_status)
+	{
+	    stats.record("status/" + getStatusName(executor.timed_status),
+			 cycle_start - executor.status_start_time);
+
+	    executor.timed_status = executor.status;
+	    executor.status_start_time = cycle_start;
+
+	    is_phase_end = executor.status == Status::Idle;
+	}
+
+	return is_phase_end;
+    }
+
+    /*
+     * Update the timing instrumentation at the beginning of a cycle.
+     * @param cycle_start the beginning of the cycle
+     */
+    void updateStats(const double &cycle_start)
+    {
+	bool is_phase_end = updateStats(right_executor, cycle_start);
+	is_phase_end |= updateStats(left_executor, cycle_start);
+
+	// publish the aggregates periodically
+	// and at the end of each phase
+	if (is_phase_end || (cycle_start - last_stats_time > stats_period))
+	{
+	    yarp::os::Bottle &bottle = port_stats.prepare();
+	    bottle.clear();
+	    stats.toBottle(bottle);
+	    port_stats.write();
+
+	    last_stats_time = cycle_start;
+	}
+    }
+
+    /*
+     * Get the executor of an arm.
+     * @param which_arm the arm
+     * @return a pointer to the executor in case of success,
+     *         a null pointer in case of failure
+     */
+    ArmExecutor* getExecutor(const std::string &which_arm)
+    {
+	if (which_arm == "right")
+	    return &right_executor;
+	else if (which_arm == "left")
+	    return &left_executor;
+	else
+	    return nullptr;
+    }
+
+    /*
+     * Get a tracked object.
+     * @param id the id of the object
+     * @return a pointer to the object in case of success,
+     *         a null pointer in case of failure
+     */
+    TrackedObject* getObject(const std::string &id)
+    {
+	auto item = objects.find(id);
+	if (item == objects.end())
+	    return nullptr;
+
+	return item->second.get();
+    }
+
+    /*
+     * Reset the status of an executor.
+     * @param executor the executor
+     * @param which_arm the arm controlled by the executor
+     */
+    void resetExecutor(ArmExecutor &executor, const std::string &which_arm)
+    {
+	executor.hand = which_arm;
+	executor.status = Status::Idle;
+	executor.previous_status = Status::Idle;
+	executor.is_approach_done = false;
+	executor.is_timer_started = false;
+	executor.approach_corner = false;
+	executor.is_phase_failed = false;
+	executor.object = registry.getDefaultObject();
+	executor.last_time = 0.0;
+	executor.fingers_command_time = 0.0;
+	executor.last_cycle_start = 0.0;
+	executor.is_streaming = false;
+	executor.timed_status = Status::Idle;
+	executor.status_start_time = yarp::os::SystemClock::nowSystem();
+	executor.published_status = Status::Idle;
+    }
+
+    /*
+     * Get the arms required by a phase.
+     * @param phase the phase, i.e. the corresponding rpc command
+     * @param arms the arms required by the phase,
+     *        empty if the phase requires both arms to be idle
+     *        without using them
+     * @return true if the phase exists, false otherwise
+     */
+    bool getPhaseArms(const std::string &phase, std::vector<std::string> &arms)
+    {
+	arms.clear();
+
+	if (phase == "localize")
+	    return true;
+	else if (phase == "home-both")
+	    arms = {"right", "left"};
+	else if (phase == "move-left-upward" ||
+		 phase == "home-left" ||
+		 phase == "approach-with-left")
+	    arms = {"left"};
+	else if (phase == "home-right" ||
+		 phase == "approach-with-right" ||
+		 phase == "approach-corner-with-right" ||
+		 phase == "push-with-right" ||
+		 phase == "rotate-with-right")
+	    arms = {"right"};
+	else
+	    return false;
+
+	return true;
+    }
+
+    /*
+     * Check if a command corresponds to a phase.
+     * @param cmd the command
+     */
+    bool isPhase(const std::string &cmd)
+    {
+	std::vector<std::string> arms;
+
+	return getPhaseArms(cmd, arms);
+    }
+
+    /*
+     * Check if a phase requires the estimate of the object.
+     * @param phase the phase, i.e. the corresponding rpc command
+     */
+    bool isPhaseUsingEstimate(const std::string &phase)
+    {
+	return (phase == "localize" ||
+		phase == "approach-with-right" ||
+		phase == "approach-corner-with-right" ||
+		phase == "approach-with-left" ||
+		phase == "rotate-with-right");
+    }
+
+    /*
+     * Check if the arms required by some phases are distinct.
+     * @param phases the phases
+     * @return true if no arm is shared
+     */
+    bool arePhasesIndependent(const std::vector<std::string> &phases)
+    {
+	std::set<std::string> used;
+	for (const std::string &phase : phases)
+	{
+	    std::vector<std::string> arms;
+	    if (!getPhaseArms(phase, arms))
+		return false;
+
+	    // phases that do not use arms require both arms idle
+	    if (arms.empty())
+		arms = {"right", "left"};
+
+	    for (const std::string &arm : arms)
+	    {
+		if (!used.insert(arm).second)
+		    return false;
+	    }
+	}
+
+	return true;
+    }
+
+    /*
+     * Return the reply to the rpc command of a phase.
+     * @param phase the phase, i.e. the corresponding rpc command
+     */
+    std::string getPhaseMessage(const std::string &phase)
+    {
+	if (phase == "move-left-upward")
+	    return "Command issued.";
+	else if (phase == "home-right")
+	    return "Home right issued.";
+	else if (phase == "home-left")
+	    return "Home left issued.";
+	else if (phase == "home-both")
+	    return "Home both issued.";
+	else if (phase == "localize")
+	    return "Localization issued.";
+	else if (phase == "approach-with-right" ||
+		 phase == "approach-corner-with-right")
+	    return "Approach with right-arm issued.";
+	else if (phase == "approach-with-left")
+	    return "Approach with left-arm issued.";
+	else if (phase == "push-with-right")
+	    return "Push with right-arm issued.";
+	else if (phase == "rotate-with-right")
+	    return "Rotation with right-arm issued.";
+
+	return "";
+    }
+
+    /*
+     * Return the name of the state of a pipeline.
+     * @param state the state
+     */
+    std::string getPipelineStateName(const PipelineState &state)
+    {
+	switch (state)
+	{
+	case PipelineState::Idle: return "idle";
+	case PipelineState::Running: return "running";
+	case PipelineState::Done: return "done";
+	case PipelineState::Failed: return "failed";
+	case PipelineState::Stopped: return "stopped";
+	}
+
+	return "";
+    }
+
+    /*
+     * Check if an arm is busy, i.e. it is executing a phase
+     * or a pipeline is running.
+     * @param which_arm the arm
+     * @param use_snapshot whether to use the snapshot published for the rpc thread
+     */
+    bool isArmBusy(const std::string &which_arm, const bool &use_snapshot)
+    {
+	ArmExecutor *executor = getExecutor(which_arm);
+
+	if (use_snapshot)
+	    return (executor->published_status != Status::Idle) ||
+		(published_pipeline_state == PipelineState::Running);
+
+	return (executor->status != Status::Idle) ||
+	    (pipeline_state == PipelineState::Running);
+    }
+
+    /*
+     * Check if the arms required by a phase are busy.
+     * @param phase the phase
+     * @param use_snapshot whether to use the snapshot published for the rpc thread
+     */
+    bool isPhaseBusy(const std::string &phase, const bool &use_snapshot)
+    {
+	std::vector<std::string> arms;
+	getPhaseArms(phase, arms);
+
+	// phases that do not use arms require both arms idle
+	if (arms.empty())
+	    arms = {"right", "left"};
+
+	for (const std::string &arm : arms)
+	{
+	    if (isArmBusy(arm, use_snapshot))
+		return true;
+	}
+
+	return false;
+    }
+
+    /*
+     * Check if an object can be the target of a command.
+     * @param id the id of the object
+     * @param use_estimate whether the command requires the estimate of the object
+     * @param error a description of the error, if any
+     * @return true if the object can be used
+     */
+    bool checkObject(const std::string &id, const bool &use_estimate, std::string &error)
+    {
+	const ObjectDescription *object = registry.find(id);
+	if (object == nullptr)
+	    error = "Unknown object " + id + "!";
+	else if (use_estimate && object->estimate_frame.empty())
+	    error = "Object " + id + " is not localized!";
+	else
+	    return true;
+
+	return false;
+    }
+
+    /*
+     * Issue a phase.
+     * @param phase the phase, i.e. the corresponding rpc command
+     * @param object the object the phase acts on
+     */
+    void issuePhase(const std::string &phase, const std::string &object)
+    {
+	if (phase == "localize")
+	{
+	    // issue localization
+	    sendCommandToFilter(true, "visual");
+
+	    return;
+	}
+	else if (phase == "home-both")
+	{
+	    // both arms are restored concurrently
+	    issuePhase("home-right", object);
+	    issuePhase("home-left", object);
+
+	    return;
+	}
+
+	std::vector<std::string> arms;
+	if (!getPhaseArms(phase, arms) || arms.size() != 1)
+	    return;
+	ArmExecutor &executor = *getExecutor(arms[0]);
+
+	executor.previous_status = executor.status;
+	executor.object = object;
+
+	if (phase == "move-left-upward")
+	{
+	    executor.status = Status::MoveLeftUpward;
+	}
+	else if (phase == "home-right" || phase == "home-left")
+	{
+	    executor.status = Status::FingersRestore;
+	}
+	else if (phase == "approach-with-right" ||
+		 phase == "approach-corner-with-right" ||
+		 phase == "approach-with-left")
+	{
+	    executor.status = Status::ArmApproach;
+
+	    if (phase == "approach-corner-with-right")
+		executor.approach_corner = true;
+	}
+	else if (phase == "push-with-right")
+	{
+	    executor.status = Status::PreparePush;
+	}
+	else if (phase == "rotate-with-right")
+	{
+	    executor.status = Status::PrepareRotation;
+	}
+
+	// reset flag
+	executor.is_phase_failed = false;
+    }
+
+    /*
+     * Stop the executor of an arm.
+     * @param executor the executor
+     */
+    void stopExecutor(ArmExecutor &executor)
+    {
+	// keep the status preceding the first stop
+	if (executor.status != Status::Stop)
+	{
+	    executor.previous_status = executor.status;
+	    executor.status = Status::Stop;
+	}
+    }
+
+    /*
+     * Apply the commands received from the rpc thread.
+     */
+    void processCommands()
+    {
+	ModuleCommand command;
+	while (commands.pop(command))
+	{
+	    switch (command.type)
+	    {
+	    case ModuleCommandType::Phase:
+	    {
+		// the rpc thread checks the published status,
+		// still a command might be received while busy
+		if (isPhaseBusy(command.phase, false))
+		{
+		    yWarning() << "VisTacLocSimModule: command received while busy, ignored";
+		    break;
+		}
+
+		issuePhase(command.phase, command.object);
+
+		break;
+	    }
+
+	    case ModuleCommandType::Pipeline:
+	    {
+		if (isArmBusy("right", false) || isArmBusy("left", false))
+		{
+		    yWarning() << "VisTacLocSimModule: command received while busy, ignored";
+
+		    // the pipeline is reported as failed
+		    // only if the current one is not running
+		    if (pipeline_state != PipelineState::Running)
+		    {
+			pipeline_id = command.pipeline_id;
+			pipeline_length = 0;
+			pipeline_state = PipelineState::Failed;
+		    }
+
+		    break;
+		}
+
+		pipeline = std::move(command.steps);
+		pipeline_length = pipeline.size();
+		pipeline_state = PipelineState::Running;
+		pipeline_id = command.pipeline_id;
+		pipeline_object = command.object;
+		is_waiting_condition = false;
+		is_condition_failed = false;
+		right_executor.is_phase_failed = false;
+		left_executor.is_phase_failed = false;
+
+		break;
+	    }
+
+	    case ModuleCommandType::Stop:
+	    {
+		// stop the required arms
+		if (command.phase != "left")
+		    stopExecutor(right_executor);
+		if (command.phase != "right")
+		    stopExecutor(left_executor);
+
+		// abort the pipeline
+		if (pipeline_state == PipelineState::Running)
+		    pipeline_state = PipelineState::Stopped;
+		pipeline.clear();
+		is_waiting_condition = false;
+
+		break;
+	    }
+	    }
+	}
+    }
+
+    /*
+     * Publish a snapshot of the status for the rpc thread.
+     */
+    void publishStatus()
+    {
+	published_pipeline_step = static_cast<int>(pipeline_length - pipeline.size());
+	published_pipeline_length = static_cast<int>(pipeline_length);
+	published_pipeline_state = pipeline_state;
+	published_pipeline_id = pipeline_id;
+	right_executor.published_status = right_executor.status;
+	left_executor.published_status = left_executor.status;
+    }
+
+    /*
+     * Execute the next step of the pipeline, if any.
+     */
+    void runPipeline()
+    {
+	if (pipeline_state != PipelineState::Running)
+	    return;
+
+	// wait for the completion of the current step
+	if (is_waiting_condition ||
+	    right_executor.status != Status::Idle ||
+	    left_executor.status != Status::Idle)
+	    return;
+
+	// abort the pipeline if the last step failed
+	if (is_condition_failed ||
+	    right_executor.is_phase_failed ||
+	    left_executor.is_phase_failed)
+	{
+	    yError() << "VisTacLocSimModule: pipeline aborted at step"
+		     << pipeline_length - pipeline.size();
+
+	    pipeline.clear();
+	    pipeline_state = PipelineState::Failed;
+
+	    return;
+	}
+
+	// all the steps were executed
+	if (pipeline.empty())
+	{
+	    yInfo() << "VisTacLocSimModule: pipeline done";
+
+	    pipeline_state = PipelineState::Done;
+
+	    return;
+	}
+
+	PipelineStep step = pipeline.front();
+	pipeline.pop_front();
+
+	yInfo() << "VisTacLocSimModule: pipeline step"
+		<< pipeline_length - pipeline.size() << "of" << pipeline_length;
+
+	if (step.type == PipelineStepType::Phase)
+	    issuePhase(step.phase, pipeline_object);
+	else if (step.type == PipelineStepType::Parallel)
+	{
+	    // the phases use distinct arms
+	    // hence they are executed concurrently
+	    for (const std::string &phase : step.phases)
+		issuePhase(phase, pipeline_object);
+	}
+	else
+	{
+	    is_waiting_condition = true;
+	    is_condition_failed = false;
+
+	    condition = step;
+	    condition_start_time = yarp::os::Time::now();
+	    condition_start_system_time = yarp::os::SystemClock::nowSystem();
+	    convergence_ref.clear();
+	}
+    }
+
+    /*
+     * Check the condition waited by the pipeline.
+     */
+    void checkCondition()
+    {
+	if (!is_waiting_condition)
+	    return;
+
+	bool is_done = false;
+	bool is_timeout = (yarp::os::Time::now() - condition_start_time) > condition.duration;
+
+	if (condition.type == PipelineStepType::Wait)
+	    is_done = is_timeout;
+	else if (condition.type == PipelineStepType::WaitConvergence)
+	{
+	    is_done = checkEstimateConvergence(condition.tolerance, condition.window);
+
+	    if (!is_done && is_timeout)
+		yError() << "VisTacLocSimModule: the estimate did not converge within"
+			 << condition.duration << "seconds";
+	}
+
+	if (is_done || is_timeout)
+	{
+	    is_waiting_condition = false;
+	    is_condition_failed = !is_done;
+
+	    stats.record("status/WaitCondition",
+			 yarp::os::SystemClock::nowSystem() - condition_start_system_time);
+	}
+    }
+
+    /*
+     * Check if the estimate of the object of the pipeline
+     * converged, i.e. its position
+     * did not move more than the tolerance within the window.
+     * @param tolerance the tolerance in meters
+     * @param window the window in seconds
+     * @return true if the estimate converged
+     */
+    bool checkEstimateConvergence(const double &tolerance, const double &window)
+    {
+	TrackedObject *object = getObject(pipeline_object);
+	if (object == nullptr || !object->is_estimate_available)
+	    return false;
+
+	double now = yarp::os::Time::now();
+	yarp::sig::Vector pos = object->estimate.getCol(3).subVector(0, 2);
+
+	// restart the window when the estimate moves too much
+	if ((convergence_ref.size() == 0) ||
+	    (norm(pos - convergence_ref) > tolerance))
+	{
+	    convergence_ref = pos;
+	    convergence_ref_time = now;
+
+	    return false;
+	}
+
+	return (now - convergence_ref_time) >= window;
+    }
+
+    /*
+     * Get an arm controller.
+     * @param which_arm the required arm controller
+     * @return a pointer to the arm controller in case of success,
+     *         a null pointer in case of failure
+     */
+    ArmController* getArmController(const std::string &which_arm)
+    {
+	if (which_arm == "right")
+	    return &right_arm;
+	else if (which_arm == "left")
+	    return &left_arm;
+	else
+	    return nullptr;
+    }
+
+    /*
+     * Get a port connected to the hand controller module.
+     * @param which_hand the required hand control module
+     * @return true/false on success/failure
+     */
+    yarp::os::RpcClient* getHandPort(const std::string &which_hand)
+    {
+	if (which_hand == "right")
+	    return &port_hand_right;
+	else if (which_hand == "left")
+	    return &port_hand_left;
+	else
+	    return nullptr;
+    }
+
+    /*
+     * Get the port receiving the status of a hand controller module.
+     * @param which_hand the required hand control module
+     * @return a pointer to the port in case of success,
+     *         a null pointer in case of failure
+     */
+    HandStatusPort* getHandStatusPort(const std::string &which_hand)
+    {
+	if (which_hand == "right")
+	    return &port_hand_status_right;
+	else if (which_hand == "left")
+	    return &port_hand_status_left;
+	else
+	    return nullptr;
+    }
+
+    /*
+     * Check if the completion of the fingers motion
+     * is notified by the hand control module.
+     * @param which_hand which hand to ask for
+     */
+    bool areFingersEventsEnabled(const std::string &which_hand)
+    {
+	HandStatusPort* port = getHandStatusPort(which_hand);
+
+	return (port != nullptr) && (port->getInputCount() > 0);
+    }
+
+    /*
+     * Return the timeout of a status.
+     * @param curr_status the status
+     * @return the timeout in seconds, a negative value if none
+     */
+    double getTimeout(const Status &curr_status)
+    {
+	switch (curr_status)
+	{
+	case Status::WaitArmApproachDone:
+	case Status::WaitArmRestoreDone:
+	    return 5.0;
+	case Status::WaitFingersApproachDone:
+	case Status::WaitFingersRestoreDone:
+	    return 10.0;
+	default:
+	    return -1.0;
+	}
+    }
+
+    /*
+     * Return how long the module can sleep waiting for events
+     * before the status of an executor has to be processed again.
+     * @param executor the executor
+     * @return the time in seconds, a negative value to wait for events only
+     */
+    double getSleepTime(ArmExecutor &executor)
+    {
+	switch (executor.status)
+	{
+	case Status::Idle:
+	{
+	    // wake up on commands only
+	    return -1.0;
+	}
+
+	case Status::PerformPush:
+	case Status::PerformRotation:
+	{
+	    // velocities are streamed periodically
+	    return tick_period;
+	}
+
+	case Status::WaitArmApproachDone:
+	case Status::WaitArmRestoreDone:
+	case Status::WaitFingersApproachDone:
+	case Status::WaitFingersRestoreDone:
+	{
+	    bool is_arm = executor.status == Status::WaitArmApproachDone ||
+		executor.status == Status::WaitArmRestoreDone;
+	    bool events_enabled = is_arm ? arm_events_enabled[executor.hand] :
+		areFingersEventsEnabled(executor.hand);
+
+	    // poll the status if events are not available
+	    if (!events_enabled)
+		return tick_period;
+
+	    // otherwise wait until the timeout expires
+	    double remaining = executor.last_time + getTimeout(executor.status) -
+		yarp::os::Time::now();
+	    return std::max(remaining, 0.0);
+	}
+
+	default:
+	{
+	    // other statuses issue commands and
+	    // are processed immediately
+	    return 0.0;
+	}
+	}
     }
 
     /*
-     * Get an arm controller.
-     * @param which_arm the required arm controller
-     * @return a pointer to the arm controller in case of success,
-     *         a null pointer in case of failure
+     * Return how long the module can sleep waiting for events
+     * before the executors or the pipeline have to be processed again.
+     * @return the time in seconds, a negative value to wait for events only
      */
-    ArmController* getArmController(const std::string &which_arm)
+    double getSleepTime()
     {
-	if (which_arm == "right")
-	    return &right_arm;
-	else if (which_arm == "left")
-	    return &left_arm;
-	else
-	    return nullptr;
-    }
+	std::vector<double> sleep_times;
+	sleep_times.push_back(getSleepTime(right_executor));
+	sleep_times.push_back(getSleepTime(left_executor));
 
-    /*
-     * Get a port connected to the hand controller module.
-     * @param which_hand the required hand control module
-     * @return true/false on success/failure
-     */
-    yarp::os::RpcClient* getHandPort(const std::string &which_hand)
-    {
-	if (which_hand == "right")
-	    return &port_hand_right;
-	else if (which_hand == "left")
-	    return &port_hand_left;
-	else
-	    return nullptr;
+	if (is_waiting_condition)
+	{
+	    // wait for the end of a Wait step
+	    // the convergence of the estimate is checked periodically
+	    if (condition.type == PipelineStepType::Wait)
+		sleep_times.push_back(std::max(condition_start_time + condition.duration -
+					       yarp::os::Time::now(), 0.0));
+	    else
+		sleep_times.push_back(tick_period);
+	}
+	else if (pipeline_state == PipelineState::Running)
+	{
+	    // the next step of the pipeline is executed
+	    // as soon as both arms are idle
+	    if (right_executor.status == Status::Idle &&
+		left_executor.status == Status::Idle)
+		sleep_times.push_back(0.0);
+	}
+
+	// take the shortest time, ignoring negative ones
+	double sleep_time = -1.0;
+	for (const double &time : sleep_times)
+	{
+	    if (time >= 0.0 && (sleep_time < 0.0 || time < sleep_time))
+		sleep_time = time;
+	}
+
+	return sleep_time;
     }
 
     /*
@@ -188,7 +1145,10 @@ protected:
 	ArmController *arm = getArmController(which_arm);
 
 	if (arm != nullptr)
+	{
+	    ScopedLatency latency(stats.get("rpc/cartesian/check-motion-done"));
 	    return arm->cartesian()->checkMotionDone(&is_done);
+	}
 	else
 	    return false;
     }
@@ -223,6 +1183,7 @@ protected:
 	    hand_cmd.requestFingersRestoreStatus();
 	else
 	    return false;
+	ScopedLatency latency(stats.get("rpc/hand/" + which_hand));
 	hand_port->write(hand_cmd, response);
 
 	// check status
@@ -263,23 +1224,42 @@ protected:
      * Perform approaching phase with the specified arm.
      * @param which_arm which arm to use
      * @param approach_corner whether to approach the corner of the object
+     * @param object_id the object to be approached
      * @return true/false on success/failure
      */
     bool approachObjectWithArm(const std::string &which_arm,
-			       const bool &approach_corner)
+			       const bool &approach_corner,
+			       const std::string &object_id)
     {
 	bool ok;
 
 	// check if the estimate is available
-    	if (!is_estimate_available)
+	TrackedObject *object = getObject(object_id);
+    	if (object == nullptr || !object->is_estimate_available)
     	    return false;
 
+	// warn if the filter stopped publishing
+	double age = object->cache.ageOfLatest(yarp::os::Time::now());
+	if (age > max_estimate_age)
+	    yWarning() << "VisTacLocSimModule: approaching" << object_id
+		       << "using an estimate" << age << "seconds old";
+
 	// evaluate the desired hand pose
 	// according to the current estimate
-	mod_helper.setModelPose(estimate);
+	// of the required object
+	const ObjectDescription &description = object->description;
+	mod_helper.setModelDimensions(description.width,
+				      description.depth,
+				      description.height);
+	mod_helper.setModelPose(object->estimate);
 	double yaw = mod_helper.evalApproachYawAttitude();
+	// the left hand approaches the left half of the side
+	// so that it can hold the object while the right hand
+	// works on the right corner
 	yarp::sig::Vector pos(3, 0.0);
-	if (!approach_corner)
+	if (which_arm == "left")
+	    mod_helper.evalApproachPosition(pos, "left");
+	else if (!approach_corner)
 	    mod_helper.evalApproachPosition(pos);
 	else
 	    mod_helper.evalApproachPosition(pos, "right");
@@ -289,13 +1269,17 @@ protected:
 	if (arm == nullptr)
 	    return false;
 
+	ScopedLatency latency(stats.get("rpc/cartesian/approach"));
+
 	// change effector to the middle finger
 	ok = arm->useFingerFrame("middle");
         if (!ok)
 	    return false;
 
 	// set desired attitude
-	arm->setHandAttitude(yaw * 180 / M_PI, 15, -90);
+	// the roll is mirrored for the left hand
+	double roll = (which_arm == "left") ? 90 : -90;
+	arm->setHandAttitude(yaw * 180 / M_PI, 15, roll);
 
         // request pose to the cartesian interface
         arm->goToPos(pos);
@@ -323,6 +1307,7 @@ protected:
 	hand_cmd.setCommandedFingers(finger_list);
 	hand_cmd.setFingersForwardSpeed(0.009);
 	hand_cmd.commandFingersApproach();
+	ScopedLatency latency(stats.get("rpc/hand/" + which_hand));
 	hand_port->write(hand_cmd, response);
 
 	return true;
@@ -348,6 +1333,7 @@ protected:
 	hand_cmd.setCommandedFingers(finger_list);
 	hand_cmd.setFingersForwardSpeed(0.005);
 	hand_cmd.commandFingersFollow();
+	ScopedLatency latency(stats.get("rpc/hand/" + which_hand));
 	hand_port->write(hand_cmd, response);
 
 	return true;
@@ -377,16 +1363,19 @@ protected:
 	yarp::sig::Vector att;
 	arm->cartesian()->getPose(pos, att);
 
-	// set final position
-	yarp::sig::Vector pos_f(3, 0.0);
-	pos_f = pos;
-	pos_f[0] += 0.17;
+	// set waypoints
+	push_waypoints[0] = pos;
+	for (size_t i = 0; i < push_offsets.size(); i++)
+	    push_waypoints[i + 1] = pos + push_offsets[i];
 
-	// configure trajectory generator
-	traj_gen.setInitialPosition(pos);
-	traj_gen.setFinalPosition(pos_f);
-	traj_gen.setDuration(trajectory_duration);
-	traj_gen.init();
+	// plan and sample the whole trajectory
+	// once before the pushing phase
+	ok = push_traj.plan(push_waypoints);
+	if (!ok)
+	{
+	    yError() << "VisTacLocSimModule: unable to plan the pushing trajectory";
+	    return false;
+	}
 
         // store the current context because we are going
         // to change the trajectory time
@@ -401,10 +1390,12 @@ protected:
     	return true;
     }
 
-    bool prepareRotateObject(const std::string &which_arm)
+    bool prepareRotateObject(const std::string &which_arm,
+			     const std::string &object_id)
     {
 	// check if the estimate is available
-	if (!is_estimate_available)
+	TrackedObject *object = getObject(object_id);
+	if (object == nullptr || !object->is_estimate_available)
 	    return false;
 
 	bool ok;
@@ -424,13 +1415,15 @@ protected:
 	yarp::sig::Vector attitude;
 	arm->cartesian()->getPose(finger_pos, attitude);
 
-	// get the current estimate of the center of the object
-	yarp::sig::Vector object_center = estimate.getCol(3).subVector(0, 2);
-
 	// configure the trajectory generator
+	// using the current estimate of the object
+	// the estimates received while rotating are used
+	// to keep the finger on the pushing point
 	rot_traj_gen.setYawRate(-20 * M_PI / 180);
-	rot_traj_gen.setObjectCenter(object_center);
+	rot_traj_gen.setPositionGain(0.5);
+	rot_traj_gen.setObjectPose(object->estimate);
 	rot_traj_gen.setPushingPoint(finger_pos);
+	rot_traj_gen.init();
 
         // store the current context because we are going
         // to change the trajectory time
@@ -441,6 +1434,8 @@ protected:
 	// of the cartesian controller
 	double traj_time = 0.6;
         arm->cartesian()->setTrajTime(traj_time);
+
+	return true;
     }
 
     bool setArmLinearVelocity(const std::string &which_arm,
@@ -454,11 +1449,13 @@ protected:
 	// compose null attitude velocity
 	yarp::sig::Vector att_dot(4, 0.0);
 
+	ScopedLatency latency(stats.get("rpc/cartesian/set-velocities"));
 	return arm->cartesian()->setTaskVelocities(velocity, att_dot);
     }
 
     /*
-     * Restore the initial configuration of the specified arm.
+     * Start restoring the initial configuration of the specified arm.
+     * The completion is checked using checkArmRestoreDone().
      * @param which_arm which hand to use
      */
     bool restoreArm(const std::string &which_arm)
@@ -469,9 +1466,43 @@ protected:
 	    return false;
 
 	// issue restore command
-	arm->goHome();
+	// without waiting for the motion
+	ScopedLatency latency(stats.get("rpc/cartesian/go-home"));
+	return arm->startGoHome();
+    }
 
-	return true;
+    /*
+     * Check if the restore of the specified arm is done.
+     * On completion the context of the cartesian controller is restored.
+     * @param which_arm which arm to ask for
+     * @param is_done whether the restore is done or not
+     * @return true for success, false for failure
+     */
+    bool checkArmRestoreDone(const std::string &which_arm,
+			     bool &is_done)
+    {
+	ArmController *arm = getArmController(which_arm);
+	if (arm == nullptr)
+	    return false;
+
+	ScopedLatency latency(stats.get("rpc/cartesian/check-motion-done"));
+	return arm->checkGoHomeDone(is_done);
+    }
+
+    /*
+     * Stop the restore of the specified arm, if any,
+     * and restore the context of the cartesian controller.
+     * @param which_arm which arm to stop
+     * @return true/false on success/failure
+     */
+    bool stopArmRestore(const std::string &which_arm)
+    {
+	ArmController *arm = getArmController(which_arm);
+	if (arm == nullptr)
+	    return false;
+
+	ScopedLatency latency(stats.get("rpc/cartesian/stop"));
+	return arm->stopGoHome();
     }
 
     /*
@@ -494,6 +1525,7 @@ protected:
 	hand_cmd.setCommandedFingers(finger_list);
 	hand_cmd.setFingersRestoreSpeed(25.0);
 	hand_cmd.commandFingersRestore();
+	ScopedLatency latency(stats.get("rpc/hand/" + which_hand));
 	hand_port->write(hand_cmd, response);
 
 	return true;
@@ -524,6 +1556,7 @@ protected:
 	if (arm == nullptr)
 	    return false;
 
+	ScopedLatency latency(stats.get("rpc/cartesian/stop"));
 	return arm->cartesian()->stopControl();
     }
 
@@ -546,6 +1579,7 @@ protected:
 	hand_cmd.setCommandedHand(which_hand);
 	hand_cmd.setCommandedFingers(finger_list);
 	hand_cmd.commandStop();
+	ScopedLatency latency(stats.get("rpc/hand/" + which_hand));
 	hand_port->write(hand_cmd, response);
 
 	return true;
@@ -554,65 +1588,158 @@ protected:
 public:
     bool configure(yarp::os::ResourceFinder &rf)
     {
+	// namespace prepended to the names of all the ports
+	// in order to run several instances on the same name server
+	std::string prefix = rf.check("prefix", yarp::os::Value("")).asString();
+
+	// the steps of the startup are reported at the end
+	StartupTimeline timeline("VisTacLocSimModule");
+
 	// open ports
-	bool ok = port_filter.open("/vis_tac_localization/filter:o");
+	std::size_t step = timeline.begin("ports");
+	bool ok = port_filter.open(prefix + "/vis_tac_localization/filter:o");
 	if (!ok)
         {
             yError() << "VisTacLocSimModule: unable to open the filter port";
             return false;
         }
 
-	ok = port_hand_right.open("/vis_tac_localization/hand-control/right/rpc:o");
+	ok = port_hand_right.open(prefix + "/vis_tac_localization/hand-control/right/rpc:o");
 	if (!ok)
         {
             yError() << "VisTacLocSimModule: unable to open the right hand control module port";
             return false;
         }
 
-	ok = port_hand_left.open("/vis_tac_localization/hand-control/left/rpc:o");
+	ok = port_hand_left.open(prefix + "/vis_tac_localization/hand-control/left/rpc:o");
 	if (!ok)
         {
             yError() << "VisTacLocSimModule: unable to open the left hand control module port";
             return false;
         }
 
-	// prepare properties for the FrameTransformClient
-	yarp::os::Property propTfClient;
-	propTfClient.put("device", "transformClient");
-	propTfClient.put("local", "/vis_tac_localization/transformClient");
-	propTfClient.put("remote", "/transformServer");
+	// the hand control modules notify the completion of the fingers motion
+	// if the status ports are not connected the status is polled
+	port_hand_status_right.configure(&events, "right");
+	ok = port_hand_status_right.open(prefix + "/vis_tac_localization/hand-control/right/status:i");
+	if (!ok)
+        {
+            yError() << "VisTacLocSimModule: unable to open the right hand control module status port";
+            return false;
+        }
+	port_hand_status_right.useCallback();
+	yarp::os::Network::connect(prefix + "/hand-control/right/status:o", port_hand_status_right.getName());
 
-	// try to open the driver
-	ok = drv_transform_client.open(propTfClient);
+	port_hand_status_left.configure(&events, "left");
+	ok = port_hand_status_left.open(prefix + "/vis_tac_localization/hand-control/left/status:i");
 	if (!ok)
+        {
+            yError() << "VisTacLocSimModule: unable to open the left hand control module status port";
+            return false;
+        }
+	port_hand_status_left.useCallback();
+	yarp::os::Network::connect(prefix + "/hand-control/left/status:o", port_hand_status_left.getName());
+
+	// load the objects of the scene
+	if (!registry.configure(rf))
+	{
+	    yError() << "VisTacLocSimModule: unable to load the objects of the scene";
+	    return false;
+	}
+
+	// the estimates of all the objects
+	// are pushed by the FrameTransformServer
+	std::string root_frame = rf.check("rootFrame", yarp::os::Value("/iCub/frame")).asString();
+	port_estimate.configure(root_frame);
+	max_estimate_age = rf.check("maxEstimateAge", yarp::os::Value(1.0)).asDouble();
+	if (max_estimate_age <= 0)
 	{
-	    yError() << "VisTacLocSimModule: unable to open the FrameTransformClient driver.";
+	    yError() << "VisTacLocSimModule: the maximum age of the estimates should be positive";
 	    return false;
 	}
+	for (const ObjectDescription &description : registry.getObjects())
+	{
+	    std::unique_ptr<TrackedObject> object(new TrackedObject());
+	    object->description = description;
+	    object->is_estimate_available = false;
+	    object->estimate_time = 0.0;
 
-	// try to retrieve the view
-	ok = drv_transform_client.view(tf_client);
-	if (!ok || tf_client == 0)
+	    // objects without an estimate frame are not localized
+	    if (!description.estimate_frame.empty())
+		port_estimate.addTarget(&object->cache, description.estimate_frame);
+
+	    objects[description.id] = std::move(object);
+	}
+	ok = port_estimate.open(prefix + "/vis_tac_localization/estimate:i");
+	if (!ok)
 	{
-	    yError() << "VisTacLocSimModule: unable to retrieve the FrameTransformClient view.";
+	    yError() << "VisTacLocSimModule: unable to open the estimate port";
 	    return false;
 	}
+	port_estimate.useCallback();
+	// the connection is also declared in the application,
+	// the estimates are received as soon as the server is available
+	if (!yarp::os::Network::connect(prefix + "/transformServer/transforms:o", port_estimate.getName()))
+	    yWarning() << "VisTacLocSimModule: unable to connect to the transform server, waiting for the estimates";
+	timeline.end(step, true);
 
 	// configure arm controllers
-	ok = right_arm.configure();
-        if (!ok)
+	// the cartesian controller is either the remote iKinCartesianSolver
+	// or the kinematic controller simcartesiancontroller
+	std::string cartesian_controller = rf.check("cartesianController",
+						    yarp::os::Value("remote")).asString();
+	if (cartesian_controller != "remote" && cartesian_controller != "kinematic")
+	{
+	    yError() << "VisTacLocSimModule: unknown cartesian controller" << cartesian_controller;
+	    return false;
+	}
+	bool use_sim_controller = (cartesian_controller == "kinematic");
+
+	// the module, and the kinematic controllers if any,
+	// can be driven by the stepped clock of clock_master
+	std::string clock_master = rf.check("clockMaster", yarp::os::Value("")).asString();
+
+	// the arm controllers are independent
+	// hence they are configured concurrently
+	bool is_right_ok = false;
+	std::thread right_thread([&]()
+				 {
+				     std::size_t right_step = timeline.begin("right arm controller");
+				     is_right_ok = right_arm.configure(use_sim_controller, clock_master, prefix);
+				     timeline.end(right_step, is_right_ok);
+				 });
+
+	step = timeline.begin("left arm controller");
+	bool is_left_ok = left_arm.configure(use_sim_controller, clock_master, prefix);
+	timeline.end(step, is_left_ok);
+
+	right_thread.join();
+
+        if (!is_right_ok)
 	{
             yError() << "VisTacLocSimModule: unable to configure the right arm controller";
+	    timeline.report();
             return false;
 	}
 
-	ok = left_arm.configure();
-        if (!ok)
+        if (!is_left_ok)
 	{
             yError() << "VisTacLocSimModule: unable to configure the left arm controller";
+	    timeline.report();
             return false;
 	}
 
+	// the cartesian controllers notify the completion of the motion
+	// if the events are not supported the status is polled
+	arm_events_enabled["right"] = right_arm.cartesian()->registerEvent(right_arm_done);
+	arm_events_enabled["left"] = left_arm.cartesian()->registerEvent(left_arm_done);
+	for (auto &item : arm_events_enabled)
+	{
+	    if (!item.second)
+		yWarning() << "VisTacLocSimModule: motion-done events not available for the"
+			   << item.first << "arm, the status will be polled";
+	}
+
 	// set default hands orientation
 	right_arm.setHandAttitude(0, 15, 0);
 	left_arm.setHandAttitude(0, 15, 0);
@@ -625,26 +1752,105 @@ public:
 	left_arm.cartesian()->setTrajTime(0.5);
 
 	// configure model helper
-	mod_helper.setModelDimensions(0.24, 0.17, 0.037);
-
-	// set default value of flags
-	is_estimate_available = false;
-	is_approach_done = false;
-	is_timer_started = false;
+	// using the default object
+	const ObjectDescription &default_object = *registry.find(registry.getDefaultObject());
+	mod_helper.setModelDimensions(default_object.width,
+				      default_object.depth,
+				      default_object.height);
 
 	// set default trajectory duration
 	trajectory_duration = 4.0;
 
+	// configure the jerk limited trajectory of the pushing phase
+	// by default the finger moves 0.17 m forward
+	yarp::os::Bottle &push_group = rf.findGroup("push");
+	ok = push_traj.setLimits(push_group.check("maxVelocity", yarp::os::Value(0.08)).asDouble(),
+				 push_group.check("maxAcceleration", yarp::os::Value(0.1)).asDouble(),
+				 push_group.check("maxJerk", yarp::os::Value(0.5)).asDouble());
+	ok &= push_traj.setSamplingPeriod(push_group.check("samplingPeriod",
+							   yarp::os::Value(0.005)).asDouble());
+	if (!ok)
+	{
+	    yError() << "VisTacLocSimModule: the limits and the sampling period"
+		     << "of the pushing trajectory should be positive";
+	    return false;
+	}
+	yarp::os::Bottle *waypoints = push_group.find("waypoints").asList();
+	if (waypoints == nullptr)
+	{
+	    push_offsets.push_back(yarp::sig::Vector(3, 0.0));
+	    push_offsets.back()[0] = 0.17;
+	}
+	else
+	{
+	    for (size_t i = 0; i < waypoints->size(); i++)
+	    {
+		yarp::os::Bottle *offset = waypoints->get(i).asList();
+		if (offset == nullptr || offset->size() != 3)
+		{
+		    yError() << "VisTacLocSimModule: expected ((x y z) ...)"
+			     << "as parameter 'waypoints' of group push";
+		    return false;
+		}
+		push_offsets.push_back(yarp::sig::Vector(3, 0.0));
+		for (size_t k = 0; k < 3; k++)
+		    push_offsets.back()[k] = offset->get(k).asDouble();
+	    }
+	}
+	push_waypoints.resize(push_offsets.size() + 1, yarp::sig::Vector(3, 0.0));
+
+	// set the period used for streaming and polling
+	tick_period = 0.02;
+
+	// allocate the storage of the trajectory
+	traj_pos.resize(3, 0.0);
+	traj_vel.resize(3, 0.0);
+	traj_att.resize(4, 0.0);
+
 	// set default status
-	status = Status::Idle;
-	previous_status = Status::Idle;
-	current_hand.clear();
+	resetExecutor(right_executor, "right");
+	resetExecutor(left_executor, "left");
+
+	// no pipeline
+	pipeline_length = 0;
+	pipeline_state = PipelineState::Idle;
+	pipeline_id = 0;
+	next_pipeline_id = 1;
+	pipeline_object = registry.getDefaultObject();
+	is_waiting_condition = false;
+	is_condition_failed = false;
+
+	// publish the initial status
+	publishStatus();
+
+	// configure timing instrumentation
+	configureStats();
+	stats_period = 1.0;
+	last_stats_time = yarp::os::SystemClock::nowSystem();
+	if (!port_stats.open(prefix + "/vis_tac_localization/stats:o"))
+	{
+	    yError() << "VisTacLocSimModule: unable to open the statistics port";
+	    return false;
+	}
+
+	// join the stepped clock if required
+	step = timeline.begin("clock");
+	ok = clock.configure("vis_tac_localization", clock_master, prefix);
+	timeline.end(step, ok);
+	if (!ok)
+	{
+	    yError() << "VisTacLocSimModule: unable to join the clock master";
+	    timeline.report();
+	    return false;
+	}
 
 	// open the rpc server
 	// TODO: take name from config
-        rpc_port.open("/service");
+        rpc_port.open(prefix + "/service");
         attach(rpc_port);
 
+	timeline.report();
+
         return true;
     }
 
@@ -658,17 +1864,31 @@ public:
 	stopFingers("right");
 	stopFingers("left");
 
-	// in case pushing was initiated
+	// in case pushing or rotation was initiated
 	// the previous context of the cartesian controller
 	// has to be restored
-	if (status == Status::PreparePush ||
-	    status == Status::PerformPush)
+	for (ArmExecutor *executor : {&right_executor, &left_executor})
 	{
-	    // restore arm controller context
-	    // that was changed in pushObject(curr_hand)
-	    restoreArmControllerContext(current_hand);
+	    // as well as if the arm is restoring
+	    stopArmRestore(executor->hand);
+
+	    if (executor->status == Status::PreparePush ||
+		executor->status == Status::PerformPush ||
+		executor->status == Status::PrepareRotation ||
+		executor->status == Status::PerformRotation)
+	    {
+		// restore arm controller context
+		// that was changed in preparePushObject(curr_hand)
+		restoreArmControllerContext(executor->hand);
+	    }
 	}
 
+	// unregister events
+	if (arm_events_enabled["right"])
+	    right_arm.cartesian()->unregisterEvent(right_arm_done);
+	if (arm_events_enabled["left"])
+	    left_arm.cartesian()->unregisterEvent(left_arm_done);
+
 	// close arm controllers
 	right_arm.close();
 	left_arm.close();
@@ -676,167 +1896,274 @@ public:
 	// close ports
         rpc_port.close();
 	port_filter.close();
+	port_estimate.close();
+	port_hand_status_right.close();
+	port_hand_status_left.close();
+	port_stats.close();
+
+	// leave the stepped clock
+	clock.close();
+
+	return true;
     }
 
     bool respond(const yarp::os::Bottle &command, yarp::os::Bottle &reply)
     {
-	mutex.lock();
+	// the rpc thread never touches the status directly,
+	// commands are sent to the RFModule thread and the replies
+	// are based on the last published snapshot of the status
+	bool is_pending = !commands.empty();
 
         std::string cmd = command.get(0).asString();
         if (cmd == "help")
         {
             reply.addVocab(yarp::os::Vocab::encode("many"));
             reply.addString("Available commands:");
-	    reply.addString("- move-left-upward");
-            reply.addString("- home-right");
-            reply.addString("- localize");
-	    reply.addString("- approach-corner-with-right");
-	    reply.addString("- approach-with-right");
-	    reply.addString("- push-with-right");
-	    reply.addString("- rotate-with-right");
+	    reply.addString("- move-left-upward [<object>]");
+            reply.addString("- home-right [<object>]");
+            reply.addString("- home-left [<object>]");
+            reply.addString("- home-both [<object>]");
+            reply.addString("- localize [<object>]");
+	    reply.addString("- approach-corner-with-right [<object>]");
+	    reply.addString("- approach-with-right [<object>]");
+	    reply.addString("- approach-with-left [<object>]");
+	    reply.addString("- push-with-right [<object>]");
+	    reply.addString("- rotate-with-right [<object>]");
+	    reply.addString("- pipeline [<object>] <step> <step> ...");
+	    reply.addString("- pipeline-status [<id>]");
+	    reply.addString("- objects");
+	    reply.addString("- estimate [<object>]");
+	    reply.addString("- stats");
+	    reply.addString("- stats-reset");
 	    reply.addString("- stop");
+	    reply.addString("- stop-right");
+	    reply.addString("- stop-left");
             reply.addString("- quit");
+
+	    return true;
         }
-	else if (cmd == "move-left-upward")
+	else if (isPhase(cmd))
 	{
-	    if (status != Status::Idle)
+	    // the object is optional
+	    std::string object_id = registry.getDefaultObject();
+	    if (command.size() > 1)
+		object_id = command.get(1).asString();
+
+	    ModuleCommand module_cmd;
+	    module_cmd.type = ModuleCommandType::Phase;
+	    module_cmd.phase = cmd;
+	    module_cmd.object = object_id;
+
+	    // phases using distinct arms can be executed concurrently
+	    std::string invalid;
+	    if (!checkObject(object_id, isPhaseUsingEstimate(cmd), invalid))
+		reply.addString(invalid);
+	    else if (is_pending || isPhaseBusy(cmd, true))
 		reply.addString("Wait for completion of the current phase!");
+	    else if (!commands.push(std::move(module_cmd)))
+		reply.addString("Too many pending commands!");
 	    else
-	    {
-		previous_status = status;
-		status = Status::MoveLeftUpward;
-
-		reply.addString("Command issued.");
-	    }
+		reply.addString(getPhaseMessage(cmd));
 	}
-	else if (cmd == "home-right")
+	else if (cmd == "pipeline")
 	{
-	    if (status != Status::Idle)
+	    // the object is optional and precedes the steps
+	    std::size_t first = 1;
+	    std::string object_id = registry.getDefaultObject();
+	    if (command.size() > 1 && command.get(1).isString() &&
+		registry.find(command.get(1).asString()) != nullptr)
+	    {
+		object_id = command.get(1).asString();
+		first = 2;
+	    }
+
+	    PipelineParser parser;
+	    std::deque<PipelineStep> steps;
+	    if (is_pending || isArmBusy("right", true) || isArmBusy("left", true))
 		reply.addString("Wait for completion of the current phase!");
+	    else if (!parser.parse(command, first, steps))
+		reply.addString("Invalid pipeline: " + parser.getError());
 	    else
 	    {
-		previous_status = status;
-		status = Status::FingersRestore;
-		current_hand = "right";
-
-		reply.addString("Home right issued.");
+		// check that all the phases exist
+		// and that parallel phases use distinct arms
+		std::string invalid;
+		bool use_estimate = false;
+		for (const PipelineStep &step : steps)
+		{
+		    if (step.type == PipelineStepType::Phase && !isPhase(step.phase))
+			invalid = "unknown phase " + step.phase;
+		    else if (step.type == PipelineStepType::Parallel &&
+			     !arePhasesIndependent(step.phases))
+			invalid = "parallel phases must be known and use distinct arms";
+
+		    if (step.type == PipelineStepType::Phase)
+			use_estimate |= isPhaseUsingEstimate(step.phase);
+		    else if (step.type == PipelineStepType::Parallel)
+		    {
+			for (const std::string &phase : step.phases)
+			    use_estimate |= isPhaseUsingEstimate(phase);
+		    }
+		    else if (step.type == PipelineStepType::WaitConvergence)
+			use_estimate = true;
+		}
+
+		std::size_t n_steps = steps.size();
+		ModuleCommand module_cmd;
+		module_cmd.type = ModuleCommandType::Pipeline;
+		module_cmd.steps = std::move(steps);
+		module_cmd.pipeline_id = next_pipeline_id;
+		module_cmd.object = object_id;
+
+		std::string invalid_object;
+		if (!invalid.empty())
+		    reply.addString("Invalid pipeline: " + invalid);
+		else if (!checkObject(object_id, use_estimate, invalid_object))
+		    reply.addString(invalid_object);
+		else if (!commands.push(std::move(module_cmd)))
+		    reply.addString("Too many pending commands!");
+		else
+		{
+		    reply.addString("Pipeline with " + std::to_string(n_steps) +
+				    " steps issued.");
+		    reply.addInt(next_pipeline_id++);
+		}
 	    }
 	}
-	else if (cmd == "home-left")
+	else if (cmd == "pipeline-status")
 	{
-	    if (status != Status::Idle)
-		reply.addString("Wait for completion of the current phase!");
-	    else
+	    // the id is published after the state, hence it is read first
+	    // so that the state is not older than the pipeline with that id
+	    int id = published_pipeline_id;
+	    PipelineState state = published_pipeline_state;
+
+	    // a pipeline issued but not started yet is pending
+	    if (command.size() > 1 && command.get(1).asInt() > id)
 	    {
-		previous_status = status;
-		status = Status::FingersRestore;
-		current_hand = "left";
+		reply.addString("pending");
 
-		reply.addString("Home left issued.");
+		return true;
 	    }
+
+	    reply.addString(getPipelineStateName(state));
+	    if (state == PipelineState::Running)
+	    {
+		reply.addInt(published_pipeline_step);
+		reply.addInt(published_pipeline_length);
+	    }
+
+	    return true;
 	}
-	else if (cmd == "localize")
+	else if (cmd == "objects")
 	{
-	    if (status != Status::Idle)
-		reply.addString("Wait for completion of the current phase!");
-	    else
+	    // (id age) for each object, the age of the
+	    // latest estimate is negative if not available
+	    double now = yarp::os::Time::now();
+	    for (const auto &item : objects)
 	    {
-		previous_status = status;
-		status = Status::Localize;
-
-		reply.addString("Localization issued.");
+		yarp::os::Bottle &entry = reply.addList();
+		entry.addString(item.first);
+		entry.addDouble(item.second->cache.ageOfLatest(now));
 	    }
+
+	    return true;
 	}
-	else if (cmd == "approach-with-right"
-		 || cmd == "approach-corner-with-right")
+	else if (cmd == "estimate")
 	{
-	    if (status != Status::Idle)
-		reply.addString("Wait for completion of the current phase!");
+	    std::string object_id = registry.getDefaultObject();
+	    if (command.size() > 1)
+		object_id = command.get(1).asString();
+
+	    // the cache can be accessed from any thread
+	    TrackedObject *object = getObject(object_id);
+	    yarp::sig::Matrix pose;
+	    double time;
+	    if (object == nullptr)
+		reply.addString("Unknown object " + object_id + "!");
+	    else if (!object->cache.latest(pose, &time) ||
+		     yarp::os::Time::now() - time > max_estimate_age)
+		reply.addString("Estimate not available!");
 	    else
 	    {
-		previous_status = status;
-		status = Status::ArmApproach;
-		current_hand = "right";
-
-		if (cmd == "approach-corner-with-right")
-		    approach_corner = true;
-
-		reply.addString("Approach with right-arm issued.");
+		// position and axis-angle
+		yarp::sig::Vector pos = pose.getCol(3).subVector(0, 2);
+		yarp::sig::Vector axis_angle = dcm2axis(pose);
+		for (size_t i = 0; i < 3; i++)
+		    reply.addDouble(pos[i]);
+		for (size_t i = 0; i < 4; i++)
+		    reply.addDouble(axis_angle[i]);
 	    }
+
+	    return true;
 	}
-	else if (cmd == "push-with-right")
+	else if (cmd == "stats")
 	{
-	    if (status != Status::Idle)
-		reply.addString("Wait for completion of the current phase!");
-	    else
-	    {
-		previous_status = status;
-		status = Status::PreparePush;
-		current_hand = "right";
+	    // (name count mean p50 p90 p99 max) for each histogram
+	    // durations are in milliseconds
+	    stats.toBottle(reply);
 
-		reply.addString("Push with right-arm issued.");
-	    }
+	    return true;
 	}
-	else if (cmd == "rotate-with-right")
+	else if (cmd == "stats-reset")
 	{
-	    if (status != Status::Idle)
-		reply.addString("Wait for completion of the current phase!");
-	    else
-	    {
-		previous_status = status;
-		status = Status::PrepareRotation;
-		current_hand = "right";
+	    stats.reset();
 
-		reply.addString("Rotation with right-arm issued.");
-	    }
+	    reply.addString("Statistics reset.");
+
+	    return true;
 	}
-	else if (cmd == "stop")
+	else if (cmd == "stop" || cmd == "stop-right" || cmd == "stop-left")
 	{
-	    previous_status = status;
-	    status = Status::Stop;
+	    ModuleCommand module_cmd;
+	    module_cmd.type = ModuleCommandType::Stop;
+	    if (cmd != "stop")
+		module_cmd.phase = cmd.substr(5);
 
-	    reply.addString("Stop issued.");
+	    if (!commands.push(std::move(module_cmd)))
+		reply.addString("Too many pending commands!");
+	    else
+		reply.addString("Stop issued.");
 	}
         else
 	{
-	    mutex.unlock();
-
             // the father class already handles the "quit" command
             return RFModule::respond(command,reply);
 	}
 
-	mutex.unlock();
+	// wake up the module
+	events.wake();
 
         return true;
     }
 
-    double getPeriod()
+    bool interruptModule()
     {
-        return 0.02;
+	// wake up the module so that it can stop
+	events.wake();
+
+	return true;
     }
 
-    bool updateModule()
+    double getPeriod()
     {
-	if(isStopping())
-	    return false;
-
-	mutex.lock();
+	// the module is driven by events
+        return 0.0;
+    }
 
+    /*
+     * Execute the current status of an executor.
+     * @param executor the executor
+     * @param event the last event received, if any
+     * @param is_event whether an event was received
+     */
+    void stepExecutor(ArmExecutor &executor, const Event &event, const bool &is_event)
+    {
 	// get the current and previous status
-	Status curr_status;
-	Status prev_status;
-	curr_status = status;
-	prev_status = previous_status;
-
-	// get the current hand
-	std::string curr_hand = current_hand;
+	Status curr_status = executor.status;
+	Status prev_status = executor.previous_status;
 
-	mutex.unlock();
-
-	// get current estimate from the filter
-	std::string source = "/iCub/frame";
-	std::string target = "/box_alt/estimate/frame";
-	is_estimate_available = tf_client->getTransform(target, source, estimate);
+	// get the hand controlled by this executor
+	const std::string &curr_hand = executor.hand;
 
 	switch(curr_status)
 	{
@@ -846,28 +2173,13 @@ public:
 	    break;
 	}
 
-	case Status::Localize:
-	{
-	    // issue localization
-	    sendCommandToFilter(true, "visual");
-
-	    // go back to Idle
-	    mutex.lock();
-	    status = Status::Idle;
-	    mutex.unlock();
-
-	    break;
-	}
-
 	case Status::MoveLeftUpward:
 	{
 	    // issue command
 	    moveLeftArmUpward();
 
 	    // go back to Idle
-	    mutex.lock();
-	    status = Status::Idle;
-	    mutex.unlock();
+	    executor.status = Status::Idle;
 
 	    break;
 	}
@@ -875,32 +2187,29 @@ public:
 	case Status::ArmApproach:
 	{
 	    // reset flag
-	    is_approach_done = false;
+	    executor.is_approach_done = false;
 
 	    if (curr_hand.empty())
 	    {
 		// this should not happen
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // issue approach with arm
-	    approachObjectWithArm(curr_hand, approach_corner);
+	    approachObjectWithArm(curr_hand, executor.approach_corner, executor.object);
 
-	    // reset approach_corner flag
-	    approach_corner = false;
+	    // reset executor.approach_corner flag
+	    executor.approach_corner = false;
 
 	    // go to state WaitArmApproachDone
-	    mutex.lock();
-	    status = Status::WaitArmApproachDone;
-	    mutex.unlock();
+	    executor.status = Status::WaitArmApproachDone;
 
 	    // reset timer
-	    last_time = yarp::os::Time::now();
+	    executor.last_time = yarp::os::Time::now();
 
 	    break;
 	}
@@ -908,23 +2217,27 @@ public:
 	case Status::WaitArmApproachDone:
 	{
 	    // timeout
-	    double timeout = 5.0;
+	    double timeout = getTimeout(curr_status);
 
-	    // check status
+	    // check status when notified
 	    bool is_done = false;
-	    bool ok = checkArmMotionDone(curr_hand, is_done);
+	    bool ok = true;
+	    if (!arm_events_enabled[curr_hand] ||
+		(is_event &&
+		 event.type == EventType::ArmMotionDone &&
+		 event.source == curr_hand))
+		ok = checkArmMotionDone(curr_hand, is_done);
 
 	    // handle failure and timeout
 	    if (!ok ||
-		((yarp::os::Time::now() - last_time > timeout)))
+		((yarp::os::Time::now() - executor.last_time > timeout)))
 	    {
 		// stop control
 		stopArm(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 	    }
 
 	    if (is_done)
@@ -933,9 +2246,7 @@ public:
 		yInfo() << "Arm approach done";
 
 		// go to FingersApproach
-		mutex.lock();
-		status = Status::FingersApproach;
-		mutex.unlock();
+		executor.status = Status::FingersApproach;
 	    }
 
 	    break;
@@ -947,23 +2258,21 @@ public:
 	    {
 		// this should not happen
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // issue approach with fingers
+	    executor.fingers_command_time = yarp::os::Time::now();
 	    approachObjectWithFingers(curr_hand);
 
 	    // go to state WaitFingersApproachDone
-	    mutex.lock();
-	    status = Status::WaitFingersApproachDone;
-	    mutex.unlock();
+	    executor.status = Status::WaitFingersApproachDone;
 
 	    // reset timer
-	    last_time = yarp::os::Time::now();
+	    executor.last_time = yarp::os::Time::now();
 
 	    break;
 	}
@@ -971,24 +2280,31 @@ public:
 	case Status::WaitFingersApproachDone:
 	{
 	    // timeout
-	    double timeout = 10.0;
+	    double timeout = getTimeout(curr_status);
 
 	    // check status
 	    bool is_done = false;
-	    bool ok = checkFingersMotionDone(curr_hand,
-					     "fingers_approach",
-					     is_done);
+	    bool ok = true;
+	    if (!areFingersEventsEnabled(curr_hand))
+		ok = checkFingersMotionDone(curr_hand,
+					    "fingers_approach",
+					    is_done);
+	    else if (is_event &&
+		     event.type == EventType::FingersApproachDone &&
+		     event.source == curr_hand &&
+		     event.timestamp >= executor.fingers_command_time)
+		is_done = true;
+
 	    // handle failure and timeout
 	    if (!ok ||
-		((yarp::os::Time::now() - last_time > timeout)))
+		((yarp::os::Time::now() - executor.last_time > timeout)))
 	    {
 		// stop control
 		stopFingers(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 	    }
 
 	    if (is_done)
@@ -997,12 +2313,10 @@ public:
 		yInfo() << "Fingers approach done";
 
 		// go to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
 
 		// update flag
-		is_approach_done = true;
+		executor.is_approach_done = true;
 	    }
 
 	    break;
@@ -1010,25 +2324,38 @@ public:
 
 	case Status::PreparePush:
 	{
-	    if (!is_approach_done)
+	    if (!executor.is_approach_done)
 	    {
 		// push not possible
 		// ignore this command
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // reset flags
-	    is_approach_done = false;
-	    is_timer_started = false;
+	    executor.is_approach_done = false;
+	    executor.is_timer_started = false;
 
 	    // prepare controller for push
-	    preparePushObject(curr_hand);
+	    bool ok;
+	    {
+		ScopedLatency latency(stats.get("rpc/cartesian/prepare"));
+		ok = preparePushObject(curr_hand);
+	    }
+	    if (!ok)
+	    {
+		// the context of the controller was not changed
+		// hence there is nothing to restore
+		// go back to Idle
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
+
+		break;
+	    }
 
 	    // enable tactile filtering
 	    sendCommandToFilter(true, "tactile");
@@ -1037,40 +2364,37 @@ public:
 	    enableFingersFollowing(curr_hand);
 
 	    // go to state PerformPush
-	    mutex.lock();
-	    status = Status::PerformPush;
-	    mutex.unlock();
+	    executor.status = Status::PerformPush;
 
 	    break;
 	}
 
 	case Status::PerformPush:
 	{
-	    if (!is_timer_started)
+	    if (!executor.is_timer_started)
 	    {
-		is_timer_started = true;
+		executor.is_timer_started = true;
 
 		// reset time
-		last_time = yarp::os::Time::now();
+		executor.last_time = yarp::os::Time::now();
 	    }
 
 	    // eval elapsed time
-	    double elapsed = yarp::os::Time::now() - last_time;
+	    double elapsed = yarp::os::Time::now() - executor.last_time;
 
 	    // get current trajectory
-	    yarp::sig::Vector pos(3, 0.0);
-	    yarp::sig::Vector vel(3, 0.0);
-	    traj_gen.getTrajectory(elapsed, pos, vel);
+	    // from the samples evaluated in preparePushObject()
+	    push_traj.getTrajectory(elapsed, traj_pos, traj_vel);
 
 	    // issue velocity command
-	    setArmLinearVelocity(curr_hand, vel);
+	    setArmLinearVelocity(curr_hand, traj_vel);
 
 	    // check for trajectory completion
-	    if (elapsed > trajectory_duration)
+	    if (elapsed > push_traj.getDuration())
 	    {
 		// issue zero velocities
-		vel = 0;
-		setArmLinearVelocity(curr_hand, vel);
+		traj_vel = 0;
+		setArmLinearVelocity(curr_hand, traj_vel);
 
 		// stop fingers control
 		stopFingers(curr_hand);
@@ -1083,9 +2407,7 @@ public:
 		restoreArmControllerContext(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
 	    }
 
 	    break;
@@ -1097,19 +2419,32 @@ public:
 	    {
 		// this should not happen
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // reset flags
-	    is_approach_done = false;
-	    is_timer_started = false;
+	    executor.is_approach_done = false;
+	    executor.is_timer_started = false;
 
 	    // prepare controller for rotation
-	    prepareRotateObject(curr_hand);
+	    bool ok;
+	    {
+		ScopedLatency latency(stats.get("rpc/cartesian/prepare"));
+		ok = prepareRotateObject(curr_hand, executor.object);
+	    }
+	    if (!ok)
+	    {
+		// the context of the controller was not changed
+		// hence there is nothing to restore
+		// go back to Idle
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
+
+		break;
+	    }
 
 	    // enable tactile filtering
 	    sendCommandToFilter(true, "tactile");
@@ -1118,39 +2453,47 @@ public:
 	    enableFingersFollowing(curr_hand);
 
 	    // go to state PerformRotation
-	    mutex.lock();
-	    status = Status::PerformRotation;
-	    mutex.unlock();
+	    executor.status = Status::PerformRotation;
 
 	    break;
 	}
 
 	case Status::PerformRotation:
 	{
-	    if (!is_timer_started)
+	    if (!executor.is_timer_started)
 	    {
-		is_timer_started = true;
+		executor.is_timer_started = true;
 
 		// reset time
-		last_time = yarp::os::Time::now();
+		executor.last_time = yarp::os::Time::now();
 	    }
 
 	    // eval elapsed time
-	    double elapsed = yarp::os::Time::now() - last_time;
+	    double elapsed = yarp::os::Time::now() - executor.last_time;
+
+	    // update the generator with the latest estimate
+	    TrackedObject *object = getObject(executor.object);
+	    if (object != nullptr && object->is_estimate_available)
+		rot_traj_gen.updateEstimate(object->estimate,
+					    object->estimate_time - executor.last_time);
 
 	    // get current trajectory
-	    yarp::sig::Vector vel(3, 0.0);
-	    rot_traj_gen.getVelocity(elapsed, vel);
+	    // correcting the actual position of the finger
+	    ArmController *arm = getArmController(curr_hand);
+	    if (arm != nullptr && arm->cartesian()->getPose(traj_pos, traj_att))
+		rot_traj_gen.getVelocity(elapsed, traj_pos, traj_vel);
+	    else
+		rot_traj_gen.getVelocity(elapsed, traj_vel);
 
 	    // issue velocity command
-	    setArmLinearVelocity(curr_hand, vel);
+	    setArmLinearVelocity(curr_hand, traj_vel);
 
 	    // check for trajectory completion
 	    if (elapsed > trajectory_duration)
 	    {
 		// issue zero velocities
-		vel = 0;
-		setArmLinearVelocity(curr_hand, vel);
+		traj_vel = 0;
+		setArmLinearVelocity(curr_hand, traj_vel);
 
 		// stop fingers control
 		stopFingers(curr_hand);
@@ -1163,9 +2506,7 @@ public:
 		restoreArmControllerContext(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
 	    }
 
 	    break;
@@ -1177,23 +2518,21 @@ public:
 	    {
 		// this should not happen
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // issue fingers restore
+	    executor.fingers_command_time = yarp::os::Time::now();
 	    restoreFingers(curr_hand);
 
 	    // reset timer
-	    last_time = yarp::os::Time::now();
+	    executor.last_time = yarp::os::Time::now();
 
 	    // go to WaitFingersRestoreDone
-	    mutex.lock();
-	    status = Status::WaitFingersRestoreDone;
-	    mutex.unlock();
+	    executor.status = Status::WaitFingersRestoreDone;
 
 	    break;
 	}
@@ -1201,24 +2540,31 @@ public:
 	case Status::WaitFingersRestoreDone:
 	{
 	    // timeout
-	    double timeout = 10.0;
+	    double timeout = getTimeout(curr_status);
 
 	    // check status
 	    bool is_done = false;
-	    bool ok = checkFingersMotionDone(curr_hand,
-					     "fingers_restore",
-					     is_done);
+	    bool ok = true;
+	    if (!areFingersEventsEnabled(curr_hand))
+		ok = checkFingersMotionDone(curr_hand,
+					    "fingers_restore",
+					    is_done);
+	    else if (is_event &&
+		     event.type == EventType::FingersRestoreDone &&
+		     event.source == curr_hand &&
+		     event.timestamp >= executor.fingers_command_time)
+		is_done = true;
+
 	    // handle failure and timeout
 	    if (!ok ||
-		((yarp::os::Time::now() - last_time > timeout)))
+		((yarp::os::Time::now() - executor.last_time > timeout)))
 	    {
 		// stop control
 		stopFingers(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 	    }
 
 	    if (is_done)
@@ -1227,9 +2573,7 @@ public:
 		yInfo() << "Fingers restore done";
 
 		// go to ArmRestore
-		mutex.lock();
-		status = Status::ArmRestore;
-		mutex.unlock();
+		executor.status = Status::ArmRestore;
 	    }
 
 	    break;
@@ -1241,23 +2585,28 @@ public:
 	    {
 		// this should not happen
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
 		break;
 	    }
 
 	    // issue arm restore
-	    restoreArm(curr_hand);
+	    if (!restoreArm(curr_hand))
+	    {
+		// go back to Idle
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 
-	    // go to state WaitArmApproachDone
-	    mutex.lock();
-	    status = Status::WaitArmRestoreDone;
-	    mutex.unlock();
+		break;
+	    }
+
+	    // go to state WaitArmRestoreDone
+	    // the module keeps running while the arm moves
+	    executor.status = Status::WaitArmRestoreDone;
 
 	    // reset timer
-	    last_time = yarp::os::Time::now();
+	    executor.last_time = yarp::os::Time::now();
 
 	    break;
 	}
@@ -1265,23 +2614,28 @@ public:
 	case Status::WaitArmRestoreDone:
 	{
 	    // timeout
-	    double timeout = 5.0;
+	    double timeout = getTimeout(curr_status);
 
-	    // check status
+	    // check status when notified
 	    bool is_done = false;
-	    bool ok = checkArmMotionDone(curr_hand, is_done);
+	    bool ok = true;
+	    if (!arm_events_enabled[curr_hand] ||
+		(is_event &&
+		 event.type == EventType::ArmMotionDone &&
+		 event.source == curr_hand))
+		ok = checkArmRestoreDone(curr_hand, is_done);
 
 	    // handle failure and timeout
 	    if (!ok ||
-		((yarp::os::Time::now() - last_time > timeout)))
+		((yarp::os::Time::now() - executor.last_time > timeout)))
 	    {
 		// stop control
-		stopArm(curr_hand);
+		// and restore the context
+		stopArmRestore(curr_hand);
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
+		executor.is_phase_failed = true;
 	    }
 
 	    if (is_done)
@@ -1290,9 +2644,7 @@ public:
 		yInfo() << "Arm restore done";
 
 		// go back to Idle
-		mutex.lock();
-		status = Status::Idle;
-		mutex.unlock();
+		executor.status = Status::Idle;
 	    }
 
 	    break;
@@ -1300,44 +2652,145 @@ public:
 
 	case Status::Stop:
 	{
-	    mutex.lock();
-
 	    // stop control
-	    stopArm("right");
-	    stopArm("left");
+	    stopArm(curr_hand);
 	    stopFingers(curr_hand);
 
+	    // the restore of the arm does not block the module
+	    // hence it might be stopped before completion
+	    stopArmRestore(curr_hand);
+
 	    // disable filtering
-	    sendCommandToFilter(false);
+	    // unless the other arm is using it
+	    ArmExecutor &other = (curr_hand == "right") ? left_executor : right_executor;
+	    if (other.status != Status::PreparePush &&
+		other.status != Status::PerformPush &&
+		other.status != Status::PrepareRotation &&
+		other.status != Status::PerformRotation)
+		sendCommandToFilter(false);
 
-	    // in case pushing was initiated
+	    // in case pushing or rotation was initiated
 	    // the previous context of the cartesian controller
 	    // has to be restored
 	    if (prev_status == Status::PreparePush ||
-		prev_status == Status::PerformPush)
+		prev_status == Status::PerformPush ||
+		prev_status == Status::PrepareRotation ||
+		prev_status == Status::PerformRotation)
 	    {
 		// restore arm controller context
-		// that was changed in pushObject(curr_hand)
+		// that was changed in preparePushObject(curr_hand)
+		// or in prepareRotateObject(curr_hand)
 		restoreArmControllerContext(curr_hand);
 	    }
 
 	    // reset flag
-	    is_approach_done = false;
+	    executor.is_approach_done = false;
 
 	    // go back to Idle
-	    status = Status::Idle;
-
-	    mutex.unlock();
+	    executor.status = Status::Idle;
 
 	    break;
 	}
 	}
-	
+    }
+
+    bool updateModule()
+    {
+	if(isStopping())
+	    return false;
+
+	// apply the commands received from the rpc thread
+	processCommands();
+	publishStatus();
+
+	// wait for events, timeouts or the next tick
+	Event event;
+	bool is_event = false;
+	double sleep_time = getSleepTime();
+	if (sleep_time != 0.0 && clock.isEnabled())
+	{
+	    // the semaphore of the queue runs on the system clock
+	    // hence with a stepped clock the module notifies when it has
+	    // to run again, sleeps on the network clock and then
+	    // takes the events received in the meantime
+	    double now = yarp::os::Time::now();
+	    double wake_time = now + tick_period;
+	    if (sleep_time > 0.0 && sleep_time < tick_period)
+		wake_time = now + sleep_time;
+	    clock.cycleDone(wake_time);
+	    yarp::os::Time::delay(wake_time - now);
+
+	    is_event = events.poll(event);
+
+	    if(isStopping())
+		return false;
+
+	    processCommands();
+	    publishStatus();
+	}
+	else if (sleep_time != 0.0)
+	{
+	    is_event = events.wait(event, sleep_time);
+
+	    if(isStopping())
+		return false;
+
+	    // the status might have been changed
+	    // by a command in the meantime
+	    processCommands();
+	    publishStatus();
+	}
+
+	// update timing instrumentation
+	double cycle_start = yarp::os::SystemClock::nowSystem();
+	updateStats(cycle_start);
+	ScopedLatency cycle_latency(stats.get("cycle"));
+
+	// get current estimates from the filter
+	// discarding those too old
+	double now = yarp::os::Time::now();
+	for (auto &item : objects)
+	{
+	    TrackedObject &object = *item.second;
+	    object.is_estimate_available = object.cache.latest(object.estimate,
+							       &object.estimate_time) &&
+		now - object.estimate_time <= max_estimate_age;
+	}
+
+	// record the age of the estimates in use
+	std::set<std::string> objects_in_use;
+	for (ArmExecutor *executor : {&right_executor, &left_executor})
+	{
+	    if (executor->status != Status::Idle)
+		objects_in_use.insert(executor->object);
+	}
+	if (is_waiting_condition)
+	    objects_in_use.insert(pipeline_object);
+	for (const std::string &id : objects_in_use)
+	{
+	    TrackedObject *object = getObject(id);
+	    if (object != nullptr && object->is_estimate_available)
+		stats.record("estimate/age", yarp::os::Time::now() - object->estimate_time);
+	}
+
+	// execute the next step of the pipeline, if any
+	runPipeline();
+
+	// the executors of the two arms run concurrently
+	stepExecutor(right_executor, event, is_event);
+	stepExecutor(left_executor, event, is_event);
+
+	// check the condition waited by the pipeline, if any
+	checkCondition();
+
+	// publish the status for the rpc thread
+	publishStatus();
+
         return true;
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
     yarp::os::Network yarp;
     if (!yarp.checkNetwork())
@@ -1346,8 +2799,15 @@ int main()
         return 1;
     }
 
+    // register the kinematic cartesian controller
+    yarp::dev::Drivers::factory().add(new yarp::dev::DriverCreatorOf<SimCartesianController>("simcartesiancontroller",
+											     "",
+											     "SimCartesianController"));
+
     VisTacLocSimModule mod;
     yarp::os::ResourceFinder rf;
+    rf.setDefaultConfigFile("vis_tac_localization_config.ini");
+    rf.configure(argc,argv);
     return mod.runModule(rf);
 
 }
@@ -0,0 +1,154 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Tips of the fingers attached by ArmController, i.e. the tips reused
+ * while the joints of the fingers do not change and the status of the
+ * tip when the cartesian controller fails to remove it.
+ */
+
+// yarp
+#include <yarp/sig/Vector.h>
+
+// std
+#include <string>
+
+#include "headers/ArmController.h"
+#include "tests/TestCheck.h"
+
+/*
+ * Arm controller replacing the encoders and
+ * the tip of the cartesian controller.
+ */
+class TestArmController : public ArmController
+{
+protected:
+    bool readArmEncoders(yarp::sig::Vector &encs) override
+    {
+	encs = encoders;
+	return true;
+    }
+
+    bool attachTip(const yarp::sig::Vector &, const yarp::sig::Vector &) override
+    {
+	// the tip is attached on top of another one
+	if (is_controller_tip_attached)
+	    is_tip_attached_twice = true;
+
+	is_controller_tip_attached = true;
+	n_attach++;
+
+	return true;
+    }
+
+    bool removeTip() override
+    {
+	if (is_remove_failing)
+	    return false;
+
+	is_controller_tip_attached = false;
+	n_remove++;
+
+	return true;
+    }
+
+public:
+    yarp::sig::Vector encoders;
+    bool is_controller_tip_attached;
+    bool is_tip_attached_twice;
+    bool is_remove_failing;
+    std::size_t n_attach;
+    std::size_t n_remove;
+
+    TestArmController() :
+	encoders(16, 0.0),
+	is_controller_tip_attached(false),
+	is_tip_attached_twice(false),
+	is_remove_failing(false),
+	n_attach(0),
+	n_remove(0)
+    {
+	which_arm = "right";
+	is_tip_attached = false;
+	is_homing = false;
+	arm_encs.resize(16, 0.0);
+	initFingerTips();
+    }
+};
+
+void testReuse()
+{
+    TestArmController arm;
+
+    CHECK(!arm.useFingerFrame("unknown"));
+    CHECK(arm.n_attach == 0);
+
+    CHECK(arm.useFingerFrame("middle"));
+    CHECK(arm.n_attach == 1 && arm.n_remove == 0);
+
+    // the same finger with the same joints
+    CHECK(arm.useFingerFrame("middle"));
+    CHECK(arm.n_attach == 1 && arm.n_remove == 0);
+
+    // a change of the joints within the quantization
+    arm.encoders[11] = 0.1;
+    CHECK(arm.useFingerFrame("middle"));
+    CHECK(arm.n_attach == 1 && arm.n_remove == 0);
+
+    // the joints of the finger changed
+    arm.encoders[11] = 20.0;
+    CHECK(arm.useFingerFrame("middle"));
+    CHECK(arm.n_attach == 2 && arm.n_remove == 1);
+
+    // another finger
+    CHECK(arm.useFingerFrame("index"));
+    CHECK(arm.n_attach == 3 && arm.n_remove == 2);
+
+    // a tip removed has to be attached again
+    CHECK(arm.removeFingerFrame());
+    CHECK(arm.useFingerFrame("index"));
+    CHECK(arm.n_attach == 4 && arm.n_remove == 3);
+
+    CHECK(!arm.is_tip_attached_twice);
+}
+
+void testFailedRemove()
+{
+    TestArmController arm;
+    CHECK(arm.useFingerFrame("middle"));
+
+    // the tip is still attached within the controller
+    arm.is_remove_failing = true;
+    CHECK(!arm.removeFingerFrame());
+    CHECK(arm.is_controller_tip_attached);
+
+    // hence it is reused
+    CHECK(arm.useFingerFrame("middle"));
+    CHECK(arm.n_attach == 1);
+
+    // and another tip is not attached on top of it
+    CHECK(!arm.useFingerFrame("index"));
+    CHECK(arm.n_attach == 1);
+
+    arm.is_remove_failing = false;
+    CHECK(arm.useFingerFrame("index"));
+    CHECK(arm.n_attach == 2 && arm.n_remove == 1);
+
+    CHECK(!arm.is_tip_attached_twice);
+}
+
+int main()
+{
+    testReuse();
+    testFailedRemove();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,205 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Bounds on the velocity, acceleration and jerk of JerkLimitedTrajectory,
+ * evaluated with finite differences, for segments reaching and not reaching
+ * the maximum velocity and for paths with corners and collinear waypoints.
+ */
+
+// yarp
+#include <yarp/sig/Vector.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "headers/JerkLimitedTrajectory.h"
+#include "tests/TestCheck.h"
+
+namespace
+{
+    const double period = 1e-3;
+
+    // relative tolerance on the bounds
+    const double tolerance = 1e-6;
+}
+
+yarp::sig::Vector point(const double &x, const double &y, const double &z)
+{
+    yarp::sig::Vector v(3);
+    v[0] = x;
+    v[1] = y;
+    v[2] = z;
+    return v;
+}
+
+double norm(const yarp::sig::Vector &v)
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+double distance(const yarp::sig::Vector &a, const yarp::sig::Vector &b)
+{
+    return norm(point(a[0] - b[0], a[1] - b[1], a[2] - b[2]));
+}
+
+/*
+ * Plan a trajectory and check that it starts and ends at rest on the
+ * first and last waypoint, passes through all the waypoints and
+ * respects the bounds, evaluated with finite differences of the velocity
+ * sampled at the sampling instants.
+ */
+void checkTrajectory(const std::vector<yarp::sig::Vector> &waypoints,
+		     const double &v_max, const double &a_max, const double &j_max)
+{
+    JerkLimitedTrajectory trajectory;
+    CHECK(trajectory.setLimits(v_max, a_max, j_max));
+    CHECK(trajectory.setSamplingPeriod(period));
+    CHECK(trajectory.plan(waypoints));
+
+    double duration = trajectory.getDuration();
+    CHECK(duration > 0.0);
+    std::size_t n = static_cast<std::size_t>(std::ceil(duration / period));
+
+    std::vector<yarp::sig::Vector> positions(n + 1);
+    std::vector<yarp::sig::Vector> velocities(n + 1);
+    for (std::size_t i = 0; i <= n; i++)
+	CHECK(trajectory.getTrajectory(std::min(i * period, duration), positions[i], velocities[i]));
+
+    CHECK(distance(positions.front(), waypoints.front()) < 1e-9);
+    CHECK(distance(positions.back(), waypoints.back()) < 1e-9);
+    CHECK(norm(velocities.front()) < 1e-9);
+    CHECK(norm(velocities.back()) < 1e-9);
+
+    // the path passes through all the waypoints
+    for (const yarp::sig::Vector &waypoint : waypoints)
+    {
+	double min_distance = distance(positions.front(), waypoint);
+	for (const yarp::sig::Vector &position : positions)
+	    min_distance = std::min(min_distance, distance(position, waypoint));
+	CHECK(min_distance < v_max * period);
+    }
+
+    // the last interval might be shorter than the period
+    double max_velocity = 0.0;
+    double max_acceleration = 0.0;
+    double max_jerk = 0.0;
+    for (std::size_t i = 0; i + 1 < n; i++)
+    {
+	max_velocity = std::max(max_velocity, norm(velocities[i]));
+	if (i == 0)
+	    continue;
+
+	yarp::sig::Vector acceleration(3);
+	yarp::sig::Vector jerk(3);
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    acceleration[k] = (velocities[i + 1][k] - velocities[i - 1][k]) / (2.0 * period);
+	    jerk[k] = (velocities[i + 1][k] - 2.0 * velocities[i][k] + velocities[i - 1][k]) / (period * period);
+	}
+	max_acceleration = std::max(max_acceleration, norm(acceleration));
+	max_jerk = std::max(max_jerk, norm(jerk));
+    }
+
+    CHECK(max_velocity <= v_max * (1.0 + tolerance));
+    CHECK(max_acceleration <= a_max * (1.0 + tolerance));
+    CHECK(max_jerk <= j_max * (1.0 + tolerance));
+}
+
+void testSegments()
+{
+    std::vector<yarp::sig::Vector> waypoints = {point(0.0, 0.0, 0.0), point(0.3, 0.4, 0.0)};
+
+    // maximum velocity reached, hence
+    // duration = length / v + v / a + a / j
+    JerkLimitedTrajectory trajectory;
+    CHECK(trajectory.setLimits(0.1, 0.2, 2.0));
+    CHECK(trajectory.plan(waypoints));
+    CHECK_NEAR(trajectory.getDuration(), 0.5 / 0.1 + 0.1 / 0.2 + 0.2 / 2.0, 1e-12);
+    checkTrajectory(waypoints, 0.1, 0.2, 2.0);
+
+    // maximum acceleration not reached (v * j < a * a)
+    checkTrajectory(waypoints, 0.1, 0.5, 1.0);
+
+    // maximum velocity not reached
+    std::vector<yarp::sig::Vector> short_waypoints = {point(0.0, 0.0, 0.0), point(0.0, 0.0, 0.02)};
+    checkTrajectory(short_waypoints, 0.1, 0.2, 2.0);
+
+    // neither the maximum velocity nor the maximum acceleration reached
+    short_waypoints[1][2] = 0.001;
+    checkTrajectory(short_waypoints, 0.1, 0.2, 2.0);
+}
+
+void testPaths()
+{
+    // the point stops at the corners
+    std::vector<yarp::sig::Vector> corners = {point(0.0, 0.0, 0.0), point(0.1, 0.0, 0.0),
+					      point(0.1, 0.1, 0.0), point(0.1, 0.1, -0.05)};
+    checkTrajectory(corners, 0.1, 0.2, 2.0);
+
+    // collinear and repeated waypoints are merged
+    std::vector<yarp::sig::Vector> collinear = {point(0.0, 0.0, 0.0), point(0.05, 0.0, 0.0),
+						point(0.05, 0.0, 0.0), point(0.2, 0.0, 0.0)};
+    std::vector<yarp::sig::Vector> merged = {point(0.0, 0.0, 0.0), point(0.2, 0.0, 0.0)};
+    JerkLimitedTrajectory trajectory;
+    CHECK(trajectory.plan(collinear));
+    double duration = trajectory.getDuration();
+    CHECK(trajectory.plan(merged));
+    CHECK_NEAR(duration, trajectory.getDuration(), 1e-12);
+    checkTrajectory(collinear, 0.1, 0.2, 2.0);
+
+    // a single waypoint is kept
+    yarp::sig::Vector position;
+    yarp::sig::Vector velocity;
+    CHECK(trajectory.plan({point(0.1, 0.2, 0.3)}));
+    CHECK(trajectory.getDuration() == 0.0);
+    CHECK(trajectory.getTrajectory(1.0, position, velocity));
+    CHECK(position.size() == 3 && distance(position, point(0.1, 0.2, 0.3)) < 1e-12);
+    CHECK(velocity.size() == 3 && norm(velocity) == 0.0);
+}
+
+void testRejected()
+{
+    JerkLimitedTrajectory trajectory;
+    yarp::sig::Vector position;
+    yarp::sig::Vector velocity;
+
+    CHECK(!trajectory.setLimits(0.0, 0.1, 1.0));
+    CHECK(!trajectory.setLimits(0.1, -0.1, 1.0));
+    CHECK(!trajectory.setLimits(0.1, 0.1, 0.0));
+    CHECK(!trajectory.setSamplingPeriod(0.0));
+    CHECK(!trajectory.setSamplingPeriod(-0.001));
+
+    // not planned yet
+    CHECK(!trajectory.getTrajectory(0.0, position, velocity));
+
+    CHECK(!trajectory.plan({}));
+    CHECK(!trajectory.plan({point(0.0, 0.0, 0.0), yarp::sig::Vector(2)}));
+
+    CHECK(trajectory.plan({point(0.0, 0.0, 0.0), point(0.1, 0.0, 0.0)}));
+    CHECK(!trajectory.getTrajectory(-0.1, position, velocity));
+
+    // the time is saturated at the duration
+    CHECK(trajectory.getTrajectory(trajectory.getDuration() + 1.0, position, velocity));
+    CHECK(distance(position, point(0.1, 0.0, 0.0)) < 1e-9 && norm(velocity) < 1e-9);
+}
+
+int main()
+{
+    testSegments();
+    testPaths();
+    testRejected();
+
+    return TEST_RESULT();
+}
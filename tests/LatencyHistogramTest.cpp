@@ -0,0 +1,175 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Aggregates and percentiles of LatencyHistogram, their relative error
+ * over the whole range, concurrent recording and LatencyStats.
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "headers/LatencyHistogram.h"
+#include "tests/TestCheck.h"
+
+namespace
+{
+    // half of a sub bucket, 32 sub buckets per power of two
+    const double relative_error = 1.0 / 64.0;
+}
+
+void testEmpty()
+{
+    LatencyHistogram histogram;
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.mean() == 0.0);
+    CHECK(histogram.min() == 0.0);
+    CHECK(histogram.max() == 0.0);
+    CHECK(histogram.percentile(50) == 0.0);
+}
+
+void testSmallValues()
+{
+    // durations below 64 us are stored exactly
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 50; i++)
+	histogram.record(i * 1e-6);
+
+    CHECK(histogram.count() == 50);
+    CHECK_NEAR(histogram.mean(), 25.5e-6, 1e-12);
+    CHECK_NEAR(histogram.min(), 1e-6, 1e-12);
+    CHECK_NEAR(histogram.max(), 50e-6, 1e-12);
+    CHECK_NEAR(histogram.percentile(0), 1e-6, 1e-12);
+    CHECK_NEAR(histogram.percentile(50), 25e-6, 1e-12);
+    CHECK_NEAR(histogram.percentile(90), 45e-6, 1e-12);
+    CHECK_NEAR(histogram.percentile(100), 50e-6, 1e-12);
+
+    // negative durations are recorded as zero
+    histogram.record(-1.0);
+    CHECK(histogram.min() == 0.0);
+
+    histogram.reset();
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.percentile(50) == 0.0);
+}
+
+void testRelativeError()
+{
+    // a single duration per histogram from 64 us to about 30 minutes
+    // the percentiles are bounded by the maximum, hence the last
+    // of the durations recorded is used
+    double max_error = 0.0;
+    for (double duration = 64e-6; duration < 2000.0; duration *= 1.37)
+    {
+	LatencyHistogram histogram;
+	histogram.record(duration);
+	histogram.record(2.0 * duration);
+	double estimate = histogram.percentile(50);
+	max_error = std::fmax(max_error, std::fabs(estimate - duration) / duration);
+    }
+    CHECK(max_error <= relative_error);
+
+    // percentiles of a uniform distribution from 0.1 ms to 1 s
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 10000; i++)
+	histogram.record(i * 1e-4);
+    CHECK(std::fabs(histogram.percentile(50) - 0.5) <= relative_error * 0.5);
+    CHECK(std::fabs(histogram.percentile(90) - 0.9) <= relative_error * 0.9);
+    CHECK(std::fabs(histogram.percentile(99) - 0.99) <= relative_error * 0.99);
+    CHECK_NEAR(histogram.percentile(100), 1.0, 1e-9);
+    CHECK_NEAR(histogram.mean(), 0.50005, 1e-9);
+
+    // durations beyond the range are clamped to the last bucket
+    // while the maximum is exact
+    LatencyHistogram huge;
+    huge.record(1e5);
+    CHECK_NEAR(huge.max(), 1e5, 1e-6);
+    CHECK(huge.percentile(100) <= huge.max());
+}
+
+void testConcurrentRecording()
+{
+    const int n_threads = 4;
+    const int n_records = 100000;
+
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++)
+    {
+	threads.push_back(std::thread([&histogram, t, n_records]()
+				      {
+					  for (int i = 0; i < n_records; i++)
+					      histogram.record((t + 1) * 1e-3);
+				      }));
+    }
+    for (std::thread &thread : threads)
+	thread.join();
+
+    CHECK(histogram.count() == static_cast<std::uint64_t>(n_threads * n_records));
+    CHECK_NEAR(histogram.mean(), 2.5e-3, 1e-9);
+    CHECK_NEAR(histogram.min(), 1e-3, 1e-12);
+    CHECK_NEAR(histogram.max(), 4e-3, 1e-12);
+}
+
+void testStats()
+{
+    LatencyStats stats;
+    stats.add("cycle");
+    stats.add("rpc");
+    stats.add("cycle");
+
+    CHECK(stats.get("cycle") != nullptr);
+    CHECK(stats.get("unknown") == nullptr);
+
+    stats.record("cycle", 0.002);
+    stats.record("cycle", 0.004);
+    stats.record("unknown", 1.0);
+    {
+	ScopedLatency latency(stats.get("rpc"));
+	ScopedLatency ignored(nullptr);
+    }
+    CHECK(stats.get("cycle")->count() == 2);
+    CHECK(stats.get("rpc")->count() == 1);
+
+    // (name count mean p50 p90 p99 max) in milliseconds, sorted by name
+    yarp::os::Bottle bottle;
+    stats.toBottle(bottle);
+    CHECK(bottle.size() == 2);
+    yarp::os::Bottle *cycle = bottle.get(0).asList();
+    CHECK(cycle != nullptr && cycle->size() == 7);
+    if (cycle != nullptr && cycle->size() == 7)
+    {
+	CHECK(cycle->get(0).asString() == "cycle");
+	CHECK(cycle->get(1).asInt() == 2);
+	CHECK_NEAR(cycle->get(2).asDouble(), 3.0, 1e-9);
+	CHECK_NEAR(cycle->get(6).asDouble(), 4.0, 1e-9);
+    }
+
+    stats.reset();
+    CHECK(stats.get("cycle")->count() == 0);
+}
+
+int main()
+{
+    testEmpty();
+    testSmallValues();
+    testRelativeError();
+    testConcurrentRecording();
+    testStats();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,382 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Closest point and ray casting queries of MeshModel,
+ * using the bounding volume hierarchy, against brute force
+ * on a mesh containing degenerate faces.
+ */
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "headers/MeshModel.h"
+#include "tests/TestCheck.h"
+
+// the mesh is written within the working directory
+#define TEST_MESH_NAME "mesh_model_test.off"
+#define TEST_QUERIES 500
+
+namespace
+{
+    const double tolerance = 1e-5;
+
+    double dot(const double a[3], const double b[3])
+    {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void sub(const float a[3], const float b[3], double r[3])
+    {
+	for (std::size_t k = 0; k < 3; k++)
+	    r[k] = static_cast<double>(a[k]) - b[k];
+    }
+
+    void cross(const double a[3], const double b[3], double r[3])
+    {
+	r[0] = a[1] * b[2] - a[2] * b[1];
+	r[1] = a[2] * b[0] - a[0] * b[2];
+	r[2] = a[0] * b[1] - a[1] * b[0];
+    }
+}
+
+/*
+ * Squared distance between a point and a segment.
+ */
+double segmentDistance(const float p[3], const float a[3], const float b[3])
+{
+    double ab[3];
+    double ap[3];
+    sub(b, a, ab);
+    sub(p, a, ap);
+
+    double length = dot(ab, ab);
+    double t = length > 0.0 ? std::min(std::max(dot(ap, ab) / length, 0.0), 1.0) : 0.0;
+    double d = 0.0;
+    for (std::size_t k = 0; k < 3; k++)
+	d += (ap[k] - t * ab[k]) * (ap[k] - t * ab[k]);
+
+    return d;
+}
+
+/*
+ * Squared distance between a point and a triangle, either the distance
+ * from the plane of the triangle, if the projection is within the
+ * triangle, or the distance from the nearest edge.
+ */
+double triangleDistance(const float p[3], const float a[3], const float b[3], const float c[3])
+{
+    double ab[3];
+    double ac[3];
+    double ap[3];
+    double n[3];
+    sub(b, a, ab);
+    sub(c, a, ac);
+    sub(p, a, ap);
+    cross(ab, ac, n);
+
+    double nn = dot(n, n);
+    if (nn > 0.0)
+    {
+	// projection on the plane
+	double s = dot(ap, n) / nn;
+	double q[3];
+	for (std::size_t k = 0; k < 3; k++)
+	    q[k] = p[k] - s * n[k];
+
+	// the projection is inside if it is on the inner side of all the edges
+	const float *vertices[3] = {a, b, c};
+	bool is_inside = true;
+	for (std::size_t i = 0; i < 3; i++)
+	{
+	    const float *v0 = vertices[i];
+	    const float *v1 = vertices[(i + 1) % 3];
+	    double edge[3];
+	    double v0q[3];
+	    double side[3];
+	    sub(v1, v0, edge);
+	    for (std::size_t k = 0; k < 3; k++)
+		v0q[k] = q[k] - v0[k];
+	    cross(edge, v0q, side);
+	    is_inside &= dot(side, n) >= 0.0;
+	}
+	if (is_inside)
+	    return s * s * nn;
+    }
+
+    return std::min(std::min(segmentDistance(p, a, b), segmentDistance(p, b, c)),
+		    segmentDistance(p, c, a));
+}
+
+/*
+ * Intersection between a ray and a triangle using the plane of the triangle.
+ */
+bool rayTriangle(const float origin[3], const float dir[3],
+		 const float a[3], const float b[3], const float c[3],
+		 double &t)
+{
+    double ab[3];
+    double ac[3];
+    double ao[3];
+    double n[3];
+    sub(b, a, ab);
+    sub(c, a, ac);
+    sub(origin, a, ao);
+    cross(ab, ac, n);
+
+    double d[3] = {dir[0], dir[1], dir[2]};
+    double denominator = dot(n, d);
+    if (std::fabs(denominator) < 1e-12)
+	return false;
+    t = -dot(ao, n) / denominator;
+    if (t < 0.0)
+	return false;
+
+    const float *vertices[3] = {a, b, c};
+    for (std::size_t i = 0; i < 3; i++)
+    {
+	const float *v0 = vertices[i];
+	const float *v1 = vertices[(i + 1) % 3];
+	double edge[3];
+	double v0q[3];
+	double side[3];
+	sub(v1, v0, edge);
+	for (std::size_t k = 0; k < 3; k++)
+	    v0q[k] = origin[k] + t * dir[k] - v0[k];
+	cross(edge, v0q, side);
+	if (dot(side, n) < 0.0)
+	    return false;
+    }
+
+    return true;
+}
+
+/*
+ * Write a bumpy sphere made of quads split in two triangles.
+ * The triangles touching the poles are degenerate since the
+ * vertices of the first and of the last ring coincide,
+ * a triangle with collinear vertices is added as well.
+ */
+void writeMesh()
+{
+    const std::size_t rings = 24;
+    const std::size_t sectors = 48;
+
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> bump(-0.01, 0.01);
+
+    std::vector<double> vertices;
+    for (std::size_t i = 0; i <= rings; i++)
+    {
+	double theta = M_PI * i / rings;
+	for (std::size_t j = 0; j < sectors; j++)
+	{
+	    double phi = 2.0 * M_PI * j / sectors;
+	    double radius = (i == 0 || i == rings) ? 0.1 : 0.1 + bump(generator);
+	    vertices.push_back(radius * std::sin(theta) * std::cos(phi));
+	    vertices.push_back(radius * std::sin(theta) * std::sin(phi));
+	    vertices.push_back(radius * std::cos(theta));
+	}
+    }
+
+    std::vector<std::size_t> faces;
+    for (std::size_t i = 0; i < rings; i++)
+    {
+	for (std::size_t j = 0; j < sectors; j++)
+	{
+	    std::size_t v00 = i * sectors + j;
+	    std::size_t v01 = i * sectors + (j + 1) % sectors;
+	    std::size_t v10 = (i + 1) * sectors + j;
+	    std::size_t v11 = (i + 1) * sectors + (j + 1) % sectors;
+	    faces.insert(faces.end(), {v00, v10, v11, v00, v11, v01});
+	}
+    }
+
+    // collinear vertices outside the sphere
+    std::size_t first = vertices.size() / 3;
+    vertices.insert(vertices.end(), {0.15, 0.0, 0.0, 0.2, 0.0, 0.0, 0.25, 0.0, 0.0});
+    faces.insert(faces.end(), {first, first + 1, first + 2});
+
+    std::ofstream file(TEST_MESH_NAME);
+    file << "OFF" << std::endl;
+    file << vertices.size() / 3 << " " << faces.size() / 3 << " 0" << std::endl;
+    for (std::size_t i = 0; i < vertices.size(); i += 3)
+	file << vertices[i] << " " << vertices[i + 1] << " " << vertices[i + 2] << std::endl;
+    for (std::size_t i = 0; i < faces.size(); i += 3)
+	file << "3 " << faces[i] << " " << faces[i + 1] << " " << faces[i + 2] << std::endl;
+}
+
+/*
+ * Compare the queries of the mesh with brute force over all the faces.
+ */
+void checkQueries(const MeshModel &mesh)
+{
+    const float *vertices = mesh.getVertices();
+    const uint32_t *faces = mesh.getFaces();
+    CHECK(mesh.getNumberFaces() == 2 * 24 * 48 + 1);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> coordinate(-0.3f, 0.3f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    double max_distance_error = 0.0;
+    std::size_t ray_mismatches = 0;
+    std::size_t count_mismatches = 0;
+    for (std::size_t i = 0; i < TEST_QUERIES; i++)
+    {
+	float p[3] = {coordinate(generator), coordinate(generator), coordinate(generator)};
+	float dir[3] = {direction(generator), direction(generator), direction(generator)};
+
+	double brute_distance = std::numeric_limits<double>::max();
+	double brute_t = std::numeric_limits<double>::max();
+	std::size_t brute_count = 0;
+	for (std::size_t f = 0; f < mesh.getNumberFaces(); f++)
+	{
+	    const float *a = &vertices[3 * faces[3 * f]];
+	    const float *b = &vertices[3 * faces[3 * f + 1]];
+	    const float *c = &vertices[3 * faces[3 * f + 2]];
+	    brute_distance = std::min(brute_distance, triangleDistance(p, a, b, c));
+
+	    double t;
+	    if (rayTriangle(p, dir, a, b, c, t))
+	    {
+		brute_t = std::min(brute_t, t);
+		brute_count++;
+	    }
+	}
+	brute_distance = std::sqrt(brute_distance);
+
+	// closest point
+	float q[3];
+	uint32_t face;
+	float squared_distance = mesh.closestPoint(p, q, face);
+	float distance = mesh.distance(p);
+	max_distance_error = std::max(max_distance_error, std::fabs(distance - brute_distance));
+	double pq[3];
+	sub(p, q, pq);
+	CHECK_NEAR(dot(pq, pq), squared_distance, tolerance);
+	CHECK(face < mesh.getNumberFaces());
+
+	// first intersection and number of intersections
+	float t;
+	bool is_hit = mesh.rayCast(p, dir, t, face);
+	bool is_brute_hit = brute_t < std::numeric_limits<double>::max();
+	if (is_hit != is_brute_hit || (is_hit && std::fabs(t - brute_t) > tolerance))
+	    ray_mismatches++;
+	if (mesh.countIntersections(p, dir) != brute_count)
+	    count_mismatches++;
+    }
+
+    CHECK(max_distance_error < tolerance);
+    CHECK(ray_mismatches == 0);
+    CHECK(count_mismatches == 0);
+}
+
+void testQueries()
+{
+    // hierarchy built in memory
+    MeshModel mesh;
+    CHECK(mesh.load(TEST_MESH_NAME, false));
+    checkQueries(mesh);
+
+    // hierarchy written to the cache and mapped
+    std::remove(TEST_MESH_NAME ".bin");
+    CHECK(mesh.load(TEST_MESH_NAME));
+    checkQueries(mesh);
+    CHECK(mesh.load(TEST_MESH_NAME));
+    checkQueries(mesh);
+}
+
+void testCorruptedCache()
+{
+    MeshModel mesh;
+    CHECK(mesh.load(TEST_MESH_NAME));
+    std::size_t n_faces = mesh.getNumberFaces();
+    mesh.clear();
+
+    // point the right child of the root out of range,
+    // the root is the first of the nodes stored at the end of the cache
+    std::vector<char> cache;
+    {
+	std::ifstream file(TEST_MESH_NAME ".bin", std::ios::binary);
+	cache.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::size_t n_nodes = 0;
+    {
+	MeshCacheHeader header;
+	CHECK(cache.size() >= sizeof(header));
+	if (cache.size() < sizeof(header))
+	    return;
+	std::memcpy(&header, cache.data(), sizeof(header));
+	n_nodes = header.n_nodes;
+    }
+    CHECK(n_nodes > 1);
+    MeshBVHNode root;
+    std::size_t root_offset = cache.size() - n_nodes * sizeof(MeshBVHNode);
+    std::memcpy(&root, cache.data() + root_offset, sizeof(root));
+    root.offset = n_nodes;
+    std::memcpy(cache.data() + root_offset, &root, sizeof(root));
+    {
+	std::ofstream file(TEST_MESH_NAME ".bin", std::ios::binary);
+	file.write(cache.data(), cache.size());
+    }
+
+    // the cache is rebuilt
+    CHECK(mesh.load(TEST_MESH_NAME));
+    CHECK(mesh.getNumberFaces() == n_faces);
+    checkQueries(mesh);
+    mesh.clear();
+
+    // point the last vertex of the last face out of range
+    {
+	std::ifstream file(TEST_MESH_NAME ".bin", std::ios::binary);
+	cache.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    MeshCacheHeader header;
+    std::memcpy(&header, cache.data(), sizeof(header));
+    CHECK(header.n_faces == n_faces);
+    uint32_t vertex = header.n_vertices;
+    std::size_t face_offset = sizeof(header) + header.n_vertices * 3 * sizeof(float) +
+	(3 * header.n_faces - 1) * sizeof(uint32_t);
+    std::memcpy(cache.data() + face_offset, &vertex, sizeof(vertex));
+    {
+	std::ofstream file(TEST_MESH_NAME ".bin", std::ios::binary);
+	file.write(cache.data(), cache.size());
+    }
+
+    // the cache is rebuilt as well
+    CHECK(mesh.load(TEST_MESH_NAME));
+    CHECK(mesh.getNumberFaces() == n_faces);
+    checkQueries(mesh);
+}
+
+int main()
+{
+    writeMesh();
+
+    testQueries();
+    testCorruptedCache();
+
+    std::remove(TEST_MESH_NAME);
+    std::remove(TEST_MESH_NAME ".bin");
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Parsing of the steps of a pipeline, as received by the rpc command
+ * 'pipeline', including the rejection of malformed steps.
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+
+// std
+#include <deque>
+#include <string>
+
+#include "headers/Pipeline.h"
+#include "tests/TestCheck.h"
+
+/*
+ * Parse a pipeline given as the text of the rpc command.
+ */
+bool parse(PipelineParser &parser, const std::string &command, std::deque<PipelineStep> &steps)
+{
+    yarp::os::Bottle bottle(command);
+    return parser.parse(bottle, 1, steps);
+}
+
+/*
+ * Check that a pipeline is rejected with an error and no steps.
+ */
+bool isRejected(PipelineParser &parser, const std::string &command)
+{
+    std::deque<PipelineStep> steps;
+    bool ok = parse(parser, command, steps);
+    return !ok && steps.empty() && !parser.getError().empty();
+}
+
+void testSteps()
+{
+    PipelineParser parser;
+    std::deque<PipelineStep> steps;
+    CHECK(parse(parser, "pipeline localize (wait 2) (wait-convergence 0.005 2.0 20.0)"
+		" (parallel approach-with-right approach-with-left)"
+		" (repeat 2 push-with-right (wait 0.0)) home-right", steps));
+    CHECK(parser.getError().empty());
+    CHECK(steps.size() == 9);
+    if (steps.size() != 9)
+	return;
+
+    CHECK(steps[0].type == PipelineStepType::Phase && steps[0].phase == "localize");
+
+    CHECK(steps[1].type == PipelineStepType::Wait && steps[1].duration == 2.0);
+
+    CHECK(steps[2].type == PipelineStepType::WaitConvergence);
+    CHECK(steps[2].tolerance == 0.005 && steps[2].window == 2.0 && steps[2].duration == 20.0);
+
+    CHECK(steps[3].type == PipelineStepType::Parallel && steps[3].phases.size() == 2);
+    CHECK(steps[3].phases.size() == 2 &&
+	  steps[3].phases[0] == "approach-with-right" && steps[3].phases[1] == "approach-with-left");
+
+    // repetitions are expanded
+    for (std::size_t i = 4; i < 8; i += 2)
+    {
+	CHECK(steps[i].type == PipelineStepType::Phase && steps[i].phase == "push-with-right");
+	CHECK(steps[i + 1].type == PipelineStepType::Wait && steps[i + 1].duration == 0.0);
+    }
+
+    CHECK(steps[8].type == PipelineStepType::Phase && steps[8].phase == "home-right");
+
+    // a previous pipeline is replaced
+    CHECK(parse(parser, "pipeline localize", steps));
+    CHECK(steps.size() == 1);
+
+    // zero repetitions
+    CHECK(parse(parser, "pipeline localize (repeat 0 push-with-right)", steps));
+    CHECK(steps.size() == 1);
+}
+
+void testMalformed()
+{
+    PipelineParser parser;
+
+    CHECK(isRejected(parser, "pipeline"));
+    CHECK(isRejected(parser, "pipeline localize 3"));
+    CHECK(isRejected(parser, "pipeline localize ()"));
+    CHECK(isRejected(parser, "pipeline (unknown 1)"));
+
+    // waits
+    CHECK(isRejected(parser, "pipeline (wait)"));
+    CHECK(isRejected(parser, "pipeline (wait two)"));
+    CHECK(isRejected(parser, "pipeline (wait 1 2)"));
+    CHECK(isRejected(parser, "pipeline (wait -1)"));
+    CHECK(isRejected(parser, "pipeline (wait -0.5)"));
+    CHECK(isRejected(parser, "pipeline (wait-convergence 0.005 2.0)"));
+    CHECK(isRejected(parser, "pipeline (wait-convergence 0.0 2.0 20.0)"));
+    CHECK(isRejected(parser, "pipeline (wait-convergence 0.005 0.0 20.0)"));
+    CHECK(isRejected(parser, "pipeline (wait-convergence 0.005 2.0 1.0)"));
+
+    // parallel steps require at least two phases
+    CHECK(isRejected(parser, "pipeline (parallel)"));
+    CHECK(isRejected(parser, "pipeline (parallel approach-with-right)"));
+    CHECK(isRejected(parser, "pipeline (parallel approach-with-right (wait 1))"));
+
+    // repetitions
+    CHECK(isRejected(parser, "pipeline (repeat 2)"));
+    CHECK(isRejected(parser, "pipeline (repeat -1 localize)"));
+    CHECK(isRejected(parser, "pipeline (repeat two localize)"));
+    CHECK(isRejected(parser, "pipeline (repeat 2 localize (wait -1))"));
+}
+
+void testMaximumSteps()
+{
+    PipelineParser parser(4);
+    std::deque<PipelineStep> steps;
+
+    CHECK(parse(parser, "pipeline (repeat 4 localize)", steps));
+    CHECK(steps.size() == 4);
+
+    // the expansion of repetitions is bounded as well
+    CHECK(isRejected(parser, "pipeline (repeat 5 localize)"));
+    CHECK(isRejected(parser, "pipeline (repeat 1000000 (repeat 1000000 localize))"));
+}
+
+int main()
+{
+    testSteps();
+    testMalformed();
+    testMaximumSteps();
+
+    return TEST_RESULT();
+}
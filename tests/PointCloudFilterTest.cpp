@@ -0,0 +1,246 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Voxel grid and crop boxes of PointCloudFilter on synthetic clouds.
+ */
+
+// yarp
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "headers/PointCloudFilter.h"
+#include "tests/TestCheck.h"
+
+namespace
+{
+    const double tolerance = 1e-5;
+}
+
+/*
+ * Copy the points of a cloud.
+ */
+std::vector<std::array<float, 3>> points(const SoAPointCloud &cloud)
+{
+    std::vector<std::array<float, 3>> p(cloud.size());
+    for (std::size_t i = 0; i < cloud.size(); i++)
+	p[i] = {{cloud.xData()[i], cloud.yData()[i], cloud.zData()[i]}};
+    return p;
+}
+
+void testVoxelize()
+{
+    // a 4x4x4 grid of voxels of 1 cm, including negative coordinates,
+    // with a different number of points in each voxel
+    const double leaf = 0.01;
+    SoAPointCloud cloud;
+    std::vector<std::array<double, 3>> centroids;
+    std::vector<std::array<float, 3>> input;
+    for (int i = -2; i < 2; i++)
+    {
+	for (int j = -2; j < 2; j++)
+	{
+	    for (int k = -2; k < 2; k++)
+	    {
+		int n_points = 1 + (i + j + k + 6) % 3;
+		std::array<double, 3> sum = {{0.0, 0.0, 0.0}};
+		for (int p = 0; p < n_points; p++)
+		{
+		    std::array<float, 3> point = {{static_cast<float>((i + 0.2 + 0.3 * p) * leaf),
+						   static_cast<float>((j + 0.5) * leaf),
+						   static_cast<float>((k + 0.8 - 0.3 * p) * leaf)}};
+		    input.push_back(point);
+		    for (std::size_t c = 0; c < 3; c++)
+			sum[c] += point[c];
+		}
+		for (std::size_t c = 0; c < 3; c++)
+		    sum[c] /= n_points;
+		centroids.push_back(sum);
+	    }
+	}
+    }
+
+    // the points are shuffled
+    std::mt19937 generator(0);
+    std::shuffle(input.begin(), input.end(), generator);
+    cloud.resize(input.size());
+    for (std::size_t i = 0; i < input.size(); i++)
+    {
+	cloud.xData()[i] = input[i][0];
+	cloud.yData()[i] = input[i][1];
+	cloud.zData()[i] = input[i][2];
+    }
+
+    // disabled by default
+    PointCloudFilter filter;
+    filter.voxelize(cloud);
+    CHECK(cloud.size() == input.size());
+
+    CHECK(!filter.setLeafSize(-leaf));
+    CHECK(filter.setLeafSize(leaf));
+    filter.voxelize(cloud);
+    CHECK(cloud.size() == centroids.size());
+    if (cloud.size() != centroids.size())
+	return;
+
+    // one centroid for each voxel
+    std::vector<std::array<float, 3>> output = points(cloud);
+    double max_error = 0.0;
+    for (const std::array<double, 3> &centroid : centroids)
+    {
+	double min_distance = 1.0;
+	for (const std::array<float, 3> &point : output)
+	{
+	    double distance = 0.0;
+	    for (std::size_t c = 0; c < 3; c++)
+		distance = std::max(distance, std::fabs(point[c] - centroid[c]));
+	    min_distance = std::min(min_distance, distance);
+	}
+	max_error = std::max(max_error, min_distance);
+    }
+    CHECK(max_error < tolerance);
+}
+
+void testCrop()
+{
+    // box rotated by 45 degrees about z
+    const double size[3] = {0.2, 0.1, 0.15};
+    const double c = std::sqrt(0.5);
+
+    // random cloud around the center of the box
+    // without points close to the faces of the boxes
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> coordinate(-0.2f, 0.2f);
+    SoAPointCloud cloud;
+    cloud.resize(1001);
+    for (std::size_t i = 0; i < cloud.size();)
+    {
+	float p[3] = {0.3f + coordinate(generator),
+		      -0.1f + coordinate(generator),
+		      0.05f + coordinate(generator)};
+	double d[3] = {p[0] - 0.3, p[1] + 0.1, p[2] - 0.05};
+	double q[3] = {c * d[0] + c * d[1], -c * d[0] + c * d[1], d[2]};
+	bool is_close = false;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    is_close |= std::fabs(std::fabs(d[k]) - size[k] / 2.0) < tolerance;
+	    is_close |= std::fabs(std::fabs(q[k]) - size[k] / 2.0) < tolerance;
+	}
+	if (is_close)
+	    continue;
+
+	cloud.xData()[i] = p[0];
+	cloud.yData()[i] = p[1];
+	cloud.zData()[i] = p[2];
+	i++;
+    }
+    const std::vector<std::array<float, 3>> input = points(cloud);
+    yarp::sig::Matrix pose(4, 4);
+    pose.eye();
+    pose(0, 0) = c;
+    pose(0, 1) = -c;
+    pose(1, 0) = c;
+    pose(1, 1) = c;
+    pose(0, 3) = 0.3;
+    pose(1, 3) = -0.1;
+    pose(2, 3) = 0.05;
+
+    PointCloudFilter filter;
+    yarp::sig::Vector box_size(3);
+    for (std::size_t k = 0; k < 3; k++)
+	box_size[k] = size[k];
+    CHECK(!filter.setCropBoxSize(yarp::sig::Vector(2, 0.1)));
+    CHECK(filter.setCropBoxSize(box_size));
+
+    // nothing is done without a mode or a pose
+    SoAPointCloud copy = cloud;
+    filter.crop(copy);
+    filter.setCropMode(CropMode::Oriented);
+    filter.crop(copy);
+    CHECK(copy.size() == input.size());
+
+    // the points within the axis aligned and the oriented box
+    std::vector<std::array<float, 3>> aligned;
+    std::vector<std::array<float, 3>> oriented;
+    for (const std::array<float, 3> &p : input)
+    {
+	double d[3] = {p[0] - 0.3, p[1] + 0.1, p[2] - 0.05};
+	double q[3] = {c * d[0] + c * d[1], -c * d[0] + c * d[1], d[2]};
+	bool is_aligned = true;
+	bool is_oriented = true;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    is_aligned &= std::fabs(d[k]) <= size[k] / 2.0;
+	    is_oriented &= std::fabs(q[k]) <= size[k] / 2.0;
+	}
+	if (is_aligned)
+	    aligned.push_back(p);
+	if (is_oriented)
+	    oriented.push_back(p);
+    }
+    CHECK(!oriented.empty() && oriented.size() < input.size());
+
+    // the points kept are not changed
+    CHECK(filter.setCropBoxPose(pose));
+    filter.crop(copy);
+    CHECK(points(copy) == oriented);
+
+    // only the position is used in axis aligned mode
+    copy = cloud;
+    filter.setCropMode(CropMode::AxisAligned);
+    filter.crop(copy);
+    CHECK(points(copy) == aligned);
+}
+
+void testFilter()
+{
+    // two clusters, the second one outside the box
+    SoAPointCloud cloud;
+    cloud.resize(20);
+    for (std::size_t i = 0; i < 20; i++)
+    {
+	float offset = i < 10 ? 0.0f : 1.0f;
+	cloud.xData()[i] = offset + 0.001f * i;
+	cloud.yData()[i] = 0.0025f;
+	cloud.zData()[i] = 0.0025f;
+    }
+
+    PointCloudFilter filter;
+    yarp::sig::Matrix pose(4, 4);
+    pose.eye();
+    CHECK(filter.setCropBoxSize(yarp::sig::Vector(3, 0.5)));
+    CHECK(filter.setCropBoxPose(pose));
+    filter.setCropMode(CropMode::AxisAligned);
+    CHECK(filter.setLeafSize(0.5));
+    filter.filter(cloud);
+
+    yarp::sig::Vector centroid;
+    CHECK(cloud.size() == 1);
+    CHECK(cloud.centroid(centroid));
+    CHECK_NEAR(centroid[0], 0.0045, tolerance);
+    CHECK_NEAR(centroid[1], 0.0025, tolerance);
+}
+
+int main()
+{
+    testVoxelize();
+    testCrop();
+    testFilter();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,236 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Round trip of PointCloudMessage through its wire format
+ * and rejection of malformed messages.
+ */
+
+// yarp
+#include <yarp/os/Bottle.h>
+#include <yarp/os/ConnectionWriter.h>
+#include <yarp/os/Portable.h>
+
+// std
+#include <string>
+#include <vector>
+
+#include "headers/PointCloudMessage.h"
+#include "tests/TestCheck.h"
+
+/*
+ * Message written item by item, used to forge malformed messages.
+ */
+class RawMessage : public yarp::os::PortWriter
+{
+public:
+    int items;
+    int magic;
+    int version;
+    int n_points;
+    int stride;
+    double timestamp;
+    std::string frame_id;
+    std::vector<char> payload;
+
+    RawMessage(const int &n, const int &point_stride) :
+	items(7),
+	magic(POINTCLOUD_MESSAGE_MAGIC),
+	version(POINTCLOUD_MESSAGE_VERSION),
+	n_points(n),
+	stride(point_stride),
+	timestamp(1.0),
+	frame_id("/frame"),
+	payload(n * point_stride, 0) { }
+
+    bool write(yarp::os::ConnectionWriter& connection) override
+    {
+	connection.appendInt(BOTTLE_TAG_LIST);
+	connection.appendInt(items);
+	connection.appendInt(BOTTLE_TAG_INT);
+	connection.appendInt(magic);
+	connection.appendInt(BOTTLE_TAG_INT);
+	connection.appendInt(version);
+	connection.appendInt(BOTTLE_TAG_INT);
+	connection.appendInt(n_points);
+	connection.appendInt(BOTTLE_TAG_INT);
+	connection.appendInt(stride);
+	connection.appendInt(BOTTLE_TAG_DOUBLE);
+	connection.appendDouble(timestamp);
+	connection.appendInt(BOTTLE_TAG_STRING);
+	connection.appendInt(frame_id.size() + 1);
+	connection.appendBlock(frame_id.c_str(), frame_id.size() + 1);
+	connection.appendInt(BOTTLE_TAG_BLOB);
+	connection.appendInt(payload.size());
+	if (payload.size() > 0)
+	    connection.appendBlock(payload.data(), payload.size());
+
+	return !connection.isError();
+    }
+};
+
+void testRoundTrip()
+{
+    SoAPointCloud cloud;
+    cloud.resize(1000);
+    for (std::size_t i = 0; i < cloud.size(); i++)
+    {
+	cloud.xData()[i] = 0.001f * i;
+	cloud.yData()[i] = -0.002f * i;
+	cloud.zData()[i] = 0.5f;
+    }
+
+    PointCloudMessage sent;
+    sent.fromPointCloud(cloud);
+    sent.setTimestamp(12.5);
+    sent.setFrameId("/depthCamera/frame");
+
+    PointCloudMessage received;
+    CHECK(yarp::os::Portable::copyPortable(sent, received));
+    CHECK(received.size() == 1000);
+    CHECK(!received.hasColors());
+    CHECK(received.getTimestamp() == 12.5);
+    CHECK(received.getFrameId() == "/depthCamera/frame");
+
+    SoAPointCloud received_cloud;
+    CHECK(received.toPointCloud(received_cloud));
+    CHECK(received_cloud.size() == cloud.size());
+    bool is_equal = received_cloud.size() == cloud.size();
+    for (std::size_t i = 0; is_equal && i < cloud.size(); i++)
+    {
+	is_equal = received_cloud.xData()[i] == cloud.xData()[i] &&
+	           received_cloud.yData()[i] == cloud.yData()[i] &&
+	           received_cloud.zData()[i] == cloud.zData()[i];
+    }
+    CHECK(is_equal);
+
+    // colors are not available
+    SoARGBPointCloud colored;
+    CHECK(!received.toPointCloud(colored));
+}
+
+void testRoundTripColors()
+{
+    SoARGBPointCloud cloud;
+    cloud.resize(10);
+    for (std::size_t i = 0; i < cloud.size(); i++)
+    {
+	cloud.xData()[i] = i;
+	cloud.yData()[i] = 2.0f * i;
+	cloud.zData()[i] = 3.0f * i;
+	cloud.rData()[i] = i;
+	cloud.gData()[i] = 100 + i;
+	cloud.bData()[i] = 200 + i;
+    }
+
+    PointCloudMessage sent;
+    sent.fromPointCloud(cloud);
+
+    PointCloudMessage received;
+    CHECK(yarp::os::Portable::copyPortable(sent, received));
+    CHECK(received.hasColors());
+    CHECK(received.getFrameId().empty());
+
+    SoARGBPointCloud received_cloud;
+    CHECK(received.toPointCloud(received_cloud));
+    CHECK(received_cloud.size() == cloud.size());
+    bool is_equal = received_cloud.size() == cloud.size();
+    for (std::size_t i = 0; is_equal && i < cloud.size(); i++)
+    {
+	is_equal = received_cloud.zData()[i] == cloud.zData()[i] &&
+	           received_cloud.rData()[i] == cloud.rData()[i] &&
+	           received_cloud.gData()[i] == cloud.gData()[i] &&
+	           received_cloud.bData()[i] == cloud.bData()[i];
+    }
+    CHECK(is_equal);
+
+    // the positions can be read without the colors
+    SoAPointCloud positions;
+    CHECK(received.toPointCloud(positions));
+    CHECK(positions.size() == cloud.size() && positions.yData()[3] == cloud.yData()[3]);
+    CHECK(received.points() == nullptr);
+}
+
+void testEmpty()
+{
+    PointCloudMessage sent;
+    sent.setFrameId("/frame");
+
+    PointCloudMessage received;
+    received.resize(5);
+    CHECK(yarp::os::Portable::copyPortable(sent, received));
+    CHECK(received.size() == 0);
+}
+
+void testMalformed()
+{
+    PointCloudMessage received;
+
+    // well formed
+    RawMessage message(4, sizeof(PackedPoint));
+    CHECK(yarp::os::Portable::copyPortable(message, received));
+    CHECK(received.size() == 4);
+
+    // wrong number of items
+    RawMessage items(4, sizeof(PackedPoint));
+    items.items = 6;
+    CHECK(!yarp::os::Portable::copyPortable(items, received));
+
+    // wrong magic and version
+    RawMessage magic(4, sizeof(PackedPoint));
+    magic.magic = VOCAB4('B','A','D','!');
+    CHECK(!yarp::os::Portable::copyPortable(magic, received));
+    RawMessage version(4, sizeof(PackedPoint));
+    version.version = POINTCLOUD_MESSAGE_VERSION + 1;
+    CHECK(!yarp::os::Portable::copyPortable(version, received));
+
+    // unknown stride
+    RawMessage stride(4, 13);
+    CHECK(!yarp::os::Portable::copyPortable(stride, received));
+
+    // negative and too many points
+    RawMessage negative(0, sizeof(PackedPoint));
+    negative.n_points = -1;
+    CHECK(!yarp::os::Portable::copyPortable(negative, received));
+    RawMessage huge(0, sizeof(PackedPoint));
+    huge.n_points = POINTCLOUD_MESSAGE_MAX_POINTS + 1;
+    CHECK(!yarp::os::Portable::copyPortable(huge, received));
+
+    // payload not matching the number of points
+    RawMessage payload(4, sizeof(PackedPoint));
+    payload.n_points = 5;
+    CHECK(!yarp::os::Portable::copyPortable(payload, received));
+
+    // a rejected message does not change the last one received
+    RawMessage rejected(4, sizeof(PackedPoint));
+    rejected.n_points = 5;
+    rejected.timestamp = 2.0;
+    rejected.frame_id = "/other";
+    CHECK(!yarp::os::Portable::copyPortable(rejected, received));
+    CHECK(received.size() == 4);
+    CHECK(received.getTimestamp() == 1.0);
+    CHECK(received.getFrameId() == "/frame");
+
+    // frame id too long
+    RawMessage frame(4, sizeof(PackedPoint));
+    frame.frame_id.assign(POINTCLOUD_MESSAGE_MAX_FRAME_ID, 'f');
+    CHECK(!yarp::os::Portable::copyPortable(frame, received));
+}
+
+int main()
+{
+    testRoundTrip();
+    testRoundTripColors();
+    testEmpty();
+    testMalformed();
+
+    return TEST_RESULT();
+}
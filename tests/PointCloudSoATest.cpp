@@ -0,0 +1,190 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Vectorized kernels of SoAPointCloud, i.e. transform, crop and centroid,
+ * against the scalar path for sizes leaving 0, 1, 7, 8 and 9 points
+ * after the last complete vector.
+ */
+
+// yarp
+#include <yarp/sig/Vector.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "headers/PointCloudSoA.h"
+#include "tests/TestCheck.h"
+
+namespace
+{
+    const double tolerance = 1e-5;
+}
+
+/*
+ * Random cloud including points on the faces of the box used for cropping.
+ */
+void randomCloud(const std::size_t &n, std::mt19937 &generator, SoARGBPointCloud &cloud)
+{
+    std::uniform_real_distribution<float> coordinate(-0.2f, 0.2f);
+    std::uniform_int_distribution<int> color(0, 255);
+    std::uniform_int_distribution<int> face(0, 5);
+
+    cloud.resize(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+	cloud.xData()[i] = coordinate(generator);
+	cloud.yData()[i] = coordinate(generator);
+	cloud.zData()[i] = coordinate(generator);
+	cloud.rData()[i] = color(generator);
+	cloud.gData()[i] = color(generator);
+	cloud.bData()[i] = color(generator);
+
+	// one point out of four on a face
+	if (i % 4 == 0)
+	{
+	    int k = face(generator);
+	    float *column = (k % 3 == 0) ? cloud.xData() : (k % 3 == 1 ? cloud.yData() : cloud.zData());
+	    column[i] = (k < 3) ? -0.1f : 0.1f;
+	}
+    }
+}
+
+void testTransform(const std::size_t &n)
+{
+    std::mt19937 generator(n);
+    SoARGBPointCloud cloud;
+    randomCloud(n, generator, cloud);
+    std::vector<float> x(cloud.xData(), cloud.xData() + n);
+    std::vector<float> y(cloud.yData(), cloud.yData() + n);
+    std::vector<float> z(cloud.zData(), cloud.zData() + n);
+
+    // rotation of 30 degrees about z and 45 degrees about x
+    const double c = std::cos(M_PI / 6.0);
+    const double s = std::sin(M_PI / 6.0);
+    const double h = std::sqrt(0.5);
+    const float rot[9] = {static_cast<float>(c), static_cast<float>(-s * h), static_cast<float>(s * h),
+			  static_cast<float>(s), static_cast<float>(c * h), static_cast<float>(-c * h),
+			  0.0f, static_cast<float>(h), static_cast<float>(h)};
+    const float pos[3] = {0.1f, -0.2f, 0.3f};
+    SoARGBPointCloud copy = cloud;
+    cloud.transform(rot, pos);
+    CHECK(cloud.size() == n);
+
+    double max_error = 0.0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+	const float *column[3] = {cloud.xData(), cloud.yData(), cloud.zData()};
+	for (std::size_t k = 0; k < 3; k++)
+	{
+	    double expected = static_cast<double>(rot[3 * k]) * x[i] +
+		static_cast<double>(rot[3 * k + 1]) * y[i] +
+		static_cast<double>(rot[3 * k + 2]) * z[i] + pos[k];
+	    max_error = std::max(max_error, std::fabs(column[k][i] - expected));
+	}
+    }
+    CHECK(max_error < tolerance);
+
+    // the same transformation as a homogeneous matrix
+    yarp::sig::Matrix transform(4, 4);
+    transform.zero();
+    for (int i = 0; i < 3; i++)
+    {
+	for (int j = 0; j < 3; j++)
+	    transform(i, j) = rot[3 * i + j];
+	transform(i, 3) = pos[i];
+    }
+    transform(3, 3) = 1.0;
+    CHECK(copy.transform(transform));
+    CHECK(std::equal(copy.xData(), copy.xData() + n, cloud.xData()));
+    CHECK(std::equal(copy.yData(), copy.yData() + n, cloud.yData()));
+    CHECK(std::equal(copy.zData(), copy.zData() + n, cloud.zData()));
+    CHECK(!copy.transform(yarp::sig::Matrix(3, 3)));
+}
+
+void testCrop(const std::size_t &n)
+{
+    std::mt19937 generator(n + 1);
+    SoARGBPointCloud cloud;
+    randomCloud(n, generator, cloud);
+
+    // a point not a number is never kept
+    if (n > 2)
+	cloud.yData()[2] = std::numeric_limits<float>::quiet_NaN();
+
+    // the points kept by the scalar path, in order
+    const float min[3] = {-0.1f, -0.1f, -0.1f};
+    const float max[3] = {0.1f, 0.1f, 0.1f};
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<unsigned char> r;
+    for (std::size_t i = 0; i < n; i++)
+    {
+	float p[3] = {cloud.xData()[i], cloud.yData()[i], cloud.zData()[i]};
+	bool is_inside = true;
+	for (std::size_t k = 0; k < 3; k++)
+	    is_inside &= (p[k] >= min[k]) && (p[k] <= max[k]);
+	if (is_inside)
+	{
+	    x.push_back(p[0]);
+	    y.push_back(p[1]);
+	    z.push_back(p[2]);
+	    r.push_back(cloud.rData()[i]);
+	}
+    }
+
+    CHECK(cloud.crop(min, max) == x.size());
+    CHECK(cloud.size() == x.size());
+    if (cloud.size() != x.size())
+	return;
+
+    CHECK(std::equal(x.begin(), x.end(), cloud.xData()));
+    CHECK(std::equal(y.begin(), y.end(), cloud.yData()));
+    CHECK(std::equal(z.begin(), z.end(), cloud.zData()));
+    CHECK(std::equal(r.begin(), r.end(), cloud.rData()));
+
+    // the centroid of the points kept
+    yarp::sig::Vector centroid;
+    CHECK(cloud.centroid(centroid) == !x.empty());
+    if (!x.empty())
+    {
+	double sum[3] = {0.0, 0.0, 0.0};
+	for (std::size_t i = 0; i < x.size(); i++)
+	{
+	    sum[0] += x[i];
+	    sum[1] += y[i];
+	    sum[2] += z[i];
+	}
+	for (std::size_t k = 0; k < 3; k++)
+	    CHECK_NEAR(centroid[k], sum[k] / x.size(), tolerance);
+    }
+
+    // cropping again keeps all the points
+    CHECK(cloud.crop(min, max) == x.size());
+}
+
+int main()
+{
+    // 0, 1, 7, 8 and 9 points after the last complete vector
+    // of both the SSE2 and the AVX2 kernels
+    for (std::size_t n : {0, 1, 7, 8, 9, 64, 65, 71, 72, 73})
+    {
+	testTransform(n);
+	testCrop(n);
+    }
+
+    return TEST_RESULT();
+}
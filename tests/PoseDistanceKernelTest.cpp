@@ -0,0 +1,215 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Vectorized distance kernels, i.e. the batched distance of
+ * BoxDistanceField and PoseDistanceKernel, against the scalar path
+ * for sizes not multiple of the vector width and of the block size,
+ * using one thread and the workers of the kernel.
+ */
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "headers/DistanceField.h"
+#include "headers/PoseDistanceKernel.h"
+#include "tests/TestCheck.h"
+
+namespace
+{
+    const double tolerance = 1e-5;
+}
+
+/*
+ * Distance field evaluating batches one point at a time
+ * using the scalar distance of another field.
+ */
+class ScalarDistanceField : public DistanceField
+{
+private:
+    const DistanceField &field;
+
+public:
+    ScalarDistanceField(const DistanceField &field) : field(field) { }
+
+    float distance(const float p[3]) const override
+    {
+	return field.distance(p);
+    }
+};
+
+/*
+ * Random pose, the rotation is obtained from a random quaternion.
+ */
+PoseHypothesis randomPose(std::mt19937 &generator)
+{
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<float> position(-0.05f, 0.05f);
+
+    double q[4];
+    double norm = 0.0;
+    for (std::size_t k = 0; k < 4; k++)
+    {
+	q[k] = normal(generator);
+	norm += q[k] * q[k];
+    }
+    norm = std::sqrt(norm);
+    double w = q[0] / norm;
+    double x = q[1] / norm;
+    double y = q[2] / norm;
+    double z = q[3] / norm;
+
+    PoseHypothesis pose;
+    double rot[9] = {1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+		     2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+		     2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)};
+    for (std::size_t k = 0; k < 9; k++)
+	pose.rot[k] = rot[k];
+    for (std::size_t k = 0; k < 3; k++)
+	pose.pos[k] = position(generator);
+
+    return pose;
+}
+
+/*
+ * Signed distance of a measurement given the pose of the object,
+ * the measurement is moved in the object frame in double precision.
+ */
+float referenceDistance(const DistanceField &field, const PoseHypothesis &pose,
+			const SoAPointCloud &points, const std::size_t &i)
+{
+    double p[3] = {points.xData()[i] - static_cast<double>(pose.pos[0]),
+		   points.yData()[i] - static_cast<double>(pose.pos[1]),
+		   points.zData()[i] - static_cast<double>(pose.pos[2])};
+    float q[3];
+    for (std::size_t k = 0; k < 3; k++)
+	q[k] = pose.rot[k] * p[0] + pose.rot[3 + k] * p[1] + pose.rot[6 + k] * p[2];
+
+    return field.distance(q);
+}
+
+void testBoxBatch()
+{
+    BoxDistanceField box(0.24, 0.17, 0.037);
+
+    // points inside, outside and on the faces
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> coordinate(-0.2f, 0.2f);
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    for (std::size_t i = 0; i < 37; i++)
+    {
+	x.push_back(coordinate(generator));
+	y.push_back(coordinate(generator));
+	z.push_back(coordinate(generator));
+    }
+    x.insert(x.end(), {0.12f, -0.12f, 0.0f, 0.0f, 0.0f});
+    y.insert(y.end(), {0.0f, 0.0f, 0.085f, 0.0f, 0.01f});
+    z.insert(z.end(), {0.0f, 0.0f, 0.0f, -0.0185f, 0.0f});
+
+    std::vector<float> d(x.size());
+    box.distance(x.data(), y.data(), z.data(), x.size(), d.data());
+    double max_error = 0.0;
+    for (std::size_t i = 0; i < x.size(); i++)
+    {
+	float p[3] = {x[i], y[i], z[i]};
+	max_error = std::max(max_error, std::fabs(static_cast<double>(d[i]) - box.distance(p)));
+    }
+    CHECK(max_error < tolerance);
+
+    // the center is inside at the distance of the nearest face
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    CHECK_NEAR(box.distance(center), -0.0185, tolerance);
+}
+
+void testKernel(const std::size_t &n_poses, const std::size_t &n_points, const std::size_t &n_threads)
+{
+    BoxDistanceField box(0.24, 0.17, 0.037);
+    ScalarDistanceField scalar(box);
+
+    std::mt19937 generator(n_poses * n_points + n_threads);
+    std::uniform_real_distribution<float> coordinate(-0.15f, 0.15f);
+    SoAPointCloud points;
+    points.resize(n_points);
+    for (std::size_t i = 0; i < n_points; i++)
+    {
+	points.xData()[i] = coordinate(generator);
+	points.yData()[i] = coordinate(generator);
+	points.zData()[i] = coordinate(generator);
+    }
+    std::vector<PoseHypothesis> poses;
+    for (std::size_t h = 0; h < n_poses; h++)
+	poses.push_back(randomPose(generator));
+
+    PoseDistanceKernel kernel(box, n_threads);
+    PoseDistanceKernel scalar_kernel(scalar, 1);
+    std::vector<float> distances;
+    std::vector<float> scalar_distances;
+    std::vector<float> sums;
+    kernel.distances(poses, points, distances);
+    scalar_kernel.distances(poses, points, scalar_distances);
+    kernel.sumOfSquares(poses, points, sums);
+    CHECK(distances.size() == n_poses * n_points);
+    CHECK(scalar_distances.size() == n_poses * n_points);
+    CHECK(sums.size() == n_poses);
+    if (distances.size() != n_poses * n_points || scalar_distances.size() != n_poses * n_points ||
+	sums.size() != n_poses)
+	return;
+
+    double max_error = 0.0;
+    double max_scalar_error = 0.0;
+    double max_sum_error = 0.0;
+    for (std::size_t h = 0; h < n_poses; h++)
+    {
+	double sum = 0.0;
+	for (std::size_t i = 0; i < n_points; i++)
+	{
+	    double reference = referenceDistance(box, poses[h], points, i);
+	    max_error = std::max(max_error, std::fabs(distances[h * n_points + i] - reference));
+	    max_scalar_error = std::max(max_scalar_error,
+					std::fabs(static_cast<double>(distances[h * n_points + i]) -
+						  scalar_distances[h * n_points + i]));
+	    sum += reference * reference;
+	}
+	max_sum_error = std::max(max_sum_error, std::fabs(sums[h] - sum) / std::max(sum, 1.0));
+    }
+
+    CHECK(max_error < tolerance);
+    CHECK(max_scalar_error < tolerance);
+    CHECK(max_sum_error < tolerance);
+}
+
+int main()
+{
+    testBoxBatch();
+
+    // sizes not multiple of the vector width and crossing a block
+    // large batches are split between the workers
+    for (std::size_t n_threads : {1, 4})
+    {
+	testKernel(1, 1, n_threads);
+	testKernel(3, 7, n_threads);
+	testKernel(5, 1029, n_threads);
+	testKernel(97, 1029, n_threads);
+    }
+
+    // the kernel can be reconfigured
+    BoxDistanceField box(0.24, 0.17, 0.037);
+    PoseDistanceKernel kernel(box, 2);
+    kernel.setNumberThreads(3);
+    CHECK(kernel.getNumberThreads() == 3);
+
+    return TEST_RESULT();
+}
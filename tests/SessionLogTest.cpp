@@ -0,0 +1,290 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Write/read round trip of a session log and
+ * recovery from truncated and corrupted logs.
+ */
+
+// std
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "headers/SessionLog.h"
+#include "tests/TestCheck.h"
+
+// the log is written within the working directory
+#define TEST_LOG_NAME "session_log_test.log"
+#define TEST_RECORDS 200
+
+/*
+ * Read and write the whole file.
+ */
+std::vector<char> readFile(const std::string &file_name)
+{
+    std::vector<char> data;
+    FILE *file = std::fopen(file_name.c_str(), "rb");
+    if (file == nullptr)
+	return data;
+
+    std::fseek(file, 0, SEEK_END);
+    data.resize(std::ftell(file));
+    std::fseek(file, 0, SEEK_SET);
+    if (std::fread(data.data(), 1, data.size(), file) != data.size())
+	data.clear();
+    std::fclose(file);
+
+    return data;
+}
+
+void writeFile(const std::string &file_name, const std::vector<char> &data, const std::size_t &size)
+{
+    FILE *file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr)
+	return;
+    std::fwrite(data.data(), 1, size, file);
+    std::fclose(file);
+}
+
+/*
+ * Content of the i-th record, records have different sizes
+ * including empty records and sizes not multiple of the padding.
+ */
+std::vector<char> recordData(const std::size_t &i)
+{
+    std::vector<char> data(i % 23);
+    for (std::size_t k = 0; k < data.size(); k++)
+	data[k] = static_cast<char>(i + k);
+    return data;
+}
+
+/*
+ * Write a log with two streams alternating records,
+ * the small chunks force several chunks per log.
+ */
+void writeLog(uint32_t &first, uint32_t &second)
+{
+    SessionLogWriter writer;
+    CHECK(writer.open(TEST_LOG_NAME, 512));
+    first = writer.addStream(StreamKind::PointCloud, "/depthCamera/points:o");
+    second = writer.addStream(StreamKind::Contacts, "/right_hand/skin_events:o");
+    CHECK(first != second);
+
+    for (std::size_t i = 0; i < TEST_RECORDS; i++)
+    {
+	std::vector<char> data = recordData(i);
+	CHECK(writer.write(i % 2 == 0 ? first : second, 0.1 * i, data.data(), data.size()));
+    }
+
+    // the meta stream and undeclared streams are refused
+    CHECK(!writer.write(SESSION_LOG_META_STREAM, 0.0, nullptr, 0));
+    CHECK(!writer.write(second + 1, 0.0, nullptr, 0));
+
+    // as well as records whose size does not fit in 32 bits
+    char byte = 0;
+    CHECK(!writer.write(first, 0.0, &byte, static_cast<std::size_t>(std::numeric_limits<uint32_t>::max()) + 1));
+
+    writer.close();
+}
+
+/*
+ * Read all the records, checking their content.
+ * @return the number of records read
+ */
+std::size_t readRecords(SessionLogReader &reader, const uint32_t &first, const uint32_t &second)
+{
+    SessionLogRecord rec;
+    std::size_t n = 0;
+    bool is_equal = true;
+    while (reader.next(rec))
+    {
+	std::vector<char> data = recordData(n);
+	is_equal &= rec.stream == (n % 2 == 0 ? first : second) &&
+	            rec.timestamp == 0.1 * n &&
+	            rec.size == data.size() &&
+	            (data.empty() || std::memcmp(rec.data, data.data(), data.size()) == 0);
+	n++;
+    }
+    CHECK(is_equal);
+
+    return n;
+}
+
+void testRoundTrip()
+{
+    uint32_t first;
+    uint32_t second;
+    writeLog(first, second);
+
+    SessionLogReader reader;
+    CHECK(reader.open(TEST_LOG_NAME));
+
+    const std::map<uint32_t, SessionLogStream> &streams = reader.getStreams();
+    CHECK(streams.size() == 2);
+    CHECK(streams.count(first) == 1 && streams.at(first).kind == StreamKind::PointCloud &&
+	  streams.at(first).name == "/depthCamera/points:o");
+    CHECK(streams.count(second) == 1 && streams.at(second).kind == StreamKind::Contacts &&
+	  streams.at(second).name == "/right_hand/skin_events:o");
+
+    double begin;
+    double end;
+    CHECK(reader.getTimeSpan(begin, end));
+    CHECK(begin == 0.0);
+    CHECK(end == 0.1 * (TEST_RECORDS - 1));
+
+    CHECK(readRecords(reader, first, second) == TEST_RECORDS);
+
+    // seek within the log and past its end
+    SessionLogRecord rec;
+    reader.seek(5.05);
+    CHECK(reader.next(rec) && rec.timestamp == 0.1 * 51);
+    reader.seek(0.1 * TEST_RECORDS);
+    CHECK(!reader.next(rec));
+    reader.rewind();
+    CHECK(reader.next(rec) && rec.timestamp == 0.0);
+}
+
+void testTruncated()
+{
+    uint32_t first;
+    uint32_t second;
+    writeLog(first, second);
+    std::vector<char> log = readFile(TEST_LOG_NAME);
+    CHECK(!log.empty());
+
+    // a crash while writing the last chunk loses only that chunk
+    writeFile(TEST_LOG_NAME, log, log.size() - 1);
+    SessionLogReader reader;
+    CHECK(reader.open(TEST_LOG_NAME));
+    std::size_t n = readRecords(reader, first, second);
+    CHECK(n > 0 && n < TEST_RECORDS);
+
+    // as well as a partial chunk header
+    writeFile(TEST_LOG_NAME, log, sizeof(SessionLogFileHeader) + sizeof(SessionLogChunkHeader) / 2);
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // but not a partial file header
+    writeFile(TEST_LOG_NAME, log, sizeof(SessionLogFileHeader) - 1);
+    CHECK(!reader.open(TEST_LOG_NAME));
+}
+
+void testCorrupted()
+{
+    uint32_t first;
+    uint32_t second;
+    writeLog(first, second);
+    const std::vector<char> log = readFile(TEST_LOG_NAME);
+    CHECK(log.size() > sizeof(SessionLogFileHeader) + sizeof(SessionLogChunkHeader));
+    if (log.size() <= sizeof(SessionLogFileHeader) + sizeof(SessionLogChunkHeader))
+	return;
+
+    SessionLogChunkHeader header;
+    std::size_t first_chunk = sizeof(SessionLogFileHeader);
+    std::memcpy(&header, log.data() + first_chunk, sizeof(header));
+    std::size_t second_chunk = first_chunk + header.size;
+    SessionLogReader reader;
+
+    // not a session log
+    std::vector<char> corrupted = log;
+    corrupted[0] = ~corrupted[0];
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(!reader.open(TEST_LOG_NAME));
+
+    // the chunks following a corrupted one are ignored
+    // a size smaller than the chunk header
+    corrupted = log;
+    uint64_t size = sizeof(SessionLogChunkHeader) - 1;
+    std::memcpy(corrupted.data() + second_chunk + offsetof(SessionLogChunkHeader, size), &size, sizeof(size));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == header.n_records - 2);
+
+    // an index beyond the chunk
+    corrupted = log;
+    uint64_t index_offset = header.size + 8;
+    std::memcpy(corrupted.data() + first_chunk + offsetof(SessionLogChunkHeader, index_offset),
+		&index_offset, sizeof(index_offset));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // more records than the entries of the index
+    corrupted = log;
+    uint32_t n_records = header.n_records + 1;
+    std::memcpy(corrupted.data() + first_chunk + offsetof(SessionLogChunkHeader, n_records),
+		&n_records, sizeof(n_records));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // fewer records than the entries of the index
+    corrupted = log;
+    n_records = header.n_records - 1;
+    std::memcpy(corrupted.data() + first_chunk + offsetof(SessionLogChunkHeader, n_records),
+		&n_records, sizeof(n_records));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // an index whose length is not a multiple of the size of the entries
+    corrupted = log;
+    index_offset = header.index_offset - 4;
+    std::memcpy(corrupted.data() + first_chunk + offsetof(SessionLogChunkHeader, index_offset),
+		&index_offset, sizeof(index_offset));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // an entry of the index not aligned
+    corrupted = log;
+    uint64_t record_offset;
+    std::memcpy(&record_offset, log.data() + first_chunk + header.index_offset, sizeof(record_offset));
+    record_offset += 4;
+    std::memcpy(corrupted.data() + first_chunk + header.index_offset, &record_offset, sizeof(record_offset));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // an entry of the index beyond the chunk
+    corrupted = log;
+    record_offset = header.size;
+    std::memcpy(corrupted.data() + first_chunk + header.index_offset, &record_offset, sizeof(record_offset));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+
+    // a record larger than the chunk
+    corrupted = log;
+    std::memcpy(&record_offset, log.data() + first_chunk + header.index_offset + (header.n_records - 1) * sizeof(uint64_t),
+		sizeof(record_offset));
+    uint32_t record_size = header.size;
+    std::memcpy(corrupted.data() + first_chunk + record_offset + offsetof(SessionLogRecordHeader, size),
+		&record_size, sizeof(record_size));
+    writeFile(TEST_LOG_NAME, corrupted, corrupted.size());
+    CHECK(reader.open(TEST_LOG_NAME));
+    CHECK(readRecords(reader, first, second) == 0);
+}
+
+int main()
+{
+    testRoundTrip();
+    testTruncated();
+    testCorrupted();
+
+    std::remove(TEST_LOG_NAME);
+
+    return TEST_RESULT();
+}
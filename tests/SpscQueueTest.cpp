@@ -0,0 +1,118 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+/*
+ * Capacity and ordering of SpscQueue, with the producer
+ * and the consumer on the same thread and on different threads.
+ */
+
+// std
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "headers/SpscQueue.h"
+#include "tests/TestCheck.h"
+
+void testCapacity()
+{
+    SpscQueue<int> queue(3);
+    int item = -1;
+
+    CHECK(queue.empty());
+    CHECK(!queue.pop(item));
+    CHECK(item == -1);
+
+    // the indices wrap around several times
+    bool is_ordered = true;
+    int pushed = 0;
+    int popped = 0;
+    for (std::size_t i = 0; i < 10; i++)
+    {
+	for (std::size_t k = 0; k < 3; k++)
+	    CHECK(queue.push(pushed++));
+	CHECK(!queue.empty());
+	CHECK(!queue.push(pushed));
+
+	for (std::size_t k = 0; k < 2; k++)
+	{
+	    CHECK(queue.pop(item));
+	    is_ordered &= item == popped++;
+	}
+	CHECK(queue.push(pushed++));
+	for (std::size_t k = 0; k < 2; k++)
+	{
+	    CHECK(queue.pop(item));
+	    is_ordered &= item == popped++;
+	}
+	CHECK(queue.empty());
+    }
+    CHECK(is_ordered);
+}
+
+void testMoveOnly()
+{
+    SpscQueue<std::unique_ptr<int>> queue(2);
+    std::unique_ptr<int> item;
+
+    CHECK(queue.push(std::unique_ptr<int>(new int(1))));
+    CHECK(queue.push(std::unique_ptr<int>(new int(2))));
+
+    // a full queue refuses the item
+    CHECK(!queue.push(std::unique_ptr<int>(new int(3))));
+
+    CHECK(queue.pop(item) && item != nullptr && *item == 1);
+    CHECK(queue.pop(item) && item != nullptr && *item == 2);
+    CHECK(!queue.pop(item));
+}
+
+void testProducerConsumer()
+{
+    const int n_items = 1000000;
+    SpscQueue<int> queue(16);
+
+    std::thread producer([&queue, n_items]()
+			 {
+			     for (int i = 0; i < n_items; i++)
+			     {
+				 while (!queue.push(i))
+				     std::this_thread::yield();
+			     }
+			 });
+
+    // every item is received once and in order
+    bool is_ordered = true;
+    int expected = 0;
+    while (expected < n_items)
+    {
+	int item;
+	if (queue.pop(item))
+	{
+	    is_ordered &= item == expected;
+	    expected++;
+	}
+	else
+	    std::this_thread::yield();
+    }
+    producer.join();
+
+    CHECK(is_ordered);
+    CHECK(queue.empty());
+}
+
+int main()
+{
+    testCapacity();
+    testMoveOnly();
+    testProducerConsumer();
+
+    return TEST_RESULT();
+}
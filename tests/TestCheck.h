@@ -0,0 +1,51 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @author: Nicola Piga <nicolapiga@gmail.com>
+ */
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// std
+#include <cmath>
+#include <cstdio>
+
+/*
+ * Checks used by the tests in this directory.
+ *
+ * Each test is a plain executable that runs all its checks,
+ * prints those failing and returns TEST_RESULT() from main,
+ * i.e. a non zero exit code if any check failed.
+ */
+
+namespace test
+{
+    inline int& failures()
+    {
+	static int failures = 0;
+	return failures;
+    }
+}
+
+#define CHECK(condition)						\
+    do									\
+    {									\
+	if (!(condition))						\
+	{								\
+	    std::fprintf(stderr, "%s:%d: check failed: %s\n",		\
+			 __FILE__, __LINE__, #condition);		\
+	    test::failures()++;						\
+	}								\
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::fabs((a) - (b)) <= (tolerance))
+
+#define TEST_RESULT() (test::failures() == 0 ? 0 : 1)
+
+#endif